@@ -21,6 +21,7 @@
 #include <util/check.h>
 #include <util/time.h>
 
+#include <bit>
 #include <cmath>
 #include <optional>
 
@@ -122,6 +123,7 @@ AddrManImpl::AddrManImpl(const NetGroupManager& netgroupman, bool deterministic,
             entry = -1;
         }
     }
+    WITH_LOCK(cs, ReserveAddrIndex(0));
 }
 
 AddrManImpl::~AddrManImpl()
@@ -162,7 +164,7 @@ void AddrManImpl::Serialize(Stream& s_) const
      * as incompatible. This is necessary because it did not check the version number on
      * deserialization.
      *
-     * vvNew, vvTried, mapInfo, mapAddr and vRandom are never encoded explicitly;
+     * vvNew, vvTried, m_infos, m_addr_index and vRandom are never encoded explicitly;
      * they are instead reconstructed from the other information.
      *
      * This format is more complex, but significantly smaller (at most 1.5 MiB), and supports
@@ -188,11 +190,11 @@ void AddrManImpl::Serialize(Stream& s_) const
 
     int nUBuckets = ADDRMAN_NEW_BUCKET_COUNT ^ (1 << 30);
     s << nUBuckets;
-    std::unordered_map<nid_type, int> mapUnkIds;
+    std::vector<int> mapUnkIds(m_infos.size());
     int nIds = 0;
-    for (const auto& entry : mapInfo) {
-        mapUnkIds[entry.first] = nIds;
-        const AddrInfo& info = entry.second;
+    for (size_t n = 0; n < m_infos.size(); n++) {
+        mapUnkIds[n] = nIds;
+        const AddrInfo& info = m_infos[n];
         if (info.nRefCount) {
             assert(nIds != nNew); // this means nNew was wrong, oh ow
             s << info;
@@ -200,8 +202,7 @@ void AddrManImpl::Serialize(Stream& s_) const
         }
     }
     nIds = 0;
-    for (const auto& entry : mapInfo) {
-        const AddrInfo& info = entry.second;
+    for (const AddrInfo& info : m_infos) {
         if (info.fInTried) {
             assert(nIds != nTried); // this means nTried was wrong, oh ow
             s << info;
@@ -209,17 +210,11 @@ void AddrManImpl::Serialize(Stream& s_) const
         }
     }
     for (int bucket = 0; bucket < ADDRMAN_NEW_BUCKET_COUNT; bucket++) {
-        int nSize = 0;
-        for (int i = 0; i < ADDRMAN_BUCKET_SIZE; i++) {
-            if (vvNew[bucket][i] != -1)
-                nSize++;
-        }
+        int nSize = std::popcount(m_new_occupied[bucket]);
         s << nSize;
-        for (int i = 0; i < ADDRMAN_BUCKET_SIZE; i++) {
-            if (vvNew[bucket][i] != -1) {
-                int nIndex = mapUnkIds[vvNew[bucket][i]];
-                s << nIndex;
-            }
+        for (uint64_t occupied = m_new_occupied[bucket]; occupied; occupied &= occupied - 1) {
+            int nIndex = mapUnkIds[vvNew[bucket][std::countr_zero(occupied)]];
+            s << nIndex;
         }
     }
     // Store asmap checksum after bucket entries so that it
@@ -279,16 +274,20 @@ void AddrManImpl::Unserialize(Stream& s_)
                     ADDRMAN_TRIED_BUCKET_COUNT * ADDRMAN_BUCKET_SIZE));
     }
 
+    m_infos.reserve(nNew + nTried);
+    vRandom.reserve(nNew + nTried);
+    ReserveAddrIndex(nNew + nTried);
+
     // Deserialize entries from the new table.
+    m_infos.resize(nNew);
     for (int n = 0; n < nNew; n++) {
-        AddrInfo& info = mapInfo[n];
+        AddrInfo& info = m_infos[n];
         s >> info;
-        mapAddr[info] = n;
+        IndexAddr(n);
         info.nRandomPos = vRandom.size();
         vRandom.push_back(n);
         m_network_counts[info.GetNetwork()].n_new++;
     }
-    nIdCount = nNew;
 
     // Deserialize entries from the tried table.
     int nLost = 0;
@@ -299,13 +298,13 @@ void AddrManImpl::Unserialize(Stream& s_)
         int nKBucketPos = info.GetBucketPosition(nKey, false, nKBucket);
         if (info.IsValid()
                 && vvTried[nKBucket][nKBucketPos] == -1) {
+            const nid_type nId = m_infos.size();
             info.nRandomPos = vRandom.size();
             info.fInTried = true;
-            vRandom.push_back(nIdCount);
-            mapInfo[nIdCount] = info;
-            mapAddr[info] = nIdCount;
-            vvTried[nKBucket][nKBucketPos] = nIdCount;
-            nIdCount++;
+            vRandom.push_back(nId);
+            m_infos.push_back(info);
+            IndexAddr(nId);
+            SetEntry(/*use_tried=*/true, nKBucket, nKBucketPos, nId);
             m_network_counts[info.GetNetwork()].n_tried++;
         } else {
             nLost++;
@@ -348,7 +347,7 @@ void AddrManImpl::Unserialize(Stream& s_)
     for (auto bucket_entry : bucket_entries) {
         int bucket{bucket_entry.first};
         const int entry_index{bucket_entry.second};
-        AddrInfo& info = mapInfo[entry_index];
+        AddrInfo& info = m_infos[entry_index];
 
         // Don't store the entry in the new bucket if it's not a valid address for our addrman
         if (!info.IsValid()) continue;
@@ -361,7 +360,7 @@ void AddrManImpl::Unserialize(Stream& s_)
         int bucket_position = info.GetBucketPosition(nKey, true, bucket);
         if (restore_bucketing && vvNew[bucket][bucket_position] == -1) {
             // Bucketing has not changed, using existing bucket positions for the new table
-            vvNew[bucket][bucket_position] = entry_index;
+            SetEntry(/*use_tried=*/false, bucket, bucket_position, entry_index);
             ++info.nRefCount;
         } else {
             // In case the new table data cannot be used (bucket count wrong or new asmap),
@@ -369,7 +368,7 @@ void AddrManImpl::Unserialize(Stream& s_)
             bucket = info.GetNewBucket(nKey, m_netgroupman);
             bucket_position = info.GetBucketPosition(nKey, true, bucket);
             if (vvNew[bucket][bucket_position] == -1) {
-                vvNew[bucket][bucket_position] = entry_index;
+                SetEntry(/*use_tried=*/false, bucket, bucket_position, entry_index);
                 ++info.nRefCount;
             }
         }
@@ -377,13 +376,10 @@ void AddrManImpl::Unserialize(Stream& s_)
 
     // Prune new entries with refcount 0 (as a result of collisions or invalid address).
     int nLostUnk = 0;
-    for (auto it = mapInfo.cbegin(); it != mapInfo.cend(); ) {
-        if (it->second.fInTried == false && it->second.nRefCount == 0) {
-            const auto itCopy = it++;
-            Delete(itCopy->first);
+    for (nid_type n = 0; n < nNew; n++) {
+        if (m_infos[n].nRefCount == 0) {
+            Delete(n);
             ++nLostUnk;
-        } else {
-            ++it;
         }
     }
     if (nLost + nLostUnk > 0) {
@@ -402,31 +398,103 @@ AddrInfo* AddrManImpl::Find(const CService& addr, nid_type* pnId)
 {
     AssertLockHeld(cs);
 
-    const auto it = mapAddr.find(addr);
-    if (it == mapAddr.end())
+    const nid_type nId = m_addr_index[FindAddrSlot(addr)];
+    if (nId == -1)
         return nullptr;
     if (pnId)
-        *pnId = (*it).second;
-    const auto it2 = mapInfo.find((*it).second);
-    if (it2 != mapInfo.end())
-        return &(*it2).second;
-    return nullptr;
+        *pnId = nId;
+    return &m_infos[nId];
+}
+
+bool AddrManImpl::IsUsedId(nid_type nId) const
+{
+    AssertLockHeld(cs);
+
+    return nId >= 0 && static_cast<size_t>(nId) < m_infos.size() && m_infos[nId].nRandomPos != -1;
+}
+
+nid_type AddrManImpl::AllocateId(const AddrInfo& info)
+{
+    AssertLockHeld(cs);
+
+    if (m_free_ids.empty()) {
+        m_infos.push_back(info);
+        return m_infos.size() - 1;
+    }
+    const nid_type nId = m_free_ids.back();
+    m_free_ids.pop_back();
+    m_infos[nId] = info;
+    return nId;
+}
+
+size_t AddrManImpl::FindAddrSlot(const CService& addr) const
+{
+    AssertLockHeld(cs);
+
+    const size_t mask = m_addr_index.size() - 1;
+    for (size_t slot = m_addr_hasher(addr) & mask;; slot = (slot + 1) & mask) {
+        const nid_type nId = m_addr_index[slot];
+        if (nId == -1 || static_cast<const CService&>(m_infos[nId]) == addr) return slot;
+    }
+}
+
+void AddrManImpl::ReserveAddrIndex(size_t count)
+{
+    AssertLockHeld(cs);
+
+    const size_t size = std::max<size_t>(std::bit_ceil(2 * count), ADDRMAN_BUCKET_SIZE);
+    if (size <= m_addr_index.size()) return;
+    std::vector<nid_type> old_index(size, -1);
+    old_index.swap(m_addr_index);
+    for (const nid_type nId : old_index) {
+        if (nId != -1) m_addr_index[FindAddrSlot(m_infos[nId])] = nId;
+    }
+}
+
+void AddrManImpl::IndexAddr(nid_type nId)
+{
+    AssertLockHeld(cs);
+
+    ReserveAddrIndex(m_addr_index_count + 1);
+    nid_type& slot = m_addr_index[FindAddrSlot(m_infos[nId])];
+    if (slot == -1) m_addr_index_count++;
+    slot = nId;
+}
+
+void AddrManImpl::UnindexAddr(const CService& addr)
+{
+    AssertLockHeld(cs);
+
+    const size_t mask = m_addr_index.size() - 1;
+    size_t slot = FindAddrSlot(addr);
+    if (m_addr_index[slot] == -1) return;
+    // Shift back the following entries of the probe sequence which may move
+    // into the emptied slot, so that lookups never stop early.
+    for (size_t next = (slot + 1) & mask; m_addr_index[next] != -1; next = (next + 1) & mask) {
+        const nid_type nId = m_addr_index[next];
+        const size_t home = m_addr_hasher(m_infos[nId]) & mask;
+        if (((next - home) & mask) >= ((next - slot) & mask)) {
+            m_addr_index[slot] = nId;
+            slot = next;
+        }
+    }
+    m_addr_index[slot] = -1;
+    m_addr_index_count--;
 }
 
 AddrInfo* AddrManImpl::Create(const CAddress& addr, const CNetAddr& addrSource, nid_type* pnId)
 {
     AssertLockHeld(cs);
 
-    nid_type nId = nIdCount++;
-    mapInfo[nId] = AddrInfo(addr, addrSource);
-    mapAddr[addr] = nId;
-    mapInfo[nId].nRandomPos = vRandom.size();
+    nid_type nId = AllocateId(AddrInfo(addr, addrSource));
+    IndexAddr(nId);
+    m_infos[nId].nRandomPos = vRandom.size();
     vRandom.push_back(nId);
     nNew++;
     m_network_counts[addr.GetNetwork()].n_new++;
     if (pnId)
         *pnId = nId;
-    return &mapInfo[nId];
+    return &m_infos[nId];
 }
 
 void AddrManImpl::SwapRandom(unsigned int nRndPos1, unsigned int nRndPos2) const
@@ -441,13 +509,11 @@ void AddrManImpl::SwapRandom(unsigned int nRndPos1, unsigned int nRndPos2) const
     nid_type nId1 = vRandom[nRndPos1];
     nid_type nId2 = vRandom[nRndPos2];
 
-    const auto it_1{mapInfo.find(nId1)};
-    const auto it_2{mapInfo.find(nId2)};
-    assert(it_1 != mapInfo.end());
-    assert(it_2 != mapInfo.end());
+    assert(IsUsedId(nId1));
+    assert(IsUsedId(nId2));
 
-    it_1->second.nRandomPos = nRndPos2;
-    it_2->second.nRandomPos = nRndPos1;
+    m_infos[nId1].nRandomPos = nRndPos2;
+    m_infos[nId2].nRandomPos = nRndPos1;
 
     vRandom[nRndPos1] = nId2;
     vRandom[nRndPos2] = nId1;
@@ -457,16 +523,19 @@ void AddrManImpl::Delete(nid_type nId)
 {
     AssertLockHeld(cs);
 
-    assert(mapInfo.count(nId) != 0);
-    AddrInfo& info = mapInfo[nId];
+    assert(IsUsedId(nId));
+    AddrInfo& info = m_infos[nId];
     assert(!info.fInTried);
     assert(info.nRefCount == 0);
 
     SwapRandom(info.nRandomPos, vRandom.size() - 1);
     m_network_counts[info.GetNetwork()].n_new--;
     vRandom.pop_back();
-    mapAddr.erase(info);
-    mapInfo.erase(nId);
+    UnindexAddr(info);
+    // The nId is reused by the next entry, so it must not linger as a collision.
+    m_tried_collisions.erase(nId);
+    info = AddrInfo{};
+    m_free_ids.push_back(nId);
     nNew--;
 }
 
@@ -477,10 +546,10 @@ void AddrManImpl::ClearNew(int nUBucket, int nUBucketPos)
     // if there is an entry in the specified bucket, delete it.
     if (vvNew[nUBucket][nUBucketPos] != -1) {
         nid_type nIdDelete = vvNew[nUBucket][nUBucketPos];
-        AddrInfo& infoDelete = mapInfo[nIdDelete];
+        AddrInfo& infoDelete = m_infos[nIdDelete];
         assert(infoDelete.nRefCount > 0);
         infoDelete.nRefCount--;
-        vvNew[nUBucket][nUBucketPos] = -1;
+        SetEntry(/*use_tried=*/false, nUBucket, nUBucketPos, -1);
         LogDebug(BCLog::ADDRMAN, "Removed %s from new[%i][%i]\n", infoDelete.ToStringAddrPort(), nUBucket, nUBucketPos);
         if (infoDelete.nRefCount == 0) {
             Delete(nIdDelete);
@@ -498,7 +567,7 @@ void AddrManImpl::MakeTried(AddrInfo& info, nid_type nId)
         const int bucket{(start_bucket + n) % ADDRMAN_NEW_BUCKET_COUNT};
         const int pos{info.GetBucketPosition(nKey, true, bucket)};
         if (vvNew[bucket][pos] == nId) {
-            vvNew[bucket][pos] = -1;
+            SetEntry(/*use_tried=*/false, bucket, pos, -1);
             info.nRefCount--;
             if (info.nRefCount == 0) break;
         }
@@ -516,12 +585,12 @@ void AddrManImpl::MakeTried(AddrInfo& info, nid_type nId)
     if (vvTried[nKBucket][nKBucketPos] != -1) {
         // find an item to evict
         nid_type nIdEvict = vvTried[nKBucket][nKBucketPos];
-        assert(mapInfo.count(nIdEvict) == 1);
-        AddrInfo& infoOld = mapInfo[nIdEvict];
+        assert(IsUsedId(nIdEvict));
+        AddrInfo& infoOld = m_infos[nIdEvict];
 
         // Remove the to-be-evicted item from the tried set.
         infoOld.fInTried = false;
-        vvTried[nKBucket][nKBucketPos] = -1;
+        SetEntry(/*use_tried=*/true, nKBucket, nKBucketPos, -1);
         nTried--;
         m_network_counts[infoOld.GetNetwork()].n_tried--;
 
@@ -533,7 +602,7 @@ void AddrManImpl::MakeTried(AddrInfo& info, nid_type nId)
 
         // Enter it into the new set again.
         infoOld.nRefCount = 1;
-        vvNew[nUBucket][nUBucketPos] = nIdEvict;
+        SetEntry(/*use_tried=*/false, nUBucket, nUBucketPos, nIdEvict);
         nNew++;
         m_network_counts[infoOld.GetNetwork()].n_new++;
         LogDebug(BCLog::ADDRMAN, "Moved %s from tried[%i][%i] to new[%i][%i] to make space\n",
@@ -541,7 +610,7 @@ void AddrManImpl::MakeTried(AddrInfo& info, nid_type nId)
     }
     assert(vvTried[nKBucket][nKBucketPos] == -1);
 
-    vvTried[nKBucket][nKBucketPos] = nId;
+    SetEntry(/*use_tried=*/true, nKBucket, nKBucketPos, nId);
     nTried++;
     info.fInTried = true;
     m_network_counts[info.GetNetwork()].n_tried++;
@@ -601,7 +670,7 @@ bool AddrManImpl::AddSingle(const CAddress& addr, const CNetAddr& source, std::c
     bool fInsert = vvNew[nUBucket][nUBucketPos] == -1;
     if (vvNew[nUBucket][nUBucketPos] != nId) {
         if (!fInsert) {
-            AddrInfo& infoExisting = mapInfo[vvNew[nUBucket][nUBucketPos]];
+            AddrInfo& infoExisting = m_infos[vvNew[nUBucket][nUBucketPos]];
             if (infoExisting.IsTerrible() || (infoExisting.nRefCount > 1 && pinfo->nRefCount == 0)) {
                 // Overwrite the existing new table entry.
                 fInsert = true;
@@ -610,7 +679,7 @@ bool AddrManImpl::AddSingle(const CAddress& addr, const CNetAddr& source, std::c
         if (fInsert) {
             ClearNew(nUBucket, nUBucketPos);
             pinfo->nRefCount++;
-            vvNew[nUBucket][nUBucketPos] = nId;
+            SetEntry(/*use_tried=*/false, nUBucket, nUBucketPos, nId);
             const auto mapped_as{m_netgroupman.GetMappedAS(addr)};
             LogDebug(BCLog::ADDRMAN, "Added %s%s to new[%i][%i]\n",
                      addr.ToStringAddrPort(), (mapped_as ? strprintf(" mapped to AS%i", mapped_as) : ""), nUBucket, nUBucketPos);
@@ -662,9 +731,9 @@ bool AddrManImpl::Good_(const CService& addr, bool test_before_evict, NodeSecond
             m_tried_collisions.insert(nId);
         }
         // Output the entry we'd be colliding with, for debugging purposes
-        auto colliding_entry = mapInfo.find(vvTried[tried_bucket][tried_bucket_pos]);
+        const AddrInfo& colliding_entry = m_infos[vvTried[tried_bucket][tried_bucket_pos]];
         LogDebug(BCLog::ADDRMAN, "Collision with %s while attempting to move %s to tried table. Collisions=%d\n",
-                 colliding_entry != mapInfo.end() ? colliding_entry->second.ToStringAddrPort() : "",
+                 colliding_entry.ToStringAddrPort(),
                  addr.ToStringAddrPort(),
                  m_tried_collisions.size());
         return false;
@@ -756,30 +825,25 @@ std::pair<CAddress, NodeSeconds> AddrManImpl::Select_(bool new_only, const std::
         int bucket = insecure_rand.randrange(bucket_count);
         int initial_position = insecure_rand.randrange(ADDRMAN_BUCKET_SIZE);
 
-        // Iterate over the positions of that bucket, starting at the initial one,
-        // and looping around.
-        int i, position;
-        nid_type node_id;
-        for (i = 0; i < ADDRMAN_BUCKET_SIZE; ++i) {
-            position = (initial_position + i) % ADDRMAN_BUCKET_SIZE;
-            node_id = GetEntry(search_tried, bucket, position);
-            if (node_id != -1) {
-                if (!networks.empty()) {
-                    const auto it{mapInfo.find(node_id)};
-                    if (Assume(it != mapInfo.end()) && networks.contains(it->second.GetNetwork())) break;
-                } else {
-                    break;
-                }
+        // Iterate over the occupied positions of that bucket, starting at the
+        // initial one, and looping around.
+        const uint64_t occupied{search_tried ? m_tried_occupied[bucket] : m_new_occupied[bucket]};
+        nid_type node_id{-1};
+        for (uint64_t candidates{std::rotr(occupied, initial_position)}; candidates; candidates &= candidates - 1) {
+            const int position{(initial_position + std::countr_zero(candidates)) % ADDRMAN_BUCKET_SIZE};
+            const nid_type id{GetEntry(search_tried, bucket, position)};
+            if (networks.empty() || networks.contains(m_infos[id].GetNetwork())) {
+                node_id = id;
+                break;
             }
         }
 
         // If the bucket is entirely empty, start over with a (likely) different one.
-        if (i == ADDRMAN_BUCKET_SIZE) continue;
+        if (node_id == -1) continue;
 
         // Find the entry to return.
-        const auto it_found{mapInfo.find(node_id)};
-        assert(it_found != mapInfo.end());
-        const AddrInfo& info{it_found->second};
+        assert(IsUsedId(node_id));
+        const AddrInfo& info{m_infos[node_id]};
 
         // With probability GetChance() * chance_factor, return the entry.
         if (insecure_rand.randbits<30>() < chance_factor * info.GetChance() * (1 << 30)) {
@@ -809,6 +873,20 @@ nid_type AddrManImpl::GetEntry(bool use_tried, size_t bucket, size_t position) c
     return -1;
 }
 
+void AddrManImpl::SetEntry(bool use_tried, size_t bucket, size_t position, nid_type nId)
+{
+    AssertLockHeld(cs);
+
+    nid_type& entry{use_tried ? vvTried[bucket][position] : vvNew[bucket][position]};
+    uint64_t& occupied{use_tried ? m_tried_occupied[bucket] : m_new_occupied[bucket]};
+    entry = nId;
+    if (nId == -1) {
+        occupied &= ~(uint64_t{1} << position);
+    } else {
+        occupied |= uint64_t{1} << position;
+    }
+}
+
 std::vector<CAddress> AddrManImpl::GetAddr_(size_t max_addresses, size_t max_pct, std::optional<Network> network, const bool filtered) const
 {
     AssertLockHeld(cs);
@@ -833,10 +911,7 @@ std::vector<CAddress> AddrManImpl::GetAddr_(size_t max_addresses, size_t max_pct
 
         int nRndPos = insecure_rand.randrange(vRandom.size() - n) + n;
         SwapRandom(n, nRndPos);
-        const auto it{mapInfo.find(vRandom[n])};
-        assert(it != mapInfo.end());
-
-        const AddrInfo& ai{it->second};
+        const AddrInfo& ai{m_infos[vRandom[n]]};
 
         // Filter by network (optional)
         if (network != std::nullopt && ai.GetNetClass() != network) continue;
@@ -857,17 +932,15 @@ std::vector<std::pair<AddrInfo, AddressPosition>> AddrManImpl::GetEntries_(bool
     const int bucket_count = from_tried ? ADDRMAN_TRIED_BUCKET_COUNT : ADDRMAN_NEW_BUCKET_COUNT;
     std::vector<std::pair<AddrInfo, AddressPosition>> infos;
     for (int bucket = 0; bucket < bucket_count; ++bucket) {
-        for (int position = 0; position < ADDRMAN_BUCKET_SIZE; ++position) {
-            nid_type id = GetEntry(from_tried, bucket, position);
-            if (id >= 0) {
-                AddrInfo info = mapInfo.at(id);
-                AddressPosition location = AddressPosition(
-                    from_tried,
-                    /*multiplicity_in=*/from_tried ? 1 : info.nRefCount,
-                    bucket,
-                    position);
-                infos.emplace_back(info, location);
-            }
+        for (uint64_t occupied = from_tried ? m_tried_occupied[bucket] : m_new_occupied[bucket]; occupied; occupied &= occupied - 1) {
+            const int position = std::countr_zero(occupied);
+            const AddrInfo& info = m_infos[GetEntry(from_tried, bucket, position)];
+            AddressPosition location = AddressPosition(
+                from_tried,
+                /*multiplicity_in=*/from_tried ? 1 : info.nRefCount,
+                bucket,
+                position);
+            infos.emplace_back(info, location);
         }
     }
 
@@ -918,11 +991,11 @@ void AddrManImpl::ResolveCollisions_()
 
         bool erase_collision = false;
 
-        // If id_new not found in mapInfo remove it from m_tried_collisions
-        if (mapInfo.count(id_new) != 1) {
+        // If id_new not found in m_infos remove it from m_tried_collisions
+        if (!IsUsedId(id_new)) {
             erase_collision = true;
         } else {
-            AddrInfo& info_new = mapInfo[id_new];
+            AddrInfo& info_new = m_infos[id_new];
 
             // Which tried bucket to move the entry to.
             int tried_bucket = info_new.GetTriedBucket(nKey, m_netgroupman);
@@ -933,7 +1006,7 @@ void AddrManImpl::ResolveCollisions_()
 
                 // Get the to-be-evicted address that is being tested
                 nid_type id_old = vvTried[tried_bucket][tried_bucket_pos];
-                AddrInfo& info_old = mapInfo[id_old];
+                AddrInfo& info_old = m_infos[id_old];
 
                 const auto current_time{Now<NodeSeconds>()};
 
@@ -984,19 +1057,19 @@ std::pair<CAddress, NodeSeconds> AddrManImpl::SelectTriedCollision_()
     std::advance(it, insecure_rand.randrange(m_tried_collisions.size()));
     nid_type id_new = *it;
 
-    // If id_new not found in mapInfo remove it from m_tried_collisions
-    if (mapInfo.count(id_new) != 1) {
+    // If id_new not found in m_infos remove it from m_tried_collisions
+    if (!IsUsedId(id_new)) {
         m_tried_collisions.erase(it);
         return {};
     }
 
-    const AddrInfo& newInfo = mapInfo[id_new];
+    const AddrInfo& newInfo = m_infos[id_new];
 
     // which tried bucket to move the entry to
     int tried_bucket = newInfo.GetTriedBucket(nKey, m_netgroupman);
     int tried_bucket_pos = newInfo.GetBucketPosition(nKey, false, tried_bucket);
 
-    const AddrInfo& info_old = mapInfo[vvTried[tried_bucket][tried_bucket_pos]];
+    const AddrInfo& info_old = m_infos[vvTried[tried_bucket][tried_bucket_pos]];
     return {info_old, info_old.m_last_try};
 }
 
@@ -1074,9 +1147,13 @@ int AddrManImpl::CheckAddrman() const
     if (vRandom.size() != (size_t)(nTried + nNew))
         return -7;
 
-    for (const auto& entry : mapInfo) {
-        nid_type n = entry.first;
-        const AddrInfo& info = entry.second;
+    size_t free_ids = 0;
+    for (nid_type n = 0; n < static_cast<nid_type>(m_infos.size()); n++) {
+        const AddrInfo& info = m_infos[n];
+        if (!IsUsedId(n)) {
+            free_ids++;
+            continue;
+        }
         if (info.fInTried) {
             if (!TicksSinceEpoch<std::chrono::seconds>(info.m_last_success)) {
                 return -1;
@@ -1093,8 +1170,7 @@ int AddrManImpl::CheckAddrman() const
             mapNew[n] = info.nRefCount;
             local_counts[info.GetNetwork()].n_new++;
         }
-        const auto it{mapAddr.find(info)};
-        if (it == mapAddr.end() || it->second != n) {
+        if (m_addr_index[FindAddrSlot(info)] != n) {
             return -5;
         }
         if (info.nRandomPos < 0 || (size_t)info.nRandomPos >= vRandom.size() || vRandom[info.nRandomPos] != n)
@@ -1107,6 +1183,13 @@ int AddrManImpl::CheckAddrman() const
         }
     }
 
+    if (free_ids != m_free_ids.size() || m_addr_index_count != vRandom.size())
+        return -22;
+    for (const nid_type n : m_free_ids) {
+        if (IsUsedId(n))
+            return -22;
+    }
+
     if (setTried.size() != (size_t)nTried)
         return -9;
     if (mapNew.size() != (size_t)nNew)
@@ -1114,14 +1197,16 @@ int AddrManImpl::CheckAddrman() const
 
     for (int n = 0; n < ADDRMAN_TRIED_BUCKET_COUNT; n++) {
         for (int i = 0; i < ADDRMAN_BUCKET_SIZE; i++) {
+            if (((m_tried_occupied[n] >> i) & 1) != (vvTried[n][i] != -1))
+                return -23;
             if (vvTried[n][i] != -1) {
                 if (!setTried.count(vvTried[n][i]))
                     return -11;
-                const auto it{mapInfo.find(vvTried[n][i])};
-                if (it == mapInfo.end() || it->second.GetTriedBucket(nKey, m_netgroupman) != n) {
+                const AddrInfo& info = m_infos[vvTried[n][i]];
+                if (info.GetTriedBucket(nKey, m_netgroupman) != n) {
                     return -17;
                 }
-                if (it->second.GetBucketPosition(nKey, false, n) != i) {
+                if (info.GetBucketPosition(nKey, false, n) != i) {
                     return -18;
                 }
                 setTried.erase(vvTried[n][i]);
@@ -1131,11 +1216,12 @@ int AddrManImpl::CheckAddrman() const
 
     for (int n = 0; n < ADDRMAN_NEW_BUCKET_COUNT; n++) {
         for (int i = 0; i < ADDRMAN_BUCKET_SIZE; i++) {
+            if (((m_new_occupied[n] >> i) & 1) != (vvNew[n][i] != -1))
+                return -23;
             if (vvNew[n][i] != -1) {
                 if (!mapNew.count(vvNew[n][i]))
                     return -12;
-                const auto it{mapInfo.find(vvNew[n][i])};
-                if (it == mapInfo.end() || it->second.GetBucketPosition(nKey, true, n) != i) {
+                if (m_infos[vvNew[n][i]].GetBucketPosition(nKey, true, n) != i) {
                     return -19;
                 }
                 if (--mapNew[vvNew[n][i]] == 0)
@@ -14,6 +14,7 @@
 #include <uint256.h>
 #include <util/time.h>
 
+#include <cstddef>
 #include <cstdint>
 #include <optional>
 #include <set>
@@ -185,14 +186,22 @@ private:
     //! @note Don't increment this. Increment `lowest_compatible` in `Serialize()` instead.
     static constexpr uint8_t INCOMPATIBILITY_BASE = 32;
 
-    //! last used nId
-    nid_type nIdCount GUARDED_BY(cs){0};
+    //! table with information about all nIds, indexed by nId. Slots of deleted
+    //! entries have nRandomPos == -1, and are reused through m_free_ids.
+    std::vector<AddrInfo> m_infos GUARDED_BY(cs);
 
-    //! table with information about all nIds
-    std::unordered_map<nid_type, AddrInfo> mapInfo GUARDED_BY(cs);
+    //! nIds of the free slots in m_infos
+    std::vector<nid_type> m_free_ids GUARDED_BY(cs);
 
-    //! find an nId based on its network address and port.
-    std::unordered_map<CService, nid_type, CServiceHash> mapAddr GUARDED_BY(cs);
+    //! find an nId based on its network address and port. Open addressing hash
+    //! table with linear probing, whose empty slots are -1. Its size is a power
+    //! of two, and at most half of it is used.
+    std::vector<nid_type> m_addr_index GUARDED_BY(cs);
+
+    //! number of used slots in m_addr_index
+    size_t m_addr_index_count GUARDED_BY(cs){0};
+
+    const CServiceHash m_addr_hasher;
 
     //! randomly-ordered vector of all nIds
     //! This is mutable because it is unobservable outside the class, so any
@@ -211,6 +220,12 @@ private:
     //! list of "new" buckets
     nid_type vvNew[ADDRMAN_NEW_BUCKET_COUNT][ADDRMAN_BUCKET_SIZE] GUARDED_BY(cs);
 
+    static_assert(ADDRMAN_BUCKET_SIZE == 64, "bucket occupancy must fit in a uint64_t");
+
+    //! occupied positions of the "tried" and "new" buckets, one bit per position
+    uint64_t m_tried_occupied[ADDRMAN_TRIED_BUCKET_COUNT] GUARDED_BY(cs){};
+    uint64_t m_new_occupied[ADDRMAN_NEW_BUCKET_COUNT] GUARDED_BY(cs){};
+
     //! last time Good was called (memory only). Initially set to 1 so that "never" is strictly worse.
     NodeSeconds m_last_good GUARDED_BY(cs){1s};
 
@@ -234,7 +249,25 @@ private:
     //! Find an entry.
     AddrInfo* Find(const CService& addr, nid_type* pnId = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
-    //! Create a new entry and add it to the internal data structures mapInfo, mapAddr and vRandom.
+    //! Whether nId refers to an entry, rather than to a free slot of m_infos.
+    bool IsUsedId(nid_type nId) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    //! Allocate a slot of m_infos for info, and return its nId.
+    nid_type AllocateId(const AddrInfo& info) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    //! Return the slot of m_addr_index holding the nId of addr, or the empty slot where it belongs.
+    size_t FindAddrSlot(const CService& addr) const EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    //! Resize m_addr_index to hold at least count addresses.
+    void ReserveAddrIndex(size_t count) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    //! Map the address of an entry to its nId in m_addr_index.
+    void IndexAddr(nid_type nId) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    //! Remove an address from m_addr_index.
+    void UnindexAddr(const CService& addr) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
+    //! Create a new entry and add it to the internal data structures m_infos, m_addr_index and vRandom.
     AddrInfo* Create(const CAddress& addr, const CNetAddr& addrSource, nid_type* pnId = nullptr) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
     //! Swap two elements in vRandom.
@@ -267,6 +300,9 @@ private:
      * */
     nid_type GetEntry(bool use_tried, size_t bucket, size_t position) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 
+    //! Store nId, or -1 to clear it, at a position of either table, and update its occupancy.
+    void SetEntry(bool use_tried, size_t bucket, size_t position, nid_type nId) EXCLUSIVE_LOCKS_REQUIRED(cs);
+
     std::vector<CAddress> GetAddr_(size_t max_addresses, size_t max_pct, std::optional<Network> network, const bool filtered = true) const EXCLUSIVE_LOCKS_REQUIRED(cs);
 
     std::vector<std::pair<AddrInfo, AddressPosition>> GetEntries_(bool from_tried) const EXCLUSIVE_LOCKS_REQUIRED(cs);
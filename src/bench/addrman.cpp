@@ -11,6 +11,7 @@
 #include <protocol.h>
 #include <random.h>
 #include <span.h>
+#include <streams.h>
 #include <uint256.h>
 #include <util/check.h>
 #include <util/time.h>
@@ -175,9 +176,41 @@ static void AddrManAddThenGood(benchmark::Bench& bench)
     });
 }
 
+static void AddrManSerialize(benchmark::Bench& bench)
+{
+    AddrMan addrman{EMPTY_NETGROUPMAN, /*deterministic=*/false, ADDRMAN_CONSISTENCY_CHECK_RATIO};
+
+    FillAddrMan(addrman);
+
+    bench.run([&] {
+        DataStream stream{};
+        stream << addrman;
+        assert(!stream.empty());
+    });
+}
+
+// Loading peers.dat, which is done once at startup.
+static void AddrManDeserialize(benchmark::Bench& bench)
+{
+    AddrMan addrman{EMPTY_NETGROUPMAN, /*deterministic=*/false, ADDRMAN_CONSISTENCY_CHECK_RATIO};
+
+    FillAddrMan(addrman);
+    DataStream serialized{};
+    serialized << addrman;
+
+    bench.run([&] {
+        DataStream stream{serialized};
+        AddrMan loaded{EMPTY_NETGROUPMAN, /*deterministic=*/false, ADDRMAN_CONSISTENCY_CHECK_RATIO};
+        stream >> loaded;
+        assert(loaded.Size() == addrman.Size());
+    });
+}
+
 BENCHMARK(AddrManAdd, benchmark::PriorityLevel::HIGH);
 BENCHMARK(AddrManSelect, benchmark::PriorityLevel::HIGH);
 BENCHMARK(AddrManSelectFromAlmostEmpty, benchmark::PriorityLevel::HIGH);
 BENCHMARK(AddrManSelectByNetwork, benchmark::PriorityLevel::HIGH);
 BENCHMARK(AddrManGetAddr, benchmark::PriorityLevel::HIGH);
 BENCHMARK(AddrManAddThenGood, benchmark::PriorityLevel::HIGH);
+BENCHMARK(AddrManSerialize, benchmark::PriorityLevel::HIGH);
+BENCHMARK(AddrManDeserialize, benchmark::PriorityLevel::HIGH);
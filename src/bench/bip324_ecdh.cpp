@@ -3,14 +3,21 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <bench/bench.h>
+#include <bip324.h>
 #include <key.h>
 #include <pubkey.h>
 #include <random.h>
 #include <span.h>
+#include <util/threadpool.h>
 
 #include <algorithm>
 #include <array>
+#include <cassert>
 #include <cstddef>
+#include <deque>
+#include <future>
+#include <optional>
+#include <vector>
 
 static void BIP324_ECDH(benchmark::Bench& bench)
 {
@@ -46,4 +53,47 @@ static void BIP324_ECDH(benchmark::Bench& bench)
     });
 }
 
+/** Key exchanges of many connections arriving at once, on the calling thread or on a pool. */
+static void BIP324HandshakeBurst(benchmark::Bench& bench, bool use_pool)
+{
+    static constexpr int HANDSHAKES{100};
+    ECC_Context ecc_context{};
+    FastRandomContext rng{/*fDeterministic=*/true};
+
+    const CKey key{GenerateRandomKey()};
+    std::array<std::byte, 32> ent32;
+    rng.fillrand(ent32);
+    const EllSwiftPubKey our_ellswift{key.EllSwiftCreate(ent32)};
+    std::vector<EllSwiftPubKey> their_ellswifts;
+    for (int i = 0; i < HANDSHAKES; ++i) {
+        std::array<std::byte, EllSwiftPubKey::size()> ellswift_data;
+        rng.fillrand(ellswift_data);
+        their_ellswifts.emplace_back(ellswift_data);
+    }
+    std::optional<ThreadPool> pool;
+    if (use_pool) pool.emplace("bench", 2);
+
+    bench.batch(HANDSHAKES).unit("handshake").run([&] {
+        std::deque<BIP324Cipher> ciphers;
+        std::vector<std::future<ECDHSecret>> secrets;
+        for (const EllSwiftPubKey& their_ellswift : their_ellswifts) {
+            BIP324Cipher& cipher{ciphers.emplace_back(key, our_ellswift)};
+            if (pool) {
+                secrets.push_back(pool->Submit(cipher.GetECDHComputation(their_ellswift, /*initiator=*/false)));
+            } else {
+                cipher.Initialize(their_ellswift, /*initiator=*/false);
+            }
+        }
+        for (size_t i = 0; i < secrets.size(); ++i) {
+            ciphers[i].Initialize(secrets[i].get(), /*initiator=*/false);
+        }
+        assert(ciphers.back());
+    });
+}
+
+static void BIP324HandshakeBurstInline(benchmark::Bench& bench) { BIP324HandshakeBurst(bench, /*use_pool=*/false); }
+static void BIP324HandshakeBurstPool(benchmark::Bench& bench) { BIP324HandshakeBurst(bench, /*use_pool=*/true); }
+
 BENCHMARK(BIP324_ECDH, benchmark::PriorityLevel::HIGH);
+BENCHMARK(BIP324HandshakeBurstInline, benchmark::PriorityLevel::HIGH);
+BENCHMARK(BIP324HandshakeBurstPool, benchmark::PriorityLevel::HIGH);
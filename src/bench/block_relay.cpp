@@ -0,0 +1,72 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bench/data/block413567.raw.h>
+#include <blockencodings.h>
+#include <net.h>
+#include <netmessagemaker.h>
+#include <node/blockrelaycache.h>
+#include <primitives/block.h>
+#include <protocol.h>
+#include <serialize.h>
+#include <streams.h>
+#include <uint256.h>
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace {
+//! Number of peers a new block is relayed to.
+constexpr int RELAY_PEERS{100};
+
+//! Hand the message to the transport and drain the bytes it produces, like the socket handler does.
+void Send(Transport& transport, CSerializedNetMsg&& msg)
+{
+    const bool queued{transport.SetMessageToSend(msg)};
+    assert(queued);
+    while (true) {
+        const auto& [bytes, more, msg_type] = transport.GetBytesToSend(/*have_next_message=*/false);
+        if (bytes.empty()) break;
+        transport.MarkBytesSent(bytes.size());
+    }
+}
+
+/**
+ * Relay a new block to RELAY_PEERS peers: a cmpctblock announcement to every
+ * peer, followed by the full block for those who request it. Either every
+ * message is serialized per peer, or the messages are shared through the
+ * BlockRelayCache.
+ */
+void BlockRelayFanOut(benchmark::Bench& bench, bool cached)
+{
+    CBlock block;
+    DataStream{benchmark::data::block413567} >> TX_WITH_WITNESS(block);
+    const uint256 hash{block.GetHash()};
+    const CBlockHeaderAndShortTxIDs cmpctblock{block, /*nonce=*/0};
+
+    std::vector<std::unique_ptr<V1Transport>> transports;
+    for (int i = 0; i < RELAY_PEERS; ++i) transports.push_back(std::make_unique<V1Transport>(i));
+
+    bench.unit("block").run([&] {
+        node::BlockRelayCache cache;
+        const auto make_cmpctblock{[&] { return NetMsg::Make(NetMsgType::CMPCTBLOCK, cmpctblock); }};
+        const auto make_block{[&] { return NetMsg::Make(NetMsgType::BLOCK, TX_WITH_WITNESS(block)); }};
+        for (auto& transport : transports) {
+            Send(*transport, cached ? cache.Get({NetMsgType::CMPCTBLOCK, hash, {}}, make_cmpctblock) : make_cmpctblock());
+        }
+        for (int i = 0; i < RELAY_PEERS; i += 4) {
+            Send(*transports[i], cached ? cache.Get({NetMsgType::BLOCK, hash, {}}, make_block) : make_block());
+        }
+    });
+}
+} // namespace
+
+static void BlockRelayFanOutSerialize(benchmark::Bench& bench) { BlockRelayFanOut(bench, /*cached=*/false); }
+static void BlockRelayFanOutCached(benchmark::Bench& bench) { BlockRelayFanOut(bench, /*cached=*/true); }
+
+BENCHMARK(BlockRelayFanOutSerialize, benchmark::PriorityLevel::HIGH);
+BENCHMARK(BlockRelayFanOutCached, benchmark::PriorityLevel::HIGH);
@@ -0,0 +1,66 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <blockencodings.h>
+#include <consensus/amount.h>
+#include <kernel/cs_main.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <random.h>
+#include <script/script.h>
+#include <sync.h>
+#include <test/util/setup_common.h>
+#include <test/util/txmempool.h>
+#include <txmempool.h>
+#include <util/check.h>
+
+#include <cassert>
+#include <memory>
+#include <vector>
+
+/**
+ * Reconstruct a block of 3000 transactions from its compact block and a
+ * mempool of 50000 transactions, which contains the whole block.
+ */
+static void BlockEncodingsReconstruct(benchmark::Bench& bench)
+{
+    const auto testing_setup = MakeNoLogFileContext<const ChainTestingSetup>(ChainType::MAIN);
+    CTxMemPool& pool = *Assert(testing_setup->m_node.mempool);
+    FastRandomContext rng{/*fDeterministic=*/true};
+
+    CBlock block;
+    CMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vout.resize(1);
+    block.vtx.push_back(MakeTransactionRef(coinbase));
+    {
+        LOCK2(cs_main, pool.cs);
+        TestMemPoolEntryHelper entry;
+        for (int i = 0; i < 50'000; ++i) {
+            CMutableTransaction tx;
+            tx.vin.resize(1);
+            tx.vin[0].prevout.hash = Txid::FromUint256(rng.rand256());
+            tx.vin[0].scriptSig = CScript() << OP_1;
+            tx.vin[0].scriptWitness.stack.push_back({1});
+            tx.vout.resize(1);
+            tx.vout[0].scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+            tx.vout[0].nValue = i;
+            const CTransactionRef tx_r{MakeTransactionRef(tx)};
+            AddToMempool(pool, entry.FromTx(tx_r));
+            if (i % 16 == 0 && block.vtx.size() <= 3000) block.vtx.push_back(tx_r);
+        }
+    }
+    const CBlockHeaderAndShortTxIDs cmpctblock{block, rng.rand64()};
+    const std::vector<CTransactionRef> extra_txn;
+
+    bench.unit("block").run([&] {
+        PartiallyDownloadedBlock partial_block{&pool};
+        const auto status{partial_block.InitData(cmpctblock, extra_txn)};
+        assert(status == READ_STATUS_OK);
+        assert(partial_block.IsTxAvailable(block.vtx.size() - 1));
+    });
+}
+
+BENCHMARK(BlockEncodingsReconstruct, benchmark::PriorityLevel::HIGH);
@@ -0,0 +1,102 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bench/data/block413567.raw.h>
+#include <coins.h>
+#include <hash.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <random.h>
+#include <script/script.h>
+#include <serialize.h>
+#include <streams.h>
+#include <tinyformat.h>
+#include <undo.h>
+#include <uint256.h>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+static constexpr uint32_t BLOCK_HEIGHT{413'567};
+
+//! Undo data for the inputs of block 413567, with coins paying to the common
+//! script types, some of them reused within the block, and created mostly in
+//! recent blocks.
+static CBlockUndo CreateTestBlockUndo()
+{
+    DataStream stream{benchmark::data::block413567};
+    CBlock block;
+    stream >> TX_WITH_WITNESS(block);
+
+    FastRandomContext rng{/*fDeterministic=*/true};
+    std::vector<CScript> scripts;
+    CBlockUndo blockundo;
+    for (const auto& tx : block.vtx) {
+        if (tx->IsCoinBase()) continue;
+        CTxUndo& txundo{blockundo.vtxundo.emplace_back()};
+        for (size_t i{0}; i < tx->vin.size(); ++i) {
+            if (scripts.empty() || rng.randrange(4) != 0) {
+                switch (rng.randrange(3)) {
+                case 0: scripts.push_back(CScript() << OP_DUP << OP_HASH160 << rng.randbytes(20) << OP_EQUALVERIFY << OP_CHECKSIG); break;
+                case 1: scripts.push_back(CScript() << OP_HASH160 << rng.randbytes(20) << OP_EQUAL); break;
+                case 2: scripts.push_back(CScript() << OP_0 << rng.randbytes(20)); break;
+                }
+            }
+            const CScript& script{rng.randrange(4) == 0 ? scripts[rng.randrange(scripts.size())] : scripts.back()};
+            const uint32_t age{rng.randbool() ? uint32_t(rng.randrange(1'000)) : uint32_t(rng.randrange(BLOCK_HEIGHT))};
+            txundo.vprevout.emplace_back(CTxOut{CAmount(rng.randrange(100'000) * 1'000), script}, BLOCK_HEIGHT - age, /*fCoinBaseIn=*/false);
+        }
+    }
+    return blockundo;
+}
+
+static void BlockUndoRead(benchmark::Bench& bench, bool compact)
+{
+    DataStream data;
+    if (compact) {
+        data << Using<BlockUndoCompactFormatter>(CreateTestBlockUndo());
+    } else {
+        data << CreateTestBlockUndo();
+    }
+    // Deserialize through a HashVerifier, like BlockManager::ReadBlockUndo.
+    bench.unit(strprintf("block undo (%u bytes)", data.size())).run([&] {
+        SpanReader reader{data};
+        HashVerifier verifier{reader};
+        verifier << uint256::ONE;
+        CBlockUndo blockundo;
+        if (compact) {
+            verifier >> Using<BlockUndoCompactFormatter>(blockundo);
+        } else {
+            verifier >> blockundo;
+        }
+        assert(reader.empty());
+    });
+}
+
+static void BlockUndoWrite(benchmark::Bench& bench, bool compact)
+{
+    const CBlockUndo blockundo{CreateTestBlockUndo()};
+    DataStream data;
+    bench.unit("block undo").run([&] {
+        data.clear();
+        if (compact) {
+            data << Using<BlockUndoCompactFormatter>(blockundo);
+        } else {
+            data << blockundo;
+        }
+    });
+}
+
+static void BlockUndoReadPlain(benchmark::Bench& bench) { BlockUndoRead(bench, /*compact=*/false); }
+static void BlockUndoReadCompact(benchmark::Bench& bench) { BlockUndoRead(bench, /*compact=*/true); }
+static void BlockUndoWritePlain(benchmark::Bench& bench) { BlockUndoWrite(bench, /*compact=*/false); }
+static void BlockUndoWriteCompact(benchmark::Bench& bench) { BlockUndoWrite(bench, /*compact=*/true); }
+
+BENCHMARK(BlockUndoReadPlain, benchmark::PriorityLevel::HIGH);
+BENCHMARK(BlockUndoReadCompact, benchmark::PriorityLevel::HIGH);
+BENCHMARK(BlockUndoWritePlain, benchmark::PriorityLevel::HIGH);
+BENCHMARK(BlockUndoWriteCompact, benchmark::PriorityLevel::HIGH);
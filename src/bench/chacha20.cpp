@@ -4,10 +4,16 @@
 
 
 #include <bench/bench.h>
+#include <bip324.h>
 #include <crypto/chacha20.h>
 #include <crypto/chacha20poly1305.h>
+#include <key.h>
+#include <pubkey.h>
+#include <random.h>
 #include <span.h>
+#include <tinyformat.h>
 
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <vector>
@@ -41,6 +47,26 @@ static void FSCHACHA20POLY1305(benchmark::Bench& bench, size_t buffersize)
     });
 }
 
+static void BIP324_ENCRYPT(benchmark::Bench& bench, size_t buffersize)
+{
+    ECC_Context ecc_context{};
+    FastRandomContext rng{/*fDeterministic=*/true};
+
+    // Set up the sending side of an established v2 connection.
+    std::array<std::byte, 32> ent32;
+    rng.fillrand(ent32);
+    BIP324Cipher initiator{GenerateRandomKey(), ent32};
+    rng.fillrand(ent32);
+    BIP324Cipher responder{GenerateRandomKey(), ent32};
+    initiator.Initialize(responder.GetOurPubKey(), /*initiator=*/true);
+
+    std::vector<std::byte> contents(buffersize);
+    std::vector<std::byte> out(buffersize + BIP324Cipher::EXPANSION);
+    bench.batch(contents.size()).unit("byte").run([&] {
+        initiator.Encrypt(contents, {}, /*ignore=*/false, out);
+    });
+}
+
 static void CHACHA20_64BYTES(benchmark::Bench& bench)
 {
     CHACHA20(bench, BUFFER_SIZE_TINY);
@@ -56,6 +82,20 @@ static void CHACHA20_1MB(benchmark::Bench& bench)
     CHACHA20(bench, BUFFER_SIZE_LARGE);
 }
 
+static void CHACHA20_1MB_STANDARD(benchmark::Bench& bench)
+{
+    bench.name(strprintf("%s using the '%s' ChaCha20 implementation", __func__, ChaCha20AutoDetect(chacha20_implementation::STANDARD)));
+    CHACHA20(bench, BUFFER_SIZE_LARGE);
+    ChaCha20AutoDetect();
+}
+
+static void CHACHA20_1MB_AVX2(benchmark::Bench& bench)
+{
+    bench.name(strprintf("%s using the '%s' ChaCha20 implementation", __func__, ChaCha20AutoDetect(chacha20_implementation::USE_AVX2)));
+    CHACHA20(bench, BUFFER_SIZE_LARGE);
+    ChaCha20AutoDetect();
+}
+
 static void FSCHACHA20POLY1305_64BYTES(benchmark::Bench& bench)
 {
     FSCHACHA20POLY1305(bench, BUFFER_SIZE_TINY);
@@ -71,9 +111,29 @@ static void FSCHACHA20POLY1305_1MB(benchmark::Bench& bench)
     FSCHACHA20POLY1305(bench, BUFFER_SIZE_LARGE);
 }
 
+static void BIP324_ENCRYPT_64BYTES(benchmark::Bench& bench)
+{
+    BIP324_ENCRYPT(bench, BUFFER_SIZE_TINY);
+}
+
+static void BIP324_ENCRYPT_256BYTES(benchmark::Bench& bench)
+{
+    BIP324_ENCRYPT(bench, BUFFER_SIZE_SMALL);
+}
+
+static void BIP324_ENCRYPT_1MB(benchmark::Bench& bench)
+{
+    BIP324_ENCRYPT(bench, BUFFER_SIZE_LARGE);
+}
+
 BENCHMARK(CHACHA20_64BYTES, benchmark::PriorityLevel::HIGH);
 BENCHMARK(CHACHA20_256BYTES, benchmark::PriorityLevel::HIGH);
 BENCHMARK(CHACHA20_1MB, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CHACHA20_1MB_STANDARD, benchmark::PriorityLevel::HIGH);
+BENCHMARK(CHACHA20_1MB_AVX2, benchmark::PriorityLevel::HIGH);
 BENCHMARK(FSCHACHA20POLY1305_64BYTES, benchmark::PriorityLevel::HIGH);
 BENCHMARK(FSCHACHA20POLY1305_256BYTES, benchmark::PriorityLevel::HIGH);
 BENCHMARK(FSCHACHA20POLY1305_1MB, benchmark::PriorityLevel::HIGH);
+BENCHMARK(BIP324_ENCRYPT_64BYTES, benchmark::PriorityLevel::HIGH);
+BENCHMARK(BIP324_ENCRYPT_256BYTES, benchmark::PriorityLevel::HIGH);
+BENCHMARK(BIP324_ENCRYPT_1MB, benchmark::PriorityLevel::HIGH);
@@ -8,6 +8,7 @@
 #include <common/args.h>
 #include <consensus/validation.h>
 #include <primitives/block.h>
+#include <primitives/block_view.h>
 #include <primitives/transaction.h>
 #include <serialize.h>
 #include <span.h>
@@ -19,6 +20,7 @@
 #include <cstddef>
 #include <memory>
 #include <optional>
+#include <span>
 #include <vector>
 
 // These are the two major time-sinks which happen after we have fully received
@@ -39,6 +41,34 @@ static void DeserializeBlockTest(benchmark::Bench& bench)
     });
 }
 
+/** A stream that hides the bytes it reads, so that transactions are hashed by
+ *  serializing them again, as for blocks read from a file. */
+class OpaqueReader
+{
+    SpanReader m_reader;
+
+public:
+    explicit OpaqueReader(std::span<const std::byte> data) : m_reader{data} {}
+
+    template <typename T>
+    OpaqueReader& operator>>(T&& obj)
+    {
+        ::Unserialize(*this, obj);
+        return *this;
+    }
+
+    void read(std::span<std::byte> dst) { m_reader.read(dst); }
+    void ignore(size_t n) { m_reader.ignore(n); }
+};
+
+static void DeserializeBlockReserializeTest(benchmark::Bench& bench)
+{
+    bench.unit("block").run([&] {
+        CBlock block;
+        OpaqueReader{benchmark::data::block413567} >> TX_WITH_WITNESS(block);
+    });
+}
+
 static void DeserializeAndCheckBlockTest(benchmark::Bench& bench)
 {
     DataStream stream(benchmark::data::block413567);
@@ -60,5 +90,15 @@ static void DeserializeAndCheckBlockTest(benchmark::Bench& bench)
     });
 }
 
+static void DeserializeBlockViewTest(benchmark::Bench& bench)
+{
+    bench.unit("block").run([&] {
+        const BlockView view{benchmark::data::block413567};
+        ankerl::nanobench::doNotOptimizeAway(view.Transactions().size());
+    });
+}
+
 BENCHMARK(DeserializeBlockTest, benchmark::PriorityLevel::HIGH);
+BENCHMARK(DeserializeBlockViewTest, benchmark::PriorityLevel::HIGH);
+BENCHMARK(DeserializeBlockReserializeTest, benchmark::PriorityLevel::HIGH);
 BENCHMARK(DeserializeAndCheckBlockTest, benchmark::PriorityLevel::HIGH);
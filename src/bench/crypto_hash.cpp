@@ -11,12 +11,14 @@
 #include <crypto/sha3.h>
 #include <crypto/sha512.h>
 #include <crypto/siphash.h>
+#include <hash.h>
 #include <random.h>
 #include <span.h>
 #include <tinyformat.h>
 #include <uint256.h>
 
 #include <cstdint>
+#include <span>
 #include <vector>
 
 /* Number of bytes to hash per iteration */
@@ -190,6 +192,39 @@ static void SHA512(benchmark::Bench& bench)
     });
 }
 
+/** Hash the transactions of a block, from 60 to 600 bytes long. */
+static std::vector<std::vector<uint8_t>> MultiMessages()
+{
+    FastRandomContext rng{/*fDeterministic=*/true};
+    std::vector<std::vector<uint8_t>> messages(2000);
+    for (auto& message : messages) message = rng.randbytes(60 + rng.randrange(540));
+    return messages;
+}
+
+static void SHA256DMulti_2000(benchmark::Bench& bench, sha256_implementation::UseImplementation implementation, bool multi)
+{
+    bench.name(strprintf("%s using the '%s' SHA256 implementation", multi ? "SHA256DMulti_2000" : "SHA256D_2000", SHA256AutoDetect(implementation)));
+    const auto data{MultiMessages()};
+    std::vector<std::span<const uint8_t>> messages{data.begin(), data.end()};
+    std::vector<uint8_t> out(32 * messages.size());
+    bench.batch(messages.size()).unit("message").run([&] {
+        if (multi) {
+            SHA256DMulti(out.data(), messages);
+        } else {
+            for (size_t i = 0; i < messages.size(); ++i) CHash256().Write(messages[i]).Finalize({out.data() + 32 * i, 32});
+        }
+    });
+    SHA256AutoDetect();
+}
+
+static void SHA256D_2000_STANDARD(benchmark::Bench& bench) { SHA256DMulti_2000(bench, sha256_implementation::STANDARD, false); }
+static void SHA256D_2000_AVX2(benchmark::Bench& bench) { SHA256DMulti_2000(bench, sha256_implementation::USE_SSE4_AND_AVX2, false); }
+static void SHA256D_2000_SHANI(benchmark::Bench& bench) { SHA256DMulti_2000(bench, sha256_implementation::USE_SSE4_AND_SHANI, false); }
+static void SHA256DMulti_2000_STANDARD(benchmark::Bench& bench) { SHA256DMulti_2000(bench, sha256_implementation::STANDARD, true); }
+static void SHA256DMulti_2000_SSE4(benchmark::Bench& bench) { SHA256DMulti_2000(bench, sha256_implementation::USE_SSE4, true); }
+static void SHA256DMulti_2000_AVX2(benchmark::Bench& bench) { SHA256DMulti_2000(bench, sha256_implementation::USE_SSE4_AND_AVX2, true); }
+static void SHA256DMulti_2000_SHANI(benchmark::Bench& bench) { SHA256DMulti_2000(bench, sha256_implementation::USE_SSE4_AND_SHANI, true); }
+
 static void SipHash_32b(benchmark::Bench& bench)
 {
     FastRandomContext rng{/*fDeterministic=*/true};
@@ -280,6 +315,13 @@ BENCHMARK(SHA256D64_1024_STANDARD, benchmark::PriorityLevel::HIGH);
 BENCHMARK(SHA256D64_1024_SSE4, benchmark::PriorityLevel::HIGH);
 BENCHMARK(SHA256D64_1024_AVX2, benchmark::PriorityLevel::HIGH);
 BENCHMARK(SHA256D64_1024_SHANI, benchmark::PriorityLevel::HIGH);
+BENCHMARK(SHA256D_2000_STANDARD, benchmark::PriorityLevel::HIGH);
+BENCHMARK(SHA256D_2000_AVX2, benchmark::PriorityLevel::HIGH);
+BENCHMARK(SHA256D_2000_SHANI, benchmark::PriorityLevel::HIGH);
+BENCHMARK(SHA256DMulti_2000_STANDARD, benchmark::PriorityLevel::HIGH);
+BENCHMARK(SHA256DMulti_2000_SSE4, benchmark::PriorityLevel::HIGH);
+BENCHMARK(SHA256DMulti_2000_AVX2, benchmark::PriorityLevel::HIGH);
+BENCHMARK(SHA256DMulti_2000_SHANI, benchmark::PriorityLevel::HIGH);
 
 BENCHMARK(MuHash, benchmark::PriorityLevel::HIGH);
 BENCHMARK(MuHashMul, benchmark::PriorityLevel::HIGH);
@@ -0,0 +1,104 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://opensource.org/license/mit/.
+
+#include <bench/bench.h>
+#include <dbwrapper.h>
+#include <random.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+//! Coin-like entries: 33 byte keys and ~64 byte values, written in batches as
+//! during a chainstate flush.
+static constexpr size_t ENTRIES_PER_BATCH{1000};
+
+static std::unique_ptr<CDBWrapper> MakeBenchDB(const BasicTestingSetup& setup, DBOptions options)
+{
+    return std::make_unique<CDBWrapper>(DBParams{
+        .path = setup.m_args.GetDataDirNet() / fs::u8path("bench_" + DBEngineName(options.engine)),
+        .cache_bytes = 8 << 20,
+        .wipe_data = true,
+        .obfuscate = true,
+        .options = options});
+}
+
+static void DBWriteBatch(benchmark::Bench& bench, DBEngine engine)
+{
+    const auto testing_setup{MakeNoLogFileContext<const BasicTestingSetup>()};
+    const auto db{MakeBenchDB(*testing_setup, {.engine = engine})};
+    FastRandomContext rng{/*fDeterministic=*/true};
+    const std::vector<std::byte> value{rng.randbytes<std::byte>(64)};
+
+    bench.batch(ENTRIES_PER_BATCH).unit("entry").run([&] {
+        CDBBatch batch{*db};
+        for (size_t i{0}; i < ENTRIES_PER_BATCH; ++i) {
+            batch.Write(std::make_pair(uint8_t{'C'}, rng.rand256()), value);
+        }
+        db->WriteBatch(batch);
+    });
+}
+
+static void DBRandomRead(benchmark::Bench& bench, DBEngine engine)
+{
+    const auto testing_setup{MakeNoLogFileContext<const BasicTestingSetup>()};
+    const auto db{MakeBenchDB(*testing_setup, {.engine = engine})};
+    FastRandomContext rng{/*fDeterministic=*/true};
+    const std::vector<std::byte> value{rng.randbytes<std::byte>(64)};
+
+    std::vector<uint256> keys;
+    for (int b{0}; b < 100; ++b) {
+        CDBBatch batch{*db};
+        for (size_t i{0}; i < ENTRIES_PER_BATCH; ++i) {
+            keys.push_back(rng.rand256());
+            batch.Write(std::make_pair(uint8_t{'C'}, keys.back()), value);
+        }
+        db->WriteBatch(batch);
+    }
+
+    std::vector<std::byte> read_value;
+    bench.run([&] {
+        const bool found{db->Read(std::make_pair(uint8_t{'C'}, keys[rng.randrange(keys.size())]), read_value)};
+        assert(found);
+    });
+}
+
+//! Keep writing new entries for long enough that LevelDB compacts into the
+//! deeper levels, so that the time spent in write stalls and compactions shows.
+static void DBSustainedWrite(benchmark::Bench& bench, DBOptions options)
+{
+    const auto testing_setup{MakeNoLogFileContext<const BasicTestingSetup>()};
+    FastRandomContext rng{/*fDeterministic=*/true};
+    const std::vector<std::byte> value{rng.randbytes<std::byte>(64)};
+
+    bench.batch(ENTRIES_PER_BATCH * 1000).unit("entry").epochs(1).epochIterations(1).run([&] {
+        const auto db{MakeBenchDB(*testing_setup, options)};
+        for (int b{0}; b < 1000; ++b) {
+            CDBBatch batch{*db};
+            for (size_t i{0}; i < ENTRIES_PER_BATCH; ++i) {
+                batch.Write(std::make_pair(uint8_t{'C'}, rng.rand256()), value);
+            }
+            db->WriteBatch(batch);
+        }
+    });
+}
+
+static void DBWriteBatchLevelDB(benchmark::Bench& bench) { DBWriteBatch(bench, DBEngine::LEVELDB); }
+static void DBWriteBatchLogStore(benchmark::Bench& bench) { DBWriteBatch(bench, DBEngine::LOGSTORE); }
+static void DBRandomReadLevelDB(benchmark::Bench& bench) { DBRandomRead(bench, DBEngine::LEVELDB); }
+static void DBRandomReadLogStore(benchmark::Bench& bench) { DBRandomRead(bench, DBEngine::LOGSTORE); }
+static void DBSustainedWriteLevelDB(benchmark::Bench& bench) { DBSustainedWrite(bench, {}); }
+static void DBSustainedWriteLevelDBSubcompactions(benchmark::Bench& bench) { DBSustainedWrite(bench, {.compaction_threads = 4}); }
+static void DBSustainedWriteLevelDBDeferred(benchmark::Bench& bench) { DBSustainedWrite(bench, {.defer_compaction = true}); }
+
+BENCHMARK(DBWriteBatchLevelDB, benchmark::PriorityLevel::LOW);
+BENCHMARK(DBWriteBatchLogStore, benchmark::PriorityLevel::LOW);
+BENCHMARK(DBRandomReadLevelDB, benchmark::PriorityLevel::LOW);
+BENCHMARK(DBRandomReadLogStore, benchmark::PriorityLevel::LOW);
+BENCHMARK(DBSustainedWriteLevelDB, benchmark::PriorityLevel::LOW);
+BENCHMARK(DBSustainedWriteLevelDBSubcompactions, benchmark::PriorityLevel::LOW);
+BENCHMARK(DBSustainedWriteLevelDBDeferred, benchmark::PriorityLevel::LOW);
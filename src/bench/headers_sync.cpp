@@ -0,0 +1,111 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <arith_uint256.h>
+#include <bench/bench.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <common/args.h>
+#include <headerssync.h>
+#include <pow.h>
+#include <primitives/block.h>
+#include <uint256.h>
+#include <util/chaintype.h>
+#include <util/threadpool.h>
+#include <validation.h>
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace {
+//! Number of headers in a full headers message.
+constexpr size_t HEADERS_BATCH{2000};
+
+std::vector<CBlockHeader> GenerateHeaders(const CChainParams& params, size_t count)
+{
+    std::vector<CBlockHeader> headers;
+    uint256 prev_hash{params.GenesisBlock().GetHash()};
+    uint32_t time{params.GenesisBlock().nTime};
+    while (headers.size() < count) {
+        CBlockHeader& header{headers.emplace_back()};
+        header.nVersion = params.GenesisBlock().nVersion;
+        header.hashPrevBlock = prev_hash;
+        header.nTime = ++time;
+        header.nBits = params.GenesisBlock().nBits;
+        while (!CheckProofOfWork(header.GetHash(), header.nBits, params.GetConsensus())) ++header.nNonce;
+        prev_hash = header.GetHash();
+    }
+    return headers;
+}
+
+//! Hash and check the proof-of-work of a full headers message, as ProcessHeadersMessage does.
+void HeadersPoW(benchmark::Bench& bench, ThreadPool* pool)
+{
+    const auto params{CreateChainParams(ArgsManager{}, ChainType::REGTEST)};
+    const std::vector<CBlockHeader> headers{GenerateHeaders(*params, HEADERS_BATCH)};
+
+    bench.batch(headers.size()).unit("header").run([&] {
+        const std::vector<uint256> hashes{GetBlockHeaderHashes(headers, pool)};
+        assert(HasValidProofOfWork(headers, hashes, params->GetConsensus()));
+    });
+}
+
+//! Sync a chain of headers through both phases of HeadersSyncState.
+void HeadersPresyncRedownload(benchmark::Bench& bench, ThreadPool* pool)
+{
+    const auto params{CreateChainParams(ArgsManager{}, ChainType::REGTEST)};
+    const std::vector<CBlockHeader> headers{GenerateHeaders(*params, 10 * HEADERS_BATCH)};
+    CBlockIndex chain_start{params->GenesisBlock()};
+    chain_start.nChainWork = GetBlockProof(chain_start);
+    arith_uint256 chain_work{chain_start.nChainWork};
+    for (const CBlockHeader& header : headers) chain_work += GetBlockProof(CBlockIndex{header});
+
+    bench.batch(2 * headers.size()).unit("header").run([&] {
+        HeadersSyncState sync{/*id=*/0, params->GetConsensus(), &chain_start, chain_work};
+        size_t accepted{0};
+        for (const auto state : {HeadersSyncState::State::PRESYNC, HeadersSyncState::State::REDOWNLOAD}) {
+            assert(sync.GetState() == state);
+            for (size_t i = 0; i < headers.size(); i += HEADERS_BATCH) {
+                const std::vector<CBlockHeader> batch(headers.begin() + i, headers.begin() + i + HEADERS_BATCH);
+                const std::vector<uint256> hashes{GetBlockHeaderHashes(batch, pool)};
+                assert(HasValidProofOfWork(batch, hashes, params->GetConsensus()));
+                const auto result{sync.ProcessNextHeaders(batch, hashes, /*full_headers_message=*/true)};
+                assert(result.success);
+                accepted += result.pow_validated_headers.size();
+            }
+        }
+        assert(accepted == headers.size());
+    });
+}
+
+void HeadersPoWSerial(benchmark::Bench& bench)
+{
+    HeadersPoW(bench, nullptr);
+}
+
+void HeadersPoWParallel(benchmark::Bench& bench)
+{
+    ThreadPool pool{"headersbench", 3};
+    HeadersPoW(bench, &pool);
+}
+
+void HeadersPresyncRedownloadSerial(benchmark::Bench& bench)
+{
+    HeadersPresyncRedownload(bench, nullptr);
+}
+
+void HeadersPresyncRedownloadParallel(benchmark::Bench& bench)
+{
+    ThreadPool pool{"headersbench", 3};
+    HeadersPresyncRedownload(bench, &pool);
+}
+} // namespace
+
+BENCHMARK(HeadersPoWSerial, benchmark::PriorityLevel::HIGH);
+BENCHMARK(HeadersPoWParallel, benchmark::PriorityLevel::HIGH);
+BENCHMARK(HeadersPresyncRedownloadSerial, benchmark::PriorityLevel::HIGH);
+BENCHMARK(HeadersPresyncRedownloadParallel, benchmark::PriorityLevel::HIGH);
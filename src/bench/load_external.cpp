@@ -4,20 +4,30 @@
 
 #include <bench/bench.h>
 #include <bench/data/block413567.raw.h>
+#include <chain.h>
 #include <chainparams.h>
+#include <consensus/amount.h>
+#include <consensus/validation.h>
 #include <flatfile.h>
 #include <node/blockstorage.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <script/script.h>
+#include <script/solver.h>
 #include <span.h>
 #include <streams.h>
+#include <sync.h>
 #include <test/util/setup_common.h>
 #include <uint256.h>
 #include <util/fs.h>
 #include <validation.h>
 
+#include <cassert>
 #include <cstdint>
 #include <cstdio>
 #include <map>
 #include <memory>
+#include <optional>
 #include <stdexcept>
 #include <vector>
 
@@ -71,4 +81,54 @@ static void LoadExternalBlockFile(benchmark::Bench& bench)
     fs::remove(blkfile);
 }
 
+/**
+ * Measure a -loadblock import end to end: scanning, reading and deserializing
+ * the blocks, storing them, and connecting them to a fresh chainstate, as a
+ * reindex does. The time to set up the empty node is included.
+ */
+static void LoadExternalBlockFileConnect(benchmark::Bench& bench)
+{
+    constexpr int CHAIN_SIZE{200};
+
+    // Build a chain whose last blocks spend the mature coinbase outputs, and
+    // serialize it as in the block files.
+    DataStream blocks{};
+    {
+        const auto chain_setup{MakeNoLogFileContext<TestChain100Setup>()};
+        const CScript script{GetScriptForRawPubKey(chain_setup->coinbaseKey.GetPubKey())};
+        const std::vector<CTxOut> outputs(20, CTxOut{1 * COIN, script});
+        for (int i{0}; i < CHAIN_SIZE - COINBASE_MATURITY; ++i) {
+            const CTransactionRef& coinbase{chain_setup->m_coinbase_txns[i]};
+            const auto [tx, fee]{chain_setup->CreateValidTransaction({coinbase}, {COutPoint{coinbase->GetHash(), 0}}, /*input_height=*/i + 1,
+                                                                     {chain_setup->coinbaseKey}, outputs, /*feerate=*/std::nullopt, /*fee_output=*/std::nullopt)};
+            chain_setup->CreateAndProcessBlock({tx}, script);
+        }
+        ChainstateManager& chainman{*chain_setup->m_node.chainman};
+        LOCK(cs_main);
+        assert(chainman.ActiveHeight() == CHAIN_SIZE);
+        for (int height{1}; height <= CHAIN_SIZE; ++height) {
+            CBlock block;
+            assert(chainman.m_blockman.ReadBlock(block, *chainman.ActiveChain()[height]));
+            blocks << chainman.GetParams().MessageStart() << static_cast<uint32_t>(GetSerializeSize(TX_WITH_WITNESS(block))) << TX_WITH_WITNESS(block);
+        }
+    }
+
+    bench.run([&] {
+        const auto testing_setup{MakeNoLogFileContext<const TestingSetup>(ChainType::REGTEST)};
+        ChainstateManager& chainman{*testing_setup->m_node.chainman};
+        const fs::path blkfile{testing_setup->m_path_root / "blk.dat"};
+        {
+            AutoFile file{fsbridge::fopen(blkfile, "wb")};
+            file << std::span{blocks};
+            assert(file.fclose() == 0);
+        }
+        AutoFile file{fsbridge::fopen(blkfile, "rb")};
+        chainman.LoadExternalBlockFile(file);
+        BlockValidationState state;
+        assert(chainman.ActiveChainstate().ActivateBestChain(state));
+        assert(WITH_LOCK(cs_main, return chainman.ActiveHeight()) == CHAIN_SIZE);
+    });
+}
+
 BENCHMARK(LoadExternalBlockFile, benchmark::PriorityLevel::HIGH);
+BENCHMARK(LoadExternalBlockFileConnect, benchmark::PriorityLevel::HIGH);
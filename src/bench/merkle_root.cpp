@@ -6,6 +6,7 @@
 #include <consensus/merkle.h>
 #include <random.h>
 #include <uint256.h>
+#include <util/threadpool.h>
 
 #include <vector>
 
@@ -24,4 +25,56 @@ static void MerkleRoot(benchmark::Bench& bench)
     });
 }
 
+static void MerkleRootParallel(benchmark::Bench& bench)
+{
+    FastRandomContext rng(true);
+    std::vector<uint256> leaves;
+    leaves.resize(9001);
+    for (auto& item : leaves) {
+        item = rng.rand256();
+    }
+    ThreadPool pool{"merklebench", 3};
+    bench.batch(leaves.size()).unit("leaf").run([&] {
+        bool mutation = false;
+        uint256 hash = ComputeMerkleRoot(std::vector<uint256>(leaves), &mutation, &pool);
+        leaves[mutation] = hash;
+    });
+}
+
+//! Replace the first of 9001 leaves, as when a new coinbase is put in a block
+//! template, and get the new root.
+static void MerkleBuilderSetFirst(benchmark::Bench& bench)
+{
+    FastRandomContext rng(true);
+    MerkleBuilder builder;
+    for (int i = 0; i < 9001; ++i) {
+        builder.Append(rng.rand256());
+    }
+    uint256 leaf = rng.rand256();
+    bench.run([&] {
+        builder.Set(0, leaf);
+        leaf = builder.Root();
+    });
+}
+
+static void MerkleBuilderAppend(benchmark::Bench& bench)
+{
+    FastRandomContext rng(true);
+    std::vector<uint256> leaves;
+    leaves.resize(9001);
+    for (auto& item : leaves) {
+        item = rng.rand256();
+    }
+    bench.batch(leaves.size()).unit("leaf").run([&] {
+        MerkleBuilder builder;
+        for (const auto& leaf : leaves) {
+            builder.Append(leaf);
+        }
+        ankerl::nanobench::doNotOptimizeAway(builder.Root());
+    });
+}
+
 BENCHMARK(MerkleRoot, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MerkleRootParallel, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MerkleBuilderSetFirst, benchmark::PriorityLevel::HIGH);
+BENCHMARK(MerkleBuilderAppend, benchmark::PriorityLevel::HIGH);
@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <bench/bench.h>
+#include <support/allocators/arena.h>
 #include <support/allocators/pool.h>
 
 #include <cstddef>
@@ -10,6 +11,7 @@
 #include <functional>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 template <typename Map>
 void BenchFillClearMap(benchmark::Bench& bench, Map& map)
@@ -49,5 +51,41 @@ static void PoolAllocator_StdUnorderedMapWithPoolResource(benchmark::Bench& benc
     BenchFillClearMap(bench, map);
 }
 
+/** Fill a vector per transaction of a block, like the script checks of ConnectBlock. */
+template <typename Vectors>
+void BenchPerBlockVectors(benchmark::Bench& bench, Vectors& vectors, auto make_vector, auto reset)
+{
+    constexpr size_t NUM_TXS{2000};
+
+    bench.batch(NUM_TXS).unit("tx").run([&] {
+        reset();
+        vectors.reserve(NUM_TXS);
+        for (size_t i = 0; i < NUM_TXS; ++i) {
+            auto& vector = vectors.emplace_back(make_vector());
+            const size_t num_inputs{1 + i % 5};
+            vector.reserve(num_inputs);
+            for (size_t j = 0; j < num_inputs; ++j) vector.emplace_back(i, j);
+        }
+        vectors.clear();
+        vectors.shrink_to_fit();
+    });
+}
+
+static void ArenaAllocator_StdVectors(benchmark::Bench& bench)
+{
+    std::vector<std::vector<std::pair<uint64_t, uint64_t>>> vectors;
+    BenchPerBlockVectors(bench, vectors, [] { return std::vector<std::pair<uint64_t, uint64_t>>{}; }, [] {});
+}
+
+static void ArenaAllocator_VectorsWithArenaResource(benchmark::Bench& bench)
+{
+    using Vector = std::vector<std::pair<uint64_t, uint64_t>, ArenaAllocator<std::pair<uint64_t, uint64_t>>>;
+    ArenaResource arena;
+    std::vector<Vector, ArenaAllocator<Vector>> vectors{&arena};
+    BenchPerBlockVectors(bench, vectors, [&] { return Vector{&arena}; }, [&] { arena.Reset(); });
+}
+
 BENCHMARK(PoolAllocator_StdUnorderedMap, benchmark::PriorityLevel::HIGH);
 BENCHMARK(PoolAllocator_StdUnorderedMapWithPoolResource, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ArenaAllocator_StdVectors, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ArenaAllocator_VectorsWithArenaResource, benchmark::PriorityLevel::HIGH);
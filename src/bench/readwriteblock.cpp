@@ -6,17 +6,22 @@
 #include <bench/data/block413567.raw.h>
 #include <flatfile.h>
 #include <node/blockstorage.h>
+#include <node/kernel_notifications.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <serialize.h>
 #include <span.h>
 #include <streams.h>
 #include <test/util/setup_common.h>
+#include <tinyformat.h>
+#include <util/check.h>
+#include <util/fs.h>
 #include <validation.h>
 
 #include <cassert>
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 
 static CBlock CreateTestBlock()
@@ -65,6 +70,80 @@ static void ReadRawBlockBench(benchmark::Bench& bench)
     });
 }
 
+//! A BlockManager storing blocks compressed, in a blocks directory of its own.
+struct CompressedBlockStorage {
+    node::KernelNotifications notifications;
+    std::unique_ptr<node::BlockManager> blockman;
+
+    explicit CompressedBlockStorage(TestingSetup& setup)
+        : notifications{Assert(setup.m_node.shutdown_request), setup.m_node.exit_status, *Assert(setup.m_node.warnings)}
+    {
+        const fs::path blocks_dir{setup.m_args.GetDataDirNet() / "blocks_compressed"};
+        fs::create_directories(blocks_dir);
+        blockman = std::make_unique<node::BlockManager>(*Assert(setup.m_node.shutdown_signal), node::BlockManager::Options{
+            .chainparams = setup.m_node.chainman->GetParams(),
+            .compress_blocks = true,
+            .blocks_dir = blocks_dir,
+            .notifications = notifications,
+            .block_tree_db_params = DBParams{
+                .path = blocks_dir / "index",
+                .cache_bytes = 0,
+            },
+        });
+    }
+};
+
+//! Report the space the block takes on disk with the compressed benchmarks.
+static std::string CompressedBlockUnit(const CBlock& block)
+{
+    DataStream block_data;
+    block_data << TX_WITH_WITNESS(block);
+    const auto payload{node::CompressBlockData(block_data)};
+    return strprintf("block (%u of %u bytes stored)", payload ? payload->size() : block_data.size(), block_data.size());
+}
+
+static void WriteBlockCompressedBench(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<TestingSetup>(ChainType::MAIN)};
+    CompressedBlockStorage storage{*testing_setup};
+    const CBlock block{CreateTestBlock()};
+    bench.unit(CompressedBlockUnit(block)).run([&] {
+        const auto pos{storage.blockman->WriteBlock(block, 413'567)};
+        assert(!pos.IsNull());
+    });
+}
+
+static void ReadBlockCompressedBench(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<TestingSetup>(ChainType::MAIN)};
+    CompressedBlockStorage storage{*testing_setup};
+    const auto& test_block{CreateTestBlock()};
+    const auto& expected_hash{test_block.GetHash()};
+    const auto& pos{storage.blockman->WriteBlock(test_block, 413'567)};
+    bench.unit(CompressedBlockUnit(test_block)).run([&] {
+        CBlock block;
+        const auto success{storage.blockman->ReadBlock(block, pos, expected_hash)};
+        assert(success);
+    });
+}
+
+static void ReadRawBlockCompressedBench(benchmark::Bench& bench)
+{
+    const auto testing_setup{MakeNoLogFileContext<TestingSetup>(ChainType::MAIN)};
+    CompressedBlockStorage storage{*testing_setup};
+    const auto test_block{CreateTestBlock()};
+    const auto pos{storage.blockman->WriteBlock(test_block, 413'567)};
+    std::vector<std::byte> block_data;
+    storage.blockman->ReadRawBlock(block_data, pos); // warmup
+    bench.unit(CompressedBlockUnit(test_block)).run([&] {
+        const auto success{storage.blockman->ReadRawBlock(block_data, pos)};
+        assert(success);
+    });
+}
+
 BENCHMARK(WriteBlockBench, benchmark::PriorityLevel::HIGH);
 BENCHMARK(ReadBlockBench, benchmark::PriorityLevel::HIGH);
 BENCHMARK(ReadRawBlockBench, benchmark::PriorityLevel::HIGH);
+BENCHMARK(WriteBlockCompressedBench, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ReadBlockCompressedBench, benchmark::PriorityLevel::HIGH);
+BENCHMARK(ReadRawBlockCompressedBench, benchmark::PriorityLevel::HIGH);
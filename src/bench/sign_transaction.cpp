@@ -8,6 +8,7 @@
 #include <key.h>
 #include <primitives/transaction.h>
 #include <pubkey.h>
+#include <random.h>
 #include <script/interpreter.h>
 #include <script/script.h>
 #include <script/sign.h>
@@ -18,6 +19,7 @@
 #include <util/translation.h>
 
 #include <cassert>
+#include <cstdint>
 #include <map>
 #include <vector>
 
@@ -73,6 +75,38 @@ static void SignTransactionSingleInput(benchmark::Bench& bench, InputType input_
 static void SignTransactionECDSA(benchmark::Bench& bench)   { SignTransactionSingleInput(bench, InputType::P2WPKH); }
 static void SignTransactionSchnorr(benchmark::Bench& bench) { SignTransactionSingleInput(bench, InputType::P2TR);   }
 
+static void SignatureHashSchnorrManyInputs(benchmark::Bench& bench)
+{
+    // A batched payout spending many taproot outputs, where computing the
+    // signature hashes of all inputs is dominated by the shared parts of the
+    // messages.
+    static constexpr int NUM_INPUTS{1000};
+    FastRandomContext rng{/*fDeterministic=*/true};
+    CMutableTransaction tx;
+    std::vector<CTxOut> spent_outputs;
+    for (int i = 0; i < NUM_INPUTS; ++i) {
+        tx.vin.emplace_back(COutPoint{Txid::FromUint256(rng.rand256()), uint32_t(i)});
+        spent_outputs.emplace_back(10000, GetScriptForDestination(WitnessV1Taproot{XOnlyPubKey{rng.rand256()}}));
+    }
+    for (int i = 0; i < 100; ++i) {
+        tx.vout.emplace_back(5000, GetScriptForDestination(WitnessV1Taproot{XOnlyPubKey{rng.rand256()}}));
+    }
+
+    bench.batch(NUM_INPUTS).unit("input").run([&] {
+        PrecomputedTransactionData txdata;
+        txdata.Init(tx, std::vector<CTxOut>{spent_outputs}, /*force=*/true);
+        ScriptExecutionData execdata;
+        execdata.m_annex_init = true;
+        execdata.m_annex_present = false;
+        uint256 hash;
+        for (uint32_t i = 0; i < NUM_INPUTS; ++i) {
+            const bool ret{SignatureHashSchnorr(hash, execdata, tx, i, SIGHASH_DEFAULT, SigVersion::TAPROOT, txdata, MissingDataBehavior::FAIL)};
+            assert(ret);
+        }
+        ankerl::nanobench::doNotOptimizeAway(hash);
+    });
+}
+
 static void SignSchnorrTapTweakBenchmark(benchmark::Bench& bench, bool use_null_merkle_root)
 {
     FastRandomContext rng;
@@ -102,5 +136,6 @@ static void SignSchnorrWithNullMerkleRoot(benchmark::Bench& bench)
 
 BENCHMARK(SignTransactionECDSA, benchmark::PriorityLevel::HIGH);
 BENCHMARK(SignTransactionSchnorr, benchmark::PriorityLevel::HIGH);
+BENCHMARK(SignatureHashSchnorrManyInputs, benchmark::PriorityLevel::HIGH);
 BENCHMARK(SignSchnorrWithMerkleRoot, benchmark::PriorityLevel::HIGH);
 BENCHMARK(SignSchnorrWithNullMerkleRoot, benchmark::PriorityLevel::HIGH);
@@ -0,0 +1,144 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <key.h>
+#include <net.h>
+#include <random.h>
+#include <span.h>
+#include <test/util/setup_common.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace {
+//! Maximum number of bytes the socket handler reads at once.
+constexpr size_t RECV_CHUNK{0x10000};
+//! Number of messages received per run.
+constexpr int NUM_MESSAGES{100};
+
+//! Append the bytes the transport has to send to wire, like the socket handler does.
+void Drain(Transport& transport, std::vector<uint8_t>& wire)
+{
+    while (true) {
+        const auto& [bytes, more, msg_type] = transport.GetBytesToSend(/*have_next_message=*/false);
+        if (bytes.empty()) break;
+        wire.insert(wire.end(), bytes.begin(), bytes.end());
+        transport.MarkBytesSent(bytes.size());
+    }
+}
+
+//! Append NUM_MESSAGES messages with payloads of payload_size bytes, as sent by transport, to wire.
+void SendMessages(Transport& transport, size_t payload_size, std::vector<uint8_t>& wire)
+{
+    FastRandomContext rng{/*fDeterministic=*/true};
+    for (int i = 0; i < NUM_MESSAGES; ++i) {
+        CSerializedNetMsg msg;
+        msg.m_type = "block";
+        msg.data = rng.randbytes(payload_size);
+        const bool queued{transport.SetMessageToSend(msg)};
+        assert(queued);
+        Drain(transport, wire);
+    }
+}
+
+/**
+ * Receive wire with the transport the way the socket handler does: read at most
+ * RECV_CHUNK bytes at once, into the transport's receive buffer if it has one,
+ * and retrieve every completed message. Returns the number of messages.
+ */
+int Receive(Transport& transport, std::span<const uint8_t> wire, std::vector<uint8_t>& socket_buffer)
+{
+    int received{0};
+    while (!wire.empty()) {
+        std::span<uint8_t> recv_buf{transport.GetReceiveBuffer()};
+        if (recv_buf.empty()) recv_buf = socket_buffer;
+        recv_buf = recv_buf.first(std::min({recv_buf.size(), RECV_CHUNK, wire.size()}));
+        // Stands in for the read from the socket.
+        std::ranges::copy(wire.first(recv_buf.size()), recv_buf.begin());
+        wire = wire.subspan(recv_buf.size());
+        std::span<const uint8_t> bytes{recv_buf};
+        while (!bytes.empty()) {
+            const bool ok{transport.ReceivedBytes(bytes)};
+            assert(ok);
+            if (transport.ReceivedMessageComplete()) {
+                bool reject{false};
+                const CNetMessage msg{transport.GetReceivedMessage(/*time=*/{}, reject)};
+                assert(!reject);
+                ++received;
+            }
+        }
+    }
+    return received;
+}
+
+void TransportReceiveV1(benchmark::Bench& bench, size_t payload_size)
+{
+    const auto testing_setup{MakeNoLogFileContext<>()};
+    V1Transport sender{/*node_id=*/0};
+    std::vector<uint8_t> wire;
+    SendMessages(sender, payload_size, wire);
+
+    std::vector<uint8_t> socket_buffer(RECV_CHUNK);
+    bench.batch(wire.size()).unit("byte").run([&] {
+        V1Transport receiver{/*node_id=*/1};
+        const int received{Receive(receiver, wire, socket_buffer)};
+        assert(received == NUM_MESSAGES);
+    });
+}
+
+/**
+ * The responder side of a v2 connection receiving the initiator's handshake
+ * and NUM_MESSAGES messages. The connection is recorded once, and every run
+ * replays it into a new responder, so that the handshake is part of every run.
+ */
+void TransportReceiveV2(benchmark::Bench& bench, size_t payload_size)
+{
+    const auto testing_setup{MakeNoLogFileContext<>()};
+    FastRandomContext rng{/*fDeterministic=*/true};
+    const CKey initiator_key{GenerateRandomKey()}, responder_key{GenerateRandomKey()};
+    const auto initiator_ent{rng.randbytes<32>()}, responder_ent{rng.randbytes<32>()};
+    const auto make_responder{[&] {
+        return std::make_unique<V2Transport>(/*nodeid=*/1, /*initiating=*/false, responder_key, responder_ent, /*garbage=*/std::vector<uint8_t>{});
+    }};
+
+    V2Transport initiator{/*nodeid=*/0, /*initiating=*/true, initiator_key, initiator_ent, /*garbage=*/{}};
+    const auto responder{make_responder()};
+    std::vector<uint8_t> wire, responder_wire;
+    std::vector<uint8_t> socket_buffer(RECV_CHUNK);
+    // Exchange keys, garbage terminators and version packets.
+    Drain(initiator, wire);
+    const int received{Receive(*responder, wire, socket_buffer)};
+    assert(received == 0);
+    Drain(*responder, responder_wire);
+    std::span<const uint8_t> to_initiator{responder_wire};
+    while (!to_initiator.empty()) {
+        const bool ok{initiator.ReceivedBytes(to_initiator)};
+        assert(ok);
+    }
+    Drain(initiator, wire);
+    SendMessages(initiator, payload_size, wire);
+
+    bench.batch(wire.size()).unit("byte").run([&] {
+        const auto receiver{make_responder()};
+        const int received{Receive(*receiver, wire, socket_buffer)};
+        assert(received == NUM_MESSAGES);
+    });
+}
+
+void TransportReceiveV1Small(benchmark::Bench& bench) { TransportReceiveV1(bench, 200); }
+void TransportReceiveV1Large(benchmark::Bench& bench) { TransportReceiveV1(bench, 1'000'000); }
+void TransportReceiveV2Small(benchmark::Bench& bench) { TransportReceiveV2(bench, 200); }
+void TransportReceiveV2Large(benchmark::Bench& bench) { TransportReceiveV2(bench, 1'000'000); }
+} // namespace
+
+BENCHMARK(TransportReceiveV1Small, benchmark::PriorityLevel::HIGH);
+BENCHMARK(TransportReceiveV1Large, benchmark::PriorityLevel::HIGH);
+BENCHMARK(TransportReceiveV2Small, benchmark::PriorityLevel::HIGH);
+BENCHMARK(TransportReceiveV2Large, benchmark::PriorityLevel::HIGH);
@@ -16,11 +16,12 @@
 
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 static constexpr node::TxOrphanage::Usage TINY_TX_WEIGHT{240};
 static constexpr int64_t APPROX_WEIGHT_PER_INPUT{200};
 
-// Creates a transaction with num_inputs inputs and 1 output, padded to target_weight. Use this function to maximize m_outpoint_to_orphan_it operations.
+// Creates a transaction with num_inputs inputs and 1 output, padded to target_weight. Use this function to maximize m_parent_to_children operations.
 // If num_inputs is 0, we maximize the number of inputs.
 static CTransactionRef MakeTransactionBulkedTo(unsigned int num_inputs, int64_t target_weight, FastRandomContext& det_rand)
 {
@@ -264,7 +265,61 @@ static void OrphanageEraseForPeer(benchmark::Bench& bench)
     OrphanageEraseAll(bench, /*block_or_disconnect=*/false);
 }
 
+static void OrphanageParentArrival(benchmark::Bench& bench)
+{
+    FastRandomContext det_rand{true};
+    const auto orphanage{node::MakeTxOrphanage(/*max_global_ann=*/node::DEFAULT_MAX_ORPHANAGE_LATENCY_SCORE, /*reserved_peer_usage=*/node::DEFAULT_RESERVED_ORPHAN_WEIGHT_PER_PEER)};
+    constexpr unsigned int NUM_PEERS{125};
+    constexpr unsigned int NUM_TXNS_PER_PEER = node::DEFAULT_MAX_ORPHANAGE_LATENCY_SCORE / NUM_PEERS;
+    constexpr unsigned int NUM_PARENTS{100};
+    constexpr unsigned int OUTPUTS_PER_PARENT{10};
+
+    // The missing parents, which arrive during the benchmark.
+    std::vector<CTransactionRef> parents;
+    parents.reserve(NUM_PARENTS);
+    for (unsigned int i{0}; i < NUM_PARENTS; ++i) {
+        CMutableTransaction tx;
+        tx.vin.emplace_back(Txid::FromUint256(det_rand.rand256()), 0);
+        tx.vout.resize(OUTPUTS_PER_PARENT);
+        parents.emplace_back(MakeTransactionRef(tx));
+    }
+
+    // Every orphan spends an output of 2 of the parents, and an output of a transaction that never arrives, so that it
+    // stays in the orphanage.
+    for (NodeId peer{0}; peer < NUM_PEERS; ++peer) {
+        for (unsigned int txnum{0}; txnum < NUM_TXNS_PER_PEER; ++txnum) {
+            CMutableTransaction tx;
+            for (int i{0}; i < 2; ++i) {
+                tx.vin.emplace_back(parents.at(det_rand.randrange(NUM_PARENTS))->GetHash(), det_rand.randrange(OUTPUTS_PER_PARENT));
+            }
+            tx.vin.emplace_back(Txid::FromUint256(det_rand.rand256()), 0);
+            tx.vout.resize(1);
+            assert(orphanage->AddTx(MakeTransactionRef(tx), peer));
+        }
+    }
+    assert(orphanage->TotalLatencyScore() <= orphanage->MaxGlobalLatencyScore());
+    assert(orphanage->TotalOrphanUsage() <= orphanage->MaxGlobalUsage());
+
+    bench.batch(NUM_PARENTS).unit("parent").run([&]() NO_THREAD_SAFETY_ANALYSIS {
+        // As each parent is accepted, its children are added to the worksets, and the ones announced by the peer
+        // that sent the parent are looked up as 1-parent-1-child packages.
+        for (const auto& parent : parents) {
+            for (const auto& [wtxid, peer] : orphanage->AddChildrenToWorkSet(*parent, det_rand)) {
+                const auto children{orphanage->GetChildrenFromSamePeer(parent, peer)};
+                assert(!children.empty());
+            }
+        }
+        // Reconsider every orphan, which leaves the orphanage in its original state.
+        node::TxOrphanage::Count num_reconsidered{0};
+        for (NodeId peer{0}; peer < NUM_PEERS; ++peer) {
+            while (orphanage->GetTxToReconsider(peer)) ++num_reconsidered;
+        }
+        assert(num_reconsidered == orphanage->CountAnnouncements());
+    });
+}
+
 BENCHMARK(OrphanageSinglePeerEviction, benchmark::PriorityLevel::LOW);
 BENCHMARK(OrphanageMultiPeerEviction, benchmark::PriorityLevel::LOW);
 BENCHMARK(OrphanageEraseForBlock, benchmark::PriorityLevel::LOW);
 BENCHMARK(OrphanageEraseForPeer, benchmark::PriorityLevel::LOW);
+BENCHMARK(OrphanageParentArrival, benchmark::PriorityLevel::LOW);
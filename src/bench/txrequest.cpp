@@ -0,0 +1,62 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <net.h>
+#include <primitives/transaction.h>
+#include <random.h>
+#include <txrequest.h>
+
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+//! Announce transactions from many peers, and request, receive and forget them like PeerManagerImpl does.
+static void TxRequestTrackerAnnounce(benchmark::Bench& bench)
+{
+    static constexpr int NUM_PEERS{125};
+    static constexpr int ANNOUNCERS_PER_TX{8};
+    static constexpr int NUM_TXS{2000};
+    static constexpr int TXS_PER_ROUND{20};
+
+    FastRandomContext rng{/*fDeterministic=*/true};
+    std::vector<GenTxid> txids;
+    for (int i = 0; i < NUM_TXS; ++i) txids.emplace_back(Wtxid::FromUint256(rng.rand256()));
+    std::vector<std::vector<NodeId>> announcers(NUM_TXS);
+    for (auto& peers : announcers) {
+        for (int i = 0; i < ANNOUNCERS_PER_TX; ++i) peers.push_back(rng.randrange(NUM_PEERS));
+    }
+
+    bench.batch(NUM_TXS * ANNOUNCERS_PER_TX).unit("announcement").run([&] {
+        TxRequestTracker tracker{/*deterministic=*/true};
+        std::chrono::microseconds now{1'000'000'000'000};
+        std::vector<std::pair<NodeId, GenTxid>> expired;
+        for (int tx = 0; tx < NUM_TXS; tx += TXS_PER_ROUND) {
+            for (int i = tx; i < tx + TXS_PER_ROUND; ++i) {
+                for (const NodeId peer : announcers[i]) {
+                    const bool preferred{peer % 4 == 0};
+                    tracker.ReceivedInv(peer, txids[i], preferred, now + (preferred ? 0s : 2s));
+                }
+            }
+            now += 100ms;
+            for (NodeId peer = 0; peer < NUM_PEERS; ++peer) {
+                for (const GenTxid& gtxid : tracker.GetRequestable(peer, now, &expired)) {
+                    tracker.RequestedTx(peer, gtxid.ToUint256(), now + 60s);
+                    // Most requests are answered; the others expire or get superseded.
+                    if (rng.randrange(4) != 0) {
+                        tracker.ReceivedResponse(peer, gtxid.ToUint256());
+                        tracker.ForgetTxHash(gtxid.ToUint256());
+                    }
+                }
+            }
+        }
+        for (NodeId peer = 0; peer < NUM_PEERS; ++peer) tracker.DisconnectedPeer(peer);
+        assert(tracker.Size() == 0);
+    });
+}
+
+BENCHMARK(TxRequestTrackerAnnounce, benchmark::PriorityLevel::HIGH);
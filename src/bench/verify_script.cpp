@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <bench/bench.h>
+#include <crypto/sha256.h>
 #include <hash.h>
 #include <key.h>
 #include <primitives/transaction.h>
@@ -18,14 +19,17 @@
 #include <cstdint>
 #include <vector>
 
-// Microbenchmark for verification of a basic P2WPKH script. Can be easily
-// modified to measure performance of other types of scripts.
-static void VerifyScriptBench(benchmark::Bench& bench)
+namespace {
+enum class SpendType { P2PKH, P2WPKH, P2WSH_MULTISIG, P2TR };
+
+// Microbenchmark for verification of a basic spend of the given type, either
+// with the fast paths of VerifyScript or with the general interpreter. The
+// difference is the per-input saving of the fast path.
+void VerifySpend(benchmark::Bench& bench, SpendType type, bool generic)
 {
     ECC_Context ecc_context{};
 
-    const uint32_t flags{SCRIPT_VERIFY_WITNESS | SCRIPT_VERIFY_P2SH};
-    const int witnessversion = 0;
+    const uint32_t flags{SCRIPT_VERIFY_WITNESS | SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_TAPROOT};
 
     // Key pair.
     CKey key;
@@ -34,37 +38,86 @@ static void VerifyScriptBench(benchmark::Bench& bench)
             0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1
         }
     };
-    key.Set(vchKey.begin(), vchKey.end(), false);
+    key.Set(vchKey.begin(), vchKey.end(), true);
     CPubKey pubkey = key.GetPubKey();
     uint160 pubkeyHash;
     CHash160().Write(pubkey).Finalize(pubkeyHash);
 
     // Script.
-    CScript scriptPubKey = CScript() << witnessversion << ToByteVector(pubkeyHash);
-    CScript scriptSig;
-    CScript witScriptPubkey = CScript() << OP_DUP << OP_HASH160 << ToByteVector(pubkeyHash) << OP_EQUALVERIFY << OP_CHECKSIG;
+    CScript keyHashScript = CScript() << OP_DUP << OP_HASH160 << ToByteVector(pubkeyHash) << OP_EQUALVERIFY << OP_CHECKSIG;
+    // A 1-of-2 multisig, which is executed by the interpreter on either path.
+    CScript multisigScript = CScript() << OP_1 << ToByteVector(pubkey) << ToByteVector(pubkey) << OP_2 << OP_CHECKMULTISIG;
+    uint256 multisigScriptHash;
+    CSHA256().Write(multisigScript.data(), multisigScript.size()).Finalize(multisigScriptHash.begin());
+    CScript scriptPubKey;
+    switch (type) {
+    case SpendType::P2PKH: scriptPubKey = keyHashScript; break;
+    case SpendType::P2WPKH: scriptPubKey = CScript() << OP_0 << ToByteVector(pubkeyHash); break;
+    case SpendType::P2WSH_MULTISIG: scriptPubKey = CScript() << OP_0 << ToByteVector(multisigScriptHash); break;
+    case SpendType::P2TR: scriptPubKey = CScript() << OP_1 << ToByteVector(XOnlyPubKey{pubkey}); break;
+    }
     const CMutableTransaction& txCredit = BuildCreditingTransaction(scriptPubKey, 1);
-    CMutableTransaction txSpend = BuildSpendingTransaction(scriptSig, CScriptWitness(), CTransaction(txCredit));
-    CScriptWitness& witness = txSpend.vin[0].scriptWitness;
-    witness.stack.emplace_back();
-    key.Sign(SignatureHash(witScriptPubkey, txSpend, 0, SIGHASH_ALL, txCredit.vout[0].nValue, SigVersion::WITNESS_V0), witness.stack.back());
-    witness.stack.back().push_back(static_cast<unsigned char>(SIGHASH_ALL));
-    witness.stack.push_back(ToByteVector(pubkey));
+    CMutableTransaction txSpend = BuildSpendingTransaction(CScript(), CScriptWitness(), CTransaction(txCredit));
+    PrecomputedTransactionData txdata;
+    txdata.Init(txSpend, {txCredit.vout[0]});
+
+    // Signature.
+    std::vector<unsigned char> sig;
+    switch (type) {
+    case SpendType::P2PKH:
+        key.Sign(SignatureHash(keyHashScript, txSpend, 0, SIGHASH_ALL, txCredit.vout[0].nValue, SigVersion::BASE), sig);
+        sig.push_back(static_cast<unsigned char>(SIGHASH_ALL));
+        txSpend.vin[0].scriptSig << sig << ToByteVector(pubkey);
+        break;
+    case SpendType::P2WPKH:
+        key.Sign(SignatureHash(keyHashScript, txSpend, 0, SIGHASH_ALL, txCredit.vout[0].nValue, SigVersion::WITNESS_V0), sig);
+        sig.push_back(static_cast<unsigned char>(SIGHASH_ALL));
+        txSpend.vin[0].scriptWitness.stack = {sig, ToByteVector(pubkey)};
+        break;
+    case SpendType::P2WSH_MULTISIG:
+        key.Sign(SignatureHash(multisigScript, txSpend, 0, SIGHASH_ALL, txCredit.vout[0].nValue, SigVersion::WITNESS_V0), sig);
+        sig.push_back(static_cast<unsigned char>(SIGHASH_ALL));
+        txSpend.vin[0].scriptWitness.stack = {{}, sig, ToByteVector(multisigScript)};
+        break;
+    case SpendType::P2TR: {
+        ScriptExecutionData execdata;
+        execdata.m_annex_init = true;
+        execdata.m_annex_present = false;
+        uint256 hash;
+        bool ret = SignatureHashSchnorr(hash, execdata, txSpend, 0, SIGHASH_DEFAULT, SigVersion::TAPROOT, txdata, MissingDataBehavior::ASSERT_FAIL);
+        assert(ret);
+        sig.resize(64);
+        ret = key.SignSchnorr(hash, sig, /*merkle_root=*/nullptr, uint256{});
+        assert(ret);
+        txSpend.vin[0].scriptWitness.stack = {sig};
+        break;
+    }
+    }
 
     // Benchmark.
+    const auto verify{generic ? VerifyScriptGeneric : VerifyScript};
     bench.run([&] {
         ScriptError err;
-        bool success = VerifyScript(
+        bool success = verify(
             txSpend.vin[0].scriptSig,
             txCredit.vout[0].scriptPubKey,
             &txSpend.vin[0].scriptWitness,
             flags,
-            MutableTransactionSignatureChecker(&txSpend, 0, txCredit.vout[0].nValue, MissingDataBehavior::ASSERT_FAIL),
+            MutableTransactionSignatureChecker(&txSpend, 0, txCredit.vout[0].nValue, txdata, MissingDataBehavior::ASSERT_FAIL),
             &err);
         assert(err == SCRIPT_ERR_OK);
         assert(success);
     });
 }
+} // namespace
+
+static void VerifyScriptP2PKH(benchmark::Bench& bench) { VerifySpend(bench, SpendType::P2PKH, /*generic=*/false); }
+static void VerifyScriptP2PKHGeneric(benchmark::Bench& bench) { VerifySpend(bench, SpendType::P2PKH, /*generic=*/true); }
+static void VerifyScriptP2WPKH(benchmark::Bench& bench) { VerifySpend(bench, SpendType::P2WPKH, /*generic=*/false); }
+static void VerifyScriptP2WPKHGeneric(benchmark::Bench& bench) { VerifySpend(bench, SpendType::P2WPKH, /*generic=*/true); }
+static void VerifyScriptP2WSHMultisig(benchmark::Bench& bench) { VerifySpend(bench, SpendType::P2WSH_MULTISIG, /*generic=*/false); }
+static void VerifyScriptP2TR(benchmark::Bench& bench) { VerifySpend(bench, SpendType::P2TR, /*generic=*/false); }
+static void VerifyScriptP2TRGeneric(benchmark::Bench& bench) { VerifySpend(bench, SpendType::P2TR, /*generic=*/true); }
 
 static void VerifyNestedIfScript(benchmark::Bench& bench)
 {
@@ -87,5 +140,11 @@ static void VerifyNestedIfScript(benchmark::Bench& bench)
     });
 }
 
-BENCHMARK(VerifyScriptBench, benchmark::PriorityLevel::HIGH);
+BENCHMARK(VerifyScriptP2PKH, benchmark::PriorityLevel::HIGH);
+BENCHMARK(VerifyScriptP2PKHGeneric, benchmark::PriorityLevel::HIGH);
+BENCHMARK(VerifyScriptP2WPKH, benchmark::PriorityLevel::HIGH);
+BENCHMARK(VerifyScriptP2WPKHGeneric, benchmark::PriorityLevel::HIGH);
+BENCHMARK(VerifyScriptP2WSHMultisig, benchmark::PriorityLevel::HIGH);
+BENCHMARK(VerifyScriptP2TR, benchmark::PriorityLevel::HIGH);
+BENCHMARK(VerifyScriptP2TRGeneric, benchmark::PriorityLevel::HIGH);
 BENCHMARK(VerifyNestedIfScript, benchmark::PriorityLevel::HIGH);
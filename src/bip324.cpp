@@ -32,14 +32,26 @@ BIP324Cipher::BIP324Cipher(const CKey& key, const EllSwiftPubKey& pubkey) noexce
     m_key(key), m_our_pubkey(pubkey) {}
 
 void BIP324Cipher::Initialize(const EllSwiftPubKey& their_pubkey, bool initiator, bool self_decrypt) noexcept
+{
+    // Perform ECDH to derive shared secret.
+    ECDHSecret ecdh_secret = m_key.ComputeBIP324ECDHSecret(their_pubkey, m_our_pubkey, initiator);
+    Initialize(ecdh_secret, initiator, self_decrypt);
+    memory_cleanse(ecdh_secret.data(), ecdh_secret.size());
+}
+
+std::function<ECDHSecret()> BIP324Cipher::GetECDHComputation(const EllSwiftPubKey& their_pubkey, bool initiator) const
+{
+    return [key = m_key, our_pubkey = m_our_pubkey, their_pubkey, initiator] {
+        return key.ComputeBIP324ECDHSecret(their_pubkey, our_pubkey, initiator);
+    };
+}
+
+void BIP324Cipher::Initialize(const ECDHSecret& ecdh_secret, bool initiator, bool self_decrypt) noexcept
 {
     // Determine salt (fixed string + network magic bytes)
     const auto& message_header = Params().MessageStart();
     std::string salt = std::string{"bitcoin_v2_shared_secret"} + std::string(std::begin(message_header), std::end(message_header));
 
-    // Perform ECDH to derive shared secret.
-    ECDHSecret ecdh_secret = m_key.ComputeBIP324ECDHSecret(their_pubkey, m_our_pubkey, initiator);
-
     // Derive encryption keys from shared secret, and initialize stream ciphers and AEADs.
     bool side = (initiator != self_decrypt);
     CHKDF_HMAC_SHA256_L32 hkdf(UCharCast(ecdh_secret.data()), ecdh_secret.size(), salt);
@@ -64,7 +76,6 @@ void BIP324Cipher::Initialize(const EllSwiftPubKey& their_pubkey, bool initiator
     hkdf.Expand32("session_id", UCharCast(m_session_id.data()));
 
     // Wipe all variables that contain information which could be used to re-derive encryption keys.
-    memory_cleanse(ecdh_secret.data(), ecdh_secret.size());
     memory_cleanse(hkdf_32_okm.data(), sizeof(hkdf_32_okm));
     memory_cleanse(&hkdf, sizeof(hkdf));
     m_key = CKey();
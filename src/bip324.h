@@ -7,6 +7,7 @@
 
 #include <array>
 #include <cstddef>
+#include <functional>
 #include <optional>
 
 #include <crypto/chacha20.h>
@@ -61,6 +62,17 @@ public:
      */
     void Initialize(const EllSwiftPubKey& their_pubkey, bool initiator, bool self_decrypt = false) noexcept;
 
+    /** Get a function computing the shared secret with the other side's public key, the costly
+     *  part of Initialize(). Only before Initialize().
+     *
+     * The function does not refer to this cipher, so it can run on another thread, even after
+     * the cipher is gone. Its result can be passed to Initialize().
+     */
+    std::function<ECDHSecret()> GetECDHComputation(const EllSwiftPubKey& their_pubkey, bool initiator) const;
+
+    /** Initialize with a shared secret from GetECDHComputation(). Can only be called once. */
+    void Initialize(const ECDHSecret& ecdh_secret, bool initiator, bool self_decrypt = false) noexcept;
+
     /** Determine whether this cipher is fully initialized. */
     explicit operator bool() const noexcept { return m_send_l_cipher.has_value(); }
 
@@ -79,7 +91,8 @@ public:
     /** Decrypt a packet. Only after Initialize().
      *
      * It must hold that input.size() + LENGTH_LEN == contents.size() + EXPANSION.
-     * Contents.size() must equal the length returned by DecryptLength.
+     * Contents.size() must equal the length returned by DecryptLength. Contents may be
+     * input.subspan(HEADER_LEN, contents.size()), to decrypt the packet in place.
      */
     bool Decrypt(std::span<const std::byte> input, std::span<const std::byte> aad, bool& ignore, std::span<std::byte> contents) noexcept;
 
@@ -15,8 +15,15 @@
 #include <txmempool.h>
 #include <validation.h>
 
+#include <bitset>
+#include <memory>
 #include <unordered_map>
 
+namespace {
+/** Number of bits of the filter of the short IDs of a compact block. 8 KiB fits in the L1 cache. */
+constexpr size_t SHORTID_FILTER_BITS{1 << 16};
+} // namespace
+
 CBlockHeaderAndShortTxIDs::CBlockHeaderAndShortTxIDs(const CBlock& block, const uint64_t nonce) :
         nonce(nonce),
         shorttxids(block.vtx.size() - 1), prefilledtxn(1), header(block) {
@@ -103,15 +110,24 @@ ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& c
     if (shorttxids.size() != cmpctblock.shorttxids.size())
         return READ_STATUS_FAILED; // Short ID collision
 
+    // Most of the mempool is not in the block. Rule out those transactions with
+    // a bitmap of the short IDs before looking them up in shorttxids, and scan
+    // the contiguous witness hashes of the mempool rather than the transactions,
+    // so that a mempool transaction costs a short ID and few cache misses.
+    auto shortid_filter{std::make_unique<std::bitset<SHORTID_FILTER_BITS>>()};
+    for (const uint64_t shortid : cmpctblock.shorttxids) shortid_filter->set(shortid % SHORTID_FILTER_BITS);
+
     std::vector<bool> have_txn(txn_available.size());
     {
     LOCK(pool->cs);
-    for (const auto& tx : pool->txns_randomized) {
-        uint64_t shortid = cmpctblock.GetShortID(tx->GetWitnessHash());
+    const auto& wtxids{pool->wtxids_randomized};
+    for (size_t i = 0; i < wtxids.size(); i++) {
+        uint64_t shortid = cmpctblock.GetShortID(wtxids[i]);
+        if (!shortid_filter->test(shortid % SHORTID_FILTER_BITS)) continue;
         std::unordered_map<uint64_t, uint16_t>::iterator idit = shorttxids.find(shortid);
         if (idit != shorttxids.end()) {
             if (!have_txn[idit->second]) {
-                txn_available[idit->second] = tx;
+                txn_available[idit->second] = pool->txns_randomized[i];
                 have_txn[idit->second]  = true;
                 mempool_count++;
             } else {
@@ -137,6 +153,7 @@ ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& c
             continue;
         }
         uint64_t shortid = cmpctblock.GetShortID(extra_txn[i]->GetWitnessHash());
+        if (!shortid_filter->test(shortid % SHORTID_FILTER_BITS)) continue;
         std::unordered_map<uint64_t, uint16_t>::iterator idit = shorttxids.find(shortid);
         if (idit != shorttxids.end()) {
             if (!have_txn[idit->second]) {
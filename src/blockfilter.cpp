@@ -9,6 +9,7 @@
 #include <crypto/siphash.h>
 #include <hash.h>
 #include <primitives/block.h>
+#include <primitives/block_view.h>
 #include <primitives/transaction.h>
 #include <script/script.h>
 #include <streams.h>
@@ -182,6 +183,17 @@ const std::string& ListBlockFilterTypes()
     return type_list;
 }
 
+static void AddSpentElements(GCSFilter::ElementSet& elements, const CBlockUndo& block_undo)
+{
+    for (const CTxUndo& tx_undo : block_undo.vtxundo) {
+        for (const Coin& prevout : tx_undo.vprevout) {
+            const CScript& script = prevout.out.scriptPubKey;
+            if (script.empty()) continue;
+            elements.emplace(script.begin(), script.end());
+        }
+    }
+}
+
 static GCSFilter::ElementSet BasicFilterElements(const CBlock& block,
                                                  const CBlockUndo& block_undo)
 {
@@ -195,14 +207,24 @@ static GCSFilter::ElementSet BasicFilterElements(const CBlock& block,
         }
     }
 
-    for (const CTxUndo& tx_undo : block_undo.vtxundo) {
-        for (const Coin& prevout : tx_undo.vprevout) {
-            const CScript& script = prevout.out.scriptPubKey;
-            if (script.empty()) continue;
+    AddSpentElements(elements, block_undo);
+    return elements;
+}
+
+static GCSFilter::ElementSet BasicFilterElements(const BlockView& block,
+                                                 const CBlockUndo& block_undo)
+{
+    GCSFilter::ElementSet elements;
+
+    for (const BlockTxView& tx : block.Transactions()) {
+        for (const TxOutView& txout : tx.vout) {
+            const std::span<const unsigned char> script = txout.scriptPubKey;
+            if (script.empty() || script[0] == OP_RETURN) continue;
             elements.emplace(script.begin(), script.end());
         }
     }
 
+    AddSpentElements(elements, block_undo);
     return elements;
 }
 
@@ -227,6 +249,16 @@ BlockFilter::BlockFilter(BlockFilterType filter_type, const CBlock& block, const
     m_filter = GCSFilter(params, BasicFilterElements(block, block_undo));
 }
 
+BlockFilter::BlockFilter(BlockFilterType filter_type, const BlockView& block, const CBlockUndo& block_undo)
+    : m_filter_type(filter_type), m_block_hash(block.header.GetHash())
+{
+    GCSFilter::Params params;
+    if (!BuildParams(params)) {
+        throw std::invalid_argument("unknown filter_type");
+    }
+    m_filter = GCSFilter(params, BasicFilterElements(block, block_undo));
+}
+
 bool BlockFilter::BuildParams(GCSFilter::Params& params) const
 {
     switch (m_filter_type) {
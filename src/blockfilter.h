@@ -18,6 +18,7 @@
 #include <uint256.h>
 #include <util/bytevectorhash.h>
 
+class BlockView;
 class CBlock;
 class CBlockUndo;
 
@@ -130,6 +131,7 @@ public:
 
     //! Construct a new BlockFilter of the specified type from a block.
     BlockFilter(BlockFilterType filter_type, const CBlock& block, const CBlockUndo& block_undo);
+    BlockFilter(BlockFilterType filter_type, const BlockView& block, const CBlockUndo& block_undo);
 
     BlockFilterType GetFilterType() const { return m_filter_type; }
     const uint256& GetBlockHash() const LIFETIMEBOUND { return m_block_hash; }
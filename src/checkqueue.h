@@ -168,8 +168,10 @@ public:
         return Loop(true /* master thread */);
     }
 
-    //! Add a batch of checks to the queue
-    void Add(std::vector<T>&& vChecks) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    //! Add a batch of checks to the queue. The checks are moved out of the
+    //! vector, which keeps its memory.
+    template <typename Alloc>
+    void Add(std::vector<T, Alloc>&& vChecks) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
     {
         if (vChecks.empty()) {
             return;
@@ -225,7 +227,8 @@ public:
         return ret;
     }
 
-    void Add(std::vector<T>&& vChecks)
+    template <typename Alloc>
+    void Add(std::vector<T, Alloc>&& vChecks)
     {
         m_queue.Add(std::move(vChecks));
     }
@@ -4,7 +4,13 @@
 
 #include <consensus/merkle.h>
 #include <hash.h>
+#include <primitives/block_view.h>
 #include <util/check.h>
+#include <util/threadpool.h>
+
+#include <algorithm>
+#include <future>
+#include <span>
 
 /*     WARNING! If you're reading this because you're learning about crypto
        and/or designing a new system that will use merkle trees, keep in mind
@@ -43,19 +49,61 @@
 */
 
 
-uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool* mutated) {
-    bool mutation = false;
-    while (hashes.size() > 1) {
-        if (mutated) {
-            for (size_t pos = 0; pos + 1 < hashes.size(); pos += 2) {
-                if (hashes[pos] == hashes[pos + 1]) mutation = true;
-            }
+/** Hash the pairs of a level of the tree in place, into its first half. */
+static void HashLevel(std::span<uint256> hashes, bool& mutation, bool check_mutation)
+{
+    if (check_mutation) {
+        for (size_t pos = 0; pos + 1 < hashes.size(); pos += 2) {
+            if (hashes[pos] == hashes[pos + 1]) mutation = true;
         }
-        if (hashes.size() & 1) {
-            hashes.push_back(hashes.back());
+    }
+    SHA256D64(hashes[0].begin(), hashes[0].begin(), hashes.size() / 2);
+    if (hashes.size() & 1) {
+        const uint256 last{hashes.back()};
+        hashes[hashes.size() / 2] = Hash(last, last);
+    }
+}
+
+/**
+ * Reduce a part of the leaves that starts at a multiple of 2^levels, and is
+ * either 2^levels long or the last part, to the hash at that many levels up,
+ * in hashes[0].
+ */
+static void ReduceLevels(std::span<uint256> hashes, int levels, bool& mutation, bool check_mutation)
+{
+    for (; levels > 0; --levels) {
+        HashLevel(hashes, mutation, check_mutation);
+        hashes = hashes.first((hashes.size() + 1) / 2);
+    }
+}
+
+uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool* mutated, ThreadPool* pool) {
+    bool mutation = false;
+    if (pool && pool->WorkersCount() > 0 && hashes.size() >= MIN_PARALLEL_MERKLE_LEAVES) {
+        // Split the leaves into one chunk per thread, each 2^levels long, so
+        // that no pair of a level below the chunk roots crosses chunks.
+        const size_t threads{pool->WorkersCount() + 1};
+        int levels = 0;
+        while ((hashes.size() >> levels) + 1 > threads) ++levels;
+        const size_t chunk_size{size_t{1} << levels};
+        const size_t chunks{(hashes.size() + chunk_size - 1) / chunk_size};
+        std::vector<std::future<bool>> futures;
+        for (size_t i = 1; i < chunks; ++i) {
+            const std::span chunk{std::span{hashes}.subspan(i * chunk_size, std::min(chunk_size, hashes.size() - i * chunk_size))};
+            futures.push_back(pool->Submit([chunk, levels, mutated] {
+                bool chunk_mutation = false;
+                ReduceLevels(chunk, levels, chunk_mutation, mutated);
+                return chunk_mutation;
+            }));
         }
-        SHA256D64(hashes[0].begin(), hashes[0].begin(), hashes.size() / 2);
-        hashes.resize(hashes.size() / 2);
+        ReduceLevels(std::span{hashes}.first(chunk_size), levels, mutation, mutated);
+        for (auto& future : futures) mutation |= future.get();
+        for (size_t i = 1; i < chunks; ++i) hashes[i] = hashes[i * chunk_size];
+        hashes.resize(chunks);
+    }
+    while (hashes.size() > 1) {
+        HashLevel(hashes, mutation, mutated);
+        hashes.resize((hashes.size() + 1) / 2);
     }
     if (mutated) *mutated = mutation;
     if (hashes.size() == 0) return uint256();
@@ -63,17 +111,27 @@ uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool* mutated) {
 }
 
 
-uint256 BlockMerkleRoot(const CBlock& block, bool* mutated)
+uint256 BlockMerkleRoot(const CBlock& block, bool* mutated, ThreadPool* pool)
 {
     std::vector<uint256> leaves;
     leaves.resize(block.vtx.size());
     for (size_t s = 0; s < block.vtx.size(); s++) {
         leaves[s] = block.vtx[s]->GetHash();
     }
-    return ComputeMerkleRoot(std::move(leaves), mutated);
+    return ComputeMerkleRoot(std::move(leaves), mutated, pool);
+}
+
+uint256 BlockMerkleRoot(const BlockView& block, bool* mutated, ThreadPool* pool)
+{
+    std::vector<uint256> leaves;
+    leaves.reserve(block.Transactions().size());
+    for (const BlockTxView& tx : block.Transactions()) {
+        leaves.push_back(tx.GetHash().ToUint256());
+    }
+    return ComputeMerkleRoot(std::move(leaves), mutated, pool);
 }
 
-uint256 BlockWitnessMerkleRoot(const CBlock& block, bool* mutated)
+uint256 BlockWitnessMerkleRoot(const CBlock& block, bool* mutated, ThreadPool* pool)
 {
     std::vector<uint256> leaves;
     leaves.resize(block.vtx.size());
@@ -81,7 +139,7 @@ uint256 BlockWitnessMerkleRoot(const CBlock& block, bool* mutated)
     for (size_t s = 1; s < block.vtx.size(); s++) {
         leaves[s] = block.vtx[s]->GetWitnessHash();
     }
-    return ComputeMerkleRoot(std::move(leaves), mutated);
+    return ComputeMerkleRoot(std::move(leaves), mutated, pool);
 }
 
 /* This implements a constant-space merkle root/path calculator, limited to 2^32 leaves. */
@@ -189,3 +247,49 @@ std::vector<uint256> TransactionMerklePath(const CBlock& block, uint32_t positio
     }
     return ComputeMerklePath(leaves, position);
 }
+
+void MerkleBuilder::Update(size_t pos)
+{
+    for (size_t level = 0; m_levels[level].size() > 1; ++level) {
+        // m_levels may grow below, so hashes is only used before that.
+        const std::vector<uint256>& hashes{m_levels[level]};
+        const size_t left{pos & ~size_t{1}};
+        // Odd levels pair their last entry with itself.
+        const uint256 parent{Hash(hashes[left], left + 1 < hashes.size() ? hashes[left + 1] : hashes[left])};
+        pos /= 2;
+        if (level + 1 == m_levels.size()) m_levels.emplace_back();
+        std::vector<uint256>& parents{m_levels[level + 1]};
+        if (pos == parents.size()) parents.emplace_back();
+        parents[pos] = parent;
+    }
+}
+
+void MerkleBuilder::Append(const uint256& leaf)
+{
+    if (m_levels.empty()) m_levels.emplace_back();
+    m_levels[0].push_back(leaf);
+    Update(m_levels[0].size() - 1);
+}
+
+void MerkleBuilder::Set(size_t pos, const uint256& leaf)
+{
+    m_levels.at(0).at(pos) = leaf;
+    Update(pos);
+}
+
+uint256 MerkleBuilder::Root() const
+{
+    if (m_levels.empty()) return uint256();
+    return m_levels.back().at(0);
+}
+
+std::vector<uint256> MerkleBuilder::Path(size_t pos) const
+{
+    std::vector<uint256> ret;
+    for (size_t level = 0; level + 1 < m_levels.size(); ++level) {
+        const std::vector<uint256>& hashes{m_levels[level]};
+        ret.push_back((pos ^ 1) < hashes.size() ? hashes[pos ^ 1] : hashes[pos]);
+        pos /= 2;
+    }
+    return ret;
+}
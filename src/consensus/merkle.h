@@ -5,24 +5,38 @@
 #ifndef BITCOIN_CONSENSUS_MERKLE_H
 #define BITCOIN_CONSENSUS_MERKLE_H
 
+#include <cstddef>
 #include <vector>
 
 #include <primitives/block.h>
 #include <uint256.h>
 
-uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool* mutated = nullptr);
+class BlockView;
+class ThreadPool;
+
+/** Trees with fewer leaves than this are not worth splitting across threads. */
+static constexpr size_t MIN_PARALLEL_MERKLE_LEAVES{2048};
+
+/*
+ * Compute the Merkle root of hashes.
+ * *mutated is set to true if a duplicated subtree was found.
+ * If pool is given and there are enough hashes, the lower levels of the tree
+ * are computed in parallel on its threads and the calling thread.
+ */
+uint256 ComputeMerkleRoot(std::vector<uint256> hashes, bool* mutated = nullptr, ThreadPool* pool = nullptr);
 
 /*
  * Compute the Merkle root of the transactions in a block.
  * *mutated is set to true if a duplicated subtree was found.
  */
-uint256 BlockMerkleRoot(const CBlock& block, bool* mutated = nullptr);
+uint256 BlockMerkleRoot(const CBlock& block, bool* mutated = nullptr, ThreadPool* pool = nullptr);
+uint256 BlockMerkleRoot(const BlockView& block, bool* mutated = nullptr, ThreadPool* pool = nullptr);
 
 /*
  * Compute the Merkle root of the witness transactions in a block.
  * *mutated is set to true if a duplicated subtree was found.
  */
-uint256 BlockWitnessMerkleRoot(const CBlock& block, bool* mutated = nullptr);
+uint256 BlockWitnessMerkleRoot(const CBlock& block, bool* mutated = nullptr, ThreadPool* pool = nullptr);
 
 /**
  * Compute merkle path to the specified transaction
@@ -34,4 +48,31 @@ uint256 BlockWitnessMerkleRoot(const CBlock& block, bool* mutated = nullptr);
  */
 std::vector<uint256> TransactionMerklePath(const CBlock& block, uint32_t position);
 
+/**
+ * The Merkle tree of a list of leaves that grows or changes one leaf at a
+ * time, such as the transactions of a block template.
+ *
+ * All levels of the tree are kept, so that appending or replacing a leaf only
+ * rehashes its path to the root. The roots are the same as those of
+ * ComputeMerkleRoot, but duplicated subtrees are not detected.
+ */
+class MerkleBuilder
+{
+    //! m_levels[0] are the leaves, and every next level the hashes of the
+    //! pairs in the previous one. The last level holds the root.
+    std::vector<std::vector<uint256>> m_levels;
+
+    //! Recompute the inner hashes that depend on leaf pos.
+    void Update(size_t pos);
+
+public:
+    void Append(const uint256& leaf);
+    void Set(size_t pos, const uint256& leaf);
+    size_t Size() const { return m_levels.empty() ? 0 : m_levels[0].size(); }
+    //! The root, or uint256() if there are no leaves.
+    uint256 Root() const;
+    //! The merkle path of leaf pos, ordered from the deepest, like TransactionMerklePath.
+    std::vector<uint256> Path(size_t pos) const;
+};
+
 #endif // BITCOIN_CONSENSUS_MERKLE_H
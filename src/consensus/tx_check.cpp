@@ -5,10 +5,16 @@
 #include <consensus/tx_check.h>
 
 #include <consensus/amount.h>
+#include <primitives/block_view.h>
 #include <primitives/transaction.h>
 #include <consensus/validation.h>
 
-bool CheckTransaction(const CTransaction& tx, TxValidationState& state)
+namespace {
+size_t GetStrippedSize(const CTransaction& tx) { return ::GetSerializeSize(TX_NO_WITNESS(tx)); }
+size_t GetStrippedSize(const BlockTxView& tx) { return tx.GetStrippedSize(); }
+
+template <typename Tx>
+bool CheckTransactionImpl(const Tx& tx, TxValidationState& state)
 {
     // Basic checks that don't depend on any context
     if (tx.vin.empty())
@@ -16,7 +22,7 @@ bool CheckTransaction(const CTransaction& tx, TxValidationState& state)
     if (tx.vout.empty())
         return state.Invalid(TxValidationResult::TX_CONSENSUS, "bad-txns-vout-empty");
     // Size limits (this doesn't take the witness into account, as that hasn't been checked for malleability)
-    if (::GetSerializeSize(TX_NO_WITNESS(tx)) * WITNESS_SCALE_FACTOR > MAX_BLOCK_WEIGHT) {
+    if (GetStrippedSize(tx) * WITNESS_SCALE_FACTOR > MAX_BLOCK_WEIGHT) {
         return state.Invalid(TxValidationResult::TX_CONSENSUS, "bad-txns-oversize");
     }
 
@@ -58,3 +64,14 @@ bool CheckTransaction(const CTransaction& tx, TxValidationState& state)
 
     return true;
 }
+} // namespace
+
+bool CheckTransaction(const CTransaction& tx, TxValidationState& state)
+{
+    return CheckTransactionImpl(tx, state);
+}
+
+bool CheckTransaction(const BlockTxView& tx, TxValidationState& state)
+{
+    return CheckTransactionImpl(tx, state);
+}
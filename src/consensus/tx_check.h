@@ -13,8 +13,10 @@
  */
 
 class CTransaction;
+class BlockTxView;
 class TxValidationState;
 
 bool CheckTransaction(const CTransaction& tx, TxValidationState& state);
+bool CheckTransaction(const BlockTxView& tx, TxValidationState& state);
 
 #endif // BITCOIN_CONSENSUS_TX_CHECK_H
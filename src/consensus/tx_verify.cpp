@@ -9,6 +9,7 @@
 #include <consensus/amount.h>
 #include <consensus/consensus.h>
 #include <consensus/validation.h>
+#include <primitives/block_view.h>
 #include <primitives/transaction.h>
 #include <script/interpreter.h>
 #include <util/check.h>
@@ -123,6 +124,18 @@ unsigned int GetLegacySigOpCount(const CTransaction& tx)
     return nSigOps;
 }
 
+unsigned int GetLegacySigOpCount(const BlockTxView& tx)
+{
+    unsigned int nSigOps = 0;
+    for (const auto& txin : tx.vin) {
+        nSigOps += GetSigOpCount(txin.scriptSig, false);
+    }
+    for (const auto& txout : tx.vout) {
+        nSigOps += GetSigOpCount(txout.scriptPubKey, false);
+    }
+    return nSigOps;
+}
+
 unsigned int GetP2SHSigOpCount(const CTransaction& tx, const CCoinsViewCache& inputs)
 {
     if (tx.IsCoinBase())
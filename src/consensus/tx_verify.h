@@ -13,6 +13,7 @@
 class CBlockIndex;
 class CCoinsViewCache;
 class CTransaction;
+class BlockTxView;
 class TxValidationState;
 
 /** Transaction validation functions */
@@ -35,6 +36,7 @@ namespace Consensus {
  * @see CTransaction::FetchInputs
  */
 unsigned int GetLegacySigOpCount(const CTransaction& tx);
+unsigned int GetLegacySigOpCount(const BlockTxView& tx);
 
 /**
  * Count ECDSA signature operations in pay-to-script-hash inputs.
@@ -7,11 +7,13 @@
 
 #include <crypto/common.h>
 #include <crypto/chacha20.h>
+#include <compat/cpuid.h>
 #include <support/cleanse.h>
 #include <span.h>
 
 #include <algorithm>
 #include <bit>
+#include <cassert>
 #include <cstring>
 
 #define QUARTERROUND(a,b,c,d) \
@@ -22,6 +24,139 @@
 
 #define REPEAT10(a) do { {a}; {a}; {a}; {a}; {a}; {a}; {a}; {a}; {a}; {a}; } while(0)
 
+namespace chacha20_avx2
+{
+void Crypt_8way(const uint32_t input[12], const std::byte* in, std::byte* out);
+}
+
+namespace chacha20_avx512
+{
+void Crypt_16way(const uint32_t input[12], const std::byte* in, std::byte* out);
+}
+
+namespace {
+/** Compute a fixed number of consecutive blocks starting at the block counter
+ *  in input[8..9], XORed into in if it is not nullptr. Does not advance the
+ *  block counter. */
+typedef void (*CryptMultiType)(const uint32_t input[12], const std::byte* in, std::byte* out);
+
+CryptMultiType Crypt_8way = nullptr;
+CryptMultiType Crypt_16way = nullptr;
+
+void Advance(uint32_t input[12], uint32_t blocks)
+{
+    const uint64_t pos = (input[8] | uint64_t{input[9]} << 32) + blocks;
+    input[8] = pos;
+    input[9] = pos >> 32;
+}
+
+/** Process as many of the blocks as possible with the given multi-block
+ *  implementations, which may be nullptr. Returns the number of blocks
+ *  processed. */
+size_t CryptMulti(uint32_t input[12], const std::byte* in, std::byte* out, size_t blocks, CryptMultiType crypt_8way, CryptMultiType crypt_16way)
+{
+    size_t done = 0;
+    if (crypt_16way) {
+        for (; blocks - done >= 16; done += 16) {
+            crypt_16way(input, in ? in + done * ChaCha20Aligned::BLOCKLEN : nullptr, out + done * ChaCha20Aligned::BLOCKLEN);
+            Advance(input, 16);
+        }
+    }
+    if (crypt_8way) {
+        for (; blocks - done >= 8; done += 8) {
+            crypt_8way(input, in ? in + done * ChaCha20Aligned::BLOCKLEN : nullptr, out + done * ChaCha20Aligned::BLOCKLEN);
+            Advance(input, 8);
+        }
+    }
+    return done;
+}
+
+/** Compare multi-block implementations against the standard code, over a
+ *  block counter that carries into the nonce. The implementations are passed
+ *  in rather than selected, as other threads may be using the selected ones. */
+bool SelfTest(CryptMultiType crypt_8way, CryptMultiType crypt_16way)
+{
+    static const std::byte KEY[32]{std::byte{0x01}, std::byte{0x23}, std::byte{0x45}, std::byte{0x67}};
+    static constexpr ChaCha20Aligned::Nonce96 NONCE{0x89abcdef, 0x0123456789abcdef};
+    static constexpr uint32_t COUNTER{0xfffffff0};
+    static constexpr size_t BLOCKS{40};
+    // Calls of fewer blocks than any multi-block implementation computes only
+    // run the standard code, whichever implementations are selected.
+    static constexpr size_t STANDARD_BLOCKS{7};
+    std::byte in[ChaCha20Aligned::BLOCKLEN * BLOCKS], out[sizeof(in)], expected[sizeof(in)];
+    for (size_t i = 0; i < sizeof(in); ++i) in[i] = std::byte(i * 7);
+
+    ChaCha20Aligned standard{KEY};
+    standard.Seek(NONCE, COUNTER);
+    for (size_t pos = 0; pos < sizeof(in); pos += ChaCha20Aligned::BLOCKLEN * STANDARD_BLOCKS) {
+        const size_t len = std::min(sizeof(in) - pos, ChaCha20Aligned::BLOCKLEN * STANDARD_BLOCKS);
+        standard.Crypt(std::span{in}.subspan(pos, len), std::span{expected}.subspan(pos, len));
+    }
+
+    uint32_t input[12];
+    for (int i = 0; i < 8; ++i) input[i] = ReadLE32(KEY + 4 * i);
+    const auto seek = [&] {
+        input[8] = COUNTER;
+        input[9] = NONCE.first;
+        input[10] = uint32_t(NONCE.second);
+        input[11] = NONCE.second >> 32;
+    };
+    seek();
+    const size_t done = CryptMulti(input, in, out, BLOCKS, crypt_8way, crypt_16way);
+    if (std::memcmp(out, expected, done * ChaCha20Aligned::BLOCKLEN)) return false;
+    // Keystream output, which is the encryption of all zero bytes.
+    seek();
+    CryptMulti(input, nullptr, out, BLOCKS, crypt_8way, crypt_16way);
+    for (size_t i = 0; i < done * ChaCha20Aligned::BLOCKLEN; ++i) {
+        if (out[i] != (expected[i] ^ in[i])) return false;
+    }
+    return true;
+}
+} // namespace
+
+std::string ChaCha20AutoDetect(chacha20_implementation::UseImplementation use_implementation)
+{
+    std::string ret = "standard";
+    CryptMultiType crypt_8way = nullptr;
+    CryptMultiType crypt_16way = nullptr;
+
+#if defined(HAVE_GETCPUID)
+    uint32_t eax, ebx, ecx, edx;
+    GetCPUID(1, 0, eax, ebx, ecx, edx);
+    const bool have_xsave = (ecx >> 27) & 1;
+    const bool have_avx = (ecx >> 28) & 1;
+    // The XMM and YMM registers, and for AVX-512 also the opmask and upper ZMM registers.
+    const uint64_t xcr0 = have_xsave && have_avx ? GetXCR0() : 0;
+    GetCPUID(0, 0, eax, ebx, ecx, edx);
+    const uint32_t max_leaf = eax;
+    if (max_leaf >= 7) {
+        GetCPUID(7, 0, eax, ebx, ecx, edx);
+    } else {
+        ebx = 0;
+    }
+    [[maybe_unused]] const bool have_avx2 = (use_implementation & chacha20_implementation::USE_AVX2) && ((ebx >> 5) & 1) && (xcr0 & 0x6) == 0x6;
+    [[maybe_unused]] const bool have_avx512 = (use_implementation & chacha20_implementation::USE_AVX512) && ((ebx >> 16) & 1) && (xcr0 & 0xe6) == 0xe6;
+
+#if defined(ENABLE_AVX2)
+    if (have_avx2) {
+        crypt_8way = chacha20_avx2::Crypt_8way;
+        ret = "avx2(8way)";
+    }
+#endif
+#if defined(ENABLE_AVX512)
+    if (have_avx512) {
+        crypt_16way = chacha20_avx512::Crypt_16way;
+        ret = have_avx2 ? "avx2(8way),avx512(16way)" : "avx512(16way)";
+    }
+#endif
+#endif // defined(HAVE_GETCPUID)
+
+    assert(SelfTest(crypt_8way, crypt_16way));
+    Crypt_8way = crypt_8way;
+    Crypt_16way = crypt_16way;
+    return ret;
+}
+
 void ChaCha20Aligned::SetKey(std::span<const std::byte> key) noexcept
 {
     assert(key.size() == KEYLEN);
@@ -66,6 +201,10 @@ inline void ChaCha20Aligned::Keystream(std::span<std::byte> output) noexcept
     uint32_t x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
     uint32_t j4, j5, j6, j7, j8, j9, j10, j11, j12, j13, j14, j15;
 
+    const size_t done = CryptMulti(input, nullptr, c, blocks, Crypt_8way, Crypt_16way);
+    blocks -= done;
+    c += done * BLOCKLEN;
+
     if (!blocks) return;
 
     j4 = input[0];
@@ -169,6 +308,11 @@ inline void ChaCha20Aligned::Crypt(std::span<const std::byte> in_bytes, std::spa
     uint32_t x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
     uint32_t j4, j5, j6, j7, j8, j9, j10, j11, j12, j13, j14, j15;
 
+    const size_t done = CryptMulti(input, m, c, blocks, Crypt_8way, Crypt_16way);
+    blocks -= done;
+    m += done * BLOCKLEN;
+    c += done * BLOCKLEN;
+
     if (!blocks) return;
 
     j4 = input[0];
@@ -0,0 +1,115 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_AVX2
+
+#include <cstddef>
+#include <cstdint>
+#include <immintrin.h>
+
+#include <attributes.h>
+
+namespace chacha20_avx2 {
+namespace {
+
+__m256i inline Add(__m256i x, __m256i y) { return _mm256_add_epi32(x, y); }
+__m256i inline Xor(__m256i x, __m256i y) { return _mm256_xor_si256(x, y); }
+
+template <int N>
+__m256i inline RotL(__m256i x) { return _mm256_or_si256(_mm256_slli_epi32(x, N), _mm256_srli_epi32(x, 32 - N)); }
+
+// Rotations by whole bytes are a single byte shuffle.
+template <>
+__m256i inline RotL<16>(__m256i x)
+{
+    return _mm256_shuffle_epi8(x, _mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+                                                   2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13));
+}
+
+template <>
+__m256i inline RotL<8>(__m256i x)
+{
+    return _mm256_shuffle_epi8(x, _mm256_setr_epi8(3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14,
+                                                   3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14));
+}
+
+void ALWAYS_INLINE QuarterRound(__m256i& a, __m256i& b, __m256i& c, __m256i& d)
+{
+    a = Add(a, b); d = RotL<16>(Xor(d, a));
+    c = Add(c, d); b = RotL<12>(Xor(b, c));
+    a = Add(a, b); d = RotL<8>(Xor(d, a));
+    c = Add(c, d); b = RotL<7>(Xor(b, c));
+}
+
+/** Write (or XOR into in and write) one half of each of the 8 blocks, given
+ *  8 state words of all blocks. */
+void ALWAYS_INLINE Output(const __m256i x[8], const std::byte* in, std::byte* out)
+{
+    // Transpose the 8x8 matrix of words, so that each register holds 8
+    // consecutive words of a single block.
+    const __m256i t0 = _mm256_unpacklo_epi32(x[0], x[1]), t1 = _mm256_unpackhi_epi32(x[0], x[1]);
+    const __m256i t2 = _mm256_unpacklo_epi32(x[2], x[3]), t3 = _mm256_unpackhi_epi32(x[2], x[3]);
+    const __m256i t4 = _mm256_unpacklo_epi32(x[4], x[5]), t5 = _mm256_unpackhi_epi32(x[4], x[5]);
+    const __m256i t6 = _mm256_unpacklo_epi32(x[6], x[7]), t7 = _mm256_unpackhi_epi32(x[6], x[7]);
+    const __m256i u0 = _mm256_unpacklo_epi64(t0, t2), u1 = _mm256_unpackhi_epi64(t0, t2);
+    const __m256i u2 = _mm256_unpacklo_epi64(t1, t3), u3 = _mm256_unpackhi_epi64(t1, t3);
+    const __m256i u4 = _mm256_unpacklo_epi64(t4, t6), u5 = _mm256_unpackhi_epi64(t4, t6);
+    const __m256i u6 = _mm256_unpacklo_epi64(t5, t7), u7 = _mm256_unpackhi_epi64(t5, t7);
+    const __m256i blocks[8] = {
+        _mm256_permute2x128_si256(u0, u4, 0x20), _mm256_permute2x128_si256(u1, u5, 0x20),
+        _mm256_permute2x128_si256(u2, u6, 0x20), _mm256_permute2x128_si256(u3, u7, 0x20),
+        _mm256_permute2x128_si256(u0, u4, 0x31), _mm256_permute2x128_si256(u1, u5, 0x31),
+        _mm256_permute2x128_si256(u2, u6, 0x31), _mm256_permute2x128_si256(u3, u7, 0x31),
+    };
+    for (int i = 0; i < 8; ++i) {
+        __m256i v = blocks[i];
+        if (in) v = Xor(v, _mm256_loadu_si256((const __m256i*)(in + 64 * i)));
+        _mm256_storeu_si256((__m256i*)(out + 64 * i), v);
+    }
+}
+
+}
+
+void Crypt_8way(const uint32_t input[12], const std::byte* in, std::byte* out)
+{
+    // The block counter of each block, and the nonce word it carries into.
+    alignas(32) uint32_t counter[8], nonce[8];
+    for (int i = 0; i < 8; ++i) {
+        const uint64_t pos = (input[8] | uint64_t{input[9]} << 32) + i;
+        counter[i] = uint32_t(pos);
+        nonce[i] = uint32_t(pos >> 32);
+    }
+
+    __m256i j[16];
+    j[0] = _mm256_set1_epi32(0x61707865);
+    j[1] = _mm256_set1_epi32(0x3320646e);
+    j[2] = _mm256_set1_epi32(0x79622d32);
+    j[3] = _mm256_set1_epi32(0x6b206574);
+    for (int i = 0; i < 8; ++i) j[4 + i] = _mm256_set1_epi32(input[i]);
+    j[12] = _mm256_load_si256((const __m256i*)counter);
+    j[13] = _mm256_load_si256((const __m256i*)nonce);
+    j[14] = _mm256_set1_epi32(input[10]);
+    j[15] = _mm256_set1_epi32(input[11]);
+
+    __m256i x[16];
+    for (int i = 0; i < 16; ++i) x[i] = j[i];
+    for (int round = 0; round < 10; ++round) {
+        QuarterRound(x[0], x[4], x[8], x[12]);
+        QuarterRound(x[1], x[5], x[9], x[13]);
+        QuarterRound(x[2], x[6], x[10], x[14]);
+        QuarterRound(x[3], x[7], x[11], x[15]);
+        QuarterRound(x[0], x[5], x[10], x[15]);
+        QuarterRound(x[1], x[6], x[11], x[12]);
+        QuarterRound(x[2], x[7], x[8], x[13]);
+        QuarterRound(x[3], x[4], x[9], x[14]);
+    }
+    for (int i = 0; i < 16; ++i) x[i] = Add(x[i], j[i]);
+
+    Output(x, in, out);
+    Output(x + 8, in ? in + 32 : nullptr, out + 32);
+}
+
+}
+
+#endif
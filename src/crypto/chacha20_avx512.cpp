@@ -0,0 +1,102 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_AVX512
+
+#include <cstddef>
+#include <cstdint>
+#include <immintrin.h>
+
+#include <attributes.h>
+
+namespace chacha20_avx512 {
+namespace {
+
+__m512i inline Add(__m512i x, __m512i y) { return _mm512_add_epi32(x, y); }
+__m512i inline Xor(__m512i x, __m512i y) { return _mm512_xor_si512(x, y); }
+
+void ALWAYS_INLINE QuarterRound(__m512i& a, __m512i& b, __m512i& c, __m512i& d)
+{
+    a = Add(a, b); d = _mm512_rol_epi32(Xor(d, a), 16);
+    c = Add(c, d); b = _mm512_rol_epi32(Xor(b, c), 12);
+    a = Add(a, b); d = _mm512_rol_epi32(Xor(d, a), 8);
+    c = Add(c, d); b = _mm512_rol_epi32(Xor(b, c), 7);
+}
+
+/** Write (or XOR into in and write) 4 of the 16 blocks, given 4 registers
+ *  that each hold 4 consecutive words of those blocks, one block per 128-bit
+ *  lane, at word offsets 0, 4, 8 and 12. */
+void ALWAYS_INLINE Output(__m512i v0, __m512i v1, __m512i v2, __m512i v3, const std::byte* in, std::byte* out)
+{
+    // Transpose the 4x4 matrix of 128-bit lanes, so that each register holds
+    // the 16 words of a single block.
+    const __m512i c0 = _mm512_shuffle_i32x4(v0, v1, 0x44), c1 = _mm512_shuffle_i32x4(v0, v1, 0xee);
+    const __m512i c2 = _mm512_shuffle_i32x4(v2, v3, 0x44), c3 = _mm512_shuffle_i32x4(v2, v3, 0xee);
+    const __m512i blocks[4] = {
+        _mm512_shuffle_i32x4(c0, c2, 0x88), _mm512_shuffle_i32x4(c0, c2, 0xdd),
+        _mm512_shuffle_i32x4(c1, c3, 0x88), _mm512_shuffle_i32x4(c1, c3, 0xdd),
+    };
+    for (int i = 0; i < 4; ++i) {
+        __m512i v = blocks[i];
+        if (in) v = Xor(v, _mm512_loadu_si512(in + 4 * 64 * i));
+        _mm512_storeu_si512(out + 4 * 64 * i, v);
+    }
+}
+
+}
+
+void Crypt_16way(const uint32_t input[12], const std::byte* in, std::byte* out)
+{
+    // The block counter of each block, and the nonce word it carries into.
+    alignas(64) uint32_t counter[16], nonce[16];
+    for (int i = 0; i < 16; ++i) {
+        const uint64_t pos = (input[8] | uint64_t{input[9]} << 32) + i;
+        counter[i] = uint32_t(pos);
+        nonce[i] = uint32_t(pos >> 32);
+    }
+
+    __m512i j[16];
+    j[0] = _mm512_set1_epi32(0x61707865);
+    j[1] = _mm512_set1_epi32(0x3320646e);
+    j[2] = _mm512_set1_epi32(0x79622d32);
+    j[3] = _mm512_set1_epi32(0x6b206574);
+    for (int i = 0; i < 8; ++i) j[4 + i] = _mm512_set1_epi32(input[i]);
+    j[12] = _mm512_load_si512(counter);
+    j[13] = _mm512_load_si512(nonce);
+    j[14] = _mm512_set1_epi32(input[10]);
+    j[15] = _mm512_set1_epi32(input[11]);
+
+    __m512i x[16];
+    for (int i = 0; i < 16; ++i) x[i] = j[i];
+    for (int round = 0; round < 10; ++round) {
+        QuarterRound(x[0], x[4], x[8], x[12]);
+        QuarterRound(x[1], x[5], x[9], x[13]);
+        QuarterRound(x[2], x[6], x[10], x[14]);
+        QuarterRound(x[3], x[7], x[11], x[15]);
+        QuarterRound(x[0], x[5], x[10], x[15]);
+        QuarterRound(x[1], x[6], x[11], x[12]);
+        QuarterRound(x[2], x[7], x[8], x[13]);
+        QuarterRound(x[3], x[4], x[9], x[14]);
+    }
+    for (int i = 0; i < 16; ++i) x[i] = Add(x[i], j[i]);
+
+    // Interleave groups of 4 words, so that each 128-bit lane of b[4 * g + k]
+    // holds words 4 * g .. 4 * g + 3 of block 4 * lane + k.
+    __m512i b[16];
+    for (int g = 0; g < 4; ++g) {
+        const __m512i t0 = _mm512_unpacklo_epi32(x[4 * g + 0], x[4 * g + 1]), t1 = _mm512_unpackhi_epi32(x[4 * g + 0], x[4 * g + 1]);
+        const __m512i t2 = _mm512_unpacklo_epi32(x[4 * g + 2], x[4 * g + 3]), t3 = _mm512_unpackhi_epi32(x[4 * g + 2], x[4 * g + 3]);
+        b[4 * g + 0] = _mm512_unpacklo_epi64(t0, t2);
+        b[4 * g + 1] = _mm512_unpackhi_epi64(t0, t2);
+        b[4 * g + 2] = _mm512_unpacklo_epi64(t1, t3);
+        b[4 * g + 3] = _mm512_unpackhi_epi64(t1, t3);
+    }
+    for (int k = 0; k < 4; ++k) {
+        Output(b[k], b[4 + k], b[8 + k], b[12 + k], in ? in + 64 * k : nullptr, out + 64 * k);
+    }
+}
+
+}
+
+#endif
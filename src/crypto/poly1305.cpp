@@ -4,9 +4,29 @@
 
 #include <crypto/common.h>
 #include <crypto/poly1305.h>
+#include <compat/cpuid.h>
 
+#include <algorithm>
+#include <cassert>
 #include <cstring>
 
+namespace poly1305_avx2
+{
+size_t Blocks(uint32_t h[5], const uint32_t r[5], const unsigned char* m, size_t bytes);
+}
+
+namespace {
+/** Process the leading multiple of 64 bytes of a run of full blocks. Returns the
+ *  number of bytes processed. */
+typedef size_t (*BlocksMultiType)(uint32_t h[5], const uint32_t r[5], const unsigned char* m, size_t bytes);
+
+BlocksMultiType BlocksMulti = nullptr;
+
+/** Below this many bytes, computing the powers of r the multi-block
+ *  implementation needs costs more than it saves. */
+constexpr size_t MIN_BLOCKS_MULTI_BYTES{256};
+} // namespace
+
 namespace poly1305_donna {
 
 // Based on the public domain implementation by Andrew Moon
@@ -56,6 +76,13 @@ static void poly1305_blocks(poly1305_context *st, const unsigned char *m, size_t
     s3 = r3 * 5;
     s4 = r4 * 5;
 
+    /* only full blocks take the multi-block path; the final one is padded differently */
+    if (BlocksMulti && !st->final && bytes >= MIN_BLOCKS_MULTI_BYTES) {
+        size_t done = BlocksMulti(st->h, st->r, m, bytes);
+        m += done;
+        bytes -= done;
+    }
+
     h0 = st->h[0];
     h1 = st->h[1];
     h2 = st->h[2];
@@ -221,3 +248,70 @@ void poly1305_update(poly1305_context *st, const unsigned char *m, size_t bytes)
 }
 
 }  // namespace poly1305_donna
+
+namespace {
+/** Compare a multi-block implementation against the standard code, over
+ *  messages of all lengths around the threshold where it is used. The
+ *  implementation is passed in rather than selected, as other threads may be
+ *  using the selected one. */
+bool SelfTest(BlocksMultiType blocks_multi)
+{
+    if (!blocks_multi) return true;
+
+    static const unsigned char KEY[32]{0xff, 0xff, 0xff, 0x0f, 0xfc, 0xff, 0xff, 0x0f, 0xfc, 0xff, 0xff, 0x0f, 0xfc, 0xff, 0xff, 0x0f, 0x01};
+    // Updates shorter than the threshold only run the standard code, whichever
+    // implementation is selected.
+    static constexpr size_t STANDARD_BYTES{MIN_BLOCKS_MULTI_BYTES / 2};
+    unsigned char msg[MIN_BLOCKS_MULTI_BYTES * 3];
+    for (size_t i = 0; i < sizeof(msg); ++i) msg[i] = 0xff - (i * 13) % 7;
+
+    for (size_t len = MIN_BLOCKS_MULTI_BYTES - 17; len <= sizeof(msg); len += 17) {
+        unsigned char expected[16], tag[16];
+        poly1305_donna::poly1305_context ctx;
+        poly1305_donna::poly1305_init(&ctx, KEY);
+        for (size_t pos = 0; pos < len; pos += STANDARD_BYTES) {
+            poly1305_donna::poly1305_update(&ctx, msg + pos, std::min(len - pos, STANDARD_BYTES));
+        }
+        poly1305_donna::poly1305_finish(&ctx, expected);
+        // The leading full blocks with the multi-block implementation, and
+        // the remaining fewer than 64 bytes with the standard code.
+        poly1305_donna::poly1305_init(&ctx, KEY);
+        const size_t done = blocks_multi(ctx.h, ctx.r, msg, len & ~size_t{POLY1305_BLOCK_SIZE - 1});
+        poly1305_donna::poly1305_update(&ctx, msg + done, len - done);
+        poly1305_donna::poly1305_finish(&ctx, tag);
+        if (std::memcmp(tag, expected, sizeof(tag))) return false;
+    }
+    return true;
+}
+} // namespace
+
+std::string Poly1305AutoDetect(bool use_optimized)
+{
+    std::string ret = "standard";
+    BlocksMultiType blocks_multi = nullptr;
+
+#if defined(HAVE_GETCPUID)
+    uint32_t eax, ebx, ecx, edx;
+    GetCPUID(1, 0, eax, ebx, ecx, edx);
+    const bool have_xsave = (ecx >> 27) & 1;
+    const bool have_avx = (ecx >> 28) & 1;
+    const bool enabled_avx = have_xsave && have_avx && (GetXCR0() & 0x6) == 0x6;
+    GetCPUID(0, 0, eax, ebx, ecx, edx);
+    [[maybe_unused]] bool have_avx2 = false;
+    if (use_optimized && enabled_avx && eax >= 7) {
+        GetCPUID(7, 0, eax, ebx, ecx, edx);
+        have_avx2 = (ebx >> 5) & 1;
+    }
+
+#if defined(ENABLE_AVX2)
+    if (have_avx2) {
+        blocks_multi = poly1305_avx2::Blocks;
+        ret = "avx2(4way)";
+    }
+#endif
+#endif // defined(HAVE_GETCPUID)
+
+    assert(SelfTest(blocks_multi));
+    BlocksMulti = blocks_multi;
+    return ret;
+}
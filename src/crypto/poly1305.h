@@ -10,6 +10,7 @@
 #include <cassert>
 #include <cstdint>
 #include <cstdlib>
+#include <string>
 
 #define POLY1305_BLOCK_SIZE 16
 
@@ -33,6 +34,11 @@ void poly1305_finish(poly1305_context *st, unsigned char mac[16]) noexcept;
 
 }  // namespace poly1305_donna
 
+/** Autodetect the best available Poly1305 implementation, or use the standard
+ *  one if use_optimized is false. Returns the name of the implementation.
+ */
+std::string Poly1305AutoDetect(bool use_optimized = true);
+
 /** C++ wrapper with std::byte span interface around poly1305_donna code. */
 class Poly1305
 {
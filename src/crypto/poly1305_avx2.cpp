@@ -0,0 +1,146 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifdef ENABLE_AVX2
+
+#include <cstddef>
+#include <cstdint>
+#include <immintrin.h>
+
+#include <attributes.h>
+
+// 4-way vectorization of the 26-bit limb arithmetic of poly1305-donna-32.
+//
+// A message of 4n blocks m[0..4n) evaluates to
+//   h' = (h + m[0]) * r^4n + m[1] * r^(4n-1) + ... + m[4n-1] * r
+// which is computed as 4 independent lanes, lane k accumulating the blocks
+// m[4i + k] using r^4 as multiplier. At the end, lane k is multiplied by
+// r^(4-k), and the lanes are summed.
+
+namespace poly1305_avx2 {
+namespace {
+
+constexpr uint32_t MASK26{0x3ffffff};
+
+/** out = a * b, partially reduced, like a single step of poly1305_blocks. */
+void MulMod(uint32_t out[5], const uint32_t a[5], const uint32_t b[5])
+{
+    const uint64_t s1 = b[1] * 5, s2 = b[2] * 5, s3 = b[3] * 5, s4 = b[4] * 5;
+    uint64_t d0 = uint64_t{a[0]} * b[0] + a[1] * s4 + a[2] * s3 + a[3] * s2 + a[4] * s1;
+    uint64_t d1 = uint64_t{a[0]} * b[1] + uint64_t{a[1]} * b[0] + a[2] * s4 + a[3] * s3 + a[4] * s2;
+    uint64_t d2 = uint64_t{a[0]} * b[2] + uint64_t{a[1]} * b[1] + uint64_t{a[2]} * b[0] + a[3] * s4 + a[4] * s3;
+    uint64_t d3 = uint64_t{a[0]} * b[3] + uint64_t{a[1]} * b[2] + uint64_t{a[2]} * b[1] + uint64_t{a[3]} * b[0] + a[4] * s4;
+    uint64_t d4 = uint64_t{a[0]} * b[4] + uint64_t{a[1]} * b[3] + uint64_t{a[2]} * b[2] + uint64_t{a[3]} * b[1] + uint64_t{a[4]} * b[0];
+    uint64_t c;
+              c = d0 >> 26; out[0] = d0 & MASK26;
+    d1 += c;  c = d1 >> 26; out[1] = d1 & MASK26;
+    d2 += c;  c = d2 >> 26; out[2] = d2 & MASK26;
+    d3 += c;  c = d3 >> 26; out[3] = d3 & MASK26;
+    d4 += c;  c = d4 >> 26; out[4] = d4 & MASK26;
+    out[0] += c * 5; c = out[0] >> 26; out[0] &= MASK26;
+    out[1] += c;
+}
+
+__m256i inline Add(__m256i x, __m256i y) { return _mm256_add_epi64(x, y); }
+__m256i inline Mul(__m256i x, __m256i y) { return _mm256_mul_epu32(x, y); }
+
+/** Load 4 blocks as 5 vectors of 26-bit limbs, one block per 64-bit lane.
+ *
+ *  The lanes hold the blocks in the order 0, 2, 1, 3, which avoids a cross-lane
+ *  permutation; the caller accounts for this when combining the lanes. */
+void ALWAYS_INLINE Load(__m256i m[5], const unsigned char* in)
+{
+    const __m256i mask = _mm256_set1_epi64x(MASK26);
+    const __m256i a = _mm256_loadu_si256((const __m256i*)in);
+    const __m256i b = _mm256_loadu_si256((const __m256i*)(in + 32));
+    const __m256i lo = _mm256_unpacklo_epi64(a, b);
+    const __m256i hi = _mm256_unpackhi_epi64(a, b);
+    m[0] = _mm256_and_si256(lo, mask);
+    m[1] = _mm256_and_si256(_mm256_srli_epi64(lo, 26), mask);
+    m[2] = _mm256_and_si256(_mm256_or_si256(_mm256_srli_epi64(lo, 52), _mm256_slli_epi64(hi, 12)), mask);
+    m[3] = _mm256_and_si256(_mm256_srli_epi64(hi, 14), mask);
+    // 1 << 128
+    m[4] = _mm256_or_si256(_mm256_srli_epi64(hi, 40), _mm256_set1_epi64x(1 << 24));
+}
+
+/** d = h * r, without reduction. s holds the limbs of r times 5. */
+void ALWAYS_INLINE MulLanes(__m256i d[5], const __m256i h[5], const __m256i r[5], const __m256i s[5])
+{
+    d[0] = Add(Add(Mul(h[0], r[0]), Mul(h[1], s[4])), Add(Add(Mul(h[2], s[3]), Mul(h[3], s[2])), Mul(h[4], s[1])));
+    d[1] = Add(Add(Mul(h[0], r[1]), Mul(h[1], r[0])), Add(Add(Mul(h[2], s[4]), Mul(h[3], s[3])), Mul(h[4], s[2])));
+    d[2] = Add(Add(Mul(h[0], r[2]), Mul(h[1], r[1])), Add(Add(Mul(h[2], r[0]), Mul(h[3], s[4])), Mul(h[4], s[3])));
+    d[3] = Add(Add(Mul(h[0], r[3]), Mul(h[1], r[2])), Add(Add(Mul(h[2], r[1]), Mul(h[3], r[0])), Mul(h[4], s[4])));
+    d[4] = Add(Add(Mul(h[0], r[4]), Mul(h[1], r[3])), Add(Add(Mul(h[2], r[2]), Mul(h[3], r[1])), Mul(h[4], r[0])));
+}
+
+/** h = d, partially reduced. */
+void ALWAYS_INLINE Carry(__m256i h[5], __m256i d[5])
+{
+    const __m256i mask = _mm256_set1_epi64x(MASK26);
+    __m256i c;
+                                  c = _mm256_srli_epi64(d[0], 26); h[0] = _mm256_and_si256(d[0], mask);
+    d[1] = Add(d[1], c);          c = _mm256_srli_epi64(d[1], 26); h[1] = _mm256_and_si256(d[1], mask);
+    d[2] = Add(d[2], c);          c = _mm256_srli_epi64(d[2], 26); h[2] = _mm256_and_si256(d[2], mask);
+    d[3] = Add(d[3], c);          c = _mm256_srli_epi64(d[3], 26); h[3] = _mm256_and_si256(d[3], mask);
+    d[4] = Add(d[4], c);          c = _mm256_srli_epi64(d[4], 26); h[4] = _mm256_and_si256(d[4], mask);
+    h[0] = Add(h[0], Add(c, _mm256_slli_epi64(c, 2)));
+                                  c = _mm256_srli_epi64(h[0], 26); h[0] = _mm256_and_si256(h[0], mask);
+    h[1] = Add(h[1], c);
+}
+
+}
+
+size_t Blocks(uint32_t h[5], const uint32_t r[5], const unsigned char* m, size_t bytes)
+{
+    const size_t chunks = bytes / 64;
+    if (chunks == 0) return 0;
+
+    uint32_t r2[5], r3[5], r4[5];
+    MulMod(r2, r, r);
+    MulMod(r3, r2, r);
+    MulMod(r4, r2, r2);
+
+    __m256i mr[5], ms[5], pr[5], ps[5];
+    for (int i = 0; i < 5; ++i) {
+        mr[i] = _mm256_set1_epi64x(r4[i]);
+        ms[i] = _mm256_set1_epi64x(r4[i] * 5);
+        // The powers of r for the lanes holding blocks 0, 2, 1 and 3.
+        pr[i] = _mm256_setr_epi64x(r4[i], r2[i], r3[i], r[i]);
+        ps[i] = _mm256_setr_epi64x(r4[i] * 5, r2[i] * 5, r3[i] * 5, r[i] * 5);
+    }
+
+    __m256i acc[5], blocks[5], d[5];
+    Load(acc, m);
+    for (int i = 0; i < 5; ++i) acc[i] = Add(acc[i], _mm256_setr_epi64x(h[i], 0, 0, 0));
+    for (size_t chunk = 1; chunk < chunks; ++chunk) {
+        MulLanes(d, acc, mr, ms);
+        Carry(acc, d);
+        Load(blocks, m + 64 * chunk);
+        for (int i = 0; i < 5; ++i) acc[i] = Add(acc[i], blocks[i]);
+    }
+    MulLanes(d, acc, pr, ps);
+
+    // Sum the lanes, then carry as in poly1305_blocks.
+    uint64_t sum[5];
+    for (int i = 0; i < 5; ++i) {
+        alignas(16) uint64_t half[2];
+        _mm_store_si128((__m128i*)half, _mm_add_epi64(_mm256_castsi256_si128(d[i]), _mm256_extracti128_si256(d[i], 1)));
+        sum[i] = half[0] + half[1];
+    }
+    uint64_t c;
+                  c = sum[0] >> 26; h[0] = sum[0] & MASK26;
+    sum[1] += c;  c = sum[1] >> 26; h[1] = sum[1] & MASK26;
+    sum[2] += c;  c = sum[2] >> 26; h[2] = sum[2] & MASK26;
+    sum[3] += c;  c = sum[3] >> 26; h[3] = sum[3] & MASK26;
+    sum[4] += c;  c = sum[4] >> 26; h[4] = sum[4] & MASK26;
+    uint64_t h0 = h[0] + c * 5;
+    h[0] = h0 & MASK26;
+    h[1] += h0 >> 26;
+
+    return chunks * 64;
+}
+
+}
+
+#endif
@@ -8,6 +8,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <vector>
 
 #if !defined(DISABLE_OPTIMIZED_SHA256)
 #include <compat/cpuid.h>
@@ -32,11 +33,13 @@ void Transform(uint32_t* s, const unsigned char* chunk, size_t blocks);
 namespace sha256d64_sse41
 {
 void Transform_4way(unsigned char* out, const unsigned char* in);
+void TransformMulti_4way(uint32_t* const s[4], const unsigned char* const chunk[4]);
 }
 
 namespace sha256d64_avx2
 {
 void Transform_8way(unsigned char* out, const unsigned char* in);
+void TransformMulti_8way(uint32_t* const s[8], const unsigned char* const chunk[8]);
 }
 
 namespace sha256d64_x86_shani
@@ -437,6 +440,7 @@ void TransformD64(unsigned char* out, const unsigned char* in)
 
 typedef void (*TransformType)(uint32_t*, const unsigned char*, size_t);
 typedef void (*TransformD64Type)(unsigned char*, const unsigned char*);
+typedef void (*TransformMultiType)(uint32_t* const*, const unsigned char* const*);
 
 template<TransformType tr>
 void TransformD64Wrapper(unsigned char* out, const unsigned char* in)
@@ -482,6 +486,8 @@ TransformD64Type TransformD64 = sha256::TransformD64;
 TransformD64Type TransformD64_2way = nullptr;
 TransformD64Type TransformD64_4way = nullptr;
 TransformD64Type TransformD64_8way = nullptr;
+TransformMultiType TransformMulti_4way = nullptr;
+TransformMultiType TransformMulti_8way = nullptr;
 
 bool SelfTest() {
     // Input state (equal to the initial SHA256 state)
@@ -565,6 +571,25 @@ bool SelfTest() {
         if (!std::equal(out, out + 256, result_d64)) return false;
     }
 
+    // Test TransformMulti_4way and TransformMulti_8way, if available, by
+    // transforming lane i from the state after i blocks with block i.
+    for (TransformMultiType transform : {TransformMulti_4way, TransformMulti_8way}) {
+        if (!transform) continue;
+        uint32_t states[8][8];
+        uint32_t* lanes[8];
+        const unsigned char* chunks[8];
+        for (size_t i = 0; i < 8; ++i) {
+            std::copy(result[i], result[i] + 8, states[i]);
+            lanes[i] = states[i];
+            chunks[i] = data + 1 + 64 * i;
+        }
+        transform(lanes, chunks);
+        if (transform == TransformMulti_4way) transform(lanes + 4, chunks + 4);
+        for (size_t i = 0; i < 8; ++i) {
+            if (!std::equal(states[i], states[i] + 8, result[i + 1])) return false;
+        }
+    }
+
     return true;
 }
 
@@ -590,6 +615,8 @@ std::string SHA256AutoDetect(sha256_implementation::UseImplementation use_implem
     TransformD64_2way = nullptr;
     TransformD64_4way = nullptr;
     TransformD64_8way = nullptr;
+    TransformMulti_4way = nullptr;
+    TransformMulti_8way = nullptr;
 
 #if !defined(DISABLE_OPTIMIZED_SHA256)
 #if defined(HAVE_GETCPUID)
@@ -639,6 +666,7 @@ std::string SHA256AutoDetect(sha256_implementation::UseImplementation use_implem
 #endif
 #if defined(ENABLE_SSE41)
         TransformD64_4way = sha256d64_sse41::Transform_4way;
+        TransformMulti_4way = sha256d64_sse41::TransformMulti_4way;
         ret += ",sse41(4way)";
 #endif
     }
@@ -646,6 +674,7 @@ std::string SHA256AutoDetect(sha256_implementation::UseImplementation use_implem
 #if defined(ENABLE_AVX2)
     if (have_avx2 && have_avx && enabled_avx) {
         TransformD64_8way = sha256d64_avx2::Transform_8way;
+        TransformMulti_8way = sha256d64_avx2::TransformMulti_8way;
         ret += ",avx2(8way)";
     }
 #endif
@@ -779,3 +808,122 @@ void SHA256D64(unsigned char* out, const unsigned char* in, size_t blocks)
         --blocks;
     }
 }
+
+namespace {
+/** A message being hashed by SHA256Multi. */
+struct MultiLane
+{
+    uint32_t s[8];
+    //! The full 64-byte blocks of the message that are left.
+    const unsigned char* data;
+    size_t blocks;
+    //! The rest of the message followed by the SHA256 padding, in one or two blocks.
+    unsigned char tail[128];
+    size_t tail_blocks;
+    size_t tail_done;
+    unsigned char* out;
+
+    void Init(std::span<const unsigned char> message, unsigned char* output)
+    {
+        sha256::Initialize(s);
+        data = message.data();
+        blocks = message.size() / 64;
+        const size_t rest = message.size() % 64;
+        std::memset(tail, 0, sizeof(tail));
+        if (rest) std::memcpy(tail, data + 64 * blocks, rest);
+        tail[rest] = 0x80;
+        tail_blocks = rest + 9 > 64 ? 2 : 1;
+        tail_done = 0;
+        WriteBE64(tail + 64 * tail_blocks - 8, uint64_t{message.size()} << 3);
+        out = output;
+    }
+
+    /** Return the next block to transform, and advance past it. */
+    const unsigned char* Next()
+    {
+        if (blocks) {
+            --blocks;
+            const unsigned char* ret = data;
+            data += 64;
+            return ret;
+        }
+        return tail + 64 * tail_done++;
+    }
+
+    bool Done() const { return !blocks && tail_done == tail_blocks; }
+
+    void Finish()
+    {
+        for (int i = 0; i < 8; ++i) WriteBE32(out + 4 * i, s[i]);
+    }
+
+    /** Process what is left of the message one block at a time. */
+    void Complete()
+    {
+        if (blocks) Transform(s, data, blocks);
+        Transform(s, tail + 64 * tail_done, tail_blocks - tail_done);
+        Finish();
+    }
+};
+
+/** Hash messages WAYS at a time with transform, refilling each lane with the
+ *  next message as soon as the one it holds is done. The lanes that are left
+ *  once all messages have been started are completed with Transform. */
+template <size_t WAYS>
+void HashMulti(TransformMultiType transform, unsigned char* out, std::span<const std::span<const unsigned char>> messages)
+{
+    MultiLane lanes[WAYS];
+    uint32_t* states[WAYS];
+    const unsigned char* chunks[WAYS];
+    size_t next = 0;
+    for (size_t i = 0; i < WAYS; ++i) {
+        lanes[i].Init(messages[next], out + 32 * next);
+        states[i] = lanes[i].s;
+        ++next;
+    }
+    size_t active = WAYS;
+    while (active == WAYS) {
+        for (size_t i = 0; i < WAYS; ++i) chunks[i] = lanes[i].Next();
+        transform(states, chunks);
+        for (size_t i = 0; i < WAYS; ++i) {
+            if (!lanes[i].Done()) continue;
+            lanes[i].Finish();
+            if (next < messages.size()) {
+                lanes[i].Init(messages[next], out + 32 * next);
+                ++next;
+            } else {
+                --active;
+            }
+        }
+    }
+    for (size_t i = 0; i < WAYS; ++i) {
+        if (!lanes[i].Done()) lanes[i].Complete();
+    }
+}
+} // namespace
+
+void SHA256Multi(unsigned char* out, std::span<const std::span<const unsigned char>> messages)
+{
+    if (TransformMulti_8way && messages.size() >= 8) {
+        HashMulti<8>(TransformMulti_8way, out, messages);
+    } else if (TransformMulti_4way && messages.size() >= 4) {
+        HashMulti<4>(TransformMulti_4way, out, messages);
+    } else {
+        for (size_t i = 0; i < messages.size(); ++i) {
+            MultiLane lane;
+            lane.Init(messages[i], out + 32 * i);
+            lane.Complete();
+        }
+    }
+}
+
+void SHA256DMulti(unsigned char* out, std::span<const std::span<const unsigned char>> messages)
+{
+    SHA256Multi(out, messages);
+    // Each digest is copied into its lane before its own output is written,
+    // so the second pass can hash them in place.
+    std::vector<std::span<const unsigned char>> digests;
+    digests.reserve(messages.size());
+    for (size_t i = 0; i < messages.size(); ++i) digests.emplace_back(out + 32 * i, 32);
+    SHA256Multi(out, digests);
+}
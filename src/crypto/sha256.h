@@ -7,6 +7,7 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <span>
 #include <string>
 
 /** A hasher class for SHA-256. */
@@ -50,4 +51,17 @@ std::string SHA256AutoDetect(sha256_implementation::UseImplementation use_implem
  */
 void SHA256D64(unsigned char* output, const unsigned char* input, size_t blocks);
 
+/** Compute the SHA256's of multiple independent messages of arbitrary length.
+ *  Messages are hashed in lockstep, several at a time, when a multi-way
+ *  implementation is available.
+ *  output:   pointer to a messages.size()*32 byte output buffer
+ *  messages: the messages to hash.
+ */
+void SHA256Multi(unsigned char* output, std::span<const std::span<const unsigned char>> messages);
+
+/** Compute the double-SHA256's of multiple independent messages of arbitrary
+ *  length, like SHA256Multi.
+ */
+void SHA256DMulti(unsigned char* output, std::span<const std::span<const unsigned char>> messages);
+
 #endif // BITCOIN_CRYPTO_SHA256_H
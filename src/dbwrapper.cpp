@@ -4,15 +4,18 @@
 
 #include <dbwrapper.h>
 
+#include <dbwrapper_engine.h>
 #include <logging.h>
 #include <random.h>
 #include <serialize.h>
 #include <span.h>
 #include <streams.h>
+#include <tinyformat.h>
 #include <util/fs.h>
 #include <util/fs_helpers.h>
 #include <util/obfuscation.h>
 #include <util/strencodings.h>
+#include <util/string.h>
 
 #include <algorithm>
 #include <cassert>
@@ -32,14 +35,39 @@
 #include <memory>
 #include <optional>
 #include <utility>
+#include <vector>
 
 static auto CharCast(const std::byte* data) { return reinterpret_cast<const char*>(data); }
 
+std::string DBEngineName(DBEngine engine)
+{
+    switch (engine) {
+    case DBEngine::LEVELDB: return "leveldb";
+    case DBEngine::LOGSTORE: return "logstore";
+    } // no default case, so the compiler can warn about missing cases
+    assert(false);
+}
+
+std::optional<DBEngine> DBEngineFromName(std::string_view name)
+{
+    for (const DBEngine engine : {DBEngine::LEVELDB, DBEngine::LOGSTORE}) {
+        if (name == DBEngineName(engine)) return engine;
+    }
+    return std::nullopt;
+}
+
 bool DestroyDB(const std::string& path_str)
 {
+    const fs::path path{fs::PathFromString(path_str)};
+    if (LogStoreExists(path)) return DestroyLogStore(path);
     return leveldb::DestroyDB(path_str, {}).ok();
 }
 
+static bool LevelDBExists(const fs::path& path)
+{
+    return fs::exists(path / "CURRENT");
+}
+
 /** Handle database error by throwing dbwrapper_error exception.
  */
 static void HandleError(const leveldb::Status& status)
@@ -153,13 +181,36 @@ static leveldb::Options GetOptions(size_t nCacheSize)
     return options;
 }
 
-struct CDBBatch::WriteBatchImpl {
+namespace {
+struct LevelDBBatch : public CDBBatch::WriteBatchImpl {
     leveldb::WriteBatch batch;
+
+    void Put(std::span<const std::byte> key, std::span<const std::byte> value) override
+    {
+        batch.Put({CharCast(key.data()), key.size()}, {CharCast(value.data()), value.size()});
+    }
+    void Delete(std::span<const std::byte> key) override { batch.Delete({CharCast(key.data()), key.size()}); }
+    void Clear() override { batch.Clear(); }
+    size_t ApproximateSize() const override { return batch.ApproximateSize(); }
 };
 
+struct LevelDBIterator : public CDBIterator::IteratorImpl {
+    const std::unique_ptr<leveldb::Iterator> iter;
+
+    explicit LevelDBIterator(leveldb::Iterator* _iter) : iter{_iter} {}
+
+    bool Valid() const override { return iter->Valid(); }
+    void SeekToFirst() override { iter->SeekToFirst(); }
+    void Seek(std::span<const std::byte> key) override { iter->Seek({CharCast(key.data()), key.size()}); }
+    void Next() override { iter->Next(); }
+    std::span<const std::byte> Key() const override { return MakeByteSpan(iter->key()); }
+    std::span<const std::byte> Value() const override { return MakeByteSpan(iter->value()); }
+};
+} // namespace
+
 CDBBatch::CDBBatch(const CDBWrapper& _parent)
     : parent{_parent},
-      m_impl_batch{std::make_unique<CDBBatch::WriteBatchImpl>()}
+      m_impl_batch{_parent.DBContext().NewBatch()}
 {
     Clear();
 };
@@ -168,29 +219,27 @@ CDBBatch::~CDBBatch() = default;
 
 void CDBBatch::Clear()
 {
-    m_impl_batch->batch.Clear();
+    m_impl_batch->Clear();
 }
 
 void CDBBatch::WriteImpl(std::span<const std::byte> key, DataStream& ssValue)
 {
-    leveldb::Slice slKey(CharCast(key.data()), key.size());
     dbwrapper_private::GetObfuscation(parent)(ssValue);
-    leveldb::Slice slValue(CharCast(ssValue.data()), ssValue.size());
-    m_impl_batch->batch.Put(slKey, slValue);
+    m_impl_batch->Put(key, ssValue);
 }
 
 void CDBBatch::EraseImpl(std::span<const std::byte> key)
 {
-    leveldb::Slice slKey(CharCast(key.data()), key.size());
-    m_impl_batch->batch.Delete(slKey);
+    m_impl_batch->Delete(key);
 }
 
 size_t CDBBatch::ApproximateSize() const
 {
-    return m_impl_batch->batch.ApproximateSize();
+    return m_impl_batch->ApproximateSize();
 }
 
-struct LevelDBContext {
+namespace {
+struct LevelDBEngine : public DBEngineImpl {
     //! custom environment this database is using (may be nullptr in case of default environment)
     leveldb::Env* penv;
 
@@ -211,25 +260,59 @@ struct LevelDBContext {
 
     //! the database itself
     leveldb::DB* pdb;
+
+    explicit LevelDBEngine(const DBParams& params);
+    ~LevelDBEngine() override;
+
+    std::unique_ptr<CDBBatch::WriteBatchImpl> NewBatch() const override
+    {
+        return std::make_unique<LevelDBBatch>();
+    }
+
+    void Write(CDBBatch::WriteBatchImpl& batch, bool sync) override
+    {
+        leveldb::Status status = pdb->Write(sync ? syncoptions : writeoptions, &static_cast<LevelDBBatch&>(batch).batch);
+        HandleError(status);
+    }
+
+    std::optional<std::string> Read(std::span<const std::byte> key) const override;
+    bool Exists(std::span<const std::byte> key) const override;
+    size_t EstimateSize(std::span<const std::byte> key1, std::span<const std::byte> key2) const override;
+    size_t DynamicMemoryUsage() const override;
+    DBStats GetStats() const override;
+
+    std::unique_ptr<CDBIterator::IteratorImpl> NewIterator() const override
+    {
+        return std::make_unique<LevelDBIterator>(pdb->NewIterator(iteroptions));
+    }
+
+    void Compact() override { pdb->CompactRange(nullptr, nullptr); }
 };
 
-CDBWrapper::CDBWrapper(const DBParams& params)
-    : m_db_context{std::make_unique<LevelDBContext>()}, m_name{fs::PathToString(params.path.stem())}, m_path{params.path}, m_is_memory{params.memory_only}
-{
-    DBContext().penv = nullptr;
-    DBContext().readoptions.verify_checksums = true;
-    DBContext().iteroptions.verify_checksums = true;
-    DBContext().iteroptions.fill_cache = false;
-    DBContext().syncoptions.sync = true;
-    DBContext().options = GetOptions(params.cache_bytes);
-    DBContext().options.create_if_missing = true;
+LevelDBEngine::LevelDBEngine(const DBParams& params)
+{
+    penv = nullptr;
+    readoptions.verify_checksums = true;
+    iteroptions.verify_checksums = true;
+    iteroptions.fill_cache = false;
+    syncoptions.sync = true;
+    options = GetOptions(params.cache_bytes);
+    options.create_if_missing = true;
+    options.max_subcompactions = params.options.compaction_threads;
+    if (params.options.defer_compaction) {
+        // Let level 0 grow well past the default limits. Each compaction then
+        // merges more data at once, and writers are throttled much later.
+        options.l0_compaction_trigger *= 4;
+        options.l0_slowdown_writes_trigger *= 4;
+        options.l0_stop_writes_trigger *= 4;
+    }
     if (params.memory_only) {
-        DBContext().penv = leveldb::NewMemEnv(leveldb::Env::Default());
-        DBContext().options.env = DBContext().penv;
+        penv = leveldb::NewMemEnv(leveldb::Env::Default());
+        options.env = penv;
     } else {
         if (params.wipe_data) {
             LogPrintf("Wiping LevelDB in %s\n", fs::PathToString(params.path));
-            leveldb::Status result = leveldb::DestroyDB(fs::PathToString(params.path), DBContext().options);
+            leveldb::Status result = leveldb::DestroyDB(fs::PathToString(params.path), options);
             HandleError(result);
         }
         TryCreateDirectories(params.path);
@@ -239,13 +322,153 @@ CDBWrapper::CDBWrapper(const DBParams& params)
     // because on POSIX leveldb passes the byte string directly to ::open(), and
     // on Windows it converts from UTF-8 to UTF-16 before calling ::CreateFileW
     // (see env_posix.cc and env_windows.cc).
-    leveldb::Status status = leveldb::DB::Open(DBContext().options, fs::PathToString(params.path), &DBContext().pdb);
+    leveldb::Status status = leveldb::DB::Open(options, fs::PathToString(params.path), &pdb);
     HandleError(status);
     LogPrintf("Opened LevelDB successfully\n");
+}
+
+LevelDBEngine::~LevelDBEngine()
+{
+    delete pdb;
+    pdb = nullptr;
+    delete options.filter_policy;
+    options.filter_policy = nullptr;
+    delete options.info_log;
+    options.info_log = nullptr;
+    delete options.block_cache;
+    options.block_cache = nullptr;
+    delete penv;
+    options.env = nullptr;
+}
+
+size_t LevelDBEngine::DynamicMemoryUsage() const
+{
+    std::string memory;
+    std::optional<size_t> parsed;
+    if (!pdb->GetProperty("leveldb.approximate-memory-usage", &memory) || !(parsed = ToIntegral<size_t>(memory))) {
+        LogDebug(BCLog::LEVELDB, "Failed to get approximate-memory-usage property\n");
+        return 0;
+    }
+    return parsed.value();
+}
+
+//! Parse a LevelDB property made of space-separated unsigned integers.
+static std::vector<uint64_t> GetIntegerProperties(leveldb::DB& db, const std::string& property)
+{
+    std::string value;
+    std::vector<uint64_t> values;
+    if (!db.GetProperty(property, &value)) return values;
+    for (const auto& field : util::SplitString(value, ' ')) {
+        const auto parsed{ToIntegral<uint64_t>(field)};
+        if (!parsed) return {};
+        values.push_back(*parsed);
+    }
+    return values;
+}
+
+DBStats LevelDBEngine::GetStats() const
+{
+    DBStats stats;
+    if (const auto totals{GetIntegerProperties(*pdb, "leveldb.compaction-totals")}; totals.size() == 4) {
+        stats.compactions = totals[0];
+        stats.compaction_micros = totals[1];
+        stats.compaction_bytes_read = totals[2];
+        stats.compaction_bytes_written = totals[3];
+    }
+    // Slowdowns, then stops waiting for a memtable flush and for level-0 compaction.
+    if (const auto stalls{GetIntegerProperties(*pdb, "leveldb.write-stalls")}; stalls.size() == 6) {
+        stats.write_slowdowns = stalls[0];
+        stats.write_slowdown_micros = stalls[1];
+        stats.write_stops = stalls[2] + stalls[4];
+        stats.write_stop_micros = stalls[3] + stalls[5];
+    }
+    for (int level{0};; ++level) {
+        const auto files{GetIntegerProperties(*pdb, strprintf("leveldb.num-files-at-level%d", level))};
+        if (files.size() != 1) break;
+        stats.files_per_level.push_back(files[0]);
+    }
+    return stats;
+}
+
+std::optional<std::string> LevelDBEngine::Read(std::span<const std::byte> key) const
+{
+    leveldb::Slice slKey(CharCast(key.data()), key.size());
+    std::string strValue;
+    leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
+    if (!status.ok()) {
+        if (status.IsNotFound())
+            return std::nullopt;
+        LogPrintf("LevelDB read failure: %s\n", status.ToString());
+        HandleError(status);
+    }
+    return strValue;
+}
+
+bool LevelDBEngine::Exists(std::span<const std::byte> key) const
+{
+    leveldb::Slice slKey(CharCast(key.data()), key.size());
+
+    std::string strValue;
+    leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
+    if (!status.ok()) {
+        if (status.IsNotFound())
+            return false;
+        LogPrintf("LevelDB read failure: %s\n", status.ToString());
+        HandleError(status);
+    }
+    return true;
+}
+
+size_t LevelDBEngine::EstimateSize(std::span<const std::byte> key1, std::span<const std::byte> key2) const
+{
+    leveldb::Slice slKey1(CharCast(key1.data()), key1.size());
+    leveldb::Slice slKey2(CharCast(key2.data()), key2.size());
+    uint64_t size = 0;
+    leveldb::Range range(slKey1, slKey2);
+    pdb->GetApproximateSizes(&range, 1, &size);
+    return size;
+}
+} // namespace
+
+std::unique_ptr<DBEngineImpl> MakeLevelDBEngine(const DBParams& params)
+{
+    return std::make_unique<LevelDBEngine>(params);
+}
+
+static std::unique_ptr<DBEngineImpl> MakeEngine(const DBParams& params)
+{
+    const DBEngine engine{params.options.engine};
+    if (!params.memory_only && !params.wipe_data) {
+        // Refuse to silently open an empty database on top of data written by
+        // another engine, which would look like a fresh datadir to callers.
+        const bool foreign{engine == DBEngine::LEVELDB ? LogStoreExists(params.path) : LevelDBExists(params.path)};
+        if (foreign) {
+            throw dbwrapper_error(strprintf("Database in %s was not created by the %s storage engine",
+                                            fs::PathToString(params.path), DBEngineName(engine)));
+        }
+    }
+    if (!params.memory_only && params.wipe_data && fs::exists(params.path)) {
+        // Remove data left by any engine, so a reindex can switch engines.
+        if (engine == DBEngine::LEVELDB && LogStoreExists(params.path) && !DestroyLogStore(params.path)) {
+            throw dbwrapper_error(strprintf("Failed to wipe database in %s", fs::PathToString(params.path)));
+        }
+        if (engine == DBEngine::LOGSTORE && LevelDBExists(params.path) && !leveldb::DestroyDB(fs::PathToString(params.path), {}).ok()) {
+            throw dbwrapper_error(strprintf("Failed to wipe database in %s", fs::PathToString(params.path)));
+        }
+    }
+    switch (engine) {
+    case DBEngine::LEVELDB: return MakeLevelDBEngine(params);
+    case DBEngine::LOGSTORE: return MakeLogStoreEngine(params);
+    } // no default case, so the compiler can warn about missing cases
+    assert(false);
+}
 
+CDBWrapper::CDBWrapper(const DBParams& params)
+    : m_db_context{MakeEngine(params)}, m_name{fs::PathToString(params.path.stem())}, m_path{params.path}, m_is_memory{params.memory_only}
+{
     if (params.options.force_compact) {
         LogPrintf("Starting database compaction of %s\n", fs::PathToString(params.path));
-        DBContext().pdb->CompactRange(nullptr, nullptr);
+        DBContext().Compact();
         LogPrintf("Finished database compaction of %s\n", fs::PathToString(params.path));
     }
 
@@ -259,19 +482,7 @@ CDBWrapper::CDBWrapper(const DBParams& params)
     LogInfo("Using obfuscation key for %s: %s", fs::PathToString(params.path), m_obfuscation.HexKey());
 }
 
-CDBWrapper::~CDBWrapper()
-{
-    delete DBContext().pdb;
-    DBContext().pdb = nullptr;
-    delete DBContext().options.filter_policy;
-    DBContext().options.filter_policy = nullptr;
-    delete DBContext().options.info_log;
-    DBContext().options.info_log = nullptr;
-    delete DBContext().options.block_cache;
-    DBContext().options.block_cache = nullptr;
-    delete DBContext().penv;
-    DBContext().options.env = nullptr;
-}
+CDBWrapper::~CDBWrapper() = default;
 
 bool CDBWrapper::WriteBatch(CDBBatch& batch, bool fSync)
 {
@@ -280,8 +491,7 @@ bool CDBWrapper::WriteBatch(CDBBatch& batch, bool fSync)
     if (log_memory) {
         mem_before = DynamicMemoryUsage() / 1024.0 / 1024;
     }
-    leveldb::Status status = DBContext().pdb->Write(fSync ? DBContext().syncoptions : DBContext().writeoptions, &batch.m_impl_batch->batch);
-    HandleError(status);
+    DBContext().Write(*batch.m_impl_batch, fSync);
     if (log_memory) {
         double mem_after = DynamicMemoryUsage() / 1024.0 / 1024;
         LogDebug(BCLog::LEVELDB, "WriteBatch memory usage: db=%s, before=%.1fMiB, after=%.1fMiB\n",
@@ -292,52 +502,27 @@ bool CDBWrapper::WriteBatch(CDBBatch& batch, bool fSync)
 
 size_t CDBWrapper::DynamicMemoryUsage() const
 {
-    std::string memory;
-    std::optional<size_t> parsed;
-    if (!DBContext().pdb->GetProperty("leveldb.approximate-memory-usage", &memory) || !(parsed = ToIntegral<size_t>(memory))) {
-        LogDebug(BCLog::LEVELDB, "Failed to get approximate-memory-usage property\n");
-        return 0;
-    }
-    return parsed.value();
+    return DBContext().DynamicMemoryUsage();
+}
+
+DBStats CDBWrapper::GetStats() const
+{
+    return DBContext().GetStats();
 }
 
 std::optional<std::string> CDBWrapper::ReadImpl(std::span<const std::byte> key) const
 {
-    leveldb::Slice slKey(CharCast(key.data()), key.size());
-    std::string strValue;
-    leveldb::Status status = DBContext().pdb->Get(DBContext().readoptions, slKey, &strValue);
-    if (!status.ok()) {
-        if (status.IsNotFound())
-            return std::nullopt;
-        LogPrintf("LevelDB read failure: %s\n", status.ToString());
-        HandleError(status);
-    }
-    return strValue;
+    return DBContext().Read(key);
 }
 
 bool CDBWrapper::ExistsImpl(std::span<const std::byte> key) const
 {
-    leveldb::Slice slKey(CharCast(key.data()), key.size());
-
-    std::string strValue;
-    leveldb::Status status = DBContext().pdb->Get(DBContext().readoptions, slKey, &strValue);
-    if (!status.ok()) {
-        if (status.IsNotFound())
-            return false;
-        LogPrintf("LevelDB read failure: %s\n", status.ToString());
-        HandleError(status);
-    }
-    return true;
+    return DBContext().Exists(key);
 }
 
 size_t CDBWrapper::EstimateSizeImpl(std::span<const std::byte> key1, std::span<const std::byte> key2) const
 {
-    leveldb::Slice slKey1(CharCast(key1.data()), key1.size());
-    leveldb::Slice slKey2(CharCast(key2.data()), key2.size());
-    uint64_t size = 0;
-    leveldb::Range range(slKey1, slKey2);
-    DBContext().pdb->GetApproximateSizes(&range, 1, &size);
-    return size;
+    return DBContext().EstimateSize(key1, key2);
 }
 
 bool CDBWrapper::IsEmpty()
@@ -347,40 +532,33 @@ bool CDBWrapper::IsEmpty()
     return !(it->Valid());
 }
 
-struct CDBIterator::IteratorImpl {
-    const std::unique_ptr<leveldb::Iterator> iter;
-
-    explicit IteratorImpl(leveldb::Iterator* _iter) : iter{_iter} {}
-};
-
 CDBIterator::CDBIterator(const CDBWrapper& _parent, std::unique_ptr<IteratorImpl> _piter) : parent(_parent),
                                                                                             m_impl_iter(std::move(_piter)) {}
 
 CDBIterator* CDBWrapper::NewIterator()
 {
-    return new CDBIterator{*this, std::make_unique<CDBIterator::IteratorImpl>(DBContext().pdb->NewIterator(DBContext().iteroptions))};
+    return new CDBIterator{*this, DBContext().NewIterator()};
 }
 
 void CDBIterator::SeekImpl(std::span<const std::byte> key)
 {
-    leveldb::Slice slKey(CharCast(key.data()), key.size());
-    m_impl_iter->iter->Seek(slKey);
+    m_impl_iter->Seek(key);
 }
 
 std::span<const std::byte> CDBIterator::GetKeyImpl() const
 {
-    return MakeByteSpan(m_impl_iter->iter->key());
+    return m_impl_iter->Key();
 }
 
 std::span<const std::byte> CDBIterator::GetValueImpl() const
 {
-    return MakeByteSpan(m_impl_iter->iter->value());
+    return m_impl_iter->Value();
 }
 
 CDBIterator::~CDBIterator() = default;
-bool CDBIterator::Valid() const { return m_impl_iter->iter->Valid(); }
-void CDBIterator::SeekToFirst() { m_impl_iter->iter->SeekToFirst(); }
-void CDBIterator::Next() { m_impl_iter->iter->Next(); }
+bool CDBIterator::Valid() const { return m_impl_iter->Valid(); }
+void CDBIterator::SeekToFirst() { m_impl_iter->SeekToFirst(); }
+void CDBIterator::Next() { m_impl_iter->Next(); }
 
 namespace dbwrapper_private {
 
@@ -13,29 +13,73 @@
 #include <util/fs.h>
 
 #include <cstddef>
+#include <cstdint>
 #include <exception>
 #include <memory>
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <vector>
 
 static const size_t DBWRAPPER_PREALLOC_KEY_SIZE = 64;
 static const size_t DBWRAPPER_PREALLOC_VALUE_SIZE = 1024;
 static const size_t DBWRAPPER_MAX_FILE_SIZE = 32 << 20; // 32 MiB
 
+//! Storage engine used to persist the contents of a CDBWrapper.
+enum class DBEngine {
+    //! The bundled LevelDB.
+    LEVELDB,
+    //! Append-only log with an in-memory key index, see dbwrapper_logstore.cpp.
+    LOGSTORE,
+};
+
+static constexpr DBEngine DEFAULT_DB_ENGINE{DBEngine::LEVELDB};
+static constexpr int DEFAULT_DB_COMPACTION_THREADS{1};
+static constexpr int MAX_DB_COMPACTION_THREADS{64};
+static constexpr bool DEFAULT_DB_DEFER_COMPACTION{false};
+
+std::string DBEngineName(DBEngine engine);
+std::optional<DBEngine> DBEngineFromName(std::string_view name);
+
 //! User-controlled performance and debug options.
 struct DBOptions {
     //! Compact database on startup.
     bool force_compact = false;
+    //! Storage engine to open the database with.
+    DBEngine engine = DEFAULT_DB_ENGINE;
+    //! Number of threads a single compaction may be split across (LevelDB only).
+    int compaction_threads = DEFAULT_DB_COMPACTION_THREADS;
+    //! Let many more level-0 files pile up before compacting and throttling
+    //! writes, trading read performance for write throughput during bulk
+    //! loads such as IBD (LevelDB only).
+    bool defer_compaction = DEFAULT_DB_DEFER_COMPACTION;
+};
+
+//! Cumulative storage engine statistics since the database was opened.
+struct DBStats {
+    //! Background compactions (for the log store: log rewrites).
+    uint64_t compactions{0};
+    uint64_t compaction_micros{0};
+    uint64_t compaction_bytes_read{0};
+    uint64_t compaction_bytes_written{0};
+    //! Writes that were slowed down to let compaction keep up.
+    uint64_t write_slowdowns{0};
+    uint64_t write_slowdown_micros{0};
+    //! Writes that were blocked until a memtable flush or compaction finished.
+    uint64_t write_stops{0};
+    uint64_t write_stop_micros{0};
+    //! Number of table files at each level; empty if the engine has no levels.
+    std::vector<uint64_t> files_per_level;
 };
 
 //! Application-specific storage settings.
 struct DBParams {
-    //! Location in the filesystem where leveldb data will be stored.
+    //! Location in the filesystem where database data will be stored.
     fs::path path;
-    //! Configures various leveldb cache settings.
+    //! Configures various storage engine cache settings.
     size_t cache_bytes;
-    //! If true, use leveldb's memory environment.
+    //! If true, keep all data in memory.
     bool memory_only = false;
     //! If true, remove all existing data.
     bool wipe_data = false;
@@ -65,6 +109,7 @@ namespace dbwrapper_private {
 const Obfuscation& GetObfuscation(const CDBWrapper&);
 }; // namespace dbwrapper_private
 
+/** Remove the database at path_str, whichever storage engine created it. */
 bool DestroyDB(const std::string& path_str);
 
 /** Batch of changes queued to be written to a CDBWrapper */
@@ -72,10 +117,12 @@ class CDBBatch
 {
     friend class CDBWrapper;
 
+public:
+    struct WriteBatchImpl;
+
 private:
     const CDBWrapper &parent;
 
-    struct WriteBatchImpl;
     const std::unique_ptr<WriteBatchImpl> m_impl_batch;
 
     DataStream ssKey{};
@@ -133,7 +180,7 @@ public:
 
     /**
      * @param[in] _parent          Parent CDBWrapper instance.
-     * @param[in] _piter           The original leveldb iterator.
+     * @param[in] _piter           The storage engine's iterator.
      */
     CDBIterator(const CDBWrapper& _parent, std::unique_ptr<IteratorImpl> _piter);
     ~CDBIterator();
@@ -173,14 +220,15 @@ public:
     }
 };
 
-struct LevelDBContext;
+struct DBEngineImpl;
 
 class CDBWrapper
 {
+    friend class CDBBatch;
     friend const Obfuscation& dbwrapper_private::GetObfuscation(const CDBWrapper&);
 private:
-    //! holds all leveldb-specific fields of this class
-    std::unique_ptr<LevelDBContext> m_db_context;
+    //! holds all storage engine specific state of this class
+    std::unique_ptr<DBEngineImpl> m_db_context;
 
     //! the name of this database
     std::string m_name;
@@ -264,9 +312,12 @@ public:
 
     bool WriteBatch(CDBBatch& batch, bool fSync = false);
 
-    // Get an estimate of LevelDB memory usage (in bytes).
+    // Get an estimate of the storage engine's memory usage (in bytes).
     size_t DynamicMemoryUsage() const;
 
+    //! Get compaction and write stall statistics of the storage engine.
+    DBStats GetStats() const;
+
     CDBIterator* NewIterator();
 
     /**
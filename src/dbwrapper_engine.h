@@ -0,0 +1,65 @@
+// Copyright (c) 2012-present The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_DBWRAPPER_ENGINE_H
+#define BITCOIN_DBWRAPPER_ENGINE_H
+
+#include <dbwrapper.h>
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+
+/** Storage engine interface behind CDBWrapper, CDBBatch and CDBIterator.
+ *
+ * Keys and values are opaque byte strings. Keys are ordered bytewise (like
+ * memcmp), and values are already obfuscated by the caller. Errors are
+ * reported by throwing dbwrapper_error.
+ */
+
+struct CDBBatch::WriteBatchImpl {
+    virtual ~WriteBatchImpl() = default;
+    virtual void Put(std::span<const std::byte> key, std::span<const std::byte> value) = 0;
+    virtual void Delete(std::span<const std::byte> key) = 0;
+    virtual void Clear() = 0;
+    virtual size_t ApproximateSize() const = 0;
+};
+
+/** Iterators must observe a consistent snapshot of the database as of their
+ * creation, and must not outlive the engine that created them. */
+struct CDBIterator::IteratorImpl {
+    virtual ~IteratorImpl() = default;
+    virtual bool Valid() const = 0;
+    virtual void SeekToFirst() = 0;
+    virtual void Seek(std::span<const std::byte> key) = 0;
+    virtual void Next() = 0;
+    virtual std::span<const std::byte> Key() const = 0;
+    virtual std::span<const std::byte> Value() const = 0;
+};
+
+struct DBEngineImpl {
+    virtual ~DBEngineImpl() = default;
+    virtual std::unique_ptr<CDBBatch::WriteBatchImpl> NewBatch() const = 0;
+    virtual void Write(CDBBatch::WriteBatchImpl& batch, bool sync) = 0;
+    virtual std::optional<std::string> Read(std::span<const std::byte> key) const = 0;
+    virtual bool Exists(std::span<const std::byte> key) const = 0;
+    virtual size_t EstimateSize(std::span<const std::byte> key1, std::span<const std::byte> key2) const = 0;
+    virtual size_t DynamicMemoryUsage() const = 0;
+    virtual DBStats GetStats() const = 0;
+    virtual std::unique_ptr<CDBIterator::IteratorImpl> NewIterator() const = 0;
+    //! Compact the whole key range.
+    virtual void Compact() = 0;
+};
+
+std::unique_ptr<DBEngineImpl> MakeLevelDBEngine(const DBParams& params);
+std::unique_ptr<DBEngineImpl> MakeLogStoreEngine(const DBParams& params);
+
+//! Whether path holds a database written by the log store engine.
+bool LogStoreExists(const fs::path& path);
+//! Remove a log store database. Returns false on failure.
+bool DestroyLogStore(const fs::path& path);
+
+#endif // BITCOIN_DBWRAPPER_ENGINE_H
@@ -0,0 +1,698 @@
+// Copyright (c) 2012-present The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/**
+ * Log store: a write-optimized storage engine for CDBWrapper.
+ *
+ * Every WriteBatch is appended to a single log file (data.log) as one
+ * checksummed record, so a write costs one sequential write(2), plus an fsync
+ * if requested. There are no memtable flushes, levels or background
+ * compactions competing with the writer for disk bandwidth.
+ *
+ * An in-memory ordered index maps each live key to the position of its value
+ * in the log. Reads are an index lookup plus one positioned read, and Exists()
+ * does not touch the disk at all. The index is rebuilt by replaying the log on
+ * open; a torn batch at the end of the log (left by a crash during a write)
+ * fails its checksum and is truncated away.
+ *
+ * Space used by overwritten and erased entries is reclaimed by rewriting the
+ * live entries, in key order, into a fresh log once the dead bytes outweigh
+ * the live ones. Rewriting is postponed while iterators are open, because
+ * they may still read values from the current log.
+ *
+ * Iterators see the database as of their creation. Rather than copying the
+ * index, every batch gets a sequence number and an entry that is overwritten
+ * or erased while an open iterator can still see it keeps its old version
+ * around. Those versions, and the erased entries, are dropped once no
+ * iterators are left.
+ *
+ * Memory usage grows with the number of keys rather than being bounded by
+ * cache_bytes, so this engine suits the block index and the optional indexes
+ * better than a very large chainstate.
+ */
+
+#include <dbwrapper_engine.h>
+
+#include <crypto/common.h>
+#include <hash.h>
+#include <logging.h>
+#include <memusage.h>
+#include <serialize.h>
+#include <span.h>
+#include <streams.h>
+#include <sync.h>
+#include <tinyformat.h>
+#include <util/fs.h>
+#include <util/fs_helpers.h>
+#include <util/syserror.h>
+#include <util/time.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ios>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+static const char* const LOG_FILENAME{"data.log"};
+static const char* const COMPACT_FILENAME{"data.log.new"};
+static const char* const LOCK_FILENAME{"LOCK"};
+
+//! Each batch is prefixed by its payload size and checksum.
+static constexpr size_t BATCH_HEADER_SIZE{8};
+static constexpr unsigned int CHECKSUM_SEED{0x6c6f6773}; // "logs"
+
+static constexpr uint8_t RECORD_ERASE{0};
+static constexpr uint8_t RECORD_PUT{1};
+
+//! Don't bother rewriting the log before this much space can be reclaimed.
+static constexpr uint64_t COMPACT_MIN_DEAD_BYTES{64 << 20};
+//! Size of the batches the live entries are rewritten in.
+static constexpr size_t COMPACT_BATCH_SIZE{1 << 20};
+
+std::string_view AsStringView(std::span<const std::byte> s)
+{
+    return {reinterpret_cast<const char*>(s.data()), s.size()};
+}
+
+//! Number of bytes a record for the given key and value sizes occupies in the log.
+uint64_t RecordSize(size_t key_size, std::optional<size_t> value_size)
+{
+    uint64_t size{1 + GetSizeOfCompactSize(key_size) + key_size};
+    if (value_size) size += GetSizeOfCompactSize(*value_size) + *value_size;
+    return size;
+}
+
+struct LogStoreBatch : public CDBBatch::WriteBatchImpl {
+    struct Op {
+        //! Offsets are relative to the start of the batch, header included.
+        size_t key_pos;
+        size_t key_size;
+        std::optional<size_t> value_pos;
+        size_t value_size;
+    };
+
+    //! Serialized batch, starting with room for the header.
+    DataStream data;
+    std::vector<Op> ops;
+
+    LogStoreBatch() { Clear(); }
+
+    void Put(std::span<const std::byte> key, std::span<const std::byte> value) override
+    {
+        data << RECORD_PUT;
+        WriteCompactSize(data, key.size());
+        const size_t key_pos{data.size()};
+        data.write(key);
+        WriteCompactSize(data, value.size());
+        const size_t value_pos{data.size()};
+        data.write(value);
+        ops.push_back({key_pos, key.size(), value_pos, value.size()});
+    }
+
+    void Delete(std::span<const std::byte> key) override
+    {
+        data << RECORD_ERASE;
+        WriteCompactSize(data, key.size());
+        const size_t key_pos{data.size()};
+        data.write(key);
+        ops.push_back({key_pos, key.size(), std::nullopt, 0});
+    }
+
+    void Clear() override
+    {
+        data.clear();
+        data.resize(BATCH_HEADER_SIZE);
+        ops.clear();
+    }
+
+    size_t ApproximateSize() const override { return data.size(); }
+
+    std::string_view Key(const Op& op) const { return AsStringView(std::span{data}.subspan(op.key_pos, op.key_size)); }
+
+    //! Fill in the header and return the bytes to append to the log.
+    std::span<const std::byte> Finalize()
+    {
+        const size_t payload_size{data.size() - BATCH_HEADER_SIZE};
+        if (payload_size > std::numeric_limits<uint32_t>::max()) {
+            throw dbwrapper_error("Log store batch too large");
+        }
+        const auto payload{std::span{data}.subspan(BATCH_HEADER_SIZE)};
+        WriteLE32(UCharCast(data.data()), payload_size);
+        WriteLE32(UCharCast(data.data() + 4), MurmurHash3(CHECKSUM_SEED, UCharSpanCast(payload)));
+        return data;
+    }
+};
+
+class LogStoreEngine : public DBEngineImpl
+{
+public:
+    struct Location {
+        uint64_t pos;
+        uint32_t size;
+    };
+    struct Version {
+        //! Sequence number of the batch that wrote this version.
+        uint64_t seq;
+        //! Location of the value, or nullopt if the key was erased.
+        std::optional<Location> loc;
+    };
+    struct Entry {
+        Version current;
+        //! Older versions still visible to open iterators, oldest first.
+        std::vector<Version> older;
+    };
+    using Index = std::map<std::string, Entry, std::less<>>;
+
+private:
+    const fs::path m_path;
+    const bool m_memory_only;
+
+    mutable Mutex m_mutex;
+    //! Live keys, plus erased ones that open iterators may still see.
+    Index m_index GUARDED_BY(m_mutex);
+    //! Entries with older versions or erased, to be cleaned up once no
+    //! iterators are open.
+    std::vector<Index::iterator> m_pinned GUARDED_BY(m_mutex);
+    //! Sequence number of the last written batch.
+    uint64_t m_seq GUARDED_BY(m_mutex){0};
+    //! Sequence number of the most recently created iterator.
+    mutable uint64_t m_snapshot_seq GUARDED_BY(m_mutex){0};
+    //! The log, on disk or in memory.
+    std::unique_ptr<AutoFile> m_file GUARDED_BY(m_mutex);
+    std::vector<std::byte> m_memory_log GUARDED_BY(m_mutex);
+    uint64_t m_log_size GUARDED_BY(m_mutex){0};
+    //! Log bytes taken up by the records of live entries.
+    uint64_t m_live_bytes GUARDED_BY(m_mutex){0};
+    size_t m_key_bytes GUARDED_BY(m_mutex){0};
+    mutable int m_open_iterators GUARDED_BY(m_mutex){0};
+    //! Totals of the log rewrites done so far.
+    DBStats m_stats GUARDED_BY(m_mutex);
+
+    fs::path LogPath() const { return m_path / LOG_FILENAME; }
+
+    static const std::optional<Location>& Visible(const Entry& entry, uint64_t seq);
+    Index::const_iterator SkipHidden(Index::const_iterator it, uint64_t seq) const EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    void Apply(std::string_view key, std::optional<Location> loc) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    void Unpin() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    void Replay(AutoFile& file, uint64_t file_size) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    void OpenLog() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    void AppendLog(std::span<const std::byte> data) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    void ReadLog(uint64_t pos, std::span<std::byte> dst) const EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+    void Rewrite() EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+
+public:
+    explicit LogStoreEngine(const DBParams& params);
+    ~LogStoreEngine() override;
+
+    std::unique_ptr<CDBBatch::WriteBatchImpl> NewBatch() const override { return std::make_unique<LogStoreBatch>(); }
+    void Write(CDBBatch::WriteBatchImpl& batch, bool sync) override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    std::optional<std::string> Read(std::span<const std::byte> key) const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    bool Exists(std::span<const std::byte> key) const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    size_t EstimateSize(std::span<const std::byte> key1, std::span<const std::byte> key2) const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    size_t DynamicMemoryUsage() const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    DBStats GetStats() const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    std::unique_ptr<CDBIterator::IteratorImpl> NewIterator() const override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void Compact() override EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    //! Used by iterators to move through the index as of sequence number seq,
+    //! and to read values from the log.
+    Index::const_iterator IteratorSeek(std::span<const std::byte> key, uint64_t seq) const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    Index::const_iterator IteratorNext(Index::const_iterator it, uint64_t seq) const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void ReadValue(Index::const_iterator it, uint64_t seq, std::vector<std::byte>& value) const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void ReleaseIterator() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
+class LogStoreIterator : public CDBIterator::IteratorImpl
+{
+    const LogStoreEngine& m_engine;
+    //! Sequence number of the last batch this iterator sees.
+    const uint64_t m_seq;
+    //! Index entries are not removed while iterators are open, so the end
+    //! iterator and the keys stay valid without holding the engine's lock.
+    const LogStoreEngine::Index::const_iterator m_end;
+    LogStoreEngine::Index::const_iterator m_it;
+    mutable std::vector<std::byte> m_value;
+    mutable bool m_value_loaded{false};
+
+public:
+    LogStoreIterator(const LogStoreEngine& engine, uint64_t seq, LogStoreEngine::Index::const_iterator end)
+        : m_engine{engine}, m_seq{seq}, m_end{end}, m_it{end} {}
+    ~LogStoreIterator() override { m_engine.ReleaseIterator(); }
+
+    bool Valid() const override { return m_it != m_end; }
+    void SeekToFirst() override
+    {
+        m_it = m_engine.IteratorSeek({}, m_seq);
+        m_value_loaded = false;
+    }
+    void Seek(std::span<const std::byte> key) override
+    {
+        m_it = m_engine.IteratorSeek(key, m_seq);
+        m_value_loaded = false;
+    }
+    void Next() override
+    {
+        m_it = m_engine.IteratorNext(m_it, m_seq);
+        m_value_loaded = false;
+    }
+    std::span<const std::byte> Key() const override { return MakeByteSpan(m_it->first); }
+    std::span<const std::byte> Value() const override
+    {
+        if (!m_value_loaded) {
+            m_engine.ReadValue(m_it, m_seq, m_value);
+            m_value_loaded = true;
+        }
+        return m_value;
+    }
+};
+
+LogStoreEngine::LogStoreEngine(const DBParams& params)
+    : m_path{params.path}, m_memory_only{params.memory_only}
+{
+    if (m_memory_only) return;
+
+    if (params.wipe_data) {
+        LogPrintf("Wiping log store in %s\n", fs::PathToString(m_path));
+        if (!DestroyLogStore(m_path)) {
+            throw dbwrapper_error(strprintf("Fatal log store error: failed to wipe %s", fs::PathToString(m_path)));
+        }
+    }
+    TryCreateDirectories(m_path);
+    if (util::LockDirectory(m_path, LOCK_FILENAME) != util::LockResult::Success) {
+        throw dbwrapper_error(strprintf("Fatal log store error: cannot obtain a lock on %s", fs::PathToString(m_path)));
+    }
+    LogPrintf("Opening log store in %s\n", fs::PathToString(m_path));
+    // A leftover rewrite output is incomplete, the original log is intact.
+    fs::remove(m_path / COMPACT_FILENAME);
+    LOCK(m_mutex);
+    try {
+        OpenLog();
+    } catch (...) {
+        // The destructor does not run when the constructor throws.
+        UnlockDirectory(m_path, LOCK_FILENAME);
+        throw;
+    }
+    LogPrintf("Opened log store successfully (%u keys, %u bytes)\n", m_index.size(), m_log_size);
+}
+
+LogStoreEngine::~LogStoreEngine()
+{
+    LOCK(m_mutex);
+    if (m_file && m_file->fclose() != 0) {
+        LogError("Failed to close log store %s: %s", fs::PathToString(LogPath()), SysErrorString(errno));
+    }
+    if (!m_memory_only) UnlockDirectory(m_path, LOCK_FILENAME);
+}
+
+const std::optional<LogStoreEngine::Location>& LogStoreEngine::Visible(const Entry& entry, uint64_t seq)
+{
+    static const std::optional<Location> absent;
+    if (entry.current.seq <= seq) return entry.current.loc;
+    for (auto it{entry.older.rbegin()}; it != entry.older.rend(); ++it) {
+        if (it->seq <= seq) return it->loc;
+    }
+    return absent;
+}
+
+LogStoreEngine::Index::const_iterator LogStoreEngine::SkipHidden(Index::const_iterator it, uint64_t seq) const
+{
+    while (it != m_index.end() && !Visible(it->second, seq)) ++it;
+    return it;
+}
+
+void LogStoreEngine::Apply(std::string_view key, std::optional<Location> loc)
+{
+    auto it{m_index.find(key)};
+    const std::optional<Location> old_loc{it != m_index.end() ? it->second.current.loc : std::nullopt};
+    if (old_loc) {
+        m_live_bytes -= RecordSize(key.size(), old_loc->size);
+        if (!loc) m_key_bytes -= key.size();
+    } else if (loc) {
+        m_key_bytes += key.size();
+    }
+    if (loc) m_live_bytes += RecordSize(key.size(), loc->size);
+
+    if (it == m_index.end()) {
+        if (loc) m_index.emplace(std::string{key}, Entry{.current = {m_seq, loc}, .older = {}});
+        return;
+    }
+    Entry& entry{it->second};
+    if (m_open_iterators > 0 && entry.current.seq <= m_snapshot_seq) {
+        // An open iterator may see the current version, keep it.
+        if (entry.older.empty()) m_pinned.push_back(it);
+        entry.older.push_back(entry.current);
+    } else if (!loc && entry.older.empty()) {
+        m_index.erase(it);
+        return;
+    }
+    entry.current = {m_seq, loc};
+}
+
+void LogStoreEngine::Unpin()
+{
+    for (const auto it : m_pinned) {
+        it->second.older.clear();
+        if (!it->second.current.loc) m_index.erase(it);
+    }
+    m_pinned.clear();
+}
+
+void LogStoreEngine::Replay(AutoFile& file, uint64_t file_size)
+{
+    std::vector<std::byte> payload;
+    while (m_log_size + BATCH_HEADER_SIZE <= file_size) {
+        std::array<std::byte, BATCH_HEADER_SIZE> header;
+        file.read(header);
+        const uint32_t payload_size{ReadLE32(UCharCast(header.data()))};
+        // A batch that does not fit in the file is a torn final write.
+        const uint64_t batch_end{m_log_size + BATCH_HEADER_SIZE + payload_size};
+        if (batch_end > file_size) break;
+        payload.resize(payload_size);
+        file.read(payload);
+        if (ReadLE32(UCharCast(header.data() + 4)) != MurmurHash3(CHECKSUM_SEED, MakeUCharSpan(payload))) {
+            // Only the last batch can be torn. Dropping a bad batch followed
+            // by more data would silently lose the committed batches after it.
+            if (batch_end == file_size) break;
+            throw dbwrapper_error(strprintf("Fatal log store error: checksum mismatch in batch at offset %u in %s",
+                                            m_log_size, fs::PathToString(LogPath())));
+        }
+
+        const uint64_t payload_pos{m_log_size + BATCH_HEADER_SIZE};
+        SpanReader reader{payload};
+        try {
+            while (!reader.empty()) {
+                uint8_t type;
+                reader >> type;
+                const uint64_t key_size{ReadCompactSize(reader, false)};
+                const size_t key_pos{payload_size - reader.size()};
+                reader.ignore(key_size);
+                const std::string_view key{AsStringView(std::span{payload}.subspan(key_pos, key_size))};
+                if (type == RECORD_ERASE) {
+                    Apply(key, std::nullopt);
+                } else if (type == RECORD_PUT) {
+                    const uint64_t value_size{ReadCompactSize(reader, false)};
+                    const size_t value_pos{payload_size - reader.size()};
+                    reader.ignore(value_size);
+                    Apply(key, Location{payload_pos + value_pos, uint32_t(value_size)});
+                } else {
+                    throw std::ios_base::failure("unknown record type");
+                }
+            }
+        } catch (const std::ios_base::failure& e) {
+            // The checksum matched, so this is not a torn write.
+            throw dbwrapper_error(strprintf("Fatal log store error: corrupted batch at offset %u in %s: %s",
+                                            m_log_size, fs::PathToString(LogPath()), e.what()));
+        }
+        m_log_size += BATCH_HEADER_SIZE + payload_size;
+    }
+}
+
+void LogStoreEngine::OpenLog()
+{
+    const fs::path log_path{LogPath()};
+    if (!fs::exists(log_path)) {
+        AutoFile file{fsbridge::fopen(log_path, "wb")};
+        if (file.IsNull() || file.fclose() != 0) {
+            throw dbwrapper_error(strprintf("Fatal log store error: failed to create %s", fs::PathToString(log_path)));
+        }
+    }
+
+    const uint64_t file_size{fs::file_size(log_path)};
+    {
+        AutoFile file{fsbridge::fopen(log_path, "rb")};
+        if (file.IsNull()) {
+            throw dbwrapper_error(strprintf("Fatal log store error: failed to open %s", fs::PathToString(log_path)));
+        }
+        try {
+            Replay(file, file_size);
+        } catch (const std::ios_base::failure& e) {
+            throw dbwrapper_error(strprintf("Fatal log store error: failed to read %s: %s", fs::PathToString(log_path), e.what()));
+        }
+    }
+    if (m_log_size < file_size) {
+        LogWarning("Truncating %u bytes of incomplete writes from %s", file_size - m_log_size, fs::PathToString(log_path));
+        fs::resize_file(log_path, m_log_size);
+    }
+
+    std::FILE* file{fsbridge::fopen(log_path, "r+b")};
+    if (!file) {
+        throw dbwrapper_error(strprintf("Fatal log store error: failed to open %s", fs::PathToString(log_path)));
+    }
+    // Batches are appended with a single fwrite() and values read with a
+    // single fread(), so stdio buffering would only add copies.
+    std::setvbuf(file, nullptr, _IONBF, 0);
+    m_file = std::make_unique<AutoFile>(file);
+}
+
+void LogStoreEngine::AppendLog(std::span<const std::byte> data)
+{
+    if (m_memory_only) {
+        m_memory_log.insert(m_memory_log.end(), data.begin(), data.end());
+    } else {
+        if (m_log_size + data.size() > uint64_t(std::numeric_limits<long>::max())) {
+            throw dbwrapper_error(strprintf("Fatal log store error: %s exceeds the maximum file size", fs::PathToString(LogPath())));
+        }
+        try {
+            m_file->seek(m_log_size, SEEK_SET);
+            m_file->write(data);
+        } catch (const std::ios_base::failure& e) {
+            throw dbwrapper_error(strprintf("Fatal log store error: failed to write %s: %s", fs::PathToString(LogPath()), e.what()));
+        }
+    }
+    m_log_size += data.size();
+}
+
+void LogStoreEngine::ReadLog(uint64_t pos, std::span<std::byte> dst) const
+{
+    if (m_memory_only) {
+        std::copy_n(m_memory_log.begin() + pos, dst.size(), dst.begin());
+        return;
+    }
+    try {
+        m_file->seek(pos, SEEK_SET);
+        m_file->read(dst);
+    } catch (const std::ios_base::failure& e) {
+        throw dbwrapper_error(strprintf("Fatal log store error: failed to read %s: %s", fs::PathToString(LogPath()), e.what()));
+    }
+}
+
+void LogStoreEngine::Write(CDBBatch::WriteBatchImpl& batch_impl, bool sync)
+{
+    auto& batch{static_cast<LogStoreBatch&>(batch_impl)};
+    if (batch.ops.empty()) return;
+
+    LOCK(m_mutex);
+    const uint64_t batch_pos{m_log_size};
+    AppendLog(batch.Finalize());
+    if (sync && !m_memory_only && !m_file->Commit()) {
+        throw dbwrapper_error(strprintf("Fatal log store error: failed to sync %s", fs::PathToString(LogPath())));
+    }
+
+    if (m_open_iterators == 0) Unpin();
+    ++m_seq;
+    for (const auto& op : batch.ops) {
+        std::optional<Location> loc;
+        if (op.value_pos) loc = Location{batch_pos + *op.value_pos, uint32_t(op.value_size)};
+        Apply(batch.Key(op), loc);
+    }
+
+    const uint64_t dead_bytes{m_log_size - m_live_bytes};
+    if (dead_bytes >= COMPACT_MIN_DEAD_BYTES && dead_bytes > m_live_bytes) Rewrite();
+}
+
+void LogStoreEngine::Rewrite()
+{
+    if (m_open_iterators > 0) return;
+    Unpin();
+
+    const auto start{SteadyClock::now()};
+    const uint64_t old_size{m_log_size};
+    std::vector<std::byte> memory_log;
+    std::unique_ptr<AutoFile> file;
+    const fs::path compact_path{m_path / COMPACT_FILENAME};
+    if (!m_memory_only) {
+        file = std::make_unique<AutoFile>(fsbridge::fopen(compact_path, "wb"));
+        if (file->IsNull()) {
+            throw dbwrapper_error(strprintf("Fatal log store error: failed to create %s", fs::PathToString(compact_path)));
+        }
+    }
+
+    // Copy the live entries in key order, remembering their new locations,
+    // which are only applied once the new log is complete.
+    std::vector<Location> locations;
+    locations.reserve(m_index.size());
+    uint64_t new_size{0};
+    LogStoreBatch batch;
+    std::vector<std::byte> value;
+    const auto flush{[&] {
+        const uint64_t batch_pos{new_size};
+        const auto data{batch.Finalize()};
+        if (file) {
+            file->write(data);
+        } else {
+            memory_log.insert(memory_log.end(), data.begin(), data.end());
+        }
+        new_size += data.size();
+        for (const auto& op : batch.ops) locations.push_back({batch_pos + *op.value_pos, uint32_t(op.value_size)});
+        batch.Clear();
+    }};
+    try {
+        for (const auto& [key, entry] : m_index) {
+            const Location& loc{*entry.current.loc};
+            value.resize(loc.size);
+            ReadLog(loc.pos, value);
+            batch.Put(MakeByteSpan(key), value);
+            if (batch.ApproximateSize() >= COMPACT_BATCH_SIZE) flush();
+        }
+        if (!batch.ops.empty()) flush();
+    } catch (const std::ios_base::failure& e) {
+        throw dbwrapper_error(strprintf("Fatal log store error: failed to write %s: %s", fs::PathToString(compact_path), e.what()));
+    }
+
+    if (file) {
+        if (!file->Commit() || file->fclose() != 0 || m_file->fclose() != 0) {
+            throw dbwrapper_error(strprintf("Fatal log store error: failed to write %s", fs::PathToString(compact_path)));
+        }
+        m_file.reset();
+        if (!RenameOver(compact_path, LogPath())) {
+            throw dbwrapper_error(strprintf("Fatal log store error: failed to replace %s", fs::PathToString(LogPath())));
+        }
+        DirectoryCommit(m_path);
+        std::FILE* new_file{fsbridge::fopen(LogPath(), "r+b")};
+        if (!new_file) {
+            throw dbwrapper_error(strprintf("Fatal log store error: failed to open %s", fs::PathToString(LogPath())));
+        }
+        std::setvbuf(new_file, nullptr, _IONBF, 0);
+        m_file = std::make_unique<AutoFile>(new_file);
+    } else {
+        m_memory_log = std::move(memory_log);
+    }
+
+    auto it{locations.begin()};
+    for (auto& [key, entry] : m_index) entry.current.loc = *it++;
+    m_log_size = new_size;
+    ++m_stats.compactions;
+    m_stats.compaction_micros += Ticks<std::chrono::microseconds>(SteadyClock::now() - start);
+    m_stats.compaction_bytes_read += old_size;
+    m_stats.compaction_bytes_written += new_size;
+    LogDebug(BCLog::LEVELDB, "Rewrote log store %s: %u -> %u bytes\n", fs::PathToString(m_path), old_size, new_size);
+}
+
+std::optional<std::string> LogStoreEngine::Read(std::span<const std::byte> key) const
+{
+    LOCK(m_mutex);
+    const auto it{m_index.find(AsStringView(key))};
+    if (it == m_index.end() || !it->second.current.loc) return std::nullopt;
+    const Location& loc{*it->second.current.loc};
+    std::string value(loc.size, '\0');
+    ReadLog(loc.pos, MakeWritableByteSpan(value));
+    return value;
+}
+
+bool LogStoreEngine::Exists(std::span<const std::byte> key) const
+{
+    LOCK(m_mutex);
+    const auto it{m_index.find(AsStringView(key))};
+    return it != m_index.end() && it->second.current.loc;
+}
+
+size_t LogStoreEngine::EstimateSize(std::span<const std::byte> key1, std::span<const std::byte> key2) const
+{
+    LOCK(m_mutex);
+    size_t size{0};
+    const auto end{m_index.lower_bound(AsStringView(key2))};
+    for (auto it{m_index.lower_bound(AsStringView(key1))}; it != end; ++it) {
+        if (const auto& loc{it->second.current.loc}) size += RecordSize(it->first.size(), loc->size);
+    }
+    return size;
+}
+
+size_t LogStoreEngine::DynamicMemoryUsage() const
+{
+    LOCK(m_mutex);
+    return memusage::DynamicUsage(m_index) + m_key_bytes + memusage::DynamicUsage(m_memory_log);
+}
+
+DBStats LogStoreEngine::GetStats() const
+{
+    LOCK(m_mutex);
+    return m_stats;
+}
+
+std::unique_ptr<CDBIterator::IteratorImpl> LogStoreEngine::NewIterator() const
+{
+    LOCK(m_mutex);
+    ++m_open_iterators;
+    m_snapshot_seq = m_seq;
+    return std::make_unique<LogStoreIterator>(*this, m_seq, m_index.end());
+}
+
+LogStoreEngine::Index::const_iterator LogStoreEngine::IteratorSeek(std::span<const std::byte> key, uint64_t seq) const
+{
+    LOCK(m_mutex);
+    return SkipHidden(m_index.lower_bound(AsStringView(key)), seq);
+}
+
+LogStoreEngine::Index::const_iterator LogStoreEngine::IteratorNext(Index::const_iterator it, uint64_t seq) const
+{
+    LOCK(m_mutex);
+    return SkipHidden(std::next(it), seq);
+}
+
+void LogStoreEngine::ReadValue(Index::const_iterator it, uint64_t seq, std::vector<std::byte>& value) const
+{
+    LOCK(m_mutex);
+    const Location& loc{*Visible(it->second, seq)};
+    value.resize(loc.size);
+    ReadLog(loc.pos, value);
+}
+
+void LogStoreEngine::ReleaseIterator() const
+{
+    LOCK(m_mutex);
+    --m_open_iterators;
+}
+
+void LogStoreEngine::Compact()
+{
+    LOCK(m_mutex);
+    Rewrite();
+}
+} // namespace
+
+std::unique_ptr<DBEngineImpl> MakeLogStoreEngine(const DBParams& params)
+{
+    return std::make_unique<LogStoreEngine>(params);
+}
+
+bool LogStoreExists(const fs::path& path)
+{
+    return fs::exists(path / LOG_FILENAME);
+}
+
+bool DestroyLogStore(const fs::path& path)
+{
+    std::error_code ec;
+    for (const char* filename : {LOG_FILENAME, COMPACT_FILENAME, LOCK_FILENAME}) {
+        fs::remove(path / filename, ec);
+        if (ec) {
+            LogWarning("Failed to remove %s: %s", fs::PathToString(path / filename), ec.message());
+            return false;
+        }
+    }
+    // Like leveldb::DestroyDB, remove the directory if nothing else is left in it.
+    if (fs::exists(path) && fs::is_empty(path)) fs::remove(path, ec);
+    return true;
+}
@@ -15,6 +15,7 @@
 #include <util/hasher.h>
 
 #include <deque>
+#include <span>
 #include <vector>
 
 // A compressed CBlockHeader, which leaves out the prevhash
@@ -141,6 +142,8 @@ public:
     /** Result data structure for ProcessNextHeaders. */
     struct ProcessingResult {
         std::vector<CBlockHeader> pow_validated_headers;
+        //! The hashes of pow_validated_headers.
+        std::vector<uint256> pow_validated_hashes;
         bool success{false};
         bool request_more{false};
     };
@@ -168,6 +171,12 @@ public:
     ProcessingResult ProcessNextHeaders(const std::vector<CBlockHeader>&
             received_headers, bool full_headers_message);
 
+    /** Same, given the hashes of received_headers, such as computed for
+     *  checking their proof-of-work. */
+    ProcessingResult ProcessNextHeaders(const std::vector<CBlockHeader>&
+            received_headers, std::span<const uint256> received_hashes,
+            bool full_headers_message);
+
     /** Issue the next GETHEADERS message to our peer.
      *
      * This will return a locator appropriate for the current sync object, to continue the
@@ -195,17 +204,18 @@ private:
      *  processed headers.
      *  On failure, this invokes Finalize() and returns false.
      */
-    bool ValidateAndStoreHeadersCommitments(const std::vector<CBlockHeader>& headers);
+    bool ValidateAndStoreHeadersCommitments(const std::vector<CBlockHeader>& headers, std::span<const uint256> hashes);
 
     /** In PRESYNC, process and update state for a single header */
-    bool ValidateAndProcessSingleHeader(const CBlockHeader& current);
+    bool ValidateAndProcessSingleHeader(const CBlockHeader& current, const uint256& hash);
 
     /** In REDOWNLOAD, check a header's commitment (if applicable) and add to
      * buffer for later processing */
-    bool ValidateAndStoreRedownloadedHeader(const CBlockHeader& header);
+    bool ValidateAndStoreRedownloadedHeader(const CBlockHeader& header, const uint256& hash);
 
-    /** Return a set of headers that satisfy our proof-of-work threshold */
-    std::vector<CBlockHeader> PopHeadersReadyForAcceptance();
+    /** Return a set of headers that satisfy our proof-of-work threshold, and
+     * append their hashes to hashes */
+    std::vector<CBlockHeader> PopHeadersReadyForAcceptance(std::vector<uint256>& hashes);
 
 private:
     /** NodeId of the peer (used for log messages) **/
@@ -13,6 +13,7 @@
 #include <node/context.h>
 #include <node/database_args.h>
 #include <node/interface_ui.h>
+#include <primitives/block_view.h>
 #include <tinyformat.h>
 #include <undo.h>
 #include <util/string.h>
@@ -21,12 +22,14 @@
 #include <validation.h>
 
 #include <chrono>
+#include <cstddef>
 #include <memory>
 #include <optional>
 #include <stdexcept>
 #include <string>
 #include <thread>
 #include <utility>
+#include <vector>
 
 constexpr uint8_t DB_BEST_BLOCK{'B'};
 
@@ -154,13 +157,20 @@ bool BaseIndex::ProcessBlock(const CBlockIndex* pindex, const CBlock* block_data
     interfaces::BlockInfo block_info = kernel::MakeBlockInfo(pindex, block_data);
 
     CBlock block;
+    std::vector<std::byte> raw_block;
+    std::optional<BlockView> block_view;
     if (!block_data) { // disk lookup if block data wasn't provided
-        if (!m_chainstate->m_blockman.ReadBlock(block, *pindex)) {
+        if (CustomOptions().connect_data_view ? !m_chainstate->m_blockman.ReadBlock(raw_block, block_view, *pindex) :
+                                                !m_chainstate->m_blockman.ReadBlock(block, *pindex)) {
             FatalErrorf("Failed to read block %s from disk",
                         pindex->GetBlockHash().ToString());
             return false;
         }
-        block_info.data = &block;
+        if (block_view) {
+            block_info.view = &*block_view;
+        } else {
+            block_info.data = &block;
+        }
     }
 
     CBlockUndo block_undo;
@@ -116,6 +116,7 @@ interfaces::Chain::NotifyOptions BlockFilterIndex::CustomOptions()
 {
     interfaces::Chain::NotifyOptions options;
     options.connect_undo_data = true;
+    options.connect_data_view = true;
     return options;
 }
 
@@ -273,7 +274,9 @@ std::optional<uint256> BlockFilterIndex::ReadFilterHeader(int height, const uint
 
 bool BlockFilterIndex::CustomAppend(const interfaces::BlockInfo& block)
 {
-    BlockFilter filter(m_filter_type, *Assert(block.data), *Assert(block.undo_data));
+    const CBlockUndo& block_undo{*Assert(block.undo_data)};
+    BlockFilter filter{block.view ? BlockFilter(m_filter_type, *block.view, block_undo) :
+                                    BlockFilter(m_filter_type, *Assert(block.data), block_undo)};
     const uint256& header = filter.ComputeHeader(m_last_header);
     bool res = Write(filter, block.height, header);
     if (res) m_last_header = header; // update last header
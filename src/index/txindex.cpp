@@ -79,16 +79,41 @@ bool TxIndex::FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRe
         return false;
     }
 
-    AutoFile file{m_chainstate->m_blockman.OpenBlockFile(postx, true)};
+    if (postx.nPos < node::STORAGE_HEADER_BYTES) {
+        LogError("Invalid block position %s for transaction %s", postx.ToString(), tx_hash.ToString());
+        return false;
+    }
+    AutoFile file{m_chainstate->m_blockman.OpenBlockFile({postx.nFile, postx.nPos - node::STORAGE_HEADER_BYTES}, true)};
     if (file.IsNull()) {
         LogError("OpenBlockFile failed");
         return false;
     }
     CBlockHeader header;
     try {
-        file >> header;
-        file.seek(postx.nTxOffset, SEEK_CUR);
-        file >> TX_WITH_WITNESS(tx);
+        MessageStartChars blk_start;
+        uint32_t blk_size;
+        file >> blk_start >> blk_size;
+        // A position that does not point at a block record, for example
+        // after the block files were rewritten, must not be read as one.
+        if (blk_start != m_chainstate->m_chainman.GetParams().MessageStart()) {
+            LogError("Block magic mismatch at %s for transaction %s", postx.ToString(), tx_hash.ToString());
+            return false;
+        }
+        if (blk_size & node::BLOCK_COMPRESSED_FLAG) {
+            // A compressed block can only be read as a whole.
+            std::vector<std::byte> block_data;
+            if (!m_chainstate->m_blockman.ReadRawBlock(block_data, postx)) {
+                return false;
+            }
+            SpanReader reader{block_data};
+            reader >> header;
+            reader.ignore(postx.nTxOffset);
+            reader >> TX_WITH_WITNESS(tx);
+        } else {
+            file >> header;
+            file.seek(postx.nTxOffset, SEEK_CUR);
+            file >> TX_WITH_WITNESS(tx);
+        }
     } catch (const std::exception& e) {
         LogError("Deserialize or I/O error - %s", e.what());
         return false;
@@ -20,6 +20,7 @@
 #include <common/system.h>
 #include <consensus/amount.h>
 #include <consensus/consensus.h>
+#include <dbwrapper.h>
 #include <deploymentstatus.h>
 #include <hash.h>
 #include <httprpc.h>
@@ -467,6 +468,7 @@ void SetupServerArgs(ArgsManager& argsman, bool can_listen_ipc)
     argsman.AddArg("-alertnotify=<cmd>", "Execute command when an alert is raised (%s in cmd is replaced by message)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
 #endif
     argsman.AddArg("-assumevalid=<hex>", strprintf("If this block is in the chain assume that it and its ancestors are valid and potentially skip their script verification (0 to verify all, default: %s, testnet3: %s, testnet4: %s, signet: %s)", defaultChainParams->GetConsensus().defaultAssumeValid.GetHex(), testnetChainParams->GetConsensus().defaultAssumeValid.GetHex(), testnet4ChainParams->GetConsensus().defaultAssumeValid.GetHex(), signetChainParams->GetConsensus().defaultAssumeValid.GetHex()), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-blockcompression", strprintf("Store new blocks compressed in the blk*.dat files. Block files containing compressed blocks cannot be read by older versions. (default: %u)", kernel::DEFAULT_BLOCK_COMPRESSION), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-blocksdir=<dir>", "Specify directory to hold blocks subdirectory for *.dat files (default: <datadir>)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-blocksxor",
                    strprintf("Whether an XOR-key applies to blocksdir *.dat files. "
@@ -482,9 +484,14 @@ void SetupServerArgs(ArgsManager& argsman, bool can_listen_ipc)
     argsman.AddArg("-blockreconstructionextratxn=<n>", strprintf("Extra transactions to keep in memory for compact block reconstructions (default: %u)", DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-blocksonly", strprintf("Whether to reject transactions from network peers. Disables automatic broadcast and rebroadcast of transactions, unless the source peer has the 'forcerelay' permission. RPC transactions are not affected. (default: %u)", DEFAULT_BLOCKSONLY), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-coinstatsindex", strprintf("Maintain coinstats index used by the gettxoutsetinfo RPC (default: %u)", DEFAULT_COINSTATSINDEX), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-compressblockfiles", "Rewrite the existing blk*.dat files with compressed blocks at startup. This can take a long time, and can be interrupted and resumed later.", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-compactundo", strprintf("Write undo data for new blocks in a compact format that is smaller and faster to read. Undo files containing data in this format cannot be read by older versions. (default: %u)", kernel::DEFAULT_COMPACT_UNDO), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-conf=<file>", strprintf("Specify path to read-only configuration file. Relative paths will be prefixed by datadir location (only useable from command line, not configuration file) (default: %s)", BITCOIN_CONF_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-datadir=<dir>", "Specify data directory", ArgsManager::ALLOW_ANY | ArgsManager::DISALLOW_NEGATION, OptionsCategory::OPTIONS);
     argsman.AddArg("-dbbatchsize", strprintf("Maximum database write batch size in bytes (default: %u)", nDefaultDbBatchSize), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-dbcompactionthreads=<n>", strprintf("Maximum number of threads a single LevelDB compaction is split across (1 to %d, default: %d)", MAX_DB_COMPACTION_THREADS, DEFAULT_DB_COMPACTION_THREADS), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-dbdefercompaction", strprintf("Let LevelDB accumulate more unsorted data before compacting it, which speeds up bulk writes such as initial block download at the cost of slower reads (default: %u)", DEFAULT_DB_DEFER_COMPACTION), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
+    argsman.AddArg("-dbengine=<engine>", strprintf("Storage engine for the block index, chainstate and index databases, one of %s or %s. Existing databases must be reindexed to switch engines (default: %s)", DBEngineName(DBEngine::LEVELDB), DBEngineName(DBEngine::LOGSTORE), DBEngineName(DEFAULT_DB_ENGINE)), ArgsManager::ALLOW_ANY | ArgsManager::DEBUG_ONLY, OptionsCategory::OPTIONS);
     argsman.AddArg("-dbcache=<n>", strprintf("Maximum database cache size <n> MiB (minimum %d, default: %d). Make sure you have enough RAM. In addition, unused memory allocated to the mempool is shared with this cache (see -maxmempool).", MIN_DB_CACHE >> 20, DEFAULT_DB_CACHE >> 20), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-includeconf=<file>", "Specify additional configuration file, relative to the -datadir path (only useable from configuration file, not command line)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg("-allowignoredconf", strprintf("For backwards compatibility, treat an unused %s file in the datadir as a warning, not an error.", BITCOIN_CONF_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
@@ -928,6 +935,13 @@ bool AppInitParameterInteraction(const ArgsManager& args)
         return InitError(strprintf(_("Specified blocks directory \"%s\" does not exist."), args.GetArg("-blocksdir", "")));
     }
 
+    if (args.IsArgSet("-dbengine") && !DBEngineFromName(args.GetArg("-dbengine", ""))) {
+        return InitError(strprintf(_("Unknown -dbengine value %s."), args.GetArg("-dbengine", "")));
+    }
+    if (const auto threads{args.GetIntArg("-dbcompactionthreads")}; threads && (*threads < 1 || *threads > MAX_DB_COMPACTION_THREADS)) {
+        return InitError(strprintf(_("-dbcompactionthreads must be between 1 and %d."), MAX_DB_COMPACTION_THREADS));
+    }
+
     // parse and validate enabled filter types
     std::string blockfilterindex_value = args.GetArg("-blockfilterindex", DEFAULT_BLOCKFILTERINDEX);
     if (blockfilterindex_value == "" || blockfilterindex_value == "1") {
@@ -1759,6 +1773,26 @@ bool AppInitMain(NodeContext& node, interfaces::BlockAndHeaderTipInfo* tip_info)
 
     ChainstateManager& chainman = *Assert(node.chainman);
 
+    if (args.GetBoolArg("-compressblockfiles", false)) {
+        LogInfo("Compressing block files...");
+        if (!chainman.m_blockman.CompressBlockFiles()) {
+            return InitError(_("Failed to compress the block files. See debug.log for details."));
+        }
+        if (ShutdownRequested(node)) {
+            LogPrintf("Shutdown requested. Exiting.\n");
+            return false;
+        }
+    }
+    // The transaction index refers to block positions that changed when block
+    // files were rewritten, in this run or in one that was interrupted.
+    if (WITH_LOCK(cs_main, return chainman.m_blockman.m_block_tree_db->ReadTxIndexStale())) {
+        LogInfo("Block files were rewritten, the transaction index will be rebuilt");
+        fs::remove_all(args.GetDataDirNet() / "indexes" / "txindex");
+        if (!WITH_LOCK(cs_main, return chainman.m_blockman.m_block_tree_db->EraseTxIndexStale())) {
+            return InitError(_("Failed to write to block index database."));
+        }
+    }
+
     assert(!node.peerman);
     node.peerman = PeerManager::make(*node.connman, *node.addrman,
                                      node.banman.get(), chainman,
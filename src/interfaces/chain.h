@@ -20,6 +20,7 @@
 #include <vector>
 
 class ArgsManager;
+class BlockView;
 class CBlock;
 class CBlockUndo;
 class CFeeRate;
@@ -83,6 +84,8 @@ struct BlockInfo {
     int file_number = -1;
     unsigned data_pos = 0;
     const CBlock* data = nullptr;
+    //! Set instead of data for blocks read from disk as a view.
+    const BlockView* view = nullptr;
     const CBlockUndo* undo_data = nullptr;
     // The maximum time in the chain up to and including this block.
     // A timestamp that can only move forward.
@@ -332,6 +335,9 @@ public:
     {
         //! Include undo data with block connected notifications.
         bool connect_undo_data = false;
+        //! Read block data of block connected notifications from disk as a
+        //! BlockView rather than a CBlock, when it is not in memory.
+        bool connect_data_view = false;
         //! Include block data with block disconnected notifications.
         bool disconnect_data = false;
         //! Include undo data with block disconnected notifications.
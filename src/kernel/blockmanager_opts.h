@@ -16,6 +16,8 @@ class CChainParams;
 namespace kernel {
 
 static constexpr bool DEFAULT_XOR_BLOCKSDIR{true};
+static constexpr bool DEFAULT_BLOCK_COMPRESSION{false};
+static constexpr bool DEFAULT_COMPACT_UNDO{false};
 
 /**
  * An options struct for `BlockManager`, more ergonomically referred to as
@@ -24,6 +26,10 @@ static constexpr bool DEFAULT_XOR_BLOCKSDIR{true};
 struct BlockManagerOpts {
     const CChainParams& chainparams;
     bool use_xor{DEFAULT_XOR_BLOCKSDIR};
+    //! Store new blocks compressed (see node::BLOCK_COMPRESSED_FLAG).
+    bool compress_blocks{DEFAULT_BLOCK_COMPRESSION};
+    //! Write undo data in the compact format (see node::UNDO_COMPACT_FLAG).
+    bool compact_undo{DEFAULT_COMPACT_UNDO};
     uint64_t prune_target{0};
     bool fast_prune{false};
     const fs::path blocks_dir;
@@ -4,6 +4,8 @@
 
 #include <kernel/context.h>
 
+#include <crypto/chacha20.h>
+#include <crypto/poly1305.h>
 #include <crypto/sha256.h>
 #include <logging.h>
 #include <random.h>
@@ -18,6 +20,8 @@ Context::Context()
     std::call_once(globals_initialized, []() {
         std::string sha256_algo = SHA256AutoDetect();
         LogInfo("Using the '%s' SHA256 implementation\n", sha256_algo);
+        LogInfo("Using the '%s' ChaCha20 implementation\n", ChaCha20AutoDetect());
+        LogInfo("Using the '%s' Poly1305 implementation\n", Poly1305AutoDetect());
         RandomInit();
     });
 }
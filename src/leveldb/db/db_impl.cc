@@ -11,6 +11,7 @@
 #include <atomic>
 #include <set>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "db/builder.h"
@@ -79,6 +80,9 @@ struct DBImpl::CompactionState {
 
   std::vector<Output> outputs;
 
+  // Position of this compaction (or subcompaction) in the key space
+  Compaction::Progress progress;
+
   // State kept for output being generated
   WritableFile* outfile;
   TableBuilder* builder;
@@ -103,6 +107,12 @@ Options SanitizeOptions(const std::string& dbname,
   ClipToRange(&result.write_buffer_size, 64 << 10, 1 << 30);
   ClipToRange(&result.max_file_size, 1 << 20, 1 << 30);
   ClipToRange(&result.block_size, 1 << 10, 4 << 20);
+  ClipToRange(&result.l0_compaction_trigger, 1, 1 << 10);
+  ClipToRange(&result.l0_slowdown_writes_trigger, result.l0_compaction_trigger,
+              1 << 10);
+  ClipToRange(&result.l0_stop_writes_trigger,
+              result.l0_slowdown_writes_trigger, 1 << 10);
+  ClipToRange(&result.max_subcompactions, 1, 64);
   if (result.info_log == nullptr) {
     // Open a log file in the same directory as the db
     src.env->CreateDir(dbname);  // In case it does not exist
@@ -885,30 +895,44 @@ Status DBImpl::InstallCompactionResults(CompactionState* compact) {
   return versions_->LogAndApply(compact->compaction->edit(), &mutex_);
 }
 
-Status DBImpl::DoCompactionWork(CompactionState* compact) {
-  const uint64_t start_micros = env_->NowMicros();
-  int64_t imm_micros = 0;  // Micros spent doing imm_ compactions
+void DBImpl::GetSubcompactionBoundaries(Compaction* c,
+                                        std::vector<std::string>* boundaries) {
+  // Split at the start of level+1 input files: they are sorted, disjoint
+  // and of similar size, so the ranges carry comparable amounts of work.
+  const int files = c->num_input_files(1);
+  const int ranges = std::min(options_.max_subcompactions, files);
+  for (int i = 1; i < ranges; i++) {
+    const Slice key = c->input(1, i * files / ranges)->smallest.user_key();
+    if (boundaries->empty() ||
+        user_comparator()->Compare(key, Slice(boundaries->back())) > 0) {
+      boundaries->push_back(key.ToString());
+    }
+  }
+}
 
-  Log(options_.info_log, "Compacting %d@%d + %d@%d files",
-      compact->compaction->num_input_files(0), compact->compaction->level(),
-      compact->compaction->num_input_files(1),
-      compact->compaction->level() + 1);
+void DBImpl::CompactPendingMemTable(int64_t* imm_micros) {
+  if (has_imm_.load(std::memory_order_relaxed)) {
+    const uint64_t imm_start = env_->NowMicros();
+    mutex_.Lock();
+    if (imm_ != nullptr) {
+      CompactMemTable();
+      // Wake up MakeRoomForWrite() if necessary.
+      background_work_finished_signal_.SignalAll();
+    }
+    mutex_.Unlock();
+    *imm_micros += (env_->NowMicros() - imm_start);
+  }
+}
 
-  assert(versions_->NumLevelFiles(compact->compaction->level()) > 0);
-  assert(compact->builder == nullptr);
-  assert(compact->outfile == nullptr);
-  if (snapshots_.empty()) {
-    compact->smallest_snapshot = versions_->LastSequence();
+Status DBImpl::DoCompactionRange(CompactionState* compact, Iterator* input,
+                                 const Slice* begin, const Slice* end,
+                                 int64_t* imm_micros) {
+  if (begin != nullptr) {
+    InternalKey start(*begin, kMaxSequenceNumber, kValueTypeForSeek);
+    input->Seek(start.Encode());
   } else {
-    compact->smallest_snapshot = snapshots_.oldest()->sequence_number();
+    input->SeekToFirst();
   }
-
-  Iterator* input = versions_->MakeInputIterator(compact->compaction);
-
-  // Release mutex while we're actually doing the compaction work
-  mutex_.Unlock();
-
-  input->SeekToFirst();
   Status status;
   ParsedInternalKey ikey;
   std::string current_user_key;
@@ -916,20 +940,17 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
   SequenceNumber last_sequence_for_key = kMaxSequenceNumber;
   while (input->Valid() && !shutting_down_.load(std::memory_order_acquire)) {
     // Prioritize immutable compaction work
-    if (has_imm_.load(std::memory_order_relaxed)) {
-      const uint64_t imm_start = env_->NowMicros();
-      mutex_.Lock();
-      if (imm_ != nullptr) {
-        CompactMemTable();
-        // Wake up MakeRoomForWrite() if necessary.
-        background_work_finished_signal_.SignalAll();
-      }
-      mutex_.Unlock();
-      imm_micros += (env_->NowMicros() - imm_start);
+    if (imm_micros != nullptr) {
+      CompactPendingMemTable(imm_micros);
     }
 
     Slice key = input->key();
-    if (compact->compaction->ShouldStopBefore(key) &&
+    if (end != nullptr && ParseInternalKey(key, &ikey) &&
+        user_comparator()->Compare(ikey.user_key, *end) >= 0) {
+      // Reached the next subcompaction's range
+      break;
+    }
+    if (compact->compaction->ShouldStopBefore(key, &compact->progress) &&
         compact->builder != nullptr) {
       status = FinishCompactionOutputFile(compact, input);
       if (!status.ok()) {
@@ -959,7 +980,8 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
         drop = true;  // (A)
       } else if (ikey.type == kTypeDeletion &&
                  ikey.sequence <= compact->smallest_snapshot &&
-                 compact->compaction->IsBaseLevelForKey(ikey.user_key)) {
+                 compact->compaction->IsBaseLevelForKey(ikey.user_key,
+                                                        &compact->progress)) {
         // For this user key:
         // (1) there is no data in higher levels
         // (2) data in lower levels will have larger sequence numbers
@@ -1018,8 +1040,95 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
   if (status.ok()) {
     status = input->status();
   }
-  delete input;
-  input = nullptr;
+  return status;
+}
+
+Status DBImpl::DoCompactionWork(CompactionState* compact) {
+  const uint64_t start_micros = env_->NowMicros();
+  int64_t imm_micros = 0;  // Micros spent doing imm_ compactions
+
+  std::vector<std::string> boundaries;
+  GetSubcompactionBoundaries(compact->compaction, &boundaries);
+
+  Log(options_.info_log, "Compacting %d@%d + %d@%d files in %d range(s)",
+      compact->compaction->num_input_files(0), compact->compaction->level(),
+      compact->compaction->num_input_files(1),
+      compact->compaction->level() + 1, static_cast<int>(boundaries.size() + 1));
+
+  assert(versions_->NumLevelFiles(compact->compaction->level()) > 0);
+  assert(compact->builder == nullptr);
+  assert(compact->outfile == nullptr);
+  if (snapshots_.empty()) {
+    compact->smallest_snapshot = versions_->LastSequence();
+  } else {
+    compact->smallest_snapshot = snapshots_.oldest()->sequence_number();
+  }
+
+  Status status;
+  if (boundaries.empty()) {
+    Iterator* input = versions_->MakeInputIterator(compact->compaction);
+
+    // Release mutex while we're actually doing the compaction work
+    mutex_.Unlock();
+    status = DoCompactionRange(compact, input, nullptr, nullptr, &imm_micros);
+    delete input;
+    input = nullptr;
+  } else {
+    // One subcompaction per key range, each with its own input iterator and
+    // outputs.  The first range is compacted on this thread, which also
+    // keeps servicing memtable compactions so writers are not blocked.
+    const size_t n = boundaries.size() + 1;
+    std::vector<CompactionState*> subs(n);
+    std::vector<Iterator*> inputs(n);
+    std::vector<Status> statuses(n);
+    for (size_t i = 0; i < n; i++) {
+      subs[i] = new CompactionState(compact->compaction);
+      subs[i]->smallest_snapshot = compact->smallest_snapshot;
+      inputs[i] = versions_->MakeInputIterator(compact->compaction);
+    }
+    std::vector<Slice> bounds(boundaries.begin(), boundaries.end());
+
+    // Release mutex while we're actually doing the compaction work
+    mutex_.Unlock();
+    std::atomic<size_t> running(n - 1);
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < n; i++) {
+      threads.emplace_back([&, i] {
+        const Slice* end = (i + 1 < n) ? &bounds[i] : nullptr;
+        statuses[i] =
+            DoCompactionRange(subs[i], inputs[i], &bounds[i - 1], end, nullptr);
+        running.fetch_sub(1, std::memory_order_release);
+      });
+    }
+    statuses[0] =
+        DoCompactionRange(subs[0], inputs[0], nullptr, &bounds[0], &imm_micros);
+    while (running.load(std::memory_order_acquire) > 0) {
+      CompactPendingMemTable(&imm_micros);
+      env_->SleepForMicroseconds(1000);
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+
+    // Hand the outputs of all ranges, in key order, to the compaction so they
+    // are installed (or released from pending_outputs_) together.
+    for (size_t i = 0; i < n; i++) {
+      if (status.ok()) {
+        status = statuses[i];
+      }
+      CompactionState* sub = subs[i];
+      if (sub->builder != nullptr) {
+        sub->builder->Abandon();
+        delete sub->builder;
+      }
+      delete sub->outfile;
+      compact->outputs.insert(compact->outputs.end(), sub->outputs.begin(),
+                              sub->outputs.end());
+      compact->total_bytes += sub->total_bytes;
+      delete sub;
+      delete inputs[i];
+    }
+  }
 
   CompactionStats stats;
   stats.micros = env_->NowMicros() - start_micros - imm_micros;
@@ -1329,17 +1438,20 @@ Status DBImpl::MakeRoomForWrite(bool force) {
       s = bg_error_;
       break;
     } else if (allow_delay && versions_->NumLevelFiles(0) >=
-                                  config::kL0_SlowdownWritesTrigger) {
+                                  options_.l0_slowdown_writes_trigger) {
       // We are getting close to hitting a hard limit on the number of
       // L0 files.  Rather than delaying a single write by several
       // seconds when we hit the hard limit, start delaying each
       // individual write by 1ms to reduce latency variance.  Also,
       // this delay hands over some CPU to the compaction thread in
       // case it is sharing the same core as the writer.
+      const uint64_t stall_start = env_->NowMicros();
       mutex_.Unlock();
       env_->SleepForMicroseconds(1000);
       allow_delay = false;  // Do not delay a single write more than once
       mutex_.Lock();
+      stall_stats_.slowdown_count++;
+      stall_stats_.slowdown_micros += env_->NowMicros() - stall_start;
     } else if (!force &&
                (mem_->ApproximateMemoryUsage() <= options_.write_buffer_size)) {
       // There is room in current memtable
@@ -1348,11 +1460,18 @@ Status DBImpl::MakeRoomForWrite(bool force) {
       // We have filled up the current memtable, but the previous
       // one is still being compacted, so we wait.
       Log(options_.info_log, "Current memtable full; waiting...\n");
+      const uint64_t stall_start = env_->NowMicros();
       background_work_finished_signal_.Wait();
-    } else if (versions_->NumLevelFiles(0) >= config::kL0_StopWritesTrigger) {
+      stall_stats_.memtable_count++;
+      stall_stats_.memtable_micros += env_->NowMicros() - stall_start;
+    } else if (versions_->NumLevelFiles(0) >=
+               options_.l0_stop_writes_trigger) {
       // There are too many level-0 files.
       Log(options_.info_log, "Too many L0 files; waiting...\n");
+      const uint64_t stall_start = env_->NowMicros();
       background_work_finished_signal_.Wait();
+      stall_stats_.l0_stop_count++;
+      stall_stats_.l0_stop_micros += env_->NowMicros() - stall_start;
     } else {
       // Attempt to switch to a new memtable and trigger compaction of old
       assert(versions_->PrevLogNumber() == 0);
@@ -1421,6 +1540,33 @@ bool DBImpl::GetProperty(const Slice& property, std::string* value) {
       }
     }
     return true;
+  } else if (in == "write-stalls") {
+    char buf[200];
+    snprintf(buf, sizeof(buf), "%llu %llu %llu %llu %llu %llu",
+             static_cast<unsigned long long>(stall_stats_.slowdown_count),
+             static_cast<unsigned long long>(stall_stats_.slowdown_micros),
+             static_cast<unsigned long long>(stall_stats_.memtable_count),
+             static_cast<unsigned long long>(stall_stats_.memtable_micros),
+             static_cast<unsigned long long>(stall_stats_.l0_stop_count),
+             static_cast<unsigned long long>(stall_stats_.l0_stop_micros));
+    value->append(buf);
+    return true;
+  } else if (in == "compaction-totals") {
+    CompactionStats total;
+    for (int level = 0; level < config::kNumLevels; level++) {
+      total.count += stats_[level].count;
+      total.micros += stats_[level].micros;
+      total.bytes_read += stats_[level].bytes_read;
+      total.bytes_written += stats_[level].bytes_written;
+    }
+    char buf[200];
+    snprintf(buf, sizeof(buf), "%lld %lld %lld %lld",
+             static_cast<long long>(total.count),
+             static_cast<long long>(total.micros),
+             static_cast<long long>(total.bytes_read),
+             static_cast<long long>(total.bytes_written));
+    value->append(buf);
+    return true;
   } else if (in == "sstables") {
     *value = versions_->current()->DebugString();
     return true;
@@ -20,6 +20,7 @@
 
 namespace leveldb {
 
+class Compaction;
 class MemTable;
 class TableCache;
 class Version;
@@ -88,14 +89,16 @@ class DBImpl : public DB {
   // Per level compaction stats.  stats_[level] stores the stats for
   // compactions that produced data for the specified "level".
   struct CompactionStats {
-    CompactionStats() : micros(0), bytes_read(0), bytes_written(0) {}
+    CompactionStats() : count(0), micros(0), bytes_read(0), bytes_written(0) {}
 
     void Add(const CompactionStats& c) {
+      this->count += 1;
       this->micros += c.micros;
       this->bytes_read += c.bytes_read;
       this->bytes_written += c.bytes_written;
     }
 
+    int64_t count;
     int64_t micros;
     int64_t bytes_read;
     int64_t bytes_written;
@@ -146,6 +149,21 @@ class DBImpl : public DB {
   Status DoCompactionWork(CompactionState* compact)
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+  // Fill *boundaries with the user keys at which compaction "c" is split
+  // into subcompactions (see Options::max_subcompactions), in increasing
+  // order.  Left empty if the compaction is not split.
+  void GetSubcompactionBoundaries(Compaction* c,
+                                  std::vector<std::string>* boundaries);
+  // Compact the entries of "input" whose user keys lie in [*begin, *end)
+  // into the outputs of "compact".  A null bound means unbounded.  If
+  // imm_micros is non-null, pending memtable compactions are performed
+  // along the way and the time spent on them is added to *imm_micros.
+  Status DoCompactionRange(CompactionState* compact, Iterator* input,
+                           const Slice* begin, const Slice* end,
+                           int64_t* imm_micros) LOCKS_EXCLUDED(mutex_);
+  // Compact imm_ if it is set, adding the time spent to *imm_micros.
+  void CompactPendingMemTable(int64_t* imm_micros) LOCKS_EXCLUDED(mutex_);
+
   Status OpenCompactionOutputFile(CompactionState* compact);
   Status FinishCompactionOutputFile(CompactionState* compact, Iterator* input);
   Status InstallCompactionResults(CompactionState* compact)
@@ -203,6 +221,26 @@ class DBImpl : public DB {
   Status bg_error_ GUARDED_BY(mutex_);
 
   CompactionStats stats_[config::kNumLevels] GUARDED_BY(mutex_);
+
+  // Per-cause counts and durations of writes being held back in
+  // MakeRoomForWrite(), see the "leveldb.write-stalls" property.
+  struct WriteStallStats {
+    WriteStallStats()
+        : slowdown_count(0),
+          slowdown_micros(0),
+          memtable_count(0),
+          memtable_micros(0),
+          l0_stop_count(0),
+          l0_stop_micros(0) {}
+
+    uint64_t slowdown_count;
+    uint64_t slowdown_micros;
+    uint64_t memtable_count;
+    uint64_t memtable_micros;
+    uint64_t l0_stop_count;
+    uint64_t l0_stop_micros;
+  };
+  WriteStallStats stall_stats_ GUARDED_BY(mutex_);
 };
 
 // Sanitize db options.  The caller should delete result.info_log if
@@ -24,6 +24,9 @@ namespace leveldb {
 namespace config {
 static const int kNumLevels = 7;
 
+// Defaults for Options::l0_compaction_trigger,
+// Options::l0_slowdown_writes_trigger and Options::l0_stop_writes_trigger.
+
 // Level-0 compaction is started when we hit this many files.
 static const int kL0_CompactionTrigger = 4;
 
@@ -81,6 +81,23 @@ struct LEVELDB_EXPORT Options {
   // the next time the database is opened.
   size_t write_buffer_size = 4 * 1024 * 1024;
 
+  // Level-0 compaction is started when we hit this many files.
+  int l0_compaction_trigger = 4;
+
+  // Soft limit on number of level-0 files.  We slow down writes at this
+  // point.  Raising the level-0 limits defers compaction work, at the cost
+  // of more files being checked by reads in the meantime.
+  int l0_slowdown_writes_trigger = 8;
+
+  // Maximum number of level-0 files.  We stop writes at this point.
+  int l0_stop_writes_trigger = 12;
+
+  // Maximum number of threads a single compaction is split across.  A
+  // compaction whose level+1 inputs span several files is divided into
+  // disjoint key ranges that are compacted concurrently, which shortens
+  // the time writers spend stalled on level-0 during bulk loads.
+  int max_subcompactions = 1;
+
   // Number of open files that can be used by the DB.  You may need to
   // increase this if your database has a large working set (budget
   // one open file per 2MB of working set).
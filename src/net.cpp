@@ -103,6 +103,11 @@ enum BindFlags {
 // The set of sockets cannot be modified while waiting
 // The sleep time needs to be small to avoid new sockets stalling
 static const uint64_t SELECT_TIMEOUT_MILLISECONDS = 50;
+// Shorter sleep time while the key exchange of v2 connections is in progress on
+// m_key_exchange_pool, so that their handshake continues soon after it completes
+static const uint64_t KEY_EXCHANGE_POLL_MILLISECONDS = 1;
+/** Number of threads computing the key exchange of v2 connections. */
+static constexpr int KEY_EXCHANGE_THREADS{2};
 
 const std::string NET_MESSAGE_TYPE_OTHER = "*other*";
 
@@ -120,7 +125,15 @@ std::string strSubVersion;
 
 size_t CSerializedNetMsg::GetMemoryUsage() const noexcept
 {
-    return sizeof(*this) + memusage::DynamicUsage(m_type) + memusage::DynamicUsage(data);
+    // A shared payload is counted in full, as it is kept alive until the message is sent.
+    return sizeof(*this) + memusage::DynamicUsage(m_type) + memusage::DynamicUsage(data) +
+           (m_shared_data ? memusage::DynamicUsage(*m_shared_data) : 0);
+}
+
+void CSerializedNetMsg::ClearPayload() noexcept
+{
+    ClearShrink(data);
+    m_shared_data.reset();
 }
 
 size_t CNetMessage::GetMemoryUsage() const noexcept
@@ -538,6 +551,7 @@ CNode* CConnman::ConnectNode(CAddress addrConnect, const char *pszDest, bool fCo
                                     .i2p_sam_session = std::move(i2p_transient_session),
                                     .recv_flood_size = nReceiveFloodSize,
                                     .use_v2transport = use_v2transport,
+                                    .key_exchange_pool = m_key_exchange_pool ? &*m_key_exchange_pool : nullptr,
                                 });
         pnode->AddRef();
 
@@ -663,8 +677,8 @@ bool CNode::ReceiveMsgBytes(std::span<const uint8_t> msg_bytes, bool& complete)
     LOCK(cs_vRecv);
     m_last_recv = std::chrono::duration_cast<std::chrono::seconds>(time);
     nRecvBytes += msg_bytes.size();
-    while (msg_bytes.size() > 0) {
-        // absorb network data
+    while (msg_bytes.size() > 0 || m_transport->ReceivePending()) {
+        // absorb network data, or data the transport kept from before
         if (!m_transport->ReceivedBytes(msg_bytes)) {
             // Serious transport problem, disconnect from the peer.
             return false;
@@ -763,6 +777,8 @@ int V1Transport::readHeader(std::span<const uint8_t> msg_bytes)
 
     // switch state to reading message data
     in_data = true;
+    // Allocate the message data at once, but no more than MAX_RESERVE_AHEAD before any of it arrives.
+    vRecv.resize(std::min<size_t>(hdr.nMessageSize, MAX_RESERVE_AHEAD));
 
     return nCopy;
 }
@@ -774,17 +790,35 @@ int V1Transport::readData(std::span<const uint8_t> msg_bytes)
     unsigned int nCopy = std::min<unsigned int>(nRemaining, msg_bytes.size());
 
     if (vRecv.size() < nDataPos + nCopy) {
-        // Allocate up to 256 KiB ahead, but never more than the total message size.
-        vRecv.resize(std::min(hdr.nMessageSize, nDataPos + nCopy + 256 * 1024));
+        // Allocate up to MAX_RESERVE_AHEAD ahead, but never more than the total message size.
+        vRecv.resize(std::min<size_t>(hdr.nMessageSize, nDataPos + nCopy + MAX_RESERVE_AHEAD));
     }
 
     hasher.Write(msg_bytes.first(nCopy));
-    memcpy(&vRecv[nDataPos], msg_bytes.data(), nCopy);
+    // Bytes which were received into GetReceiveBuffer() are in place already.
+    if (msg_bytes.data() != UCharCast(&vRecv[nDataPos])) {
+        memcpy(&vRecv[nDataPos], msg_bytes.data(), nCopy);
+    }
     nDataPos += nCopy;
 
     return nCopy;
 }
 
+std::span<uint8_t> V1Transport::GetReceiveBuffer() noexcept
+{
+    AssertLockNotHeld(m_recv_mutex);
+    LOCK(m_recv_mutex);
+    // The size of the message data is only known once the header is complete. A read of a small
+    // rest of it into the socket handler's buffer also takes in the messages after it, so only
+    // larger ones are received in place.
+    if (!in_data || CompleteInternal()) return {};
+    if (hdr.nMessageSize - nDataPos < SOCKET_RECV_BUFFER_SIZE) return {};
+    if (vRecv.size() == nDataPos) {
+        vRecv.resize(std::min<size_t>(hdr.nMessageSize, nDataPos + MAX_RESERVE_AHEAD));
+    }
+    return std::span{UCharCast(vRecv.data()), vRecv.size()}.subspan(nDataPos);
+}
+
 const uint256& V1Transport::GetMessageHash() const
 {
     AssertLockHeld(m_recv_mutex);
@@ -836,17 +870,25 @@ CNetMessage V1Transport::GetReceivedMessage(const std::chrono::microseconds time
 bool V1Transport::SetMessageToSend(CSerializedNetMsg& msg) noexcept
 {
     AssertLockNotHeld(m_send_mutex);
-    // Determine whether a new message can be set.
+    // Determine whether a new message can be set, or queued behind the one being sent.
     LOCK(m_send_mutex);
-    if (m_sending_header || m_bytes_sent < m_message_to_send.data.size()) return false;
+    const bool sending{m_sending_header || m_bytes_sent < m_message_to_send.Payload().size()};
+    if (sending && m_send_queue.size() >= MAX_SEND_QUEUE) return false;
 
     // create dbl-sha256 checksum
-    uint256 hash = Hash(msg.data);
+    uint256 hash = Hash(msg.Payload());
 
     // create header
-    CMessageHeader hdr(m_magic_bytes, msg.m_type.c_str(), msg.data.size());
+    CMessageHeader hdr(m_magic_bytes, msg.m_type.c_str(), msg.Payload().size());
     memcpy(hdr.pchChecksum, hash.begin(), CMessageHeader::CHECKSUM_SIZE);
 
+    if (sending) {
+        auto& queued{m_send_queue.emplace_back()};
+        VectorWriter{queued.header, 0, hdr};
+        queued.msg = std::move(msg);
+        return true;
+    }
+
     // serialize header
     m_header_to_send.clear();
     VectorWriter{m_header_to_send, 0, hdr};
@@ -866,19 +908,41 @@ Transport::BytesToSend V1Transport::GetBytesToSend(bool have_next_message) const
         return {std::span{m_header_to_send}.subspan(m_bytes_sent),
                 // We have more to send after the header if the message has payload, or if there
                 // is a next message after that.
-                have_next_message || !m_message_to_send.data.empty(),
+                have_next_message || !m_message_to_send.Payload().empty() || !m_send_queue.empty(),
                 m_message_to_send.m_type
                };
     } else {
-        return {std::span{m_message_to_send.data}.subspan(m_bytes_sent),
+        return {m_message_to_send.Payload().subspan(m_bytes_sent),
                 // We only have more to send after this message's payload if there is another
                 // message.
-                have_next_message,
+                have_next_message || !m_send_queue.empty(),
                 m_message_to_send.m_type
                };
     }
 }
 
+Transport::BuffersToSend V1Transport::GetBuffersToSend(bool have_next_message) const noexcept
+{
+    AssertLockNotHeld(m_send_mutex);
+    LOCK(m_send_mutex);
+    std::vector<std::span<const uint8_t>> to_send;
+    to_send.reserve(2 * (1 + m_send_queue.size()));
+    const auto add{[&](std::span<const uint8_t> bytes) {
+        if (!bytes.empty()) to_send.push_back(bytes);
+    }};
+    if (m_sending_header) {
+        add(std::span{m_header_to_send}.subspan(m_bytes_sent));
+        add(m_message_to_send.Payload());
+    } else {
+        add(m_message_to_send.Payload().subspan(m_bytes_sent));
+    }
+    for (const auto& queued : m_send_queue) {
+        add(queued.header);
+        add(queued.msg.Payload());
+    }
+    return {std::move(to_send), have_next_message};
+}
+
 void V1Transport::MarkBytesSent(size_t bytes_sent) noexcept
 {
     AssertLockNotHeld(m_send_mutex);
@@ -888,19 +952,29 @@ void V1Transport::MarkBytesSent(size_t bytes_sent) noexcept
         // We're done sending a message's header. Switch to sending its data bytes.
         m_sending_header = false;
         m_bytes_sent = 0;
-    } else if (!m_sending_header && m_bytes_sent == m_message_to_send.data.size()) {
+    } else if (!m_sending_header && m_bytes_sent == m_message_to_send.Payload().size()) {
         // We're done sending a message's data. Wipe the data vector to reduce memory consumption.
-        ClearShrink(m_message_to_send.data);
+        m_message_to_send.ClearPayload();
         m_bytes_sent = 0;
     }
+    // Once a message is done (which for one without data is right after its header), move on to
+    // the next queued one.
+    if (!m_sending_header && m_message_to_send.Payload().empty() && !m_send_queue.empty()) {
+        m_header_to_send = std::move(m_send_queue.front().header);
+        m_message_to_send = std::move(m_send_queue.front().msg);
+        m_send_queue.pop_front();
+        m_sending_header = true;
+    }
 }
 
 size_t V1Transport::GetSendMemoryUsage() const noexcept
 {
     AssertLockNotHeld(m_send_mutex);
     LOCK(m_send_mutex);
-    // Don't count sending-side fields besides m_message_to_send, as they're all small and bounded.
-    return m_message_to_send.GetMemoryUsage();
+    // Don't count the headers, as they're all small and bounded.
+    size_t usage{m_message_to_send.GetMemoryUsage()};
+    for (const auto& queued : m_send_queue) usage += queued.msg.GetMemoryUsage();
+    return usage;
 }
 
 namespace {
@@ -992,9 +1066,10 @@ void V2Transport::StartSendingHandshake() noexcept
     // We cannot wipe m_send_garbage as it will still be used as AAD later in the handshake.
 }
 
-V2Transport::V2Transport(NodeId nodeid, bool initiating, const CKey& key, std::span<const std::byte> ent32, std::vector<uint8_t> garbage) noexcept
+V2Transport::V2Transport(NodeId nodeid, bool initiating, const CKey& key, std::span<const std::byte> ent32, std::vector<uint8_t> garbage, ThreadPool* key_exchange_pool) noexcept
     : m_cipher{key, ent32}, m_initiating{initiating}, m_nodeid{nodeid},
       m_v1_fallback{nodeid},
+      m_key_exchange_pool{key_exchange_pool},
       m_recv_state{initiating ? RecvState::KEY : RecvState::KEY_MAYBE_V1},
       m_send_garbage{std::move(garbage)},
       m_send_state{initiating ? SendState::AWAITING_KEY : SendState::MAYBE_V1}
@@ -1007,9 +1082,9 @@ V2Transport::V2Transport(NodeId nodeid, bool initiating, const CKey& key, std::s
     }
 }
 
-V2Transport::V2Transport(NodeId nodeid, bool initiating) noexcept
+V2Transport::V2Transport(NodeId nodeid, bool initiating, ThreadPool* key_exchange_pool) noexcept
     : V2Transport{nodeid, initiating, GenerateRandomKey(),
-                  MakeByteSpan(GetRandHash()), GenerateRandomGarbage()} {}
+                  MakeByteSpan(GetRandHash()), GenerateRandomGarbage(), key_exchange_pool} {}
 
 void V2Transport::SetReceiveState(RecvState recv_state) noexcept
 {
@@ -1020,6 +1095,9 @@ void V2Transport::SetReceiveState(RecvState recv_state) noexcept
         Assume(recv_state == RecvState::KEY || recv_state == RecvState::V1);
         break;
     case RecvState::KEY:
+        Assume(recv_state == RecvState::KEY_EXCHANGE || recv_state == RecvState::GARB_GARBTERM);
+        break;
+    case RecvState::KEY_EXCHANGE:
         Assume(recv_state == RecvState::GARB_GARBTERM);
         break;
     case RecvState::GARB_GARBTERM:
@@ -1083,7 +1161,7 @@ void V2Transport::ProcessReceivedMaybeV1Bytes() noexcept
     std::array<uint8_t, V1_PREFIX_LEN> v1_prefix = {0, 0, 0, 0, 'v', 'e', 'r', 's', 'i', 'o', 'n', 0, 0, 0, 0, 0};
     std::copy(std::begin(Params().MessageStart()), std::end(Params().MessageStart()), v1_prefix.begin());
     Assume(m_recv_buffer.size() <= v1_prefix.size());
-    if (!std::equal(m_recv_buffer.begin(), m_recv_buffer.end(), v1_prefix.begin())) {
+    if (!std::ranges::equal(MakeUCharSpan(m_recv_buffer), std::span{v1_prefix}.first(m_recv_buffer.size()))) {
         // Mismatch with v1 prefix, so we can assume a v2 connection.
         SetReceiveState(RecvState::KEY); // Convert to KEY state, leaving received bytes around.
         // Transition the sender to AWAITING_KEY state and start sending.
@@ -1093,7 +1171,7 @@ void V2Transport::ProcessReceivedMaybeV1Bytes() noexcept
     } else if (m_recv_buffer.size() == v1_prefix.size()) {
         // Full match with the v1 prefix, so fall back to v1 behavior.
         LOCK(m_send_mutex);
-        std::span<const uint8_t> feedback{m_recv_buffer};
+        std::span<const uint8_t> feedback{MakeUCharSpan(m_recv_buffer)};
         // Feed already received bytes to v1 transport. It should always accept these, because it's
         // less than the size of a v1 header, and these are the first bytes fed to m_v1_fallback.
         bool ret = m_v1_fallback.ReceivedBytes(feedback);
@@ -1125,7 +1203,7 @@ bool V2Transport::ProcessReceivedKeyBytes() noexcept
     static constexpr std::array<uint8_t, 12> MATCH = {'v', 'e', 'r', 's', 'i', 'o', 'n', 0, 0, 0, 0, 0};
     static constexpr size_t OFFSET = std::tuple_size_v<MessageStartChars>;
     if (!m_initiating && m_recv_buffer.size() >= OFFSET + MATCH.size()) {
-        if (std::equal(MATCH.begin(), MATCH.end(), m_recv_buffer.begin() + OFFSET)) {
+        if (std::ranges::equal(MATCH, MakeUCharSpan(m_recv_buffer).subspan(OFFSET, MATCH.size()))) {
             LogDebug(BCLog::NET, "V2 transport error: V1 peer with wrong MessageStart %s\n",
                      HexStr(std::span(m_recv_buffer).first(OFFSET)));
             return false;
@@ -1136,39 +1214,62 @@ bool V2Transport::ProcessReceivedKeyBytes() noexcept
         // Other side's key has been fully received, and can now be Diffie-Hellman combined with
         // our key to initialize the encryption ciphers.
 
-        // Initialize the ciphers.
         EllSwiftPubKey ellswift(MakeByteSpan(m_recv_buffer));
-        LOCK(m_send_mutex);
-        m_cipher.Initialize(ellswift, m_initiating);
-
-        // Switch receiver state to GARB_GARBTERM.
-        SetReceiveState(RecvState::GARB_GARBTERM);
         m_recv_buffer.clear();
-
-        // Switch sender state to READY.
-        SetSendState(SendState::READY);
-
-        // Append the garbage terminator to the send buffer.
-        m_send_buffer.resize(m_send_buffer.size() + BIP324Cipher::GARBAGE_TERMINATOR_LEN);
-        std::copy(m_cipher.GetSendGarbageTerminator().begin(),
-                  m_cipher.GetSendGarbageTerminator().end(),
-                  MakeWritableByteSpan(m_send_buffer).last(BIP324Cipher::GARBAGE_TERMINATOR_LEN).begin());
-
-        // Construct version packet in the send buffer, with the sent garbage data as AAD.
-        m_send_buffer.resize(m_send_buffer.size() + BIP324Cipher::EXPANSION + VERSION_CONTENTS.size());
-        m_cipher.Encrypt(
-            /*contents=*/VERSION_CONTENTS,
-            /*aad=*/MakeByteSpan(m_send_garbage),
-            /*ignore=*/false,
-            /*output=*/MakeWritableByteSpan(m_send_buffer).last(BIP324Cipher::EXPANSION + VERSION_CONTENTS.size()));
-        // We no longer need the garbage.
-        ClearShrink(m_send_garbage);
+        if (m_key_exchange_pool) {
+            // Compute the shared secret on the pool. Meanwhile, received bytes are kept in
+            // m_recv_pending.
+            m_key_exchange = m_key_exchange_pool->Submit(m_cipher.GetECDHComputation(ellswift, m_initiating));
+            SetReceiveState(RecvState::KEY_EXCHANGE);
+        } else {
+            CompleteKeyExchange(m_cipher.GetECDHComputation(ellswift, m_initiating)());
+        }
     } else {
         // We still have to receive more key bytes.
     }
     return true;
 }
 
+void V2Transport::CompleteKeyExchange(ECDHSecret ecdh_secret) noexcept
+{
+    AssertLockHeld(m_recv_mutex);
+    AssertLockNotHeld(m_send_mutex);
+    Assume(m_recv_state == RecvState::KEY || m_recv_state == RecvState::KEY_EXCHANGE);
+
+    // Initialize the ciphers.
+    LOCK(m_send_mutex);
+    m_cipher.Initialize(ecdh_secret, m_initiating);
+    memory_cleanse(ecdh_secret.data(), ecdh_secret.size());
+
+    // Switch receiver state to GARB_GARBTERM.
+    SetReceiveState(RecvState::GARB_GARBTERM);
+
+    // Switch sender state to READY.
+    SetSendState(SendState::READY);
+
+    // Append the garbage terminator to the send buffer.
+    m_send_buffer.resize(m_send_buffer.size() + BIP324Cipher::GARBAGE_TERMINATOR_LEN);
+    std::copy(m_cipher.GetSendGarbageTerminator().begin(),
+              m_cipher.GetSendGarbageTerminator().end(),
+              MakeWritableByteSpan(m_send_buffer).last(BIP324Cipher::GARBAGE_TERMINATOR_LEN).begin());
+
+    // Construct version packet in the send buffer, with the sent garbage data as AAD.
+    m_send_buffer.resize(m_send_buffer.size() + BIP324Cipher::EXPANSION + VERSION_CONTENTS.size());
+    m_cipher.Encrypt(
+        /*contents=*/VERSION_CONTENTS,
+        /*aad=*/MakeByteSpan(m_send_garbage),
+        /*ignore=*/false,
+        /*output=*/MakeWritableByteSpan(m_send_buffer).last(BIP324Cipher::EXPANSION + VERSION_CONTENTS.size()));
+    // We no longer need the garbage.
+    ClearShrink(m_send_garbage);
+}
+
+bool V2Transport::KeyExchangeReady() const noexcept
+{
+    AssertLockHeld(m_recv_mutex);
+    return m_recv_state == RecvState::KEY_EXCHANGE && m_key_exchange.wait_for(std::chrono::seconds{0}) == std::future_status::ready;
+}
+
 bool V2Transport::ProcessReceivedGarbageBytes() noexcept
 {
     AssertLockHeld(m_recv_mutex);
@@ -1209,24 +1310,25 @@ bool V2Transport::ProcessReceivedPacketBytes() noexcept
         1 + CMessageHeader::MESSAGE_TYPE_SIZE +
         std::min<size_t>(MAX_SIZE, MAX_PROTOCOL_MESSAGE_LENGTH);
 
-    if (m_recv_buffer.size() == BIP324Cipher::LENGTH_LEN) {
+    if (m_recv_pos == BIP324Cipher::LENGTH_LEN) {
         // Length descriptor received.
-        m_recv_len = m_cipher.DecryptLength(MakeByteSpan(m_recv_buffer));
+        m_recv_len = m_cipher.DecryptLength(MakeByteSpan(m_recv_buffer).first(BIP324Cipher::LENGTH_LEN));
         if (m_recv_len > MAX_CONTENTS_LEN) {
             LogDebug(BCLog::NET, "V2 transport error: packet too large (%u bytes), peer=%d\n", m_recv_len, m_nodeid);
             return false;
         }
-    } else if (m_recv_buffer.size() > BIP324Cipher::LENGTH_LEN && m_recv_buffer.size() == m_recv_len + BIP324Cipher::EXPANSION) {
-        // Ciphertext received, decrypt it into m_recv_decode_buffer.
+    } else if (m_recv_pos > BIP324Cipher::LENGTH_LEN && m_recv_pos == m_recv_len + BIP324Cipher::EXPANSION) {
+        // Ciphertext received, decrypt it in place: the contents overwrite their own ciphertext,
+        // between the encrypted length and header before them, and the tag after them.
         // Note that it is impossible to reach this branch without hitting the branch above first,
         // as GetMaxBytesToProcess only allows up to LENGTH_LEN into the buffer before that point.
-        m_recv_decode_buffer.resize(m_recv_len);
+        const std::span<std::byte> packet{std::span{m_recv_buffer}.subspan(BIP324Cipher::LENGTH_LEN, m_recv_pos - BIP324Cipher::LENGTH_LEN)};
         bool ignore{false};
         bool ret = m_cipher.Decrypt(
-            /*input=*/MakeByteSpan(m_recv_buffer).subspan(BIP324Cipher::LENGTH_LEN),
+            /*input=*/packet,
             /*aad=*/MakeByteSpan(m_recv_aad),
             /*ignore=*/ignore,
-            /*contents=*/MakeWritableByteSpan(m_recv_decode_buffer));
+            /*contents=*/packet.subspan(BIP324Cipher::HEADER_LEN, m_recv_len));
         if (!ret) {
             LogDebug(BCLog::NET, "V2 transport error: packet decryption failure (%u bytes), peer=%d\n", m_recv_len, m_nodeid);
             return false;
@@ -1234,9 +1336,9 @@ bool V2Transport::ProcessReceivedPacketBytes() noexcept
         // We have decrypted a valid packet with the AAD we expected, so clear the expected AAD.
         ClearShrink(m_recv_aad);
         // Feed the last 4 bytes of the Poly1305 authentication tag (and its timing) into our RNG.
-        RandAddEvent(ReadLE32(m_recv_buffer.data() + m_recv_buffer.size() - 4));
+        RandAddEvent(ReadLE32(UCharCast(m_recv_buffer.data() + m_recv_pos - 4)));
 
-        // At this point we have a valid packet decrypted into m_recv_decode_buffer. If it's not a
+        // At this point we have a valid packet decrypted in m_recv_buffer. If it's not a
         // decoy, which we simply ignore, use the current state to decide what to do with it.
         if (!ignore) {
             switch (m_recv_state) {
@@ -1254,10 +1356,12 @@ bool V2Transport::ProcessReceivedPacketBytes() noexcept
                 Assume(false);
             }
         }
-        // Wipe the receive buffer where the next packet will be received into.
-        ClearShrink(m_recv_buffer);
-        // In all but APP_READY state, we can wipe the decoded contents.
-        if (m_recv_state != RecvState::APP_READY) ClearShrink(m_recv_decode_buffer);
+        // In all but APP_READY state, we can wipe the decoded contents, and receive the next
+        // packet.
+        if (m_recv_state != RecvState::APP_READY) {
+            ClearShrink(m_recv_buffer);
+            m_recv_pos = 0;
+        }
     } else {
         // We either have less than 3 bytes, so we don't know the packet's length yet, or more
         // than 3 bytes but less than the packet's full ciphertext. Wait until those arrive.
@@ -1285,6 +1389,9 @@ size_t V2Transport::GetMaxBytesToProcess() noexcept
         // that (64 bytes), as garbage follows, and locating the garbage terminator requires the
         // key exchange first.
         return EllSwiftPubKey::size() - m_recv_buffer.size();
+    case RecvState::KEY_EXCHANGE:
+        // Received bytes are kept in m_recv_pending until the key exchange completes.
+        return 0;
     case RecvState::GARB_GARBTERM:
         // Process garbage bytes one by one (because terminator may appear anywhere).
         return 1;
@@ -1293,14 +1400,14 @@ size_t V2Transport::GetMaxBytesToProcess() noexcept
         // These three states all involve decoding a packet. Process the length descriptor first,
         // so that we know where the current packet ends (and we don't process bytes from the next
         // packet or decoy yet). Then, process the ciphertext bytes of the current packet.
-        if (m_recv_buffer.size() < BIP324Cipher::LENGTH_LEN) {
-            return BIP324Cipher::LENGTH_LEN - m_recv_buffer.size();
+        if (m_recv_pos < BIP324Cipher::LENGTH_LEN) {
+            return BIP324Cipher::LENGTH_LEN - m_recv_pos;
         } else {
             // Note that BIP324Cipher::EXPANSION is the total difference between contents size
             // and encoded packet size, which includes the 3 bytes due to the packet length.
             // When transitioning from receiving the packet length to receiving its ciphertext,
             // the encrypted packet length is left in the receive buffer.
-            return BIP324Cipher::EXPANSION + m_recv_len - m_recv_buffer.size();
+            return BIP324Cipher::EXPANSION + m_recv_len - m_recv_pos;
         }
     case RecvState::APP_READY:
         // No bytes can be processed until GetMessage() is called.
@@ -1317,12 +1424,35 @@ size_t V2Transport::GetMaxBytesToProcess() noexcept
 bool V2Transport::ReceivedBytes(std::span<const uint8_t>& msg_bytes) noexcept
 {
     AssertLockNotHeld(m_recv_mutex);
-    /** How many bytes to allocate in the receive buffer at most above what is received so far. */
-    static constexpr size_t MAX_RESERVE_AHEAD = 256 * 1024;
-
     LOCK(m_recv_mutex);
     if (m_recv_state == RecvState::V1) return m_v1_fallback.ReceivedBytes(msg_bytes);
 
+    if (m_recv_state == RecvState::KEY_EXCHANGE) {
+        // Keep what is received while the shared secret is computed. As callers stop reading
+        // from the peer while ReceiveWaiting() is true, this is at most the rest of the read
+        // that completed the key. Never wait for the key exchange here.
+        m_recv_pending.insert(m_recv_pending.end(), msg_bytes.begin(), msg_bytes.end());
+        msg_bytes = {};
+        if (!KeyExchangeReady()) return true;
+        CompleteKeyExchange(m_key_exchange.get());
+    }
+
+    if (!m_recv_pending.empty()) {
+        // Process the bytes kept during the key exchange before any new ones.
+        std::span<const uint8_t> pending{m_recv_pending};
+        const bool ret{ProcessReceivedBytes(pending)};
+        m_recv_pending.erase(m_recv_pending.begin(), m_recv_pending.end() - pending.size());
+        if (m_recv_pending.empty()) ClearShrink(m_recv_pending);
+        return ret;
+    }
+
+    return ProcessReceivedBytes(msg_bytes);
+}
+
+bool V2Transport::ProcessReceivedBytes(std::span<const uint8_t>& msg_bytes) noexcept
+{
+    AssertLockHeld(m_recv_mutex);
+
     // Process the provided bytes in msg_bytes in a loop. In each iteration a nonzero number of
     // bytes (decided by GetMaxBytesToProcess) are taken from the beginning om msg_bytes, and
     // appended to m_recv_buffer. Then, depending on the receiver state, one of the
@@ -1331,42 +1461,51 @@ bool V2Transport::ReceivedBytes(std::span<const uint8_t>& msg_bytes) noexcept
         // Decide how many bytes to copy from msg_bytes to m_recv_buffer.
         size_t max_read = GetMaxBytesToProcess();
 
-        // Reserve space in the buffer if there is not enough.
-        if (m_recv_buffer.size() + std::min(msg_bytes.size(), max_read) > m_recv_buffer.capacity()) {
-            switch (m_recv_state) {
-            case RecvState::KEY_MAYBE_V1:
-            case RecvState::KEY:
-            case RecvState::GARB_GARBTERM:
-                // During the initial states (key/garbage), allocate once to fit the maximum (4111
-                // bytes).
+        switch (m_recv_state) {
+        case RecvState::KEY_MAYBE_V1:
+        case RecvState::KEY:
+        case RecvState::GARB_GARBTERM:
+            // During the initial states (key/garbage), allocate once to fit the maximum (4111
+            // bytes).
+            if (m_recv_buffer.size() + std::min(msg_bytes.size(), max_read) > m_recv_buffer.capacity()) {
                 m_recv_buffer.reserve(MAX_GARBAGE_LEN + BIP324Cipher::GARBAGE_TERMINATOR_LEN);
-                break;
-            case RecvState::VERSION:
-            case RecvState::APP: {
-                // During states where a packet is being received, as much as is expected but never
-                // more than MAX_RESERVE_AHEAD bytes in addition to what is received so far.
-                // This means attackers that want to cause us to waste allocated memory are limited
-                // to MAX_RESERVE_AHEAD above the largest allowed message contents size, and to
-                // MAX_RESERVE_AHEAD more than they've actually sent us.
-                size_t alloc_add = std::min(max_read, msg_bytes.size() + MAX_RESERVE_AHEAD);
-                m_recv_buffer.reserve(m_recv_buffer.size() + alloc_add);
-                break;
             }
-            case RecvState::APP_READY:
-                // The buffer is empty in this state.
-                Assume(m_recv_buffer.empty());
-                break;
-            case RecvState::V1:
-                // Should have bailed out above.
-                Assume(false);
-                break;
+            break;
+        case RecvState::VERSION:
+        case RecvState::APP:
+            // During states where a packet is being received, the buffer is sized to as much as is
+            // expected but never more than MAX_RESERVE_AHEAD bytes in addition to what is received
+            // so far. This means attackers that want to cause us to waste allocated memory are
+            // limited to MAX_RESERVE_AHEAD above the largest allowed message contents size, and to
+            // MAX_RESERVE_AHEAD more than they've actually sent us.
+            if (m_recv_buffer.size() < m_recv_pos + std::min(msg_bytes.size(), max_read)) {
+                m_recv_buffer.resize(m_recv_pos + std::min(max_read, msg_bytes.size() + MAX_RESERVE_AHEAD));
             }
+            break;
+        case RecvState::KEY_EXCHANGE:
+        case RecvState::APP_READY:
+            // No bytes are processed in these states.
+            Assume(max_read == 0);
+            break;
+        case RecvState::V1:
+            // Should have bailed out above.
+            Assume(false);
+            break;
         }
 
         // Can't read more than provided input.
         max_read = std::min(msg_bytes.size(), max_read);
         // Copy data to buffer.
-        m_recv_buffer.insert(m_recv_buffer.end(), UCharCast(msg_bytes.data()), UCharCast(msg_bytes.data() + max_read));
+        if (m_recv_state == RecvState::VERSION || m_recv_state == RecvState::APP) {
+            // Bytes which were received into GetReceiveBuffer() are in place already.
+            if (msg_bytes.data() != UCharCast(m_recv_buffer.data() + m_recv_pos)) {
+                std::memcpy(m_recv_buffer.data() + m_recv_pos, msg_bytes.data(), max_read);
+            }
+            m_recv_pos += max_read;
+        } else {
+            const auto bytes{MakeByteSpan(msg_bytes).first(max_read)};
+            m_recv_buffer.insert(m_recv_buffer.end(), bytes.begin(), bytes.end());
+        }
         msg_bytes = msg_bytes.subspan(max_read);
 
         // Process data in the buffer.
@@ -1380,6 +1519,10 @@ bool V2Transport::ReceivedBytes(std::span<const uint8_t>& msg_bytes) noexcept
             if (!ProcessReceivedKeyBytes()) return false;
             break;
 
+        case RecvState::KEY_EXCHANGE:
+            // The remaining bytes are kept by the next ReceivedBytes call.
+            return true;
+
         case RecvState::GARB_GARBTERM:
             if (!ProcessReceivedGarbageBytes()) return false;
             break;
@@ -1451,57 +1594,103 @@ CNetMessage V2Transport::GetReceivedMessage(std::chrono::microseconds time, bool
     if (m_recv_state == RecvState::V1) return m_v1_fallback.GetReceivedMessage(time, reject_message);
 
     Assume(m_recv_state == RecvState::APP_READY);
-    std::span<const uint8_t> contents{m_recv_decode_buffer};
+    std::span<const uint8_t> contents{MakeUCharSpan(m_recv_buffer).subspan(BIP324Cipher::LENGTH_LEN + BIP324Cipher::HEADER_LEN, m_recv_len)};
     auto msg_type = GetMessageType(contents);
     CNetMessage msg{DataStream{}};
     // Note that BIP324Cipher::EXPANSION also includes the length descriptor size.
-    msg.m_raw_message_size = m_recv_decode_buffer.size() + BIP324Cipher::EXPANSION;
+    msg.m_raw_message_size = m_recv_len + BIP324Cipher::EXPANSION;
     if (msg_type) {
         reject_message = false;
         msg.m_type = std::move(*msg_type);
         msg.m_time = time;
         msg.m_message_size = contents.size();
-        msg.m_recv.resize(contents.size());
-        std::copy(contents.begin(), contents.end(), UCharCast(msg.m_recv.data()));
+        // Hand the buffer over to the message, without the tag after the payload, and skipping
+        // everything before it.
+        const size_t payload_pos = contents.data() - UCharCast(m_recv_buffer.data());
+        m_recv_buffer.resize(payload_pos + contents.size());
+        msg.m_recv = DataStream{std::move(m_recv_buffer)};
+        msg.m_recv.ignore(payload_pos);
     } else {
-        LogDebug(BCLog::NET, "V2 transport error: invalid message type (%u bytes contents), peer=%d\n", m_recv_decode_buffer.size(), m_nodeid);
+        LogDebug(BCLog::NET, "V2 transport error: invalid message type (%u bytes contents), peer=%d\n", m_recv_len, m_nodeid);
         reject_message = true;
     }
-    ClearShrink(m_recv_decode_buffer);
+    ClearShrink(m_recv_buffer);
+    m_recv_pos = 0;
     SetReceiveState(RecvState::APP);
 
     return msg;
 }
 
+std::span<uint8_t> V2Transport::GetReceiveBuffer() noexcept
+{
+    AssertLockNotHeld(m_recv_mutex);
+    LOCK(m_recv_mutex);
+    if (m_recv_state == RecvState::V1) return m_v1_fallback.GetReceiveBuffer();
+    // Once the length of a packet is known, the rest of it can be received in place. Before, and in
+    // the other states, only a few bytes are processed at a time.
+    if (m_recv_state != RecvState::VERSION && m_recv_state != RecvState::APP) return {};
+    // Like for V1Transport, a small rest of a packet is read into the socket handler's buffer along
+    // with what follows it.
+    if (m_recv_pos < BIP324Cipher::LENGTH_LEN || GetMaxBytesToProcess() < SOCKET_RECV_BUFFER_SIZE) return {};
+    if (m_recv_buffer.size() == m_recv_pos) {
+        m_recv_buffer.resize(m_recv_pos + std::min(GetMaxBytesToProcess(), MAX_RESERVE_AHEAD));
+    }
+    return MakeWritableUCharSpan(m_recv_buffer).subspan(m_recv_pos);
+}
+
+bool V2Transport::ReceivePending() const noexcept
+{
+    AssertLockNotHeld(m_recv_mutex);
+    LOCK(m_recv_mutex);
+    if (m_recv_state == RecvState::KEY_EXCHANGE) return KeyExchangeReady();
+    return !m_recv_pending.empty() && m_recv_state != RecvState::APP_READY;
+}
+
+bool V2Transport::ReceiveWaiting() const noexcept
+{
+    AssertLockNotHeld(m_recv_mutex);
+    LOCK(m_recv_mutex);
+    return m_recv_state == RecvState::KEY_EXCHANGE && !KeyExchangeReady();
+}
+
 bool V2Transport::SetMessageToSend(CSerializedNetMsg& msg) noexcept
 {
     AssertLockNotHeld(m_send_mutex);
     LOCK(m_send_mutex);
     if (m_send_state == SendState::V1) return m_v1_fallback.SetMessageToSend(msg);
     // We only allow adding a new message to be sent when in the READY state (so the packet cipher
-    // is available) and the send buffer is empty. This limits the number of messages in the send
-    // buffer to just one, and leaves the responsibility for queueing them up to the caller.
-    if (!(m_send_state == SendState::READY && m_send_buffer.empty())) return false;
+    // is available). It is encrypted into the send buffer if that is empty, and queued behind it
+    // otherwise, up to MAX_SEND_QUEUE packets. Further queueing is left to the caller.
+    if (m_send_state != SendState::READY) return false;
+    if (!m_send_buffer.empty() && m_send_queue.size() >= MAX_SEND_QUEUE) return false;
     // Construct contents (encoding message type + payload).
     std::vector<uint8_t> contents;
+    const auto payload{msg.Payload()};
     auto short_message_id = V2_MESSAGE_MAP(msg.m_type);
     if (short_message_id) {
-        contents.resize(1 + msg.data.size());
+        contents.resize(1 + payload.size());
         contents[0] = *short_message_id;
-        std::copy(msg.data.begin(), msg.data.end(), contents.begin() + 1);
+        std::copy(payload.begin(), payload.end(), contents.begin() + 1);
     } else {
         // Initialize with zeroes, and then write the message type string starting at offset 1.
         // This means contents[0] and the unused positions in contents[1..13] remain 0x00.
-        contents.resize(1 + CMessageHeader::MESSAGE_TYPE_SIZE + msg.data.size(), 0);
+        contents.resize(1 + CMessageHeader::MESSAGE_TYPE_SIZE + payload.size(), 0);
         std::copy(msg.m_type.begin(), msg.m_type.end(), contents.data() + 1);
-        std::copy(msg.data.begin(), msg.data.end(), contents.begin() + 1 + CMessageHeader::MESSAGE_TYPE_SIZE);
+        std::copy(payload.begin(), payload.end(), contents.begin() + 1 + CMessageHeader::MESSAGE_TYPE_SIZE);
+    }
+    // Construct ciphertext in send buffer, or in a new queued packet.
+    std::vector<uint8_t>* packet{&m_send_buffer};
+    if (!m_send_buffer.empty()) {
+        auto& queued{m_send_queue.emplace_back()};
+        queued.type = msg.m_type;
+        packet = &queued.packet;
+    } else {
+        m_send_type = msg.m_type;
     }
-    // Construct ciphertext in send buffer.
-    m_send_buffer.resize(contents.size() + BIP324Cipher::EXPANSION);
-    m_cipher.Encrypt(MakeByteSpan(contents), {}, false, MakeWritableByteSpan(m_send_buffer));
-    m_send_type = msg.m_type;
+    packet->resize(contents.size() + BIP324Cipher::EXPANSION);
+    m_cipher.Encrypt(MakeByteSpan(contents), {}, false, MakeWritableByteSpan(*packet));
     // Release memory
-    ClearShrink(msg.data);
+    msg.ClearPayload();
     return true;
 }
 
@@ -1515,13 +1704,29 @@ Transport::BytesToSend V2Transport::GetBytesToSend(bool have_next_message) const
     Assume(m_send_pos <= m_send_buffer.size());
     return {
         std::span{m_send_buffer}.subspan(m_send_pos),
-        // We only have more to send after the current m_send_buffer if there is a (next)
-        // message to be sent, and we're capable of sending packets. */
-        have_next_message && m_send_state == SendState::READY,
+        // We only have more to send after the current m_send_buffer if there are queued packets,
+        // or if there is a (next) message to be sent, and we're capable of sending packets. */
+        !m_send_queue.empty() || (have_next_message && m_send_state == SendState::READY),
         m_send_type
     };
 }
 
+Transport::BuffersToSend V2Transport::GetBuffersToSend(bool have_next_message) const noexcept
+{
+    AssertLockNotHeld(m_send_mutex);
+    LOCK(m_send_mutex);
+    if (m_send_state == SendState::V1) return m_v1_fallback.GetBuffersToSend(have_next_message);
+
+    Assume(m_send_pos <= m_send_buffer.size());
+    std::vector<std::span<const uint8_t>> to_send;
+    if (m_send_pos < m_send_buffer.size()) {
+        to_send.reserve(1 + m_send_queue.size());
+        to_send.push_back(std::span{m_send_buffer}.subspan(m_send_pos));
+        for (const auto& queued : m_send_queue) to_send.emplace_back(queued.packet);
+    }
+    return {std::move(to_send), have_next_message && m_send_state == SendState::READY};
+}
+
 void V2Transport::MarkBytesSent(size_t bytes_sent) noexcept
 {
     AssertLockNotHeld(m_send_mutex);
@@ -1537,10 +1742,16 @@ void V2Transport::MarkBytesSent(size_t bytes_sent) noexcept
     if (m_send_pos >= CMessageHeader::HEADER_SIZE) {
         m_sent_v1_header_worth = true;
     }
-    // Wipe the buffer when everything is sent.
+    // Move on to the next queued packet, or wipe the buffer, when everything is sent.
     if (m_send_pos == m_send_buffer.size()) {
         m_send_pos = 0;
-        ClearShrink(m_send_buffer);
+        if (m_send_queue.empty()) {
+            ClearShrink(m_send_buffer);
+        } else {
+            m_send_buffer = std::move(m_send_queue.front().packet);
+            m_send_type = std::move(m_send_queue.front().type);
+            m_send_queue.pop_front();
+        }
     }
 }
 
@@ -1567,7 +1778,9 @@ size_t V2Transport::GetSendMemoryUsage() const noexcept
     LOCK(m_send_mutex);
     if (m_send_state == SendState::V1) return m_v1_fallback.GetSendMemoryUsage();
 
-    return sizeof(m_send_buffer) + memusage::DynamicUsage(m_send_buffer);
+    size_t usage{sizeof(m_send_buffer) + memusage::DynamicUsage(m_send_buffer)};
+    for (const auto& queued : m_send_queue) usage += sizeof(queued.packet) + memusage::DynamicUsage(queued.packet);
+    return usage;
 }
 
 Transport::Info V2Transport::GetInfo() const noexcept
@@ -1581,7 +1794,8 @@ Transport::Info V2Transport::GetInfo() const noexcept
     // Do not report v2 and session ID until the version packet has been received
     // and verified (confirming that the other side very likely has the same keys as us).
     if (m_recv_state != RecvState::KEY_MAYBE_V1 && m_recv_state != RecvState::KEY &&
-        m_recv_state != RecvState::GARB_GARBTERM && m_recv_state != RecvState::VERSION) {
+        m_recv_state != RecvState::KEY_EXCHANGE && m_recv_state != RecvState::GARB_GARBTERM &&
+        m_recv_state != RecvState::VERSION) {
         info.transport_type = TransportProtocolType::V2;
         info.session_id = uint256(MakeUCharSpan(m_cipher.GetSessionID()));
     } else {
@@ -1599,25 +1813,26 @@ std::pair<size_t, bool> CConnman::SocketSendData(CNode& node) const
     std::optional<bool> expected_more;
 
     while (true) {
-        if (it != node.vSendMsg.end()) {
-            // If possible, move one message from the send queue to the transport. This fails when
-            // there is an existing message still being sent, or (for v2 transports) when the
-            // handshake has not yet completed.
+        // Move as many messages from the send queue to the transport as it accepts, so they can
+        // be sent with a single call. This stops when its own queue is full, or (for v2
+        // transports) when the handshake has not yet completed.
+        while (it != node.vSendMsg.end()) {
             size_t memusage = it->GetMemoryUsage();
-            if (node.m_transport->SetMessageToSend(*it)) {
-                // Update memory usage of send buffer (as *it will be deleted).
-                node.m_send_memusage -= memusage;
-                ++it;
-            }
+            if (!node.m_transport->SetMessageToSend(*it)) break;
+            // Update memory usage of send buffer (as *it will be deleted).
+            node.m_send_memusage -= memusage;
+            ++it;
         }
-        const auto& [data, more, msg_type] = node.m_transport->GetBytesToSend(it != node.vSendMsg.end());
-        // We rely on the 'more' value returned by GetBytesToSend to correctly predict whether more
-        // bytes are still to be sent, to correctly set the MSG_MORE flag. As a sanity check,
+        const auto [data, more] = node.m_transport->GetBuffersToSend(it != node.vSendMsg.end());
+        // We rely on the 'more' value returned by GetBuffersToSend to correctly predict whether
+        // more bytes are still to be sent, to correctly set the MSG_MORE flag. As a sanity check,
         // verify that the previously returned 'more' was correct.
         if (expected_more.has_value()) Assume(!data.empty() == *expected_more);
         expected_more = more;
         data_left = !data.empty(); // will be overwritten on next loop if all of data gets sent
-        int nBytes = 0;
+        size_t data_size{0};
+        for (const auto& buf : data) data_size += buf.size();
+        ssize_t nBytes = 0;
         if (!data.empty()) {
             LOCK(node.m_sock_mutex);
             // There is no socket in case we've already disconnected, or in test cases without
@@ -1632,19 +1847,26 @@ std::pair<size_t, bool> CConnman::SocketSendData(CNode& node) const
                 flags |= MSG_MORE;
             }
 #endif
-            nBytes = node.m_sock->Send(reinterpret_cast<const char*>(data.data()), data.size(), flags);
+            nBytes = node.m_sock->SendVectored(data, flags);
+            ++m_total_send_calls;
         }
         if (nBytes > 0) {
             node.m_last_send = GetTime<std::chrono::seconds>();
             node.nSendBytes += nBytes;
-            // Notify transport that bytes have been processed.
-            node.m_transport->MarkBytesSent(nBytes);
-            // Update statistics per message type.
-            if (!msg_type.empty()) { // don't report v2 handshake bytes for now
-                node.AccountForSentBytes(msg_type, nBytes);
+            // Notify transport that bytes have been processed, one message at a time, and update
+            // statistics per message type.
+            for (size_t left = nBytes; left > 0;) {
+                const auto& [msg_data, _more, msg_type] = node.m_transport->GetBytesToSend(/*have_next_message=*/false);
+                if (!Assume(!msg_data.empty())) break;
+                const size_t msg_bytes{std::min(left, msg_data.size())};
+                if (!msg_type.empty()) { // don't report v2 handshake bytes for now
+                    node.AccountForSentBytes(msg_type, msg_bytes);
+                }
+                node.m_transport->MarkBytesSent(msg_bytes);
+                left -= msg_bytes;
             }
             nSentSize += nBytes;
-            if ((size_t)nBytes != data.size()) {
+            if ((size_t)nBytes != data_size) {
                 // could not send full message; stop sending more
                 break;
             }
@@ -1837,6 +2059,7 @@ void CConnman::CreateNodeFromAcceptedSocket(std::unique_ptr<Sock>&& sock,
                                  .prefer_evict = discouraged,
                                  .recv_flood_size = nReceiveFloodSize,
                                  .use_v2transport = use_v2transport,
+                                 .key_exchange_pool = m_key_exchange_pool ? &*m_key_exchange_pool : nullptr,
                              });
     pnode->AddRef();
     m_msgproc->InitializeNode(*pnode, local_services);
@@ -2055,7 +2278,9 @@ Sock::EventsPerSock CConnman::GenerateWaitSockets(std::span<CNode* const> nodes)
     }
 
     for (CNode* pnode : nodes) {
-        bool select_recv = !pnode->fPauseRecv;
+        // Do not read from peers whose transport waits for a key exchange; the socket handler
+        // continues with them once it completes.
+        bool select_recv = !pnode->fPauseRecv && !WITH_LOCK(pnode->cs_vRecv, return pnode->m_transport->ReceiveWaiting());
         bool select_send;
         {
             LOCK(pnode->cs_vSend);
@@ -2086,7 +2311,10 @@ void CConnman::SocketHandler()
     {
         const NodesSnapshot snap{*this, /*shuffle=*/false};
 
-        const auto timeout = std::chrono::milliseconds(SELECT_TIMEOUT_MILLISECONDS);
+        const bool key_exchanges{std::ranges::any_of(snap.Nodes(), [](CNode* node) {
+            return WITH_LOCK(node->cs_vRecv, return node->m_transport->ReceiveWaiting());
+        })};
+        const auto timeout = std::chrono::milliseconds(key_exchanges ? KEY_EXCHANGE_POLL_MILLISECONDS : SELECT_TIMEOUT_MILLISECONDS);
 
         // Check for the readiness of the already connected sockets and the
         // listening sockets in one call ("readiness" as in poll(2) or
@@ -2153,19 +2381,24 @@ void CConnman::SocketHandlerConnected(const std::vector<CNode*>& nodes,
         if (recvSet || errorSet)
         {
             // typical socket buffer is 8K-64K
-            uint8_t pchBuf[0x10000];
+            uint8_t pchBuf[SOCKET_RECV_BUFFER_SIZE];
+            // Read straight into the transport's buffer when it has one, to avoid copying the bytes.
+            std::span<uint8_t> recv_buf{pnode->GetReceiveBuffer()};
+            if (recv_buf.empty()) recv_buf = pchBuf;
+            recv_buf = recv_buf.first(std::min(recv_buf.size(), sizeof(pchBuf)));
             int nBytes = 0;
             {
                 LOCK(pnode->m_sock_mutex);
                 if (!pnode->m_sock) {
                     continue;
                 }
-                nBytes = pnode->m_sock->Recv(pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
+                nBytes = pnode->m_sock->Recv(recv_buf.data(), recv_buf.size(), MSG_DONTWAIT);
+                ++m_total_recv_calls;
             }
             if (nBytes > 0)
             {
                 bool notify = false;
-                if (!pnode->ReceiveMsgBytes({pchBuf, (size_t)nBytes}, notify)) {
+                if (!pnode->ReceiveMsgBytes(recv_buf.first(nBytes), notify)) {
                     LogDebug(BCLog::NET,
                         "receiving message bytes failed, %s\n",
                         pnode->DisconnectMsg(fLogIPs)
@@ -2198,6 +2431,20 @@ void CConnman::SocketHandlerConnected(const std::vector<CNode*>& nodes,
                     pnode->CloseSocketDisconnect();
                 }
             }
+        } else if (WITH_LOCK(pnode->cs_vRecv, return pnode->m_transport->ReceivePending())) {
+            // Continue with what was received during a key exchange which has completed since.
+            bool notify = false;
+            if (!pnode->ReceiveMsgBytes({}, notify)) {
+                LogDebug(BCLog::NET,
+                    "receiving message bytes failed, %s\n",
+                    pnode->DisconnectMsg(fLogIPs)
+                );
+                pnode->CloseSocketDisconnect();
+            }
+            if (notify) {
+                pnode->MarkReceivedMsgsForProcessing();
+                WakeMessageHandler();
+            }
         }
 
         if (InactivityCheck(*pnode)) pnode->fDisconnect = true;
@@ -3349,6 +3596,7 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
     }
 
     // Send and receive from sockets, accept connections
+    m_key_exchange_pool.emplace("keyexch", KEY_EXCHANGE_THREADS);
     threadSocketHandler = std::thread(&util::TraceThread, "net", [this] { ThreadSocketHandler(); });
 
     if (!gArgs.GetBoolArg("-dnsseed", DEFAULT_DNSSEED))
@@ -3447,6 +3695,7 @@ void CConnman::StopThreads()
         threadDNSAddressSeed.join();
     if (threadSocketHandler.joinable())
         threadSocketHandler.join();
+    m_key_exchange_pool.reset();
 }
 
 void CConnman::StopNodes()
@@ -3487,6 +3736,13 @@ void CConnman::DeleteNode(CNode* pnode)
 {
     assert(pnode);
     m_msgproc->FinalizeNode(*pnode);
+    CNodeStats stats;
+    pnode->CopyStats(stats);
+    {
+        LOCK(m_msg_type_bytes_mutex);
+        for (const auto& [msg_type, bytes] : stats.mapSendBytesPerMsgType) m_disconnected_bytes_sent_per_msg_type[msg_type] += bytes;
+        for (const auto& [msg_type, bytes] : stats.mapRecvBytesPerMsgType) m_disconnected_bytes_recv_per_msg_type[msg_type] += bytes;
+    }
     delete pnode;
 }
 
@@ -3772,15 +4028,41 @@ uint64_t CConnman::GetTotalBytesSent() const
     return nTotalBytesSent;
 }
 
+uint64_t CConnman::GetTotalSendCalls() const
+{
+    return m_total_send_calls;
+}
+
+uint64_t CConnman::GetTotalRecvCalls() const
+{
+    return m_total_recv_calls;
+}
+
+void CConnman::GetTotalBytesPerMsgType(mapMsgTypeSize& sent, mapMsgTypeSize& recv) const
+{
+    {
+        LOCK(m_msg_type_bytes_mutex);
+        sent = m_disconnected_bytes_sent_per_msg_type;
+        recv = m_disconnected_bytes_recv_per_msg_type;
+    }
+    LOCK(m_nodes_mutex);
+    for (CNode* pnode : m_nodes) {
+        CNodeStats stats;
+        pnode->CopyStats(stats);
+        for (const auto& [msg_type, bytes] : stats.mapSendBytesPerMsgType) sent[msg_type] += bytes;
+        for (const auto& [msg_type, bytes] : stats.mapRecvBytesPerMsgType) recv[msg_type] += bytes;
+    }
+}
+
 ServiceFlags CConnman::GetLocalServices() const
 {
     return m_local_services;
 }
 
-static std::unique_ptr<Transport> MakeTransport(NodeId id, bool use_v2transport, bool inbound) noexcept
+static std::unique_ptr<Transport> MakeTransport(NodeId id, bool use_v2transport, bool inbound, ThreadPool* key_exchange_pool) noexcept
 {
     if (use_v2transport) {
-        return std::make_unique<V2Transport>(id, /*initiating=*/!inbound);
+        return std::make_unique<V2Transport>(id, /*initiating=*/!inbound, key_exchange_pool);
     } else {
         return std::make_unique<V1Transport>(id);
     }
@@ -3796,7 +4078,7 @@ CNode::CNode(NodeId idIn,
              ConnectionType conn_type_in,
              bool inbound_onion,
              CNodeOptions&& node_opts)
-    : m_transport{MakeTransport(idIn, node_opts.use_v2transport, conn_type_in == ConnectionType::INBOUND)},
+    : m_transport{MakeTransport(idIn, node_opts.use_v2transport, conn_type_in == ConnectionType::INBOUND, node_opts.key_exchange_pool)},
       m_permission_flags{node_opts.permission_flags},
       m_sock{sock},
       m_connected{GetTime<std::chrono::seconds>()},
@@ -3866,10 +4148,10 @@ bool CConnman::NodeFullyConnected(const CNode* pnode)
 void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
 {
     AssertLockNotHeld(m_total_bytes_sent_mutex);
-    size_t nMessageSize = msg.data.size();
+    size_t nMessageSize = msg.Payload().size();
     LogDebug(BCLog::NET, "sending %s (%d bytes) peer=%d\n", msg.m_type, nMessageSize, pnode->GetId());
     if (gArgs.GetBoolArg("-capturemessages", false)) {
-        CaptureMessage(pnode->addr, msg.m_type, msg.data, /*is_incoming=*/false);
+        CaptureMessage(pnode->addr, msg.m_type, msg.Payload(), /*is_incoming=*/false);
     }
 
     TRACEPOINT(net, outbound_message,
@@ -3877,8 +4159,8 @@ void CConnman::PushMessage(CNode* pnode, CSerializedNetMsg&& msg)
         pnode->m_addr_name.c_str(),
         pnode->ConnectionTypeAsString().c_str(),
         msg.m_type.c_str(),
-        msg.data.size(),
-        msg.data.data()
+        msg.Payload().size(),
+        msg.Payload().data()
     );
 
     size_t nBytesSent = 0;
@@ -32,17 +32,20 @@
 #include <util/check.h>
 #include <util/sock.h>
 #include <util/threadinterrupt.h>
+#include <util/threadpool.h>
 
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
 #include <deque>
 #include <functional>
+#include <future>
 #include <list>
 #include <map>
 #include <memory>
 #include <optional>
 #include <queue>
+#include <span>
 #include <thread>
 #include <unordered_set>
 #include <vector>
@@ -62,6 +65,9 @@ static constexpr auto FEELER_INTERVAL = 2min;
 static constexpr auto EXTRA_BLOCK_RELAY_ONLY_PEER_INTERVAL = 5min;
 /** Maximum length of incoming protocol messages (no message over 4 MB is currently acceptable). */
 static const unsigned int MAX_PROTOCOL_MESSAGE_LENGTH = 4 * 1000 * 1000;
+/** Size of the buffer the socket handler receives into, unless the transport provides one (see
+ *  Transport::GetReceiveBuffer). */
+static constexpr size_t SOCKET_RECV_BUFFER_SIZE{0x10000};
 /** Maximum length of the user agent string in `version` message */
 static const unsigned int MAX_SUBVERSION_LENGTH = 256;
 /** Maximum number of automatic outgoing nodes over which we'll relay everything (blocks, tx, addrs, etc) */
@@ -124,13 +130,26 @@ struct CSerializedNetMsg {
     {
         CSerializedNetMsg copy;
         copy.data = data;
+        copy.m_shared_data = m_shared_data;
         copy.m_type = m_type;
         return copy;
     }
 
     std::vector<unsigned char> data;
+    /** Payload shared with other messages, which is sent instead of data if set. Copying the
+     *  message does not copy it. */
+    std::shared_ptr<const std::vector<unsigned char>> m_shared_data;
     std::string m_type;
 
+    /** The payload to send. */
+    std::span<const unsigned char> Payload() const noexcept
+    {
+        return m_shared_data ? std::span{*m_shared_data} : std::span{data};
+    }
+
+    /** Release the payload. */
+    void ClearPayload() noexcept;
+
     /** Compute total memory usage of this object (own memory + any dynamic memory). */
     size_t GetMemoryUsage() const noexcept;
 };
@@ -254,6 +273,10 @@ public:
 /** The Transport converts one connection's sent messages to wire bytes, and received bytes back. */
 class Transport {
 public:
+    /** How many messages a transport queues behind the one being sent, so that a single send
+     *  call can write them all to the socket. */
+    static constexpr size_t MAX_SEND_QUEUE{32};
+
     virtual ~Transport() = default;
 
     struct Info
@@ -279,6 +302,14 @@ public:
      */
     virtual bool ReceivedBytes(std::span<const uint8_t>& msg_bytes) = 0;
 
+    /** Return the buffer the next wire bytes would be copied into, if known.
+     *
+     * Bytes written to (a prefix of) this buffer and then passed to ReceivedBytes, with msg_bytes
+     * pointing to its start, are not copied again. The buffer is only valid until the next call
+     * to another receiver side function. Returns an empty span if there is no such buffer.
+     */
+    virtual std::span<uint8_t> GetReceiveBuffer() noexcept = 0;
+
     /** Retrieve a completed message from transport.
      *
      * This can only be called when ReceivedMessageComplete() is true.
@@ -288,13 +319,25 @@ public:
      */
     virtual CNetMessage GetReceivedMessage(std::chrono::microseconds time, bool& reject_message) = 0;
 
+    /** Returns true if ReceivedBytes can make progress without new bytes.
+     *
+     * This is the case when bytes were received while the transport was waiting for work done on
+     * another thread (see ReceiveWaiting), and that work has completed. ReceivedBytes must then
+     * be called, with an empty msg_bytes if nothing new was received, until this is false.
+     */
+    virtual bool ReceivePending() const noexcept = 0;
+
+    /** Returns true if the transport is waiting for work done on another thread, after which
+     *  ReceivePending() will return true. No more bytes should be read from the peer meanwhile. */
+    virtual bool ReceiveWaiting() const noexcept = 0;
+
     // 2. Sending side functions, for converting messages into bytes to be sent over the wire.
 
     /** Set the next message to send.
      *
-     * If no message can currently be set (perhaps because the previous one is not yet done being
-     * sent), returns false, and msg will be unmodified. Otherwise msg is enqueued (and
-     * possibly moved-from) and true is returned.
+     * If no message can currently be set (perhaps because MAX_SEND_QUEUE messages are already
+     * waiting behind the one being sent), returns false, and msg will be unmodified. Otherwise
+     * msg is enqueued (and possibly moved-from) and true is returned.
      */
     virtual bool SetMessageToSend(CSerializedNetMsg& msg) noexcept = 0;
 
@@ -348,6 +391,27 @@ public:
      */
     virtual BytesToSend GetBytesToSend(bool have_next_message) const noexcept = 0;
 
+    /** Return type for GetBuffersToSend, consisting of:
+     *  - std::vector<std::span<const uint8_t>> to_send: non-empty buffers of bytes to be sent over
+     *    the wire, in order.
+     *  - bool more: whether there will be more bytes to be sent after all of to_send is sent.
+     */
+    using BuffersToSend = std::pair<
+        std::vector<std::span<const uint8_t>> /*to_send*/,
+        bool /*more*/
+    >;
+
+    /** Get all bytes to send on the wire, for a vectored send.
+     *
+     * The first buffer is the to_send of GetBytesToSend(), and the others hold the bytes it will
+     * return after that, for the messages queued behind the one being sent. Bytes sent from them
+     * must still be reported to MarkBytesSent() one GetBytesToSend() result at a time, which
+     * allows accounting for them per message type. The more return value and have_next_message
+     * are as in GetBytesToSend(), for after the last buffer. The buffers refer to data internal
+     * to the transport, and calling any non-const function on this object may invalidate them.
+     */
+    virtual BuffersToSend GetBuffersToSend(bool have_next_message) const noexcept = 0;
+
     /** Report how many bytes returned by the last GetBytesToSend() have been sent.
      *
      * bytes_sent cannot exceed to_send.size() of the last GetBytesToSend() result.
@@ -368,6 +432,9 @@ public:
 class V1Transport final : public Transport
 {
 private:
+    /** How many bytes to allocate in the receive buffer at most above what is received so far. */
+    static constexpr size_t MAX_RESERVE_AHEAD = 256 * 1024;
+
     const MessageStartChars m_magic_bytes;
     const NodeId m_node_id; // Only for logging
     mutable Mutex m_recv_mutex; //!< Lock for receive state
@@ -413,6 +480,14 @@ private:
     bool m_sending_header GUARDED_BY(m_send_mutex) {false};
     /** How many bytes have been sent so far (from m_header_to_send, or from m_message_to_send.data). */
     size_t m_bytes_sent GUARDED_BY(m_send_mutex) {0};
+    /** A message waiting to be sent, with its serialized header. */
+    struct QueuedMessage
+    {
+        std::vector<uint8_t> header;
+        CSerializedNetMsg msg;
+    };
+    /** The messages to send after m_message_to_send, at most MAX_SEND_QUEUE. */
+    std::deque<QueuedMessage> m_send_queue GUARDED_BY(m_send_mutex);
 
 public:
     explicit V1Transport(const NodeId node_id) noexcept;
@@ -438,10 +513,14 @@ public:
         return ret >= 0;
     }
 
+    std::span<uint8_t> GetReceiveBuffer() noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_recv_mutex);
     CNetMessage GetReceivedMessage(std::chrono::microseconds time, bool& reject_message) override EXCLUSIVE_LOCKS_REQUIRED(!m_recv_mutex);
+    bool ReceivePending() const noexcept override { return false; }
+    bool ReceiveWaiting() const noexcept override { return false; }
 
     bool SetMessageToSend(CSerializedNetMsg& msg) noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     BytesToSend GetBytesToSend(bool have_next_message) const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
+    BuffersToSend GetBuffersToSend(bool have_next_message) const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     void MarkBytesSent(size_t bytes_sent) noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     size_t GetSendMemoryUsage() const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     bool ShouldReconnectV1() const noexcept override { return false; }
@@ -459,6 +538,9 @@ private:
      *  determine if their peer is speaking V1 or V2. */
     static constexpr size_t V1_PREFIX_LEN = 16;
 
+    /** How many bytes to allocate in the receive buffer at most above what is received so far. */
+    static constexpr size_t MAX_RESERVE_AHEAD = 256 * 1024;
+
     // The sender side and receiver side of V2Transport are state machines that are transitioned
     // through, based on what has been received. The receive state corresponds to the contents of,
     // and bytes received to, the receive buffer. The send state controls what can be appended to
@@ -475,6 +557,9 @@ private:
      *        |          |                                  |         |
      *        v          v                                  v         |
      *  KEY_MAYBE_V1 -> KEY -> GARB_GARBTERM -> VERSION -> APP -> APP_READY
+     *        |          |          ^
+     *        |          v          |
+     *        |    KEY_EXCHANGE ----/
      *        |
      *        \-------> V1
      */
@@ -493,6 +578,14 @@ private:
          * becomes GARB_GARBTERM. */
         KEY,
 
+        /** Nothing (the shared secret is being computed on another thread).
+         *
+         * When a key exchange pool is used, this state is entered from KEY once the other side's
+         * public key is received. Bytes received in this state are kept in m_recv_pending. When
+         * the shared secret is known, the ciphers get initialized, the state becomes
+         * GARB_GARBTERM, and the kept bytes are processed before any new ones. */
+        KEY_EXCHANGE,
+
         /** Garbage and garbage terminator.
          *
          * Whenever a byte is received, the last 16 bytes are compared with the expected garbage
@@ -514,8 +607,8 @@ private:
         /** Application packet.
          *
          * A packet is received, and decrypted/verified. If that succeeds, the state becomes
-         * APP_READY and the decrypted contents is kept in m_recv_decode_buffer until it is
-         * retrieved as a message by GetMessage(). */
+         * APP_READY and the decrypted contents is kept in m_recv_buffer until it is retrieved
+         * as a message by GetMessage(). */
         APP,
 
         /** Nothing (an application packet is available for GetMessage()).
@@ -581,20 +674,29 @@ private:
     const NodeId m_nodeid;
     /** Encapsulate a V1Transport to fall back to. */
     V1Transport m_v1_fallback;
+    /** Pool to compute the shared secret on, or nullptr to compute it synchronously. */
+    ThreadPool* const m_key_exchange_pool;
 
     /** Lock for receiver-side fields. */
     mutable Mutex m_recv_mutex ACQUIRED_BEFORE(m_send_mutex);
-    /** In {VERSION, APP}, the decrypted packet length, if m_recv_buffer.size() >=
+    /** In {VERSION, APP}, the decrypted packet length, if m_recv_pos >=
      *  BIP324Cipher::LENGTH_LEN. Unspecified otherwise. */
     uint32_t m_recv_len GUARDED_BY(m_recv_mutex) {0};
-    /** Receive buffer; meaning is determined by m_recv_state. */
-    std::vector<uint8_t> m_recv_buffer GUARDED_BY(m_recv_mutex);
+    /** In {VERSION, APP}, how many bytes of the current packet were received into m_recv_buffer.
+     *  Once the packet length is known, the buffer is sized ahead of it, so that the rest of the
+     *  packet can be received in place (see GetReceiveBuffer). */
+    size_t m_recv_pos GUARDED_BY(m_recv_mutex) {0};
+    /** Receive buffer; meaning is determined by m_recv_state. Packets are decrypted in place,
+     *  and the buffer of an application packet is handed over to its CNetMessage. */
+    SerializeData m_recv_buffer GUARDED_BY(m_recv_mutex);
     /** AAD expected in next received packet (currently used only for garbage). */
-    std::vector<uint8_t> m_recv_aad GUARDED_BY(m_recv_mutex);
-    /** Buffer to put decrypted contents in, for converting to CNetMessage. */
-    std::vector<uint8_t> m_recv_decode_buffer GUARDED_BY(m_recv_mutex);
+    SerializeData m_recv_aad GUARDED_BY(m_recv_mutex);
     /** Current receiver state. */
     RecvState m_recv_state GUARDED_BY(m_recv_mutex);
+    /** The shared secret being computed on m_key_exchange_pool (KEY_EXCHANGE state only). */
+    std::future<ECDHSecret> m_key_exchange GUARDED_BY(m_recv_mutex);
+    /** Bytes received in KEY_EXCHANGE state which have not been processed yet. */
+    std::vector<uint8_t> m_recv_pending GUARDED_BY(m_recv_mutex);
 
     /** Lock for sending-side fields. If both sending and receiving fields are accessed,
      *  m_recv_mutex must be acquired before m_send_mutex. */
@@ -607,6 +709,14 @@ private:
     std::vector<uint8_t> m_send_garbage GUARDED_BY(m_send_mutex);
     /** Type of the message being sent. */
     std::string m_send_type GUARDED_BY(m_send_mutex);
+    /** An encrypted packet waiting to be sent, with the type of its message. */
+    struct QueuedPacket
+    {
+        std::vector<uint8_t> packet;
+        std::string type;
+    };
+    /** The packets to send after the send buffer (READY state only), at most MAX_SEND_QUEUE. */
+    std::deque<QueuedPacket> m_send_queue GUARDED_BY(m_send_mutex);
     /** Current sender state. */
     SendState m_send_state GUARDED_BY(m_send_mutex);
     /** Whether we've sent at least 24 bytes (which would trigger disconnect for V1 peers). */
@@ -626,6 +736,12 @@ private:
     void ProcessReceivedMaybeV1Bytes() noexcept EXCLUSIVE_LOCKS_REQUIRED(m_recv_mutex, !m_send_mutex);
     /** Process bytes in m_recv_buffer, while in KEY state. */
     bool ProcessReceivedKeyBytes() noexcept EXCLUSIVE_LOCKS_REQUIRED(m_recv_mutex, !m_send_mutex);
+    /** Initialize the ciphers with the shared secret, and switch to GARB_GARBTERM state. */
+    void CompleteKeyExchange(ECDHSecret ecdh_secret) noexcept EXCLUSIVE_LOCKS_REQUIRED(m_recv_mutex, !m_send_mutex);
+    /** Whether the shared secret computed on m_key_exchange_pool is available. */
+    bool KeyExchangeReady() const noexcept EXCLUSIVE_LOCKS_REQUIRED(m_recv_mutex);
+    /** Feed bytes to the receive state machine (not in V1 or KEY_EXCHANGE state). */
+    bool ProcessReceivedBytes(std::span<const uint8_t>& msg_bytes) noexcept EXCLUSIVE_LOCKS_REQUIRED(m_recv_mutex, !m_send_mutex);
     /** Process bytes in m_recv_buffer, while in GARB_GARBTERM state. */
     bool ProcessReceivedGarbageBytes() noexcept EXCLUSIVE_LOCKS_REQUIRED(m_recv_mutex);
     /** Process bytes in m_recv_buffer, while in VERSION/APP state. */
@@ -636,22 +752,28 @@ public:
 
     /** Construct a V2 transport with securely generated random keys.
      *
-     * @param[in] nodeid      the node's NodeId (only for debug log output).
-     * @param[in] initiating  whether we are the initiator side.
+     * @param[in] nodeid             the node's NodeId (only for debug log output).
+     * @param[in] initiating         whether we are the initiator side.
+     * @param[in] key_exchange_pool  pool to compute the shared secret on, so that the calling
+     *                               thread is not held up by it (optional).
      */
-    V2Transport(NodeId nodeid, bool initiating) noexcept;
+    V2Transport(NodeId nodeid, bool initiating, ThreadPool* key_exchange_pool = nullptr) noexcept;
 
     /** Construct a V2 transport with specified keys and garbage (test use only). */
-    V2Transport(NodeId nodeid, bool initiating, const CKey& key, std::span<const std::byte> ent32, std::vector<uint8_t> garbage) noexcept;
+    V2Transport(NodeId nodeid, bool initiating, const CKey& key, std::span<const std::byte> ent32, std::vector<uint8_t> garbage, ThreadPool* key_exchange_pool = nullptr) noexcept;
 
     // Receive side functions.
     bool ReceivedMessageComplete() const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_recv_mutex);
     bool ReceivedBytes(std::span<const uint8_t>& msg_bytes) noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_recv_mutex, !m_send_mutex);
+    std::span<uint8_t> GetReceiveBuffer() noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_recv_mutex);
     CNetMessage GetReceivedMessage(std::chrono::microseconds time, bool& reject_message) noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_recv_mutex);
+    bool ReceivePending() const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_recv_mutex);
+    bool ReceiveWaiting() const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_recv_mutex);
 
     // Send side functions.
     bool SetMessageToSend(CSerializedNetMsg& msg) noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     BytesToSend GetBytesToSend(bool have_next_message) const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
+    BuffersToSend GetBuffersToSend(bool have_next_message) const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     void MarkBytesSent(size_t bytes_sent) noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
     size_t GetSendMemoryUsage() const noexcept override EXCLUSIVE_LOCKS_REQUIRED(!m_send_mutex);
 
@@ -667,6 +789,8 @@ struct CNodeOptions
     bool prefer_evict = false;
     size_t recv_flood_size{DEFAULT_MAXRECEIVEBUFFER * 1000};
     bool use_v2transport = false;
+    //! Pool to run the v2 key exchange on, see V2Transport.
+    ThreadPool* key_exchange_pool = nullptr;
 };
 
 /** Information about a peer */
@@ -917,6 +1041,17 @@ public:
      */
     bool ReceiveMsgBytes(std::span<const uint8_t> msg_bytes, bool& complete) EXCLUSIVE_LOCKS_REQUIRED(!cs_vRecv);
 
+    /**
+     * The buffer the transport would copy the next received bytes into (see
+     * Transport::GetReceiveBuffer), so that they can be read from the socket
+     * directly into it. Only the socket handler thread may use it, until its
+     * next call to ReceiveMsgBytes.
+     */
+    std::span<uint8_t> GetReceiveBuffer() EXCLUSIVE_LOCKS_REQUIRED(!cs_vRecv)
+    {
+        return WITH_LOCK(cs_vRecv, return m_transport->GetReceiveBuffer());
+    }
+
     void SetCommonVersion(int greatest_common_version)
     {
         Assume(m_greatest_common_version == INIT_PROTO_VERSION);
@@ -1262,6 +1397,12 @@ public:
 
     uint64_t GetTotalBytesRecv() const;
     uint64_t GetTotalBytesSent() const EXCLUSIVE_LOCKS_REQUIRED(!m_total_bytes_sent_mutex);
+    /** Number of calls made to send to and receive from sockets of peers. */
+    uint64_t GetTotalSendCalls() const;
+    uint64_t GetTotalRecvCalls() const;
+
+    /** Bytes sent and received per message type, over all connections since startup. */
+    void GetTotalBytesPerMsgType(mapMsgTypeSize& sent, mapMsgTypeSize& recv) const EXCLUSIVE_LOCKS_REQUIRED(!m_nodes_mutex, !m_msg_type_bytes_mutex);
 
     /** Get a unique deterministic randomizer. */
     CSipHasher GetDeterministicRandomizer(uint64_t id) const;
@@ -1367,7 +1508,7 @@ private:
     CNode* ConnectNode(CAddress addrConnect, const char *pszDest, bool fCountFailure, ConnectionType conn_type, bool use_v2transport) EXCLUSIVE_LOCKS_REQUIRED(!m_unused_i2p_sessions_mutex);
     void AddWhitelistPermissionFlags(NetPermissionFlags& flags, const CNetAddr &addr, const std::vector<NetWhitelistPermissions>& ranges) const;
 
-    void DeleteNode(CNode* pnode);
+    void DeleteNode(CNode* pnode) EXCLUSIVE_LOCKS_REQUIRED(!m_msg_type_bytes_mutex);
 
     NodeId GetNewNodeId();
 
@@ -1413,6 +1554,14 @@ private:
     mutable Mutex m_total_bytes_sent_mutex;
     std::atomic<uint64_t> nTotalBytesRecv{0};
     uint64_t nTotalBytesSent GUARDED_BY(m_total_bytes_sent_mutex) {0};
+    //! Mutable as the const SocketSendData counts its calls.
+    mutable std::atomic<uint64_t> m_total_send_calls{0};
+    std::atomic<uint64_t> m_total_recv_calls{0};
+
+    // Network usage per message type of disconnected peers
+    mutable Mutex m_msg_type_bytes_mutex;
+    mapMsgTypeSize m_disconnected_bytes_sent_per_msg_type GUARDED_BY(m_msg_type_bytes_mutex);
+    mapMsgTypeSize m_disconnected_bytes_recv_per_msg_type GUARDED_BY(m_msg_type_bytes_mutex);
 
     // outbound limit & stats
     uint64_t nMaxOutboundTotalBytesSentInCycle GUARDED_BY(m_total_bytes_sent_mutex) {0};
@@ -1562,6 +1711,9 @@ private:
     std::thread threadOpenConnections;
     std::thread threadMessageHandler;
     std::thread threadI2PAcceptIncoming;
+    //! Computes the key exchange of v2 connections off the socket handler thread, while the
+    //! threads are running.
+    std::optional<ThreadPool> m_key_exchange_pool;
 
     /** flag for deciding to connect to an extra outbound peer,
      *  in excess of m_max_outbound_full_relay
@@ -53,6 +53,9 @@ struct CNodeStateStats {
     int m_starting_height = -1;
     std::chrono::microseconds m_ping_wait;
     std::vector<int> vHeightInFlight;
+    size_t m_inflight_window{0};
+    std::optional<double> m_block_download_bytes_per_sec;
+    std::optional<std::chrono::microseconds> m_block_download_latency;
     bool m_relay_txs;
     CAmount m_fee_filter_received;
     uint64_t m_addr_processed = 0;
@@ -0,0 +1,95 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blockdownload.h>
+
+#include <util/time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <optional>
+
+namespace node {
+namespace {
+void Average(double& average, double sample, bool first, double weight)
+{
+    average = first ? sample : average + weight * (sample - average);
+}
+} // namespace
+
+void BlockDownloadModel::BlockReceived(std::chrono::microseconds requested, std::chrono::microseconds received, size_t bytes)
+{
+    // Whether the peer was still sending the previous block when this one was requested.
+    const bool pipelined{m_samples > 0 && requested < m_last_received};
+    const double elapsed{std::max(0.0, Ticks<SecondsDouble>(received - (pipelined ? m_last_received : requested)))};
+
+    Average(m_block_bytes, bytes, m_samples == 0, SAMPLE_WEIGHT);
+    if (pipelined) {
+        Average(m_transfer_bytes, bytes, m_transfer_samples == 0, SAMPLE_WEIGHT);
+        Average(m_transfer_seconds, elapsed, m_transfer_samples == 0, SAMPLE_WEIGHT);
+        ++m_transfer_samples;
+    } else {
+        // Before the throughput is known, the whole response time counts as latency.
+        const auto bytes_per_second{GetBytesPerSecond()};
+        const double latency{bytes_per_second ? std::max(0.0, elapsed - bytes / *bytes_per_second) : elapsed};
+        Average(m_latency_seconds, latency, m_latency_samples == 0, SAMPLE_WEIGHT);
+        ++m_latency_samples;
+    }
+    m_last_received = std::max(m_last_received, received);
+    ++m_samples;
+}
+
+std::optional<double> BlockDownloadModel::GetBytesPerSecond() const
+{
+    if (m_transfer_samples == 0) return std::nullopt;
+    // Blocks which were processed in the same instant may average to no time at all.
+    return m_transfer_bytes / std::max(m_transfer_seconds, 1e-6);
+}
+
+std::optional<std::chrono::microseconds> BlockDownloadModel::GetLatency() const
+{
+    if (m_latency_samples == 0) return std::nullopt;
+    return std::chrono::microseconds{std::llround(m_latency_seconds * 1e6)};
+}
+
+size_t BlockDownloadModel::GetWindow() const
+{
+    const auto bytes_per_second{GetBytesPerSecond()};
+    // A peer which delivered every block before the next one was requested
+    // has never been limited by the window.
+    if (m_samples < MIN_SAMPLES || !bytes_per_second) return DEFAULT_BLOCKS_IN_FLIGHT_PER_PEER;
+
+    const double seconds{m_latency_seconds + Ticks<SecondsDouble>(TARGET_QUEUE_TIME)};
+    const double blocks{std::ceil(*bytes_per_second * seconds / std::max(m_block_bytes, 1.0))};
+    return std::clamp<double>(blocks, MIN_BLOCKS_IN_FLIGHT_PER_PEER, MAX_BLOCKS_IN_FLIGHT_PER_PEER);
+}
+
+BlockDownloadWalk::Step BlockDownloadWalk::Next(int height, std::optional<NodeId> in_flight_from, bool too_deep)
+{
+    if (in_flight_from) {
+        if (!m_waiting_for) {
+            // This is the first already-in-flight block.
+            m_waiting_for = in_flight_from;
+            if (!too_deep) m_waiting_for_height = height;
+        }
+        return Step::SKIP;
+    }
+
+    // The block is not already downloaded, and not yet in flight.
+    if (height > m_window_end) {
+        // We reached the end of the window. We aren't able to fetch anything, but we would be if the
+        // download window was one larger.
+        if (m_requested == 0 && m_waiting_for != m_peer) m_stalled = true;
+        return Step::STOP;
+    }
+
+    // Don't request blocks that go further than what limited peers can provide
+    if (too_deep) return Step::SKIP;
+
+    ++m_requested;
+    return Step::REQUEST;
+}
+} // namespace node
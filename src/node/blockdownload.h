@@ -0,0 +1,156 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_BLOCKDOWNLOAD_H
+#define BITCOIN_NODE_BLOCKDOWNLOAD_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+typedef int64_t NodeId;
+
+namespace node {
+/** Number of blocks requested at a time from a peer whose download performance is not known yet. */
+static constexpr size_t DEFAULT_BLOCKS_IN_FLIGHT_PER_PEER{16};
+/** Lower bound of the number of blocks requested at a time from a single peer. */
+static constexpr size_t MIN_BLOCKS_IN_FLIGHT_PER_PEER{2};
+/** Upper bound of the number of blocks requested at a time from a single peer. */
+static constexpr size_t MAX_BLOCKS_IN_FLIGHT_PER_PEER{64};
+/** Number of peers from which a block that holds back the block download window is requested at the
+ *  same time, so that a faster peer can deliver it while the stalling peer is given time. */
+static constexpr size_t MAX_STALLING_BLOCK_REQUESTS{2};
+
+/**
+ * Model of the block download performance of a single peer, used to size the
+ * number of blocks that are requested from it at a time.
+ *
+ * Peers serve blocks in the order they were requested, so a peer starts
+ * sending a block when it was requested, or when it finished sending the
+ * previous one, whichever is later. For every received block this gives:
+ *
+ * - the time spent transferring it, which is a sample of the throughput of
+ *   the peer if it was still sending the previous block when this one was
+ *   requested, and
+ *
+ * - the time between requesting and receiving it beyond the transfer time,
+ *   which is a sample of the latency of the peer otherwise.
+ *
+ * The block sizes, transfer times and latencies are averaged exponentially,
+ * and the throughput is the ratio of the averages, so that blocks which are
+ * processed back to back do not produce outliers.
+ *
+ * The window is the number of blocks the peer is expected to deliver within
+ * its latency plus TARGET_QUEUE_TIME. Fast peers get more blocks in flight,
+ * while slow peers get fewer, so that they hold back the block download
+ * window less.
+ */
+class BlockDownloadModel
+{
+public:
+    /** Time worth of blocks that should be queued at a peer, beyond its latency. */
+    static constexpr std::chrono::seconds TARGET_QUEUE_TIME{2};
+    /** Number of received blocks before the window is derived from the measurements. */
+    static constexpr size_t MIN_SAMPLES{4};
+
+private:
+    //! Weight of a new sample in the averages.
+    static constexpr double SAMPLE_WEIGHT{0.125};
+
+    //! Number of blocks received, and of throughput and latency samples among them.
+    size_t m_samples{0};
+    size_t m_transfer_samples{0};
+    size_t m_latency_samples{0};
+    //! When the last block was received.
+    std::chrono::microseconds m_last_received{0};
+    //! Average size in bytes of all blocks.
+    double m_block_bytes{0};
+    //! Averages of the size in bytes and the transfer time in seconds of the throughput samples.
+    double m_transfer_bytes{0};
+    double m_transfer_seconds{0};
+    //! Average latency in seconds.
+    double m_latency_seconds{0};
+
+public:
+    /**
+     * Record a block of the given size which was requested at requested and
+     * received at received. Blocks must be recorded in the order they were
+     * received.
+     */
+    void BlockReceived(std::chrono::microseconds requested, std::chrono::microseconds received, size_t bytes);
+
+    /** Number of blocks received so far. */
+    size_t GetSamples() const { return m_samples; }
+
+    /** The measured throughput in bytes per second, if any. */
+    std::optional<double> GetBytesPerSecond() const;
+
+    /** The measured latency, if any. */
+    std::optional<std::chrono::microseconds> GetLatency() const;
+
+    /**
+     * Number of blocks to keep in flight from the peer, between
+     * MIN_BLOCKS_IN_FLIGHT_PER_PEER and MAX_BLOCKS_IN_FLIGHT_PER_PEER.
+     * DEFAULT_BLOCKS_IN_FLIGHT_PER_PEER until MIN_SAMPLES blocks were
+     * received.
+     */
+    size_t GetWindow() const;
+};
+
+/**
+ * Decides which blocks of the download window to request from a peer. The
+ * caller walks the blocks we don't have yet in increasing height order, and
+ * passes each of them to Next until it returns STOP, or enough blocks were
+ * requested.
+ *
+ * If nothing could be requested because the rest of the window is in flight,
+ * the first block in flight holds back the window: GetStaller returns the
+ * peer it was requested from, and GetStallingHeight its height, for
+ * requesting it from this peer as well (see ShouldRequestStallingBlock).
+ */
+class BlockDownloadWalk
+{
+public:
+    enum class Step {
+        SKIP,
+        REQUEST,
+        STOP,
+    };
+
+private:
+    const NodeId m_peer;
+    const int m_window_end;
+    size_t m_requested{0};
+    //! The first block in flight, and the peer it was requested from.
+    std::optional<NodeId> m_waiting_for;
+    std::optional<int> m_waiting_for_height;
+    bool m_stalled{false};
+
+public:
+    BlockDownloadWalk(NodeId peer, int window_end) : m_peer{peer}, m_window_end{window_end} {}
+
+    /**
+     * The next block of the walk. in_flight_from is the peer the block was
+     * first requested from, if it is in flight, and too_deep is whether it is
+     * deeper than the peer can serve.
+     */
+    Step Next(int height, std::optional<NodeId> in_flight_from, bool too_deep);
+
+    std::optional<NodeId> GetStaller() const { return m_stalled ? m_waiting_for : std::nullopt; }
+    std::optional<int> GetStallingHeight() const { return m_stalled ? m_waiting_for_height : std::nullopt; }
+};
+
+/**
+ * Whether to request the block holding back the download window from a peer
+ * with budget more blocks to keep in flight, while requests peers have it in
+ * flight already.
+ */
+inline bool ShouldRequestStallingBlock(size_t budget, size_t requests)
+{
+    return budget > 0 && requests < MAX_STALLING_BLOCK_REQUESTS;
+}
+} // namespace node
+
+#endif // BITCOIN_NODE_BLOCKDOWNLOAD_H
@@ -0,0 +1,164 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blockfile_reader.h>
+
+#include <consensus/consensus.h>
+#include <logging.h>
+#include <node/blockstorage.h>
+#include <primitives/transaction.h>
+#include <serialize.h>
+#include <streams.h>
+#include <util/threadnames.h>
+
+#include <utility>
+#include <vector>
+
+namespace node {
+BlockFileReader::BlockFileReader(AutoFile& file, const MessageStartChars& message_start, size_t max_buffered)
+    : m_max_buffered{max_buffered}
+{
+    m_thread = std::thread{[this, &file, message_start] {
+        util::ThreadRename("blkread");
+        ThreadRead(file, message_start);
+    }};
+}
+
+BlockFileReader::~BlockFileReader()
+{
+    WITH_LOCK(m_mutex, m_stop = true);
+    m_consumed_cv.notify_all();
+    m_thread.join();
+}
+
+std::optional<BlockFileReader::Entry> BlockFileReader::Next()
+{
+    std::optional<Entry> entry;
+    {
+        WAIT_LOCK(m_mutex, lock);
+        m_produced_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return !m_queue.empty() || m_done; });
+        if (m_queue.empty()) {
+            if (m_error) std::rethrow_exception(m_error);
+            return std::nullopt;
+        }
+        entry = std::move(m_queue.front().first);
+        m_buffered -= m_queue.front().second;
+        m_queue.pop_front();
+    }
+    m_consumed_cv.notify_one();
+    return entry;
+}
+
+bool BlockFileReader::Push(Entry&& entry, size_t size)
+{
+    {
+        WAIT_LOCK(m_mutex, lock);
+        // A block that is larger than the limit on its own is still queued
+        // once everything before it has been taken.
+        m_consumed_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+            return m_stop || m_queue.empty() || m_buffered + size <= m_max_buffered;
+        });
+        if (m_stop) return false;
+        m_queue.emplace_back(std::move(entry), size);
+        m_buffered += size;
+    }
+    m_produced_cv.notify_one();
+    return true;
+}
+
+void BlockFileReader::ThreadRead(AutoFile& file, MessageStartChars message_start)
+{
+    try {
+        BufferedFile blkdat{file, 2 * MAX_BLOCK_SERIALIZED_SIZE, MAX_BLOCK_SERIALIZED_SIZE + 8};
+        // nRewind indicates where to resume scanning in case something goes wrong,
+        // such as a block header that fails to deserialize.
+        uint64_t nRewind = blkdat.GetPos();
+        while (!blkdat.eof()) {
+            blkdat.SetPos(nRewind);
+            nRewind++; // start one byte further next time, in case of failure
+            blkdat.SetLimit(); // remove former limit
+            unsigned int nSize = 0;
+            bool compressed{false};
+            try {
+                // locate a header
+                MessageStartChars buf;
+                blkdat.FindByte(std::byte(message_start[0]));
+                nRewind = blkdat.GetPos() + 1;
+                blkdat >> buf;
+                if (buf != message_start) {
+                    continue;
+                }
+                // read size
+                blkdat >> nSize;
+                compressed = (nSize & BLOCK_COMPRESSED_FLAG) != 0;
+                nSize &= ~BLOCK_COMPRESSED_FLAG;
+                if (nSize < (compressed ? sizeof(uint32_t) : 80) || nSize > MAX_BLOCK_SERIALIZED_SIZE)
+                    continue;
+            } catch (const std::exception&) {
+                // no valid block header found; don't complain
+                // (this happens at the end of every blk.dat file)
+                break;
+            }
+            Entry entry;
+            if (compressed) {
+                // The payload must be decompressed before anything can be
+                // deserialized from it, so read it whole.
+                std::vector<std::byte> payload(nSize);
+                std::optional<std::vector<std::byte>> block_data;
+                try {
+                    entry.pos = blkdat.GetPos();
+                    blkdat.SetLimit(entry.pos + nSize);
+                    blkdat.read(payload);
+                    block_data = DecompressBlockData(payload);
+                    if (!block_data) throw std::ios_base::failure("malformed compressed block");
+                    SpanReader{*block_data} >> entry.header;
+                    entry.hash = entry.header.GetHash();
+                    nRewind = entry.pos + nSize;
+                } catch (const std::exception& e) {
+                    LogDebug(BCLog::REINDEX, "%s: unexpected data at file offset 0x%x - %s. continuing\n", __func__, (nRewind - 1), e.what());
+                    continue;
+                }
+                try {
+                    entry.block = std::make_shared<CBlock>();
+                    SpanReader{*block_data} >> TX_WITH_WITNESS(*entry.block);
+                } catch (const std::exception& e) {
+                    entry.block.reset();
+                    entry.error = e.what();
+                }
+                if (!Push(std::move(entry), block_data->size())) return;
+                continue;
+            }
+            try {
+                // read block header
+                entry.pos = blkdat.GetPos();
+                blkdat.SetLimit(entry.pos + nSize);
+                blkdat >> entry.header;
+                entry.hash = entry.header.GetHash();
+                // Pull the rest of the block into the buffer and position to the marker before the next block. It is
+                // still possible to rewind to the start of the current block without a disk read.
+                nRewind = entry.pos + nSize;
+                blkdat.SkipTo(nRewind);
+            } catch (const std::exception& e) {
+                // See the comment in ChainstateManager::LoadExternalBlockFile() on why unexpected data is not fatal.
+                LogDebug(BCLog::REINDEX, "%s: unexpected data at file offset 0x%x - %s. continuing\n", __func__, (nRewind - 1), e.what());
+                continue;
+            }
+            try {
+                blkdat.SetPos(entry.pos);
+                entry.block = std::make_shared<CBlock>();
+                blkdat >> TX_WITH_WITNESS(*entry.block);
+            } catch (const std::exception& e) {
+                // Only reported if the block turns out to be needed.
+                entry.block.reset();
+                entry.error = e.what();
+            }
+            if (!Push(std::move(entry), nSize)) return;
+        }
+    } catch (...) {
+        WITH_LOCK(m_mutex, m_error = std::current_exception());
+    }
+    WITH_LOCK(m_mutex, m_done = true);
+    m_produced_cv.notify_all();
+}
+} // namespace node
@@ -0,0 +1,105 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_BLOCKFILE_READER_H
+#define BITCOIN_NODE_BLOCKFILE_READER_H
+
+#include <kernel/messagestartchars.h>
+#include <primitives/block.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+
+class AutoFile;
+
+namespace node {
+//! Maximum number of serialized block bytes read ahead by a BlockFileReader.
+static constexpr size_t DEFAULT_BLOCKFILE_READAHEAD{32 << 20};
+
+/**
+ * Scan a file of blocks, in the format of the blk?????.dat files, on a
+ * background thread.
+ *
+ * Each block is located by its message start and size prefix, read and
+ * deserialized ahead of time, and queued until the caller asks for it. This
+ * lets the disk reads and deserialization of the next blocks overlap with the
+ * validation of the current one during -reindex and -loadblock.
+ *
+ * Blocks stored compressed (see BLOCK_COMPRESSED_FLAG) are decompressed by
+ * the reader thread as well.
+ *
+ * Like the synchronous scanner it replaces, the reader skips over data that
+ * does not look like a block, and resumes scanning one byte after a message
+ * start whose block header cannot be read.
+ */
+class BlockFileReader
+{
+public:
+    struct Entry {
+        //! Position of the serialized block (after the message start and size) in the file.
+        uint64_t pos;
+        CBlockHeader header;
+        uint256 hash;
+        //! The deserialized block, or nullptr if only the header could be read.
+        std::shared_ptr<CBlock> block;
+        //! Why the block failed to deserialize, if it did.
+        std::string error;
+    };
+
+    /**
+     * Start reading file, which must stay open until the reader is destroyed.
+     *
+     * @param[in] file            The file to read blocks from, positioned where scanning should start
+     * @param[in] message_start   The network's message start, which precedes each block
+     * @param[in] max_buffered    Stop reading ahead once this many serialized bytes are queued
+     */
+    BlockFileReader(AutoFile& file, const MessageStartChars& message_start, size_t max_buffered = DEFAULT_BLOCKFILE_READAHEAD);
+    //! Stop the background thread, discarding any blocks not yet returned.
+    ~BlockFileReader();
+
+    BlockFileReader(const BlockFileReader&) = delete;
+    BlockFileReader& operator=(const BlockFileReader&) = delete;
+
+    /**
+     * Wait for the next block in the file.
+     *
+     * @returns the next block, or std::nullopt at the end of the file.
+     * @throws std::runtime_error if the reader failed for another reason than
+     *         reaching the end of the file.
+     */
+    std::optional<Entry> Next() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    void ThreadRead(AutoFile& file, MessageStartChars message_start) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    //! Queue a block, waiting for room first. Returns false if the reader is being stopped.
+    bool Push(Entry&& entry, size_t size) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    const size_t m_max_buffered;
+
+    Mutex m_mutex;
+    //! Signaled when an entry is queued or the reader thread finished.
+    std::condition_variable m_produced_cv;
+    //! Signaled when an entry is taken or the reader is being stopped.
+    std::condition_variable m_consumed_cv;
+    //! Blocks read ahead, together with their serialized size.
+    std::deque<std::pair<Entry, size_t>> m_queue GUARDED_BY(m_mutex);
+    size_t m_buffered GUARDED_BY(m_mutex){0};
+    bool m_done GUARDED_BY(m_mutex){false};
+    bool m_stop GUARDED_BY(m_mutex){false};
+    std::exception_ptr m_error GUARDED_BY(m_mutex);
+
+    std::thread m_thread;
+};
+} // namespace node
+
+#endif // BITCOIN_NODE_BLOCKFILE_READER_H
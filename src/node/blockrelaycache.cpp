@@ -0,0 +1,69 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blockrelaycache.h>
+
+#include <memusage.h>
+#include <net.h>
+#include <sync.h>
+
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace node {
+CSerializedNetMsg BlockRelayCache::MakeMessage(const Key& key, std::shared_ptr<const std::vector<unsigned char>> payload)
+{
+    CSerializedNetMsg msg;
+    msg.m_type = key.msg_type;
+    msg.m_shared_data = std::move(payload);
+    return msg;
+}
+
+std::optional<CSerializedNetMsg> BlockRelayCache::Find(const Key& key)
+{
+    LOCK(m_mutex);
+    const auto it{m_index.find(key)};
+    if (it == m_index.end()) {
+        ++m_misses;
+        return std::nullopt;
+    }
+    ++m_hits;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return MakeMessage(key, it->second->payload);
+}
+
+CSerializedNetMsg BlockRelayCache::Insert(const Key& key, CSerializedNetMsg&& msg)
+{
+    if (!msg.m_shared_data) {
+        msg.m_shared_data = std::make_shared<const std::vector<unsigned char>>(std::move(msg.data));
+        msg.data.clear();
+    }
+    const size_t bytes{memusage::DynamicUsage(*msg.m_shared_data)};
+    if (bytes > m_max_bytes) return std::move(msg);
+
+    LOCK(m_mutex);
+    if (const auto it{m_index.find(key)}; it != m_index.end()) {
+        // Raced with another thread serializing the same message, keep the cached one.
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return MakeMessage(key, it->second->payload);
+    }
+    while (!m_entries.empty() && m_bytes + bytes > m_max_bytes) {
+        m_bytes -= memusage::DynamicUsage(*m_entries.back().payload);
+        m_index.erase(m_entries.back().key);
+        m_entries.pop_back();
+    }
+    m_entries.push_front({key, msg.m_shared_data});
+    m_index.emplace(key, m_entries.begin());
+    m_bytes += bytes;
+    return std::move(msg);
+}
+
+BlockRelayCache::Stats BlockRelayCache::GetStats() const
+{
+    LOCK(m_mutex);
+    return {.hits = m_hits, .misses = m_misses, .entries = m_entries.size(), .bytes = m_bytes};
+}
+} // namespace node
@@ -0,0 +1,107 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_BLOCKRELAYCACHE_H
+#define BITCOIN_NODE_BLOCKRELAYCACHE_H
+
+#include <net.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace node {
+/** Default memory budget of the BlockRelayCache. */
+static constexpr size_t DEFAULT_BLOCK_RELAY_CACHE_BYTES{32 << 20};
+
+/**
+ * Least recently used cache of the serialized block, cmpctblock and blocktxn
+ * messages of recent blocks, so that relaying a block to many peers serializes
+ * each message once.
+ *
+ * The payloads are shared with the messages handed out through
+ * CSerializedNetMsg::m_shared_data, so evicting an entry does not affect
+ * messages which are still queued for sending. The cache only accounts for
+ * the payloads it references itself.
+ */
+class BlockRelayCache
+{
+public:
+    /**
+     * Identifies a message: its type, the block it is about, and a variant
+     * which tells apart different messages of the same type for the same
+     * block, like a block with and without witnesses, or the transactions
+     * requested by a getblocktxn.
+     */
+    struct Key {
+        std::string msg_type;
+        uint256 block_hash;
+        uint256 variant;
+
+        friend bool operator<(const Key& a, const Key& b)
+        {
+            return std::tie(a.block_hash, a.variant, a.msg_type) < std::tie(b.block_hash, b.variant, b.msg_type);
+        }
+    };
+
+    struct Stats {
+        uint64_t hits{0};
+        uint64_t misses{0};
+        size_t entries{0};
+        size_t bytes{0};
+    };
+
+private:
+    struct Entry {
+        Key key;
+        std::shared_ptr<const std::vector<unsigned char>> payload;
+    };
+
+    const size_t m_max_bytes;
+
+    mutable Mutex m_mutex;
+    //! Entries from most to least recently used.
+    std::list<Entry> m_entries GUARDED_BY(m_mutex);
+    std::map<Key, std::list<Entry>::iterator> m_index GUARDED_BY(m_mutex);
+    size_t m_bytes GUARDED_BY(m_mutex){0};
+    uint64_t m_hits GUARDED_BY(m_mutex){0};
+    uint64_t m_misses GUARDED_BY(m_mutex){0};
+
+    static CSerializedNetMsg MakeMessage(const Key& key, std::shared_ptr<const std::vector<unsigned char>> payload);
+
+public:
+    explicit BlockRelayCache(size_t max_bytes = DEFAULT_BLOCK_RELAY_CACHE_BYTES) : m_max_bytes{max_bytes} {}
+
+    /** Return the message for key, if cached, and mark it as most recently used. */
+    std::optional<CSerializedNetMsg> Find(const Key& key) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /**
+     * Cache the payload of msg under key, evicting the least recently used
+     * entries beyond the memory budget, and return the message sharing the
+     * cached payload. Payloads larger than the budget are not cached.
+     */
+    CSerializedNetMsg Insert(const Key& key, CSerializedNetMsg&& msg) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Return the message for key, serializing it with make() if it is not cached. */
+    template <typename F>
+    CSerializedNetMsg Get(const Key& key, F&& make) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        if (auto msg{Find(key)}) return std::move(*msg);
+        return Insert(key, make());
+    }
+
+    Stats GetStats() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+} // namespace node
+
+#endif // BITCOIN_NODE_BLOCKRELAYCACHE_H
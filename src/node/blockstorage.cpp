@@ -8,6 +8,7 @@
 #include <chain.h>
 #include <consensus/params.h>
 #include <consensus/validation.h>
+#include <crypto/common.h>
 #include <dbwrapper.h>
 #include <flatfile.h>
 #include <hash.h>
@@ -18,6 +19,7 @@
 #include <logging.h>
 #include <pow.h>
 #include <primitives/block.h>
+#include <primitives/block_view.h>
 #include <primitives/transaction.h>
 #include <random.h>
 #include <serialize.h>
@@ -31,13 +33,17 @@
 #include <util/batchpriority.h>
 #include <util/check.h>
 #include <util/fs.h>
+#include <util/fs_helpers.h>
+#include <util/lz4.h>
 #include <util/obfuscation.h>
 #include <util/signalinterrupt.h>
 #include <util/strencodings.h>
 #include <util/syserror.h>
 #include <util/translation.h>
+#include <util/vector.h>
 #include <validation.h>
 
+#include <algorithm>
 #include <cstddef>
 #include <map>
 #include <optional>
@@ -49,6 +55,8 @@ static constexpr uint8_t DB_BLOCK_INDEX{'b'};
 static constexpr uint8_t DB_FLAG{'F'};
 static constexpr uint8_t DB_REINDEX_FLAG{'R'};
 static constexpr uint8_t DB_LAST_BLOCK{'l'};
+static constexpr uint8_t DB_PENDING_BLOCK_FILE{'p'};
+static constexpr uint8_t DB_TXINDEX_STALE{'s'};
 // Keys used in previous version that might still be found in the DB:
 // BlockTreeDB::DB_TXINDEX_BLOCK{'T'};
 // BlockTreeDB::DB_TXINDEX{'t'}
@@ -91,6 +99,38 @@ bool BlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockFi
     return WriteBatch(batch, true);
 }
 
+bool BlockTreeDB::WriteRewrittenBlockFile(int nFile, const CBlockFileInfo& info, const std::vector<const CBlockIndex*>& blockinfo)
+{
+    CDBBatch batch(*this);
+    batch.Write(std::make_pair(DB_BLOCK_FILES, nFile), info);
+    for (const CBlockIndex* bi : blockinfo) {
+        batch.Write(std::make_pair(DB_BLOCK_INDEX, bi->GetBlockHash()), CDiskBlockIndex{bi});
+    }
+    batch.Write(DB_PENDING_BLOCK_FILE, nFile);
+    batch.Write(DB_TXINDEX_STALE, uint8_t{'1'});
+    return WriteBatch(batch, true);
+}
+
+bool BlockTreeDB::ReadPendingBlockFile(int& nFile)
+{
+    return Read(DB_PENDING_BLOCK_FILE, nFile);
+}
+
+bool BlockTreeDB::ErasePendingBlockFile()
+{
+    return Erase(DB_PENDING_BLOCK_FILE, /*fSync=*/true);
+}
+
+bool BlockTreeDB::ReadTxIndexStale()
+{
+    return Exists(DB_TXINDEX_STALE);
+}
+
+bool BlockTreeDB::EraseTxIndexStale()
+{
+    return Erase(DB_TXINDEX_STALE, /*fSync=*/true);
+}
+
 bool BlockTreeDB::WriteFlag(const std::string& name, bool fValue)
 {
     return Write(std::make_pair(DB_FLAG, name), fValue ? uint8_t{'1'} : uint8_t{'0'});
@@ -522,6 +562,16 @@ bool BlockManager::LoadBlockIndexDB(const std::optional<uint256>& snapshot_block
         }
     }
 
+    // Complete a block file rewrite that was interrupted after the new block
+    // positions were committed, see CompressBlockFiles()
+    int pending_file;
+    if (m_block_tree_db->ReadPendingBlockFile(pending_file)) {
+        LogInfo("Completing the interrupted rewrite of block file %05i", pending_file);
+        if (!FinishBlockFileRewrite(pending_file)) {
+            return false;
+        }
+    }
+
     // Check presence of blk files
     LogPrintf("Checking all blk files are present...\n");
     std::set<int> setBlkDataFiles;
@@ -661,9 +711,13 @@ CBlockFileInfo* BlockManager::GetBlockFileInfo(size_t n)
 bool BlockManager::ReadBlockUndo(CBlockUndo& blockundo, const CBlockIndex& index) const
 {
     const FlatFilePos pos{WITH_LOCK(::cs_main, return index.GetUndoPos())};
+    if (pos.nPos < STORAGE_HEADER_BYTES) {
+        LogError("Failed for %s while reading block undo storage header", pos.ToString());
+        return false;
+    }
 
-    // Open history file to read
-    AutoFile file{OpenUndoFile(pos, true)};
+    // Open history file to read, from the header that tells the format
+    AutoFile file{OpenUndoFile({pos.nFile, pos.nPos - STORAGE_HEADER_BYTES}, true)};
     if (file.IsNull()) {
         LogError("OpenUndoFile failed for %s while reading block undo", pos.ToString());
         return false;
@@ -671,11 +725,19 @@ bool BlockManager::ReadBlockUndo(CBlockUndo& blockundo, const CBlockIndex& index
     BufferedReader filein{std::move(file)};
 
     try {
+        MessageStartChars undo_start;
+        uint32_t undo_size;
+        filein >> undo_start >> undo_size;
+
         // Read block
         HashVerifier verifier{filein}; // Use HashVerifier, as reserializing may lose data, c.f. commit d3424243
 
         verifier << index.pprev->GetBlockHash();
-        verifier >> blockundo;
+        if (undo_size & UNDO_COMPACT_FLAG) {
+            verifier >> Using<BlockUndoCompactFormatter>(blockundo);
+        } else {
+            verifier >> blockundo;
+        }
 
         uint256 hashChecksum;
         filein >> hashChecksum;
@@ -895,7 +957,9 @@ void BlockManager::UpdateBlockInfo(const CBlock& block, unsigned int nHeight, co
         m_blockfile_cursors[chain_type] = BlockfileCursor{pos.nFile};
     }
 
-    // Update the file information with the current block.
+    // Update the file information with the current block. A compressed block
+    // takes less space than this, so nSize may overshoot the end of the file,
+    // which only leaves a gap before the next block written to it.
     const unsigned int added_size = ::GetSerializeSize(TX_WITH_WITNESS(block));
     const int nFile = pos.nFile;
     if (static_cast<int>(m_blockfile_info.size()) <= nFile) {
@@ -937,7 +1001,13 @@ bool BlockManager::WriteBlockUndo(const CBlockUndo& blockundo, BlockValidationSt
     // Write undo information to disk
     if (block.GetUndoPos().IsNull()) {
         FlatFilePos pos;
-        const auto blockundo_size{static_cast<uint32_t>(GetSerializeSize(blockundo))};
+        // Compact undo data is serialized only once, as it is costlier to produce.
+        std::optional<DataStream> compact_undo;
+        if (m_opts.compact_undo) {
+            compact_undo.emplace();
+            *compact_undo << Using<BlockUndoCompactFormatter>(blockundo);
+        }
+        const auto blockundo_size{static_cast<uint32_t>(compact_undo ? compact_undo->size() : GetSerializeSize(blockundo))};
         if (!FindUndoPos(state, block.nFile, pos, blockundo_size + UNDO_DATA_DISK_OVERHEAD)) {
             LogError("FindUndoPos failed for %s while writing block undo", pos.ToString());
             return false;
@@ -953,14 +1023,20 @@ bool BlockManager::WriteBlockUndo(const CBlockUndo& blockundo, BlockValidationSt
             BufferedWriter fileout{file};
 
             // Write index header
-            fileout << GetParams().MessageStart() << blockundo_size;
+            fileout << GetParams().MessageStart() << (compact_undo ? blockundo_size | UNDO_COMPACT_FLAG : blockundo_size);
             pos.nPos += STORAGE_HEADER_BYTES;
             {
                 // Calculate checksum
                 HashWriter hasher{};
-                hasher << block.pprev->GetBlockHash() << blockundo;
+                hasher << block.pprev->GetBlockHash();
                 // Write undo data & checksum
-                fileout << blockundo << hasher.GetHash();
+                if (compact_undo) {
+                    hasher << std::span{*compact_undo};
+                    fileout << std::span{*compact_undo} << hasher.GetHash();
+                } else {
+                    hasher << blockundo;
+                    fileout << blockundo << hasher.GetHash();
+                }
             }
             // BufferedWriter will flush pending data to file when fileout goes out of scope.
         }
@@ -997,6 +1073,24 @@ bool BlockManager::WriteBlockUndo(const CBlockUndo& blockundo, BlockValidationSt
     return true;
 }
 
+std::optional<std::vector<std::byte>> CompressBlockData(std::span<const std::byte> block_data)
+{
+    const std::vector<std::byte> compressed{util::LZ4Compress(block_data)};
+    if (sizeof(uint32_t) + compressed.size() >= block_data.size()) return std::nullopt;
+    std::vector<std::byte> payload(sizeof(uint32_t));
+    WriteLE32(UCharCast(payload.data()), block_data.size());
+    payload.insert(payload.end(), compressed.begin(), compressed.end());
+    return payload;
+}
+
+std::optional<std::vector<std::byte>> DecompressBlockData(std::span<const std::byte> payload)
+{
+    if (payload.size() < sizeof(uint32_t)) return std::nullopt;
+    const uint32_t block_size{ReadLE32(UCharCast(payload.data()))};
+    if (block_size > MAX_SIZE) return std::nullopt;
+    return util::LZ4Decompress(payload.subspan(sizeof(uint32_t)), block_size);
+}
+
 bool BlockManager::ReadBlock(CBlock& block, const FlatFilePos& pos, const std::optional<uint256>& expected_hash) const
 {
     block.SetNull();
@@ -1044,6 +1138,48 @@ bool BlockManager::ReadBlock(CBlock& block, const CBlockIndex& index) const
     return ReadBlock(block, block_pos, index.GetBlockHash());
 }
 
+bool BlockManager::ReadBlock(std::vector<std::byte>& block_data, std::optional<BlockView>& view, const CBlockIndex& index) const
+{
+    view.reset();
+
+    const FlatFilePos pos{WITH_LOCK(cs_main, return index.GetBlockPos())};
+    if (!ReadRawBlock(block_data, pos)) {
+        return false;
+    }
+
+    try {
+        view.emplace(block_data);
+    } catch (const std::exception& e) {
+        LogError("Deserialize or I/O error - %s at %s while reading block", e.what(), pos.ToString());
+        return false;
+    }
+
+    const auto block_hash{view->header.GetHash()};
+
+    // Check the header
+    if (!CheckProofOfWork(block_hash, view->header.nBits, GetConsensus())) {
+        LogError("Errors in block header at %s while reading block", pos.ToString());
+        view.reset();
+        return false;
+    }
+
+    // Signet only: check block solution
+    if (GetConsensus().signet_blocks && !CheckSignetBlockSolution(view->ToBlock(), GetConsensus())) {
+        LogError("Errors in block solution at %s while reading block", pos.ToString());
+        view.reset();
+        return false;
+    }
+
+    if (block_hash != index.GetBlockHash()) {
+        LogError("GetHash() doesn't match index at %s while reading block (%s != %s)",
+                 pos.ToString(), block_hash.ToString(), index.GetBlockHash().ToString());
+        view.reset();
+        return false;
+    }
+
+    return true;
+}
+
 bool BlockManager::ReadRawBlock(std::vector<std::byte>& block, const FlatFilePos& pos) const
 {
     if (pos.nPos < STORAGE_HEADER_BYTES) {
@@ -1071,6 +1207,9 @@ bool BlockManager::ReadRawBlock(std::vector<std::byte>& block, const FlatFilePos
             return false;
         }
 
+        const bool compressed{(blk_size & BLOCK_COMPRESSED_FLAG) != 0};
+        blk_size &= ~BLOCK_COMPRESSED_FLAG;
+
         if (blk_size > MAX_SIZE) {
             LogError("Block data is larger than maximum deserialization size for %s: %s versus %s while reading raw block",
                 pos.ToString(), blk_size, MAX_SIZE);
@@ -1079,6 +1218,15 @@ bool BlockManager::ReadRawBlock(std::vector<std::byte>& block, const FlatFilePos
 
         block.resize(blk_size); // Zeroing of memory is intentional here
         filein.read(block);
+
+        if (compressed) {
+            auto block_data{DecompressBlockData(block)};
+            if (!block_data) {
+                LogError("Failed to decompress block data for %s while reading raw block", pos.ToString());
+                return false;
+            }
+            block = std::move(*block_data);
+        }
     } catch (const std::exception& e) {
         LogError("Read from block file failed: %s for %s while reading raw block", e.what(), pos.ToString());
         return false;
@@ -1089,7 +1237,14 @@ bool BlockManager::ReadRawBlock(std::vector<std::byte>& block, const FlatFilePos
 
 FlatFilePos BlockManager::WriteBlock(const CBlock& block, int nHeight)
 {
-    const unsigned int block_size{static_cast<unsigned int>(GetSerializeSize(TX_WITH_WITNESS(block)))};
+    std::optional<std::vector<std::byte>> compressed;
+    if (m_opts.compress_blocks) {
+        DataStream block_data;
+        block_data << TX_WITH_WITNESS(block);
+        compressed = CompressBlockData(block_data);
+    }
+    const unsigned int block_size{compressed ? static_cast<unsigned int>(compressed->size()) :
+                                               static_cast<unsigned int>(GetSerializeSize(TX_WITH_WITNESS(block)))};
     FlatFilePos pos{FindNextBlockPos(block_size + STORAGE_HEADER_BYTES, nHeight, block.GetBlockTime())};
     if (pos.IsNull()) {
         LogError("FindNextBlockPos failed for %s while writing block", pos.ToString());
@@ -1104,11 +1259,17 @@ FlatFilePos BlockManager::WriteBlock(const CBlock& block, int nHeight)
     {
         BufferedWriter fileout{file};
 
-        // Write index header
-        fileout << GetParams().MessageStart() << block_size;
-        pos.nPos += STORAGE_HEADER_BYTES;
-        // Write block
-        fileout << TX_WITH_WITNESS(block);
+        if (compressed) {
+            fileout << GetParams().MessageStart() << (block_size | BLOCK_COMPRESSED_FLAG);
+            pos.nPos += STORAGE_HEADER_BYTES;
+            fileout << std::span{*compressed};
+        } else {
+            // Write index header
+            fileout << GetParams().MessageStart() << block_size;
+            pos.nPos += STORAGE_HEADER_BYTES;
+            // Write block
+            fileout << TX_WITH_WITNESS(block);
+        }
     }
 
     if (file.fclose() != 0) {
@@ -1120,6 +1281,131 @@ FlatFilePos BlockManager::WriteBlock(const CBlock& block, int nHeight)
     return pos;
 }
 
+bool BlockManager::CompressBlockFiles()
+{
+    if (!m_blockfiles_indexed) {
+        LogWarning("Not compressing block files while the block index is being rebuilt");
+        return true;
+    }
+    const int num_files{WITH_LOCK(cs_LastBlockFile, return static_cast<int>(m_blockfile_info.size()))};
+    // Find the blocks of each file in one pass over the block index.
+    std::vector<std::vector<CBlockIndex*>> blocks_by_file(num_files);
+    {
+        LOCK(::cs_main);
+        for (auto& [_, block_index] : m_block_index) {
+            if ((block_index.nStatus & BLOCK_HAVE_DATA) && block_index.nFile >= 0 && block_index.nFile < num_files) {
+                blocks_by_file[block_index.nFile].push_back(&block_index);
+            }
+        }
+    }
+    for (int file_num{0}; file_num < num_files; ++file_num) {
+        if (m_interrupt) return true;
+        LOCK2(::cs_main, cs_LastBlockFile);
+        if (!CompressBlockFile(file_num, blocks_by_file[file_num])) return false;
+        ClearShrink(blocks_by_file[file_num]);
+    }
+    return true;
+}
+
+bool BlockManager::CompressBlockFile(int file_num, std::vector<CBlockIndex*>& blocks)
+{
+    AssertLockHeld(::cs_main);
+    AssertLockHeld(cs_LastBlockFile);
+
+    // Pruned or never used
+    if (blocks.empty()) return true;
+    std::ranges::sort(blocks, {}, [](const CBlockIndex* block) { return block->nDataPos; });
+
+    const fs::path path{GetBlockPosFilename({file_num, 0})};
+    const fs::path tmp_path{path + ".tmp"};
+    AutoFile filein{OpenBlockFile({file_num, 0}, /*fReadOnly=*/true)};
+    if (filein.IsNull()) {
+        LogError("Failed to open block file %s for compression", fs::PathToString(path));
+        return false;
+    }
+    AutoFile fileout{fsbridge::fopen(tmp_path, "wb"), m_obfuscation};
+    if (fileout.IsNull()) {
+        LogError("Failed to create %s: %s", fs::PathToString(tmp_path), SysErrorString(errno));
+        return false;
+    }
+
+    // Copy the blocks of the file in order, compressing those that are not yet.
+    std::vector<unsigned int> new_positions;
+    new_positions.reserve(blocks.size());
+    unsigned int new_size{0};
+    bool changed{false};
+    try {
+        std::vector<std::byte> payload;
+        for (const CBlockIndex* block : blocks) {
+            MessageStartChars blk_start;
+            uint32_t blk_size;
+            filein.seek(block->nDataPos - STORAGE_HEADER_BYTES, SEEK_SET);
+            filein >> blk_start >> blk_size;
+            if (blk_start != GetParams().MessageStart() || (blk_size & ~BLOCK_COMPRESSED_FLAG) > MAX_SIZE) {
+                throw std::ios_base::failure(strprintf("unexpected block storage header at offset %u", block->nDataPos));
+            }
+            payload.resize(blk_size & ~BLOCK_COMPRESSED_FLAG);
+            filein.read(payload);
+            if (!(blk_size & BLOCK_COMPRESSED_FLAG)) {
+                if (auto compressed{CompressBlockData(payload)}) {
+                    payload = std::move(*compressed);
+                    blk_size = payload.size() | BLOCK_COMPRESSED_FLAG;
+                    changed = true;
+                }
+            }
+            fileout << blk_start << blk_size << std::span{payload};
+            new_positions.push_back(new_size + STORAGE_HEADER_BYTES);
+            new_size += STORAGE_HEADER_BYTES + payload.size();
+        }
+    } catch (const std::exception& e) {
+        // Leave the file as it is. Blocks that cannot be read from it will
+        // be reported when they are needed.
+        LogWarning("Not compressing block file %s: %s", fs::PathToString(path), e.what());
+        (void)fileout.fclose();
+        fs::remove(tmp_path);
+        return true;
+    }
+    if (!changed) {
+        (void)fileout.fclose();
+        fs::remove(tmp_path);
+        return true;
+    }
+    if (!fileout.Commit() || fileout.fclose() != 0) {
+        LogError("Failed to write %s: %s", fs::PathToString(tmp_path), SysErrorString(errno));
+        (void)fileout.fclose();
+        return false;
+    }
+
+    // Commit the new positions before the old file is replaced, so that an
+    // interruption from here on can be completed on the next start.
+    const unsigned int old_size{m_blockfile_info[file_num].nSize};
+    for (size_t i{0}; i < blocks.size(); ++i) {
+        blocks[i]->nDataPos = new_positions[i];
+    }
+    m_blockfile_info[file_num].nSize = new_size;
+    if (!m_block_tree_db->WriteRewrittenBlockFile(file_num, m_blockfile_info[file_num], {blocks.begin(), blocks.end()})) {
+        LogError("Failed to write the block positions of rewritten block file %s", fs::PathToString(path));
+        return false;
+    }
+    if (!FinishBlockFileRewrite(file_num)) return false;
+    LogInfo("Compressed block file %s from %u to %u bytes", fs::PathToString(path), old_size, new_size);
+    return true;
+}
+
+bool BlockManager::FinishBlockFileRewrite(int file_num)
+{
+    const fs::path path{GetBlockPosFilename({file_num, 0})};
+    const fs::path tmp_path{path + ".tmp"};
+    if (fs::exists(tmp_path)) {
+        if (!RenameOver(tmp_path, path)) {
+            LogError("Failed to rename %s to %s: %s", fs::PathToString(tmp_path), fs::PathToString(path), SysErrorString(errno));
+            return false;
+        }
+        DirectoryCommit(path.parent_path());
+    }
+    return m_block_tree_db->ErasePendingBlockFile();
+}
+
 static auto InitBlocksdirXorKey(const BlockManager::Options& opts)
 {
     // Bytes are serialized without length indicator, so this is also the exact
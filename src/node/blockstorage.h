@@ -36,6 +36,7 @@
 #include <vector>
 
 class BlockValidationState;
+class BlockView;
 class CBlockUndo;
 class Chainstate;
 class ChainstateManager;
@@ -59,6 +60,16 @@ public:
     void ReadReindexing(bool& fReindexing);
     bool WriteFlag(const std::string& name, bool fValue);
     bool ReadFlag(const std::string& name, bool& fValue);
+    //! Atomically store the new block positions and info of a rewritten block
+    //! file, mark the rewrite as pending until ErasePendingBlockFile(), and
+    //! mark the transaction index as stale until EraseTxIndexStale().
+    bool WriteRewrittenBlockFile(int nFile, const CBlockFileInfo& info, const std::vector<const CBlockIndex*>& blockinfo);
+    bool ReadPendingBlockFile(int& nFile);
+    bool ErasePendingBlockFile();
+    //! Whether block files were rewritten since the transaction index was
+    //! last discarded, so that it refers to outdated block positions.
+    bool ReadTxIndexStale();
+    bool EraseTxIndexStale();
     bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex, const util::SignalInterrupt& interrupt)
         EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 };
@@ -77,6 +88,35 @@ static const unsigned int MAX_BLOCKFILE_SIZE = 0x8000000; // 128 MiB
 /** Size of header written by WriteBlock before a serialized CBlock (8 bytes) */
 static constexpr uint32_t STORAGE_HEADER_BYTES{std::tuple_size_v<MessageStartChars> + sizeof(unsigned int)};
 
+/**
+ * Set in the size field of the header written by WriteBlock when the block is
+ * stored compressed. The size field then holds the size of the compressed
+ * payload: the size of the serialized CBlock (4 bytes, little endian),
+ * followed by the serialized CBlock in the LZ4 block format.
+ */
+static constexpr uint32_t BLOCK_COMPRESSED_FLAG{0x80000000};
+
+/**
+ * Compress a serialized CBlock into the payload of a compressed block file record.
+ *
+ * @returns the payload, or std::nullopt if compression would not save space.
+ */
+std::optional<std::vector<std::byte>> CompressBlockData(std::span<const std::byte> block_data);
+
+/**
+ * Decompress the payload of a compressed block file record.
+ *
+ * @returns the serialized CBlock, or std::nullopt if the payload is malformed.
+ */
+std::optional<std::vector<std::byte>> DecompressBlockData(std::span<const std::byte> payload);
+
+/**
+ * Set in the size field of the header written by WriteBlockUndo when the undo
+ * data is serialized with BlockUndoCompactFormatter rather than as a plain
+ * CBlockUndo.
+ */
+static constexpr uint32_t UNDO_COMPACT_FLAG{0x80000000};
+
 /** Total overhead when writing undo data: header (8 bytes) plus checksum (32 bytes) */
 static constexpr uint32_t UNDO_DATA_DISK_OVERHEAD{STORAGE_HEADER_BYTES + uint256::size()};
 
@@ -168,6 +208,11 @@ private:
      */
     [[nodiscard]] FlatFilePos FindNextBlockPos(unsigned int nAddSize, unsigned int nHeight, uint64_t nTime);
     [[nodiscard]] bool FlushChainstateBlockFile(int tip_height);
+    //! Rewrite one block file with compressed blocks, see CompressBlockFiles().
+    //! blocks are the entries of the block index with data in the file.
+    bool CompressBlockFile(int file_num, std::vector<CBlockIndex*>& blocks) EXCLUSIVE_LOCKS_REQUIRED(::cs_main, cs_LastBlockFile);
+    //! Replace a block file by its rewritten version, once the new block positions are committed.
+    bool FinishBlockFileRewrite(int file_num) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
     bool FindUndoPos(BlockValidationState& state, int nFile, FlatFilePos& pos, unsigned int nAddSize);
 
     AutoFile OpenUndoFile(const FlatFilePos& pos, bool fReadOnly = false) const;
@@ -337,6 +382,23 @@ public:
      */
     FlatFilePos WriteBlock(const CBlock& block, int nHeight);
 
+    /**
+     * Rewrite the block files so that every block in them is stored compressed, where that saves space.
+     *
+     * Each file is rewritten to a temporary file, whose block positions are then
+     * committed to the block tree database before it replaces the original. An
+     * interrupted rewrite is completed by LoadBlockIndexDB() on the next start.
+     * The same commit marks the transaction index as stale (see
+     * BlockTreeDB::ReadTxIndexStale()), as the positions it stores change.
+     *
+     * Must be called before any other thread may read blocks, as block positions
+     * change underneath them.
+     *
+     * @returns false on error. Interruption is not an error; files that were
+     *          already rewritten stay rewritten.
+     */
+    bool CompressBlockFiles() LOCKS_EXCLUDED(::cs_main);
+
     /** Update blockfile info while processing a block during reindex. The block must be available on disk.
      *
      * @param[in]  block        the block being processed
@@ -413,6 +475,8 @@ public:
     /** Functions for disk access for blocks */
     bool ReadBlock(CBlock& block, const FlatFilePos& pos, const std::optional<uint256>& expected_hash) const;
     bool ReadBlock(CBlock& block, const CBlockIndex& index) const;
+    /** Read a block into block_data and parse it as a view of it, with the checks of ReadBlock. */
+    bool ReadBlock(std::vector<std::byte>& block_data, std::optional<BlockView>& view, const CBlockIndex& index) const;
     bool ReadRawBlock(std::vector<std::byte>& block, const FlatFilePos& pos) const;
 
     bool ReadBlockUndo(CBlockUndo& blockundo, const CBlockIndex& index) const;
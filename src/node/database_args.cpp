@@ -7,6 +7,9 @@
 #include <common/args.h>
 #include <dbwrapper.h>
 
+#include <algorithm>
+#include <cstdint>
+
 namespace node {
 void ReadDatabaseArgs(const ArgsManager& args, DBOptions& options)
 {
@@ -14,5 +17,13 @@ void ReadDatabaseArgs(const ArgsManager& args, DBOptions& options)
     // databases), but it'd be easy to parse database-specific options by adding
     // a database_type string or enum parameter to this function.
     if (auto value = args.GetBoolArg("-forcecompactdb")) options.force_compact = *value;
+    if (auto value = args.GetArg("-dbengine")) {
+        // Unknown values are rejected in AppInitParameterInteraction().
+        if (auto engine = DBEngineFromName(*value)) options.engine = *engine;
+    }
+    if (auto value = args.GetIntArg("-dbcompactionthreads")) {
+        options.compaction_threads = std::clamp<int64_t>(*value, 1, MAX_DB_COMPACTION_THREADS);
+    }
+    if (auto value = args.GetBoolArg("-dbdefercompaction")) options.defer_compaction = *value;
 }
 } // namespace node
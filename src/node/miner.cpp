@@ -108,6 +108,7 @@ void ApplyArgsManOptions(const ArgsManager& args, BlockAssembler::Options& optio
 void BlockAssembler::resetBlock()
 {
     inBlock.clear();
+    m_witness_merkle = MerkleBuilder{};
 
     // Reserve space for fixed-size block header, txs count, and coinbase tx.
     nBlockWeight = m_options.block_reserved_weight;
@@ -130,6 +131,9 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock()
     // Add dummy coinbase tx as first transaction. It is skipped by the
     // getblocktemplate RPC and mining interface consumers must not use it.
     pblock->vtx.emplace_back();
+    pblocktemplate->m_merkle.Append(uint256::ZERO);
+    // The witness hash of the coinbase is 0.
+    m_witness_merkle.Append(uint256::ZERO);
 
     LOCK(::cs_main);
     CBlockIndex* pindexPrev = m_chainstate.m_chain.Tip();
@@ -169,7 +173,9 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock()
     Assert(nHeight > 0);
     coinbaseTx.nLockTime = static_cast<uint32_t>(nHeight - 1);
     pblock->vtx[0] = MakeTransactionRef(std::move(coinbaseTx));
-    pblocktemplate->vchCoinbaseCommitment = m_chainstate.m_chainman.GenerateCoinbaseCommitment(*pblock, pindexPrev);
+    pblocktemplate->vchCoinbaseCommitment = m_chainstate.m_chainman.GenerateCoinbaseCommitment(*pblock, pindexPrev, m_witness_merkle.Root());
+    pblocktemplate->m_merkle.Set(0, pblock->vtx[0]->GetHash().ToUint256());
+    pblock->hashMerkleRoot = pblocktemplate->m_merkle.Root();
 
     LogPrintf("CreateNewBlock(): block weight: %u txs: %u fees: %ld sigops %d\n", GetBlockWeight(*pblock), nBlockTx, nFees, nBlockSigOpsCost);
 
@@ -240,6 +246,8 @@ void BlockAssembler::AddToBlock(CTxMemPool::txiter iter)
     nBlockSigOpsCost += iter->GetSigOpCost();
     nFees += iter->GetFee();
     inBlock.insert(iter->GetSharedTx()->GetHash());
+    pblocktemplate->m_merkle.Append(iter->GetTx().GetHash().ToUint256());
+    m_witness_merkle.Append(iter->GetTx().GetWitnessHash().ToUint256());
 
     if (m_options.print_modified_fee) {
         LogPrintf("fee rate %s txid %s\n",
@@ -454,6 +462,28 @@ void AddMerkleRootAndCoinbase(CBlock& block, CTransactionRef coinbase, uint32_t
     block.hashMerkleRoot = BlockMerkleRoot(block);
 }
 
+void AddMerkleRootAndCoinbase(CBlockTemplate& block_template, CTransactionRef coinbase, uint32_t version, uint32_t timestamp, uint32_t nonce)
+{
+    CBlock& block{block_template.block};
+    if (block.vtx.empty() || block_template.m_merkle.Size() != block.vtx.size()) {
+        return AddMerkleRootAndCoinbase(block, std::move(coinbase), version, timestamp, nonce);
+    }
+    block_template.m_merkle.Set(0, coinbase->GetHash().ToUint256());
+    block.vtx[0] = std::move(coinbase);
+    block.nVersion = version;
+    block.nTime = timestamp;
+    block.nNonce = nonce;
+    block.hashMerkleRoot = block_template.m_merkle.Root();
+}
+
+std::vector<uint256> CoinbaseMerklePath(const CBlockTemplate& block_template)
+{
+    if (block_template.m_merkle.Size() != block_template.block.vtx.size()) {
+        return TransactionMerklePath(block_template.block, 0);
+    }
+    return block_template.m_merkle.Path(0);
+}
+
 std::unique_ptr<CBlockTemplate> WaitAndCreateNewBlock(ChainstateManager& chainman,
                                                       KernelNotifications& kernel_notifications,
                                                       CTxMemPool* mempool,
@@ -6,6 +6,7 @@
 #ifndef BITCOIN_NODE_MINER_H
 #define BITCOIN_NODE_MINER_H
 
+#include <consensus/merkle.h>
 #include <interfaces/types.h>
 #include <node/types.h>
 #include <policy/policy.h>
@@ -50,6 +51,9 @@ struct CBlockTemplate
     /* A vector of package fee rates, ordered by the sequence in which
      * packages are selected for inclusion in the block template.*/
     std::vector<FeeFrac> m_package_feerates;
+    /* The merkle tree of the txids of block.vtx, so that the merkle root can
+     * be updated cheaply when the coinbase transaction is replaced. */
+    MerkleBuilder m_merkle;
 };
 
 // Container for tracking updates to ancestor feerate as we include (parent)
@@ -159,6 +163,8 @@ private:
     uint64_t nBlockSigOpsCost;
     CAmount nFees;
     std::unordered_set<Txid, SaltedTxidHasher> inBlock;
+    // The merkle tree of the wtxids of the block, for the witness commitment
+    MerkleBuilder m_witness_merkle;
 
     // Chain context for the block
     int nHeight;
@@ -237,6 +243,10 @@ void ApplyArgsManOptions(const ArgsManager& gArgs, BlockAssembler::Options& opti
 
 /* Compute the block's merkle root, insert or replace the coinbase transaction and the merkle root into the block */
 void AddMerkleRootAndCoinbase(CBlock& block, CTransactionRef coinbase, uint32_t version, uint32_t timestamp, uint32_t nonce);
+/* Same as above for the block of a template, only rehashing the coinbase's path to the merkle root */
+void AddMerkleRootAndCoinbase(CBlockTemplate& block_template, CTransactionRef coinbase, uint32_t version, uint32_t timestamp, uint32_t nonce);
+/* The merkle path of the coinbase transaction of the block of a template */
+std::vector<uint256> CoinbaseMerklePath(const CBlockTemplate& block_template);
 
 /**
  * Return a new block template when fees rise to a certain threshold or after a
@@ -9,140 +9,130 @@
 #include <policy/policy.h>
 #include <primitives/transaction.h>
 #include <util/feefrac.h>
-#include <util/time.h>
 #include <util/hasher.h>
+#include <util/time.h>
 
-#include <boost/multi_index/indexed_by.hpp>
-#include <boost/multi_index/ordered_index.hpp>
-#include <boost/multi_index/tag.hpp>
-#include <boost/multi_index_container.hpp>
-
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <set>
 #include <unordered_map>
+#include <vector>
 
 namespace node {
-/** Minimum NodeId for lower_bound lookups (in practice, NodeIds start at 0). */
-static constexpr NodeId MIN_PEER{std::numeric_limits<NodeId>::min()};
-/** Maximum NodeId for upper_bound lookups. */
-static constexpr NodeId MAX_PEER{std::numeric_limits<NodeId>::max()};
 class TxOrphanageImpl final : public TxOrphanage {
     // Type alias for sequence numbers
     using SequenceNumber = uint64_t;
     /** Global sequence number, increment each time an announcement is added. */
     SequenceNumber m_current_sequence{0};
 
+    /** Position of an orphan in m_orphans, or of an announcement in m_announcements. */
+    using Index = uint32_t;
+    /** Index that refers to nothing. */
+    static constexpr Index NO_INDEX{std::numeric_limits<Index>::max()};
+
+    /** One orphan transaction. Each orphan (i.e. wtxid) is unique, and has at least one announcement. Multiple
+     * transactions with the same txid but different wtxid are possible. */
+    struct Orphan
+    {
+        /** The transaction, or nullptr if this slot of m_orphans is free. */
+        CTransactionRef m_tx;
+        /** Approximation for "memory usage". The total memory is a function of the memory used to store the
+         * transaction itself, each announcement, and each entry in m_parent_to_children. We use weight because it is
+         * often higher than the actual memory usage of the tranaction. This metric conveniently encompasses
+         * m_parent_to_children usage since input data does not get the witness discount, and makes it easier to reason
+         * about each peer's limits using well-understood transaction attributes. */
+        TxOrphanage::Usage m_usage{0};
+        /** Approximation of how much this transaction contributes to latency in EraseForBlock and EraseForPeer. The
+         * computation time is a function of the number of announcements (thus 1 per announcement) and the number of
+         * entries in m_parent_to_children (thus an additional 1 for every 10 inputs). Transactions with a small number of
+         * inputs (9 or fewer) are counted as 1 to make it easier to reason about each peer's limits in terms of "normal"
+         * transactions. */
+        TxOrphanage::Count m_latency_score{0};
+        /** The announcements of this orphan, sorted by announcer. */
+        std::vector<Index> m_announcements;
+    };
+
     /** One orphan announcement. Each announcement (i.e. combination of wtxid, nodeid) is unique. There may be multiple
-     * announcements for the same tx, and multiple transactions with the same txid but different wtxid are possible. */
+     * announcements for the same tx. */
     struct Announcement
     {
-        const CTransactionRef m_tx;
+        /** The announced orphan, or NO_INDEX if this slot of m_announcements is free. */
+        Index m_orphan{NO_INDEX};
         /** Which peer announced this tx */
-        const NodeId m_announcer;
+        NodeId m_announcer{0};
         /** What order this transaction entered the orphanage. */
-        const SequenceNumber m_entry_sequence;
+        SequenceNumber m_entry_sequence{0};
         /** Whether this tx should be reconsidered. Always starts out false. A peer's workset is the collection of all
          * announcements with m_reconsider=true. */
         bool m_reconsider{false};
-
-        Announcement(const CTransactionRef& tx, NodeId peer, SequenceNumber seq) :
-            m_tx{tx}, m_announcer{peer}, m_entry_sequence{seq}
-        { }
-
-        /** Get an approximation for "memory usage". The total memory is a function of the memory used to store the
-         * transaction itself, each entry in m_orphans, and each entry in m_outpoint_to_orphan_it. We use weight because
-         * it is often higher than the actual memory usage of the tranaction. This metric conveniently encompasses
-         * m_outpoint_to_orphan_it usage since input data does not get the witness discount, and makes it easier to
-         * reason about each peer's limits using well-understood transaction attributes. */
-        TxOrphanage::Usage GetMemUsage()  const {
-            return GetTransactionWeight(*m_tx);
-        }
-
-        /** Get an approximation of how much this transaction contributes to latency in EraseForBlock and EraseForPeer.
-         * The computation time is a function of the number of entries in m_orphans (thus 1 per announcement) and the
-         * number of entries in m_outpoint_to_orphan_it (thus an additional 1 for every 10 inputs). Transactions with a
-         * small number of inputs (9 or fewer) are counted as 1 to make it easier to reason about each peer's limits in
-         * terms of "normal" transactions. */
-        TxOrphanage::Count GetLatencyScore() const {
-            return 1 + (m_tx->vin.size() / 10);
-        }
+        /** Position in the heap of the announcer it is in (see PeerDoSInfo::m_heaps). */
+        Index m_heap_pos{NO_INDEX};
     };
 
-    // Index by wtxid, then peer
-    struct ByWtxid {};
-    using ByWtxidView = std::tuple<Wtxid, NodeId>;
-    struct WtxidExtractor
-    {
-        using result_type = ByWtxidView;
-        result_type operator()(const Announcement& ann) const
-        {
-            return ByWtxidView{ann.m_tx->GetWitnessHash(), ann.m_announcer};
-        }
-    };
+    /** All orphans. Slots of erased ones are reused through m_free_orphans. */
+    std::vector<Orphan> m_orphans;
+    std::vector<Index> m_free_orphans;
 
-    // Sort by peer, then by whether it is ready to reconsider, then by recency.
-    struct ByPeer {};
-    using ByPeerView = std::tuple<NodeId, bool, SequenceNumber>;
-    struct ByPeerViewExtractor {
-        using result_type = ByPeerView;
-        result_type operator()(const Announcement& ann) const
-        {
-            return ByPeerView{ann.m_announcer, ann.m_reconsider, ann.m_entry_sequence};
-        }
-    };
-
-    struct OrphanIndices final : boost::multi_index::indexed_by<
-        boost::multi_index::ordered_unique<boost::multi_index::tag<ByWtxid>, WtxidExtractor>,
-        boost::multi_index::ordered_unique<boost::multi_index::tag<ByPeer>, ByPeerViewExtractor>
-    >{};
-
-    using AnnouncementMap = boost::multi_index::multi_index_container<Announcement, OrphanIndices>;
-    template<typename Tag>
-    using Iter = typename AnnouncementMap::index<Tag>::type::iterator;
-    AnnouncementMap m_orphans;
+    /** All announcements. Slots of erased ones are reused through m_free_announcements. */
+    std::vector<Announcement> m_announcements;
+    std::vector<Index> m_free_announcements;
 
     const TxOrphanage::Count m_max_global_latency_score{DEFAULT_MAX_ORPHANAGE_LATENCY_SCORE};
     const TxOrphanage::Usage m_reserved_usage_per_peer{DEFAULT_RESERVED_ORPHAN_WEIGHT_PER_PEER};
 
-    /** Number of unique orphans by wtxid. Less than or equal to the number of entries in m_orphans. */
+    /** Number of unique orphans by wtxid. Less than or equal to the number of announcements. */
     TxOrphanage::Count m_unique_orphans{0};
 
-    /** Memory used by orphans (see Announcement::GetMemUsage()), deduplicated by wtxid. */
+    /** Memory used by orphans (see Orphan::m_usage), deduplicated by wtxid. */
     TxOrphanage::Usage m_unique_orphan_usage{0};
 
-    /** The sum of each unique transaction's latency scores including the inputs only (see Announcement::GetLatencyScore
-     * but subtract 1 for the announcements themselves). The total orphanage's latency score is given by this value +
-     * the number of entries in m_orphans. */
+    /** The sum of each unique transaction's latency scores including the inputs only (see Orphan::m_latency_score but
+     * subtract 1 for the announcements themselves). The total orphanage's latency score is given by this value + the
+     * number of announcements. */
     TxOrphanage::Count m_unique_rounded_input_scores{0};
 
-    /** Index from the parents' outputs to wtxids that exist in m_orphans. Used to find children of
-     * a transaction that can be reconsidered and to remove entries that conflict with a block.*/
-    std::unordered_map<COutPoint, std::set<Wtxid>, SaltedOutpointHasher> m_outpoint_to_orphan_it;
+    /** Index from wtxids to the orphans in m_orphans. */
+    std::unordered_map<Wtxid, Index, SaltedTxidHasher> m_wtxid_to_orphan;
+
+    /** Index from the txids of parents to the orphans in m_orphans spending any of their outputs, once per orphan.
+     * Used to find children of a transaction that can be reconsidered and to remove entries that conflict with a
+     * block. */
+    std::unordered_map<Txid, std::vector<Index>, SaltedTxidHasher> m_parent_to_children;
 
     struct PeerDoSInfo {
         TxOrphanage::Usage m_total_usage{0};
         TxOrphanage::Count m_count_announcements{0};
         TxOrphanage::Count m_total_latency_score{0};
+        /** The peer's announcements that are not reconsiderable, and its workset, indexed by
+         * Announcement::m_reconsider. Each is a min-heap by m_entry_sequence, so that the oldest announcement is at
+         * the front, and moving announcements between them as worksets change costs O(log n). */
+        std::array<std::vector<Index>, 2> m_heaps;
+        /** Compare the counters (not the heaps). */
         bool operator==(const PeerDoSInfo& other) const
         {
             return m_total_usage == other.m_total_usage &&
                    m_count_announcements == other.m_count_announcements &&
                    m_total_latency_score == other.m_total_latency_score;
         }
-        void Add(const Announcement& ann)
+        void Add(const Orphan& orphan)
         {
-            m_total_usage += ann.GetMemUsage();
-            m_total_latency_score += ann.GetLatencyScore();
+            m_total_usage += orphan.m_usage;
+            m_total_latency_score += orphan.m_latency_score;
             m_count_announcements += 1;
         }
-        bool Subtract(const Announcement& ann)
+        bool Subtract(const Orphan& orphan)
         {
-            Assume(m_total_usage >= ann.GetMemUsage());
-            Assume(m_total_latency_score >= ann.GetLatencyScore());
+            Assume(m_total_usage >= orphan.m_usage);
+            Assume(m_total_latency_score >= orphan.m_latency_score);
             Assume(m_count_announcements >= 1);
 
-            m_total_usage -= ann.GetMemUsage();
-            m_total_latency_score -= ann.GetLatencyScore();
+            m_total_usage -= orphan.m_usage;
+            m_total_latency_score -= orphan.m_latency_score;
             m_count_announcements -= 1;
             return m_count_announcements == 0;
         }
@@ -168,12 +158,36 @@ class TxOrphanageImpl final : public TxOrphanage {
      * number of peers and thus global {latency score, memory} limits. */
     std::unordered_map<NodeId, PeerDoSInfo> m_peer_orphanage_info;
 
-    /** Erase from m_orphans and update m_peer_orphanage_info. */
-    template<typename Tag>
-    void Erase(Iter<Tag> it);
+    /** Return the announcement of orphan by peer, or NO_INDEX. */
+    Index FindAnnouncement(const Orphan& orphan, NodeId peer) const;
+
+    /** Move the announcement at position pos of heap towards the front or the back until the heap is ordered. */
+    void SiftUp(std::vector<Index>& heap, Index pos);
+    void SiftDown(std::vector<Index>& heap, Index pos);
+
+    /** Add an announcement to heap. */
+    void HeapPush(std::vector<Index>& heap, Index ann);
+
+    /** Remove an announcement from heap. */
+    void HeapErase(std::vector<Index>& heap, Index ann);
+
+    /** Add an announcement of orphan by peer, which must not exist yet. */
+    void Announce(Index orphan, NodeId peer);
+
+    /** Move an announcement into or out of the workset of its announcer. */
+    void SetReconsider(Index ann, bool reconsider);
+
+    /** Erase an announcement, and its orphan if it was the last announcement of it. */
+    void EraseAnnouncement(Index ann);
+
+    /** Erase an orphan and all its announcements. */
+    void EraseOrphan(Index orphan);
+
+    /** Remove an announcement from its announcer and update m_peer_orphanage_info, but not from its orphan. */
+    void ReleaseAnnouncement(Index ann);
 
-    /** Check if there is exactly one announcement with the same wtxid as it. */
-    bool IsUnique(Iter<ByWtxid> it) const;
+    /** Remove an orphan whose announcements are all released. */
+    void ReleaseOrphan(Index orphan);
 
     /** Check if the orphanage needs trimming. */
     bool NeedsTrim() const;
@@ -195,16 +209,16 @@ public:
     TxOrphanage::Count TotalLatencyScore() const override;
     TxOrphanage::Usage ReservedPeerUsage() const override;
 
-    /** Maximum allowed (deduplicated) latency score for all tranactions (see Announcement::GetLatencyScore()). Dynamic
-     * based on number of peers. Each peer has an equal amount, but the global maximum latency score stays constant. The
+    /** Maximum allowed (deduplicated) latency score for all tranactions (see Orphan::m_latency_score). Dynamic based
+     * on number of peers. Each peer has an equal amount, but the global maximum latency score stays constant. The
      * number of peers times MaxPeerLatencyScore() (rounded) adds up to MaxGlobalLatencyScore().  As long as every peer's
      * m_total_latency_score / MaxPeerLatencyScore() < 1, MaxGlobalLatencyScore() is not exceeded. */
     TxOrphanage::Count MaxPeerLatencyScore() const override;
 
-    /** Maximum allowed (deduplicated) memory usage for all transactions (see Announcement::GetMemUsage()). Dynamic based
-     * on number of peers. More peers means more allowed memory usage. The number of peers times ReservedPeerUsage()
-     * adds up to MaxGlobalUsage(). As long as every peer's m_total_usage / ReservedPeerUsage() < 1, MaxGlobalUsage() is
-     * not exceeded. */
+    /** Maximum allowed (deduplicated) memory usage for all transactions (see Orphan::m_usage). Dynamic based on number
+     * of peers. More peers means more allowed memory usage. The number of peers times ReservedPeerUsage() adds up to
+     * MaxGlobalUsage(). As long as every peer's m_total_usage / ReservedPeerUsage() < 1, MaxGlobalUsage() is not
+     * exceeded. */
     TxOrphanage::Usage MaxGlobalUsage() const override;
 
     bool AddTx(const CTransactionRef& tx, NodeId peer) override;
@@ -226,46 +240,153 @@ public:
     void SanityCheck() const override;
 };
 
-template<typename Tag>
-void TxOrphanageImpl::Erase(Iter<Tag> it)
+TxOrphanageImpl::Index TxOrphanageImpl::FindAnnouncement(const Orphan& orphan, NodeId peer) const
+{
+    const auto it{std::ranges::lower_bound(orphan.m_announcements, peer, {}, [&](Index ann) { return m_announcements[ann].m_announcer; })};
+    return it != orphan.m_announcements.end() && m_announcements[*it].m_announcer == peer ? *it : NO_INDEX;
+}
+
+void TxOrphanageImpl::SiftUp(std::vector<Index>& heap, Index pos)
+{
+    const Index ann{heap[pos]};
+    while (pos > 0) {
+        const Index parent{(pos - 1) / 2};
+        if (m_announcements[heap[parent]].m_entry_sequence < m_announcements[ann].m_entry_sequence) break;
+        heap[pos] = heap[parent];
+        m_announcements[heap[pos]].m_heap_pos = pos;
+        pos = parent;
+    }
+    heap[pos] = ann;
+    m_announcements[ann].m_heap_pos = pos;
+}
+
+void TxOrphanageImpl::SiftDown(std::vector<Index>& heap, Index pos)
+{
+    const Index ann{heap[pos]};
+    while (true) {
+        Index child{2 * pos + 1};
+        if (child >= heap.size()) break;
+        if (child + 1 < heap.size() && m_announcements[heap[child + 1]].m_entry_sequence < m_announcements[heap[child]].m_entry_sequence) ++child;
+        if (m_announcements[ann].m_entry_sequence < m_announcements[heap[child]].m_entry_sequence) break;
+        heap[pos] = heap[child];
+        m_announcements[heap[pos]].m_heap_pos = pos;
+        pos = child;
+    }
+    heap[pos] = ann;
+    m_announcements[ann].m_heap_pos = pos;
+}
+
+void TxOrphanageImpl::HeapPush(std::vector<Index>& heap, Index ann)
+{
+    // New announcements have the highest sequence number, so this only sifts when moving between heaps.
+    heap.push_back(ann);
+    SiftUp(heap, heap.size() - 1);
+}
+
+void TxOrphanageImpl::HeapErase(std::vector<Index>& heap, Index ann)
+{
+    const Index pos{m_announcements[ann].m_heap_pos};
+    Assume(pos < heap.size() && heap[pos] == ann);
+    m_announcements[ann].m_heap_pos = NO_INDEX;
+    const Index last{heap.back()};
+    heap.pop_back();
+    if (pos == heap.size()) return;
+    heap[pos] = last;
+    SiftUp(heap, pos);
+    SiftDown(heap, m_announcements[last].m_heap_pos);
+}
+
+void TxOrphanageImpl::Announce(Index orphan, NodeId peer)
+{
+    Index ann;
+    if (m_free_announcements.empty()) {
+        ann = m_announcements.size();
+        m_announcements.emplace_back();
+    } else {
+        ann = m_free_announcements.back();
+        m_free_announcements.pop_back();
+    }
+    Announcement& entry{m_announcements[ann]};
+    entry.m_orphan = orphan;
+    entry.m_announcer = peer;
+    entry.m_entry_sequence = m_current_sequence++;
+    entry.m_reconsider = false;
+
+    auto& anns{m_orphans[orphan].m_announcements};
+    anns.insert(std::ranges::upper_bound(anns, peer, {}, [&](Index other) { return m_announcements[other].m_announcer; }), ann);
+
+    auto& peer_info = m_peer_orphanage_info.try_emplace(peer).first->second;
+    peer_info.Add(m_orphans[orphan]);
+    HeapPush(peer_info.m_heaps[false], ann);
+}
+
+void TxOrphanageImpl::SetReconsider(Index ann, bool reconsider)
+{
+    Announcement& entry{m_announcements[ann]};
+    auto peer_it = m_peer_orphanage_info.find(entry.m_announcer);
+    if (!Assume(peer_it != m_peer_orphanage_info.end())) return;
+    HeapErase(peer_it->second.m_heaps[entry.m_reconsider], ann);
+    entry.m_reconsider = reconsider;
+    HeapPush(peer_it->second.m_heaps[entry.m_reconsider], ann);
+}
+
+void TxOrphanageImpl::EraseAnnouncement(Index ann)
+{
+    const Index orphan{m_announcements[ann].m_orphan};
+    auto& anns{m_orphans[orphan].m_announcements};
+    anns.erase(std::ranges::find(anns, ann));
+    ReleaseAnnouncement(ann);
+    if (anns.empty()) ReleaseOrphan(orphan);
+}
+
+void TxOrphanageImpl::EraseOrphan(Index orphan)
+{
+    for (const Index ann : m_orphans[orphan].m_announcements) ReleaseAnnouncement(ann);
+    m_orphans[orphan].m_announcements.clear();
+    ReleaseOrphan(orphan);
+}
+
+void TxOrphanageImpl::ReleaseAnnouncement(Index ann)
 {
+    Announcement& entry{m_announcements[ann]};
     // Update m_peer_orphanage_info and clean up entries if they point to an empty struct.
     // This means peers that are not storing any orphans do not have an entry in
     // m_peer_orphanage_info (they can be added back later if they announce another orphan) and
     // ensures disconnected peers are not tracked forever.
-    auto peer_it = m_peer_orphanage_info.find(it->m_announcer);
+    auto peer_it = m_peer_orphanage_info.find(entry.m_announcer);
     Assume(peer_it != m_peer_orphanage_info.end());
-    if (peer_it->second.Subtract(*it)) m_peer_orphanage_info.erase(peer_it);
-
-    if (IsUnique(m_orphans.project<ByWtxid>(it))) {
-        m_unique_orphans -= 1;
-        m_unique_rounded_input_scores -= it->GetLatencyScore() - 1;
-        m_unique_orphan_usage -= it->GetMemUsage();
-
-        // Remove references in m_outpoint_to_orphan_it
-        const auto& wtxid{it->m_tx->GetWitnessHash()};
-        for (const auto& input : it->m_tx->vin) {
-            auto it_prev = m_outpoint_to_orphan_it.find(input.prevout);
-            if (it_prev != m_outpoint_to_orphan_it.end()) {
-                it_prev->second.erase(wtxid);
-                // Clean up keys if they point to an empty set.
-                if (it_prev->second.empty()) {
-                    m_outpoint_to_orphan_it.erase(it_prev);
-                }
-            }
-        }
-    }
-    m_orphans.get<Tag>().erase(it);
+    HeapErase(peer_it->second.m_heaps[entry.m_reconsider], ann);
+    if (peer_it->second.Subtract(m_orphans[entry.m_orphan])) m_peer_orphanage_info.erase(peer_it);
+
+    entry.m_orphan = NO_INDEX;
+    m_free_announcements.push_back(ann);
 }
 
-bool TxOrphanageImpl::IsUnique(Iter<ByWtxid> it) const
+void TxOrphanageImpl::ReleaseOrphan(Index orphan)
 {
-    // Iterators ByWtxid are sorted by wtxid, so check if neighboring elements have the same wtxid.
-    auto& index = m_orphans.get<ByWtxid>();
-    if (it == index.end()) return false;
-    if (std::next(it) != index.end() && std::next(it)->m_tx->GetWitnessHash() == it->m_tx->GetWitnessHash()) return false;
-    if (it != index.begin() && std::prev(it)->m_tx->GetWitnessHash() == it->m_tx->GetWitnessHash()) return false;
-    return true;
+    Orphan& entry{m_orphans[orphan]};
+    Assume(entry.m_announcements.empty());
+    m_unique_orphans -= 1;
+    m_unique_rounded_input_scores -= entry.m_latency_score - 1;
+    m_unique_orphan_usage -= entry.m_usage;
+
+    // Remove references in m_parent_to_children
+    for (const auto& input : entry.m_tx->vin) {
+        auto it_children = m_parent_to_children.find(input.prevout.hash);
+        // Another input may have spent from the same parent already.
+        if (it_children == m_parent_to_children.end()) continue;
+        auto& children{it_children->second};
+        const auto it{std::ranges::find(children, orphan)};
+        if (it == children.end()) continue;
+        *it = children.back();
+        children.pop_back();
+        // Clean up keys if they point to an empty vector.
+        if (children.empty()) m_parent_to_children.erase(it_children);
+    }
+    m_wtxid_to_orphan.erase(entry.m_tx->GetWitnessHash());
+
+    entry.m_tx.reset();
+    m_free_orphans.push_back(orphan);
 }
 
 TxOrphanage::Usage TxOrphanageImpl::UsageByPeer(NodeId peer) const
@@ -274,7 +395,7 @@ TxOrphanage::Usage TxOrphanageImpl::UsageByPeer(NodeId peer) const
     return it == m_peer_orphanage_info.end() ? 0 : it->second.m_total_usage;
 }
 
-TxOrphanage::Count TxOrphanageImpl::CountAnnouncements() const { return m_orphans.size(); }
+TxOrphanage::Count TxOrphanageImpl::CountAnnouncements() const { return m_announcements.size() - m_free_announcements.size(); }
 
 TxOrphanage::Usage TxOrphanageImpl::TotalOrphanUsage() const { return m_unique_orphan_usage; }
 
@@ -303,81 +424,73 @@ bool TxOrphanageImpl::AddTx(const CTransactionRef& tx, NodeId peer)
     }
 
     // We will return false if the tx already exists under a different peer.
-    const bool brand_new{!HaveTx(wtxid)};
-
-    auto [iter, inserted] = m_orphans.get<ByWtxid>().emplace(tx, peer, m_current_sequence);
-    // If the announcement (same wtxid, same peer) already exists, emplacement fails. Return false.
-    if (!inserted) return false;
-
-    ++m_current_sequence;
-    auto& peer_info = m_peer_orphanage_info.try_emplace(peer).first->second;
-    peer_info.Add(*iter);
-
-    // Add links in m_outpoint_to_orphan_it
-    if (brand_new) {
-        for (const auto& input : tx->vin) {
-            auto& wtxids_for_prevout = m_outpoint_to_orphan_it.try_emplace(input.prevout).first->second;
-            wtxids_for_prevout.emplace(wtxid);
-        }
-
-        m_unique_orphans += 1;
-        m_unique_orphan_usage += iter->GetMemUsage();
-        m_unique_rounded_input_scores += iter->GetLatencyScore() - 1;
-
-        LogDebug(BCLog::TXPACKAGES, "stored orphan tx %s (wtxid=%s), weight: %u (mapsz %u outsz %u)\n",
-                    txid.ToString(), wtxid.ToString(), sz, m_orphans.size(), m_outpoint_to_orphan_it.size());
-        Assume(IsUnique(iter));
-    } else {
+    auto [it_orphan, brand_new] = m_wtxid_to_orphan.try_emplace(wtxid, NO_INDEX);
+    if (!brand_new) {
+        const Index orphan{it_orphan->second};
+        // If the announcement (same wtxid, same peer) already exists, return false.
+        if (FindAnnouncement(m_orphans[orphan], peer) != NO_INDEX) return false;
+        Announce(orphan, peer);
         LogDebug(BCLog::TXPACKAGES, "added peer=%d as announcer of orphan tx %s (wtxid=%s)\n",
                     peer, txid.ToString(), wtxid.ToString());
-        Assume(!IsUnique(iter));
+        return false;
+    }
+
+    Index orphan;
+    if (m_free_orphans.empty()) {
+        orphan = m_orphans.size();
+        m_orphans.emplace_back();
+    } else {
+        orphan = m_free_orphans.back();
+        m_free_orphans.pop_back();
     }
-    return brand_new;
+    it_orphan->second = orphan;
+    Orphan& entry{m_orphans[orphan]};
+    entry.m_tx = tx;
+    entry.m_usage = sz;
+    entry.m_latency_score = 1 + (tx->vin.size() / 10);
+
+    // Add links in m_parent_to_children. This orphan is pushed last, so it is a duplicate iff it is at the back.
+    for (const auto& input : tx->vin) {
+        auto& children = m_parent_to_children[input.prevout.hash];
+        if (children.empty() || children.back() != orphan) children.push_back(orphan);
+    }
+
+    m_unique_orphans += 1;
+    m_unique_orphan_usage += entry.m_usage;
+    m_unique_rounded_input_scores += entry.m_latency_score - 1;
+    Announce(orphan, peer);
+
+    LogDebug(BCLog::TXPACKAGES, "stored orphan tx %s (wtxid=%s), weight: %u (mapsz %u outsz %u)\n",
+                txid.ToString(), wtxid.ToString(), sz, CountAnnouncements(), m_parent_to_children.size());
+    return true;
 }
 
 bool TxOrphanageImpl::AddAnnouncer(const Wtxid& wtxid, NodeId peer)
 {
-    auto& index_by_wtxid = m_orphans.get<ByWtxid>();
-    auto it = index_by_wtxid.lower_bound(ByWtxidView{wtxid, MIN_PEER});
-
     // Do nothing if this transaction isn't already present. We can't create an entry if we don't
     // have the tx data.
-    if (it == index_by_wtxid.end()) return false;
-    if (it->m_tx->GetWitnessHash() != wtxid) return false;
+    const auto it = m_wtxid_to_orphan.find(wtxid);
+    if (it == m_wtxid_to_orphan.end()) return false;
 
-    // Add another announcement, copying the CTransactionRef from one that already exists.
-    const auto& ptx = it->m_tx;
-    auto [iter, inserted] = index_by_wtxid.emplace(ptx, peer, m_current_sequence);
-    // If the announcement (same wtxid, same peer) already exists, emplacement fails. Return false.
-    if (!inserted) return false;
+    // If the announcement (same wtxid, same peer) already exists, return false.
+    const Index orphan{it->second};
+    if (FindAnnouncement(m_orphans[orphan], peer) != NO_INDEX) return false;
+    Announce(orphan, peer);
 
-    ++m_current_sequence;
-    auto& peer_info = m_peer_orphanage_info.try_emplace(peer).first->second;
-    peer_info.Add(*iter);
-
-    const auto& txid = ptx->GetHash();
     LogDebug(BCLog::TXPACKAGES, "added peer=%d as announcer of orphan tx %s (wtxid=%s)\n",
-                peer, txid.ToString(), wtxid.ToString());
-
-    Assume(!IsUnique(iter));
+                peer, m_orphans[orphan].m_tx->GetHash().ToString(), wtxid.ToString());
     return true;
 }
 
 bool TxOrphanageImpl::EraseTx(const Wtxid& wtxid)
 {
-    auto& index_by_wtxid = m_orphans.get<ByWtxid>();
-
-    auto it = index_by_wtxid.lower_bound(ByWtxidView{wtxid, MIN_PEER});
-    if (it == index_by_wtxid.end() || it->m_tx->GetWitnessHash() != wtxid) return false;
-
-    auto it_end = index_by_wtxid.upper_bound(ByWtxidView{wtxid, MAX_PEER});
-    unsigned int num_ann{0};
-    const auto txid = it->m_tx->GetHash();
-    while (it != it_end) {
-        Assume(it->m_tx->GetWitnessHash() == wtxid);
-        Erase<ByWtxid>(it++);
-        num_ann += 1;
-    }
+    const auto it = m_wtxid_to_orphan.find(wtxid);
+    if (it == m_wtxid_to_orphan.end()) return false;
+
+    const Index orphan{it->second};
+    const auto num_ann{m_orphans[orphan].m_announcements.size()};
+    const auto txid = m_orphans[orphan].m_tx->GetHash();
+    EraseOrphan(orphan);
 
     LogDebug(BCLog::TXPACKAGES, "removed orphan tx %s (wtxid=%s) (%u announcements)\n", txid.ToString(), wtxid.ToString(), num_ann);
 
@@ -387,19 +500,18 @@ bool TxOrphanageImpl::EraseTx(const Wtxid& wtxid)
 /** Erase all entries by this peer. */
 void TxOrphanageImpl::EraseForPeer(NodeId peer)
 {
-    auto& index_by_peer = m_orphans.get<ByPeer>();
-    auto it = index_by_peer.lower_bound(ByPeerView{peer, false, 0});
-    if (it == index_by_peer.end() || it->m_announcer != peer) return;
-
-    unsigned int num_ann{0};
-    while (it != index_by_peer.end() && it->m_announcer == peer) {
-        // Delete item, cleaning up m_outpoint_to_orphan_it iff this entry is unique by wtxid.
-        Erase<ByPeer>(it++);
-        num_ann += 1;
-    }
+    auto peer_it = m_peer_orphanage_info.find(peer);
+    if (peer_it == m_peer_orphanage_info.end()) return;
+
+    // Collect the announcements first, erasing the last one also erases the peer's heaps.
+    std::vector<Index> anns;
+    anns.reserve(peer_it->second.m_count_announcements);
+    for (const auto& heap : peer_it->second.m_heaps) anns.insert(anns.end(), heap.begin(), heap.end());
+    // Delete each announcement, cleaning up its orphan iff it was the last announcement of it.
+    for (const Index ann : anns) EraseAnnouncement(ann);
     Assume(!m_peer_orphanage_info.contains(peer));
 
-    if (num_ann > 0) LogDebug(BCLog::TXPACKAGES, "Erased %d orphan transaction(s) from peer=%d\n", num_ann, peer);
+    if (!anns.empty()) LogDebug(BCLog::TXPACKAGES, "Erased %d orphan transaction(s) from peer=%d\n", anns.size(), peer);
 }
 
 /** If the data structure needs trimming, evicts announcements by selecting the DoSiest peer and evicting its oldest
@@ -459,15 +571,17 @@ void TxOrphanageImpl::LimitOrphans()
 
         // This inner loop trims until this peer is no longer the DoSiest one or has a score within 1. The score 1 is
         // just a conservative fallback: once the last peer goes below ratio 1, NeedsTrim() will return false anyway.
-        // We evict the oldest announcement(s) from this peer, sorting non-reconsiderable before reconsiderable.
-        // The number of inner loop iterations is bounded by the total number of announcements.
+        // We evict the oldest announcement(s) from this peer, which are at the front of its heaps, sorting
+        // non-reconsiderable before reconsiderable. The number of inner loop iterations is bounded by the total
+        // number of announcements.
         const auto& dos_threshold = heap_peer_dos.empty() ? FeeFrac{1, 1} : heap_peer_dos.front().second;
-        auto it_ann = m_orphans.get<ByPeer>().lower_bound(ByPeerView{worst_peer, false, 0});
         while (NeedsTrim()) {
-            if (!Assume(it_ann->m_announcer == worst_peer)) break;
-            if (!Assume(it_ann != m_orphans.get<ByPeer>().end())) break;
+            if (!Assume(it_worst_peer != m_peer_orphanage_info.end())) break;
+            const auto& heaps{it_worst_peer->second.m_heaps};
+            if (!Assume(!heaps[false].empty() || !heaps[true].empty())) break;
+            const Index ann{heaps[false].empty() ? heaps[true].front() : heaps[false].front()};
 
-            Erase<ByPeer>(it_ann++);
+            EraseAnnouncement(ann);
             num_erased += 1;
 
             // If we erased the last orphan from this peer, it_worst_peer will be invalidated.
@@ -492,106 +606,109 @@ void TxOrphanageImpl::LimitOrphans()
 std::vector<std::pair<Wtxid, NodeId>> TxOrphanageImpl::AddChildrenToWorkSet(const CTransaction& tx, FastRandomContext& rng)
 {
     std::vector<std::pair<Wtxid, NodeId>> ret;
-    auto& index_by_wtxid = m_orphans.get<ByWtxid>();
-    for (unsigned int i = 0; i < tx.vout.size(); i++) {
-        const auto it_by_prev = m_outpoint_to_orphan_it.find(COutPoint(tx.GetHash(), i));
-        if (it_by_prev != m_outpoint_to_orphan_it.end()) {
-            for (const auto& wtxid : it_by_prev->second) {
-                // Belt and suspenders, each entry in m_outpoint_to_orphan_it should always have at least 1 announcement.
-                auto it = index_by_wtxid.lower_bound(ByWtxidView{wtxid, MIN_PEER});
-                if (!Assume(it != index_by_wtxid.end())) continue;
-
-                // Select a random peer to assign orphan processing, reducing wasted work if the orphan is still missing
-                // inputs. However, we don't want to create an issue in which the assigned peer can purposefully stop us
-                // from processing the orphan by disconnecting.
-                auto it_end = index_by_wtxid.upper_bound(ByWtxidView{wtxid, MAX_PEER});
-                const auto num_announcers{std::distance(it, it_end)};
-                if (!Assume(num_announcers > 0)) continue;
-                std::advance(it, rng.randrange(num_announcers));
-
-                if (!Assume(it->m_tx->GetWitnessHash() == wtxid)) break;
-
-                // Mark this orphan as ready to be reconsidered.
-                static constexpr auto mark_reconsidered_modifier = [](auto& ann) { ann.m_reconsider = true; };
-                if (!it->m_reconsider) {
-                    index_by_wtxid.modify(it, mark_reconsidered_modifier);
-                    ret.emplace_back(wtxid, it->m_announcer);
-                }
-
-                LogDebug(BCLog::TXPACKAGES, "added %s (wtxid=%s) to peer %d workset\n",
-                            it->m_tx->GetHash().ToString(), it->m_tx->GetWitnessHash().ToString(), it->m_announcer);
-            }
+    const auto it_children = m_parent_to_children.find(tx.GetHash());
+    if (it_children == m_parent_to_children.end()) return ret;
+
+    for (const Index orphan : it_children->second) {
+        const Orphan& entry{m_orphans[orphan]};
+        // Only consider orphans spending an output that tx actually has.
+        if (std::ranges::none_of(entry.m_tx->vin, [&](const CTxIn& input) {
+                return input.prevout.hash == tx.GetHash() && input.prevout.n < tx.vout.size();
+            })) {
+            continue;
         }
+
+        // Select a random peer to assign orphan processing, reducing wasted work if the orphan is still missing
+        // inputs. However, we don't want to create an issue in which the assigned peer can purposefully stop us
+        // from processing the orphan by disconnecting.
+        // Belt and suspenders, each orphan should always have at least 1 announcement.
+        if (!Assume(!entry.m_announcements.empty())) continue;
+        const Index ann{entry.m_announcements[rng.randrange(entry.m_announcements.size())]};
+
+        // Mark this orphan as ready to be reconsidered.
+        if (!m_announcements[ann].m_reconsider) {
+            SetReconsider(ann, true);
+            ret.emplace_back(entry.m_tx->GetWitnessHash(), m_announcements[ann].m_announcer);
+        }
+
+        LogDebug(BCLog::TXPACKAGES, "added %s (wtxid=%s) to peer %d workset\n",
+                    entry.m_tx->GetHash().ToString(), entry.m_tx->GetWitnessHash().ToString(), m_announcements[ann].m_announcer);
     }
     return ret;
 }
 
 bool TxOrphanageImpl::HaveTx(const Wtxid& wtxid) const
 {
-    auto it_lower = m_orphans.get<ByWtxid>().lower_bound(ByWtxidView{wtxid, MIN_PEER});
-    return it_lower != m_orphans.get<ByWtxid>().end() && it_lower->m_tx->GetWitnessHash() == wtxid;
+    return m_wtxid_to_orphan.contains(wtxid);
 }
 
 CTransactionRef TxOrphanageImpl::GetTx(const Wtxid& wtxid) const
 {
-    auto it_lower = m_orphans.get<ByWtxid>().lower_bound(ByWtxidView{wtxid, MIN_PEER});
-    if (it_lower != m_orphans.get<ByWtxid>().end() && it_lower->m_tx->GetWitnessHash() == wtxid) return it_lower->m_tx;
+    const auto it = m_wtxid_to_orphan.find(wtxid);
+    if (it != m_wtxid_to_orphan.end()) return m_orphans[it->second].m_tx;
     return nullptr;
 }
 
 bool TxOrphanageImpl::HaveTxFromPeer(const Wtxid& wtxid, NodeId peer) const
 {
-    return m_orphans.get<ByWtxid>().count(ByWtxidView{wtxid, peer}) > 0;
+    const auto it = m_wtxid_to_orphan.find(wtxid);
+    return it != m_wtxid_to_orphan.end() && FindAnnouncement(m_orphans[it->second], peer) != NO_INDEX;
 }
 
 /** If there is a tx that can be reconsidered, return it and set it back to
  * non-reconsiderable. Otherwise, return a nullptr. */
 CTransactionRef TxOrphanageImpl::GetTxToReconsider(NodeId peer)
 {
-    auto it = m_orphans.get<ByPeer>().lower_bound(ByPeerView{peer, true, 0});
-    if (it != m_orphans.get<ByPeer>().end() && it->m_announcer == peer && it->m_reconsider) {
-        // Flip m_reconsider. Even if this transaction stays in orphanage, it shouldn't be
-        // reconsidered again until there is a new reason to do so.
-        static constexpr auto mark_reconsidered_modifier = [](auto& ann) { ann.m_reconsider = false; };
-        m_orphans.get<ByPeer>().modify(it, mark_reconsidered_modifier);
-        return it->m_tx;
-    }
-    return nullptr;
+    auto peer_it = m_peer_orphanage_info.find(peer);
+    if (peer_it == m_peer_orphanage_info.end() || peer_it->second.m_heaps[true].empty()) return nullptr;
+
+    // Flip m_reconsider of the oldest announcement in the workset. Even if this transaction stays in orphanage, it
+    // shouldn't be reconsidered again until there is a new reason to do so.
+    const Index ann{peer_it->second.m_heaps[true].front()};
+    SetReconsider(ann, false);
+    return m_orphans[m_announcements[ann].m_orphan].m_tx;
 }
 
 /** Return whether there is a tx that can be reconsidered. */
 bool TxOrphanageImpl::HaveTxToReconsider(NodeId peer)
 {
-    auto it = m_orphans.get<ByPeer>().lower_bound(ByPeerView{peer, true, 0});
-    return it != m_orphans.get<ByPeer>().end() && it->m_announcer == peer && it->m_reconsider;
+    auto peer_it = m_peer_orphanage_info.find(peer);
+    return peer_it != m_peer_orphanage_info.end() && !peer_it->second.m_heaps[true].empty();
 }
 void TxOrphanageImpl::EraseForBlock(const CBlock& block)
 {
-    if (m_orphans.empty()) return;
+    if (m_wtxid_to_orphan.empty()) return;
 
-    std::set<Wtxid> wtxids_to_erase;
+    // Group the outputs the block spends by the transaction they belong to, keeping only those of
+    // orphan parents, so that the children of each parent are scanned once.
+    std::unordered_map<Txid, std::vector<uint32_t>, SaltedTxidHasher> spent_by_parent;
     for (const CTransactionRef& ptx : block.vtx) {
-        const CTransaction& block_tx = *ptx;
-
-        // Which orphan pool entries must we evict?
-        for (const auto& input : block_tx.vin) {
-            auto it_prev = m_outpoint_to_orphan_it.find(input.prevout);
-            if (it_prev != m_outpoint_to_orphan_it.end()) {
-                // Copy all wtxids to wtxids_to_erase.
-                std::copy(it_prev->second.cbegin(), it_prev->second.cend(), std::inserter(wtxids_to_erase, wtxids_to_erase.end()));
-            }
+        for (const auto& input : ptx->vin) {
+            if (!m_parent_to_children.contains(input.prevout.hash)) continue;
+            spent_by_parent[input.prevout.hash].push_back(input.prevout.n);
         }
     }
 
-    unsigned int num_erased{0};
-    for (const auto& wtxid : wtxids_to_erase) {
-        num_erased += EraseTx(wtxid) ? 1 : 0;
+    // Which orphan pool entries must we evict?
+    std::vector<Index> orphans_to_erase;
+    for (auto& [parent, spent] : spent_by_parent) {
+        std::ranges::sort(spent);
+        for (const Index orphan : m_parent_to_children.find(parent)->second) {
+            if (std::ranges::any_of(m_orphans[orphan].m_tx->vin, [&](const CTxIn& orphan_input) {
+                    return orphan_input.prevout.hash == parent && std::ranges::binary_search(spent, orphan_input.prevout.n);
+                })) {
+                orphans_to_erase.push_back(orphan);
+            }
+        }
     }
+    std::ranges::sort(orphans_to_erase);
+    orphans_to_erase.erase(std::ranges::unique(orphans_to_erase).begin(), orphans_to_erase.end());
+
+    for (const Index orphan : orphans_to_erase) EraseOrphan(orphan);
 
-    if (num_erased != 0) {
-        LogDebug(BCLog::TXPACKAGES, "Erased %d orphan transaction(s) included or conflicted by block\n", num_erased);
+    if (!orphans_to_erase.empty()) {
+        LogDebug(BCLog::TXPACKAGES, "Erased %d orphan transaction(s) included or conflicted by block\n", orphans_to_erase.size());
     }
-    Assume(wtxids_to_erase.size() == num_erased);
 }
 
 /** Get all children that spend from this tx and were received from nodeid. Sorted from most
@@ -599,27 +716,23 @@ void TxOrphanageImpl::EraseForBlock(const CBlock& block)
 std::vector<CTransactionRef> TxOrphanageImpl::GetChildrenFromSamePeer(const CTransactionRef& parent, NodeId peer) const
 {
     std::vector<CTransactionRef> children_found;
-    const auto& parent_txid{parent->GetHash()};
-
-    // Iterate through all orphans from this peer, in reverse order, so that more recent
-    // transactions are added first. Doing so helps avoid work when one of the orphans replaced
-    // an earlier one. Since we require the NodeId to match, one peer's announcement order does
-    // not bias how we process other peer's orphans.
-    auto& index_by_peer = m_orphans.get<ByPeer>();
-    auto it_upper = index_by_peer.upper_bound(ByPeerView{peer, true, std::numeric_limits<uint64_t>::max()});
-    auto it_lower = index_by_peer.lower_bound(ByPeerView{peer, false, 0});
-
-    while (it_upper != it_lower) {
-        --it_upper;
-        if (!Assume(it_upper->m_announcer == peer)) break;
-        // Check if this tx spends from parent.
-        for (const auto& input : it_upper->m_tx->vin) {
-            if (input.prevout.hash == parent_txid) {
-                children_found.emplace_back(it_upper->m_tx);
-                break;
-            }
-        }
+    const auto it_children = m_parent_to_children.find(parent->GetHash());
+    if (it_children == m_parent_to_children.end()) return children_found;
+
+    // Look up this peer's announcement of each child, and return them with more recent transactions first. Doing so
+    // helps avoid work when one of the orphans replaced an earlier one. Since we require the NodeId to match, one
+    // peer's announcement order does not bias how we process other peer's orphans. Reconsiderable ones go first.
+    std::vector<Index> anns;
+    for (const Index orphan : it_children->second) {
+        const Index ann{FindAnnouncement(m_orphans[orphan], peer)};
+        if (ann != NO_INDEX) anns.push_back(ann);
     }
+    std::ranges::sort(anns, std::greater{}, [&](Index ann) {
+        return std::make_pair(m_announcements[ann].m_reconsider, m_announcements[ann].m_entry_sequence);
+    });
+
+    children_found.reserve(anns.size());
+    for (const Index ann : anns) children_found.emplace_back(m_orphans[m_announcements[ann].m_orphan].m_tx);
     return children_found;
 }
 
@@ -628,18 +741,11 @@ std::vector<TxOrphanage::OrphanTxBase> TxOrphanageImpl::GetOrphanTransactions()
     std::vector<TxOrphanage::OrphanTxBase> result;
     result.reserve(m_unique_orphans);
 
-    auto& index_by_wtxid = m_orphans.get<ByWtxid>();
-    auto it = index_by_wtxid.begin();
-    std::set<NodeId> this_orphan_announcers;
-    while (it != index_by_wtxid.end()) {
-        this_orphan_announcers.insert(it->m_announcer);
-        // If this is the last entry, or the next entry has a different wtxid, build a OrphanTxBase.
-        if (std::next(it) == index_by_wtxid.end() || std::next(it)->m_tx->GetWitnessHash() != it->m_tx->GetWitnessHash()) {
-            result.emplace_back(it->m_tx, std::move(this_orphan_announcers));
-            this_orphan_announcers.clear();
-        }
-
-        ++it;
+    for (const Orphan& entry : m_orphans) {
+        if (!entry.m_tx) continue;
+        std::set<NodeId> announcers;
+        for (const Index ann : entry.m_announcements) announcers.insert(m_announcements[ann].m_announcer);
+        result.emplace_back(entry.m_tx, std::move(announcers));
     }
     Assume(m_unique_orphans == result.size());
 
@@ -649,60 +755,95 @@ std::vector<TxOrphanage::OrphanTxBase> TxOrphanageImpl::GetOrphanTransactions()
 void TxOrphanageImpl::SanityCheck() const
 {
     std::unordered_map<NodeId, PeerDoSInfo> reconstructed_peer_info;
-    std::map<Wtxid, std::pair<TxOrphanage::Usage, TxOrphanage::Count>> unique_wtxids_to_scores;
-    std::set<COutPoint> all_outpoints;
-
-    for (auto it = m_orphans.begin(); it != m_orphans.end(); ++it) {
-        for (const auto& input : it->m_tx->vin) {
-            all_outpoints.insert(input.prevout);
+    TxOrphanage::Count unique_orphans{0};
+    TxOrphanage::Usage unique_usage{0};
+    TxOrphanage::Count unique_rounded_input_scores{0};
+    size_t parent_links{0};
+
+    // Free slots are exactly the unused ones.
+    assert(std::ranges::count_if(m_orphans, [](const Orphan& entry) { return !entry.m_tx; }) == std::ssize(m_free_orphans));
+    for (const Index orphan : m_free_orphans) assert(!m_orphans[orphan].m_tx && m_orphans[orphan].m_announcements.empty());
+    assert(std::ranges::count(m_announcements, NO_INDEX, &Announcement::m_orphan) == std::ssize(m_free_announcements));
+    for (const Index ann : m_free_announcements) assert(m_announcements[ann].m_orphan == NO_INDEX);
+
+    for (Index orphan{0}; orphan < m_orphans.size(); ++orphan) {
+        const Orphan& entry{m_orphans[orphan]};
+        if (!entry.m_tx) continue;
+        unique_orphans += 1;
+        unique_usage += entry.m_usage;
+        unique_rounded_input_scores += entry.m_latency_score - 1;
+        assert(entry.m_usage == GetTransactionWeight(*entry.m_tx));
+        assert(entry.m_latency_score == 1 + (entry.m_tx->vin.size() / 10));
+
+        // The wtxid index points to this orphan.
+        const auto it = m_wtxid_to_orphan.find(entry.m_tx->GetWitnessHash());
+        assert(it != m_wtxid_to_orphan.end() && it->second == orphan);
+
+        // The orphan is listed exactly once as child of each of its parents.
+        std::set<Txid> parents;
+        for (const auto& input : entry.m_tx->vin) parents.insert(input.prevout.hash);
+        for (const auto& parent : parents) {
+            const auto it_children = m_parent_to_children.find(parent);
+            assert(it_children != m_parent_to_children.end());
+            assert(std::ranges::count(it_children->second, orphan) == 1);
+        }
+        parent_links += parents.size();
+
+        // Each orphan has at least one announcement, sorted by announcer, which refer back to it.
+        assert(!entry.m_announcements.empty());
+        for (size_t i{0}; i < entry.m_announcements.size(); ++i) {
+            const Announcement& ann{m_announcements[entry.m_announcements[i]]};
+            assert(ann.m_orphan == orphan);
+            if (i > 0) assert(m_announcements[entry.m_announcements[i - 1]].m_announcer < ann.m_announcer);
+            reconstructed_peer_info[ann.m_announcer].Add(entry);
         }
-        unique_wtxids_to_scores.emplace(it->m_tx->GetWitnessHash(), std::make_pair(it->GetMemUsage(), it->GetLatencyScore() - 1));
-
-        auto& peer_info = reconstructed_peer_info[it->m_announcer];
-        peer_info.m_total_usage += it->GetMemUsage();
-        peer_info.m_count_announcements += 1;
-        peer_info.m_total_latency_score += it->GetLatencyScore();
     }
-    assert(reconstructed_peer_info.size() == m_peer_orphanage_info.size());
+    assert(m_wtxid_to_orphan.size() == unique_orphans);
+    assert(std::accumulate(m_parent_to_children.begin(), m_parent_to_children.end(), size_t{0},
+        [](size_t sum, const auto& pair) { assert(!pair.second.empty()); return sum + pair.second.size(); }) == parent_links);
 
-    // All outpoints exist in m_outpoint_to_orphan_it, all keys in m_outpoint_to_orphan_it correspond to some
-    // orphan, and all wtxids referenced in m_outpoint_to_orphan_it are also in m_orphans.
-    // This ensures m_outpoint_to_orphan_it is cleaned up.
-    assert(all_outpoints.size() == m_outpoint_to_orphan_it.size());
-    for (const auto& [outpoint, wtxid_set] : m_outpoint_to_orphan_it) {
-        assert(all_outpoints.contains(outpoint));
-        for (const auto& wtxid : wtxid_set) {
-            assert(unique_wtxids_to_scores.contains(wtxid));
+    // Each peer's heaps hold exactly its announcements, ordered by sequence and matching m_reconsider.
+    assert(reconstructed_peer_info.size() == m_peer_orphanage_info.size());
+    for (const auto& [peer, info] : m_peer_orphanage_info) {
+        assert(reconstructed_peer_info.contains(peer) && reconstructed_peer_info.at(peer) == info);
+        TxOrphanage::Count count{0};
+        for (const bool reconsider : {false, true}) {
+            const auto& heap{info.m_heaps[reconsider]};
+            for (Index pos{0}; pos < heap.size(); ++pos) {
+                const Announcement& entry{m_announcements[heap[pos]]};
+                assert(entry.m_orphan != NO_INDEX);
+                assert(entry.m_announcer == peer);
+                assert(entry.m_reconsider == reconsider);
+                assert(entry.m_heap_pos == pos);
+                if (pos > 0) assert(m_announcements[heap[(pos - 1) / 2]].m_entry_sequence < entry.m_entry_sequence);
+            }
+            count += heap.size();
         }
+        assert(count == info.m_count_announcements);
     }
 
     // Cached m_unique_orphans value is correct.
-    assert(m_orphans.size() >= m_unique_orphans);
-    assert(m_orphans.size() <= m_peer_orphanage_info.size() * m_unique_orphans);
-    assert(unique_wtxids_to_scores.size() == m_unique_orphans);
-
-    const auto calculated_dedup_usage = std::accumulate(unique_wtxids_to_scores.begin(), unique_wtxids_to_scores.end(),
-        TxOrphanage::Usage{0}, [](TxOrphanage::Usage sum, const auto pair) { return sum + pair.second.first; });
-    assert(calculated_dedup_usage == m_unique_orphan_usage);
+    assert(CountAnnouncements() >= m_unique_orphans);
+    assert(CountAnnouncements() <= m_peer_orphanage_info.size() * m_unique_orphans);
+    assert(unique_orphans == m_unique_orphans);
+    assert(unique_usage == m_unique_orphan_usage);
 
     // Global usage is deduplicated, should be less than or equal to the sum of all per-peer usages.
     const auto summed_peer_usage = std::accumulate(m_peer_orphanage_info.begin(), m_peer_orphanage_info.end(),
-        TxOrphanage::Usage{0}, [](TxOrphanage::Usage sum, const auto pair) { return sum + pair.second.m_total_usage; });
+        TxOrphanage::Usage{0}, [](TxOrphanage::Usage sum, const auto& pair) { return sum + pair.second.m_total_usage; });
     assert(summed_peer_usage >= m_unique_orphan_usage);
 
     // Cached m_unique_rounded_input_scores value is correct.
-    const auto calculated_total_latency_score = std::accumulate(unique_wtxids_to_scores.begin(), unique_wtxids_to_scores.end(),
-        TxOrphanage::Count{0}, [](TxOrphanage::Count sum, const auto pair) { return sum + pair.second.second; });
-    assert(calculated_total_latency_score == m_unique_rounded_input_scores);
+    assert(unique_rounded_input_scores == m_unique_rounded_input_scores);
 
     // Global latency score is deduplicated, should be less than or equal to the sum of all per-peer latency scores.
     const auto summed_peer_latency_score = std::accumulate(m_peer_orphanage_info.begin(), m_peer_orphanage_info.end(),
-        TxOrphanage::Count{0}, [](TxOrphanage::Count sum, const auto pair) { return sum + pair.second.m_total_latency_score; });
-    assert(summed_peer_latency_score >= m_unique_rounded_input_scores + m_orphans.size());
+        TxOrphanage::Count{0}, [](TxOrphanage::Count sum, const auto& pair) { return sum + pair.second.m_total_latency_score; });
+    assert(summed_peer_latency_score >= m_unique_rounded_input_scores + CountAnnouncements());
 }
 
 TxOrphanage::Count TxOrphanageImpl::MaxGlobalLatencyScore() const { return m_max_global_latency_score; }
-TxOrphanage::Count TxOrphanageImpl::TotalLatencyScore() const { return m_unique_rounded_input_scores + m_orphans.size(); }
+TxOrphanage::Count TxOrphanageImpl::TotalLatencyScore() const { return m_unique_rounded_input_scores + CountAnnouncements(); }
 TxOrphanage::Usage TxOrphanageImpl::ReservedPeerUsage() const { return m_reserved_usage_per_peer; }
 TxOrphanage::Count TxOrphanageImpl::MaxPeerLatencyScore() const { return m_max_global_latency_score / std::max<unsigned int>(m_peer_orphanage_info.size(), 1); }
 TxOrphanage::Usage TxOrphanageImpl::MaxGlobalUsage() const { return m_reserved_usage_per_peer * std::max<int64_t>(m_peer_orphanage_info.size(), 1); }
@@ -5,9 +5,18 @@
 #include <node/txreconciliation.h>
 
 #include <common/system.h>
+#include <crypto/siphash.h>
 #include <logging.h>
+#include <node/minisketchwrapper.h>
 #include <util/check.h>
 
+#include <minisketch.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <set>
 #include <unordered_map>
 #include <variant>
 
@@ -18,6 +27,12 @@ namespace {
 const std::string RECON_STATIC_SALT = "Tx Relay Salting";
 const HashWriter RECON_SALT_HASHER = TaggedHash(RECON_STATIC_SALT);
 
+/** Size in bytes of a short ID in serialized sketches. */
+constexpr size_t SKETCH_ELEMENT_BYTES{4};
+
+/** Sketches have spare capacity beyond the estimated set difference, so that a difference of the estimated size decodes to wrong transactions with a probability of about 2^-RECON_FALSE_POSITIVE_BITS. */
+constexpr uint32_t RECON_FALSE_POSITIVE_BITS{16};
+
 /**
  * Salt (specified by BIP-330) constructed from contributions from both peers. It is used
  * to compute transaction short IDs, which are then used to construct a sketch representing a set
@@ -29,6 +44,18 @@ uint256 ComputeSalt(uint64_t salt1, uint64_t salt2)
     return (HashWriter(RECON_SALT_HASHER) << std::min(salt1, salt2) << std::max(salt1, salt2)).GetSHA256();
 }
 
+/**
+ * Phase of the reconciliation in progress with a peer. Initiators go through the REQUESTED
+ * phases, responders through the RESPONDED ones.
+ */
+enum class Phase {
+    NONE,
+    INIT_REQUESTED,
+    EXT_REQUESTED,
+    INIT_RESPONDED,
+    EXT_RESPONDED,
+};
+
 /**
  * Keeps track of txreconciliation-related per-peer state.
  */
@@ -36,9 +63,6 @@ class TxReconciliationState
 {
 public:
     /**
-     * TODO: This field is public to ignore -Wunused-private-field. Make private once used in
-     * the following commits.
-     *
      * Reconciliation protocol assumes using one role consistently: either a reconciliation
      * initiator (requesting sketches), or responder (sending sketches). This defines our role,
      * based on the direction of the p2p connection.
@@ -47,14 +71,64 @@ public:
     bool m_we_initiate;
 
     /**
-     * TODO: These fields are public to ignore -Wunused-private-field. Make private once used in
-     * the following commits.
-     *
      * These values are used to salt short IDs, which is necessary for transaction reconciliations.
      */
     uint64_t m_k0, m_k1;
 
+    /** Transactions to be reconciled in the next reconciliation. */
+    std::set<Wtxid> m_local_set;
+
+    /**
+     * Transactions of the reconciliation in progress. Transactions added while a
+     * reconciliation is in progress wait for the next one.
+     */
+    std::set<Wtxid> m_local_snapshot;
+
+    Phase m_phase{Phase::NONE};
+
+    /** Phase the deadline below applies to, so that every phase gets its own deadline. */
+    Phase m_deadline_phase{Phase::NONE};
+
+    /** When the peer must have moved the reconciliation past m_deadline_phase. */
+    std::chrono::microseconds m_phase_deadline{0};
+
+    /** When to initiate the next reconciliation, if we are the initiator. */
+    std::chrono::microseconds m_next_request{0};
+
+    /** Coefficient q of the estimated set difference, learned from past reconciliations. */
+    double m_q{RECON_Q};
+
+    /** The initial sketch received from the peer, kept until its extension arrives. */
+    std::vector<uint8_t> m_remote_sketch;
+
+    /** Capacity of the initial sketch sent to the peer, if we are the responder. */
+    size_t m_sketch_capacity{0};
+
     TxReconciliationState(bool we_initiate, uint64_t k0, uint64_t k1) : m_we_initiate(we_initiate), m_k0(k0), m_k1(k1) {}
+
+    /** Short ID of a transaction in sketches, see BIP-330. */
+    uint32_t ComputeShortID(const Wtxid& wtxid) const
+    {
+        const uint64_t s{SipHashUint256(m_k0, m_k1, wtxid.ToUint256())};
+        return 1 + static_cast<uint32_t>(s % 0xFFFFFFFF);
+    }
+
+    /** Sketch of the given capacity of the reconciliation in progress. */
+    Minisketch ComputeSketch(size_t capacity) const
+    {
+        Minisketch sketch{node::MakeMinisketch32(capacity)};
+        for (const Wtxid& wtxid : m_local_snapshot) sketch.Add(ComputeShortID(wtxid));
+        return sketch;
+    }
+
+    /** Finish the reconciliation in progress. */
+    void Finish()
+    {
+        m_local_snapshot.clear();
+        m_remote_sketch.clear();
+        m_sketch_capacity = 0;
+        m_phase = Phase::NONE;
+    }
 };
 
 } // namespace
@@ -142,6 +216,213 @@ public:
         return (recon_state != m_states.end() &&
                 std::holds_alternative<TxReconciliationState>(recon_state->second));
     }
+
+    bool AddToSet(NodeId peer_id, const Wtxid& wtxid) EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        auto* state{GetRegisteredState(peer_id)};
+        if (!state) return false;
+        // Pick transactions for fanout by their short ID, which is random per peer.
+        if (state->ComputeShortID(wtxid) % RECON_FANOUT_INVERSE_RATE == 0) return false;
+        if (state->m_local_set.size() >= MAX_RECONSET_SIZE) return false;
+        // A transaction that is still being reconciled must not be in the next sketch again.
+        if (state->m_local_snapshot.contains(wtxid)) return true;
+        state->m_local_set.insert(wtxid);
+        return true;
+    }
+
+    std::optional<std::pair<uint16_t, uint16_t>> InitiateReconciliationRequest(NodeId peer_id, std::chrono::microseconds now)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        auto* state{GetRegisteredState(peer_id)};
+        if (!state || !state->m_we_initiate || state->m_phase != Phase::NONE || now < state->m_next_request) return std::nullopt;
+
+        state->m_next_request = now + RECON_REQUEST_INTERVAL;
+        state->m_local_snapshot = std::move(state->m_local_set);
+        state->m_local_set.clear();
+        state->m_phase = Phase::INIT_REQUESTED;
+        state->m_deadline_phase = Phase::INIT_REQUESTED;
+        state->m_phase_deadline = now + RECON_RESPONSE_TIMEOUT;
+        LogPrintLevel(BCLog::TXRECONCILIATION, BCLog::Level::Debug, "Request reconciliation of %u transactions from peer=%d\n",
+                      state->m_local_snapshot.size(), peer_id);
+        return std::make_pair(static_cast<uint16_t>(state->m_local_snapshot.size()),
+                              static_cast<uint16_t>(std::lround(state->m_q * Q_PRECISION)));
+    }
+
+    std::optional<std::vector<uint8_t>> HandleReconciliationRequest(NodeId peer_id, uint16_t remote_set_size, uint16_t remote_q)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        auto* state{GetRegisteredState(peer_id)};
+        if (!state || state->m_we_initiate || state->m_phase != Phase::NONE) return std::nullopt;
+
+        state->m_local_snapshot = std::move(state->m_local_set);
+        state->m_local_set.clear();
+
+        // Estimate the set difference as described in BIP-330.
+        const size_t local_set_size{state->m_local_snapshot.size()};
+        const double q{double(remote_q) / Q_PRECISION};
+        const size_t set_size_diff{local_set_size > remote_set_size ? local_set_size - remote_set_size : remote_set_size - local_set_size};
+        const size_t estimated_diff{set_size_diff + static_cast<size_t>(std::ceil(q * std::min<size_t>(local_set_size, remote_set_size))) + 1};
+        if (estimated_diff > MAX_SKETCH_CAPACITY) {
+            // An empty sketch makes the initiator fall back to announcing all transactions.
+            LogPrintLevel(BCLog::TXRECONCILIATION, BCLog::Level::Debug, "Estimated set difference of %u with peer=%d is too large to reconcile\n",
+                          estimated_diff, peer_id);
+            state->m_phase = Phase::EXT_RESPONDED;
+            return std::vector<uint8_t>{};
+        }
+
+        Minisketch sketch{node::MakeMinisketch32FP(estimated_diff, RECON_FALSE_POSITIVE_BITS)};
+        // The extension doubles the capacity, which must still be accepted by the initiator.
+        state->m_sketch_capacity = std::min(sketch.GetCapacity(), MAX_SKETCH_CAPACITY);
+        sketch = state->ComputeSketch(state->m_sketch_capacity);
+        state->m_phase = Phase::INIT_RESPONDED;
+        return sketch.Serialize();
+    }
+
+    std::optional<TxReconciliationTracker::SketchResult> HandleSketch(NodeId peer_id, std::span<const uint8_t> skdata)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        auto* state{GetRegisteredState(peer_id)};
+        if (!state || !state->m_we_initiate) return std::nullopt;
+        if (state->m_phase != Phase::INIT_REQUESTED && state->m_phase != Phase::EXT_REQUESTED) return std::nullopt;
+        if (skdata.size() % SKETCH_ELEMENT_BYTES != 0) return std::nullopt;
+
+        TxReconciliationTracker::SketchResult result;
+        const auto fail{[&] {
+            LogPrintLevel(BCLog::TXRECONCILIATION, BCLog::Level::Debug, "Reconciliation with peer=%d failed, announcing %u transactions\n",
+                          peer_id, state->m_local_snapshot.size());
+            result.announce.assign(state->m_local_snapshot.begin(), state->m_local_snapshot.end());
+            state->Finish();
+            return result;
+        }};
+
+        std::vector<uint8_t> remote_sketch;
+        if (state->m_phase == Phase::INIT_REQUESTED) {
+            if (skdata.size() > MAX_SKETCH_CAPACITY * SKETCH_ELEMENT_BYTES) return std::nullopt;
+            // The responder gave up on reconciling.
+            if (skdata.empty()) return fail();
+            remote_sketch.assign(skdata.begin(), skdata.end());
+        } else {
+            // The extension holds as many elements as the initial sketch.
+            if (skdata.size() != state->m_remote_sketch.size()) return std::nullopt;
+            remote_sketch = std::move(state->m_remote_sketch);
+            remote_sketch.insert(remote_sketch.end(), skdata.begin(), skdata.end());
+        }
+
+        const size_t capacity{remote_sketch.size() / SKETCH_ELEMENT_BYTES};
+        Minisketch sketch{state->ComputeSketch(capacity)};
+        sketch.Merge(node::MakeMinisketch32(capacity).Deserialize(remote_sketch));
+        const auto diff{sketch.DecodeFP(RECON_FALSE_POSITIVE_BITS)};
+        if (!diff) {
+            if (state->m_phase == Phase::EXT_REQUESTED) return fail();
+            state->m_remote_sketch = std::move(remote_sketch);
+            state->m_phase = Phase::EXT_REQUESTED;
+            result.request_extension = true;
+            return result;
+        }
+
+        std::map<uint32_t, Wtxid> local_shortids;
+        for (const Wtxid& wtxid : state->m_local_snapshot) local_shortids.emplace(state->ComputeShortID(wtxid), wtxid);
+        for (const uint64_t shortid : *diff) {
+            if (const auto it{local_shortids.find(shortid)}; it != local_shortids.end()) {
+                result.announce.push_back(it->second);
+            } else {
+                result.ask_shortids.push_back(shortid);
+            }
+        }
+        result.success = true;
+
+        // Learn q from the actual set difference, see BIP-330.
+        const size_t local_set_size{state->m_local_snapshot.size()};
+        const size_t remote_set_size{local_set_size - result.announce.size() + result.ask_shortids.size()};
+        const size_t min_set_size{std::min(local_set_size, remote_set_size)};
+        if (min_set_size > 0) {
+            const double set_size_diff{std::abs(double(local_set_size) - double(remote_set_size))};
+            state->m_q = std::clamp((diff->size() - set_size_diff) / min_set_size, 0.0, double(std::numeric_limits<uint16_t>::max()) / Q_PRECISION);
+        }
+        LogPrintLevel(BCLog::TXRECONCILIATION, BCLog::Level::Debug, "Reconciliation with peer=%d succeeded: %u transactions to announce, %u to request\n",
+                      peer_id, result.announce.size(), result.ask_shortids.size());
+        state->Finish();
+        return result;
+    }
+
+    std::optional<std::vector<uint8_t>> HandleSketchExtensionRequest(NodeId peer_id) EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        auto* state{GetRegisteredState(peer_id)};
+        if (!state || state->m_we_initiate || state->m_phase != Phase::INIT_RESPONDED) return std::nullopt;
+
+        // A sketch of twice the capacity starts with the initial sketch, so only send the rest.
+        std::vector<uint8_t> skdata{state->ComputeSketch(2 * state->m_sketch_capacity).Serialize()};
+        skdata.erase(skdata.begin(), skdata.begin() + state->m_sketch_capacity * SKETCH_ELEMENT_BYTES);
+        state->m_phase = Phase::EXT_RESPONDED;
+        return skdata;
+    }
+
+    std::optional<std::vector<Wtxid>> HandleReconciliationDifference(NodeId peer_id, bool success, std::span<const uint32_t> ask_shortids)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        auto* state{GetRegisteredState(peer_id)};
+        if (!state || state->m_we_initiate) return std::nullopt;
+        if (state->m_phase != Phase::INIT_RESPONDED && state->m_phase != Phase::EXT_RESPONDED) return std::nullopt;
+
+        std::vector<Wtxid> announce;
+        if (success) {
+            const std::set<uint32_t> asked(ask_shortids.begin(), ask_shortids.end());
+            for (const Wtxid& wtxid : state->m_local_snapshot) {
+                if (asked.contains(state->ComputeShortID(wtxid))) announce.push_back(wtxid);
+            }
+        } else {
+            announce.assign(state->m_local_snapshot.begin(), state->m_local_snapshot.end());
+        }
+        state->Finish();
+        return announce;
+    }
+
+    std::vector<Wtxid> ExpireReconciliation(NodeId peer_id, std::chrono::microseconds now)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_txreconciliation_mutex)
+    {
+        AssertLockNotHeld(m_txreconciliation_mutex);
+        LOCK(m_txreconciliation_mutex);
+        auto* state{GetRegisteredState(peer_id)};
+        if (!state || state->m_phase == Phase::NONE) return {};
+
+        // Phases entered while handling a message start their deadline on the first check.
+        if (state->m_deadline_phase != state->m_phase) {
+            state->m_deadline_phase = state->m_phase;
+            state->m_phase_deadline = now + RECON_RESPONSE_TIMEOUT;
+            return {};
+        }
+        if (now < state->m_phase_deadline) return {};
+
+        // Announce everything the peer may be missing, including the transactions that piled
+        // up meanwhile, so that relay to the peer does not stall behind it.
+        std::vector<Wtxid> announce(state->m_local_snapshot.begin(), state->m_local_snapshot.end());
+        announce.insert(announce.end(), state->m_local_set.begin(), state->m_local_set.end());
+        LogPrintLevel(BCLog::TXRECONCILIATION, BCLog::Level::Debug, "Reconciliation with peer=%d timed out, announcing %u transactions\n",
+                      peer_id, announce.size());
+        state->m_local_set.clear();
+        state->Finish();
+        return announce;
+    }
+
+private:
+    TxReconciliationState* GetRegisteredState(NodeId peer_id) EXCLUSIVE_LOCKS_REQUIRED(m_txreconciliation_mutex)
+    {
+        auto recon_state = m_states.find(peer_id);
+        if (recon_state == m_states.end()) return nullptr;
+        return std::get_if<TxReconciliationState>(&recon_state->second);
+    }
 };
 
 TxReconciliationTracker::TxReconciliationTracker(uint32_t recon_version) : m_impl{std::make_unique<TxReconciliationTracker::Impl>(recon_version)} {}
@@ -168,3 +449,38 @@ bool TxReconciliationTracker::IsPeerRegistered(NodeId peer_id) const
 {
     return m_impl->IsPeerRegistered(peer_id);
 }
+
+bool TxReconciliationTracker::AddToSet(NodeId peer_id, const Wtxid& wtxid)
+{
+    return m_impl->AddToSet(peer_id, wtxid);
+}
+
+std::optional<std::pair<uint16_t, uint16_t>> TxReconciliationTracker::InitiateReconciliationRequest(NodeId peer_id, std::chrono::microseconds now)
+{
+    return m_impl->InitiateReconciliationRequest(peer_id, now);
+}
+
+std::optional<std::vector<uint8_t>> TxReconciliationTracker::HandleReconciliationRequest(NodeId peer_id, uint16_t remote_set_size, uint16_t remote_q)
+{
+    return m_impl->HandleReconciliationRequest(peer_id, remote_set_size, remote_q);
+}
+
+std::optional<TxReconciliationTracker::SketchResult> TxReconciliationTracker::HandleSketch(NodeId peer_id, std::span<const uint8_t> skdata)
+{
+    return m_impl->HandleSketch(peer_id, skdata);
+}
+
+std::optional<std::vector<uint8_t>> TxReconciliationTracker::HandleSketchExtensionRequest(NodeId peer_id)
+{
+    return m_impl->HandleSketchExtensionRequest(peer_id);
+}
+
+std::optional<std::vector<Wtxid>> TxReconciliationTracker::HandleReconciliationDifference(NodeId peer_id, bool success, std::span<const uint32_t> ask_shortids)
+{
+    return m_impl->HandleReconciliationDifference(peer_id, success, ask_shortids);
+}
+
+std::vector<Wtxid> TxReconciliationTracker::ExpireReconciliation(NodeId peer_id, std::chrono::microseconds now)
+{
+    return m_impl->ExpireReconciliation(peer_id, now);
+}
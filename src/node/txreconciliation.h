@@ -7,12 +7,46 @@
 
 #include <net.h>
 #include <sync.h>
+#include <util/transaction_identifier.h>
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <optional>
+#include <span>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 /** Supported transaction reconciliation protocol version */
 static constexpr uint32_t TXRECONCILIATION_VERSION{1};
+/** Interval between reconciliation requests to a peer we initiate reconciliations with. */
+static constexpr std::chrono::seconds RECON_REQUEST_INTERVAL{8};
+/**
+ * How long a peer may take to send its next message of a reconciliation in progress, before
+ * we give up on the reconciliation and announce the transactions with INVs instead.
+ */
+static constexpr std::chrono::seconds RECON_RESPONSE_TIMEOUT{30};
+/**
+ * Maximum number of transactions waiting to be reconciled with a peer. Transactions beyond
+ * that are announced to the peer with an INV.
+ */
+static constexpr size_t MAX_RECONSET_SIZE{3000};
+/**
+ * Maximum capacity of a sketch. Decoding a sketch takes time quadratic in its capacity, so
+ * larger set differences are announced in full instead.
+ */
+static constexpr size_t MAX_SKETCH_CAPACITY{1 << 10};
+/** Default coefficient q of the estimated set difference, see BIP-330. */
+static constexpr double RECON_Q{0.25};
+/** Scale of q in reqrecon messages, see BIP-330. */
+static constexpr uint16_t Q_PRECISION{(2 << 14) - 1};
+/**
+ * One in this many transactions are announced to a peer we reconcile with by INV anyway, so
+ * that they still propagate quickly through the network.
+ */
+static constexpr uint32_t RECON_FANOUT_INVERSE_RATE{10};
 
 enum class ReconciliationRegisterResult {
     NOT_FOUND,
@@ -84,6 +118,67 @@ public:
      * Check if a peer is registered to reconcile transactions with us.
      */
     bool IsPeerRegistered(NodeId peer_id) const;
+
+    /**
+     * Step 1. Add a transaction to the reconciliation set of the peer. Returns false if the
+     * transaction should be announced to the peer with an INV instead: the peer is not
+     * registered, the transaction was picked for fanout to the peer, or the set is full.
+     */
+    bool AddToSet(NodeId peer_id, const Wtxid& wtxid);
+
+    /**
+     * Step 2. If we initiate reconciliations with the peer, no reconciliation is in progress,
+     * and RECON_REQUEST_INTERVAL passed since the last one, start a reconciliation. Returns
+     * the size of our reconciliation set and the q coefficient to send in a reqrecon message.
+     */
+    std::optional<std::pair<uint16_t, uint16_t>> InitiateReconciliationRequest(NodeId peer_id, std::chrono::microseconds now);
+
+    /**
+     * Step 2. Respond to a reqrecon message from the peer. Returns the sketch of our
+     * reconciliation set to send in a sketch message, which is empty if the estimated set
+     * difference is too large to reconcile, or std::nullopt if the request violates the
+     * protocol.
+     */
+    std::optional<std::vector<uint8_t>> HandleReconciliationRequest(NodeId peer_id, uint16_t remote_set_size, uint16_t remote_q);
+
+    /** What to send to the peer after processing its sketch, see HandleSketch. */
+    struct SketchResult {
+        //! Whether the sketch could not be decoded and an extension should be requested with reqsketchext.
+        bool request_extension{false};
+        //! Whether the set difference was found, to send in the reconcildiff message.
+        bool success{false};
+        //! Short IDs of the transactions the peer has and we are missing, to send in the reconcildiff message.
+        std::vector<uint32_t> ask_shortids;
+        //! Transactions the peer is missing, or the whole reconciliation set if the reconciliation failed, to announce with INVs.
+        std::vector<Wtxid> announce;
+    };
+
+    /**
+     * Step 3. Process a sketch message from the peer, in response to a reqrecon or
+     * reqsketchext message. Returns std::nullopt if the sketch violates the protocol.
+     */
+    std::optional<SketchResult> HandleSketch(NodeId peer_id, std::span<const uint8_t> skdata);
+
+    /**
+     * Step 4b. Respond to a reqsketchext message from the peer. Returns the sketch extension
+     * to send in a sketch message, or std::nullopt if the request violates the protocol.
+     */
+    std::optional<std::vector<uint8_t>> HandleSketchExtensionRequest(NodeId peer_id);
+
+    /**
+     * Step 4. Process a reconcildiff message from the peer. Returns the transactions the peer
+     * asked for, or the whole reconciliation set if the reconciliation failed, to announce
+     * with INVs, or std::nullopt if the message violates the protocol.
+     */
+    std::optional<std::vector<Wtxid>> HandleReconciliationDifference(NodeId peer_id, bool success, std::span<const uint32_t> ask_shortids);
+
+    /**
+     * Give up on the reconciliation in progress if the peer has not moved it to the next phase
+     * within RECON_RESPONSE_TIMEOUT. Returns the transactions of the reconciliation and those
+     * waiting for the next one, to announce with INVs. A late message of the abandoned
+     * reconciliation is then a protocol violation.
+     */
+    std::vector<Wtxid> ExpireReconciliation(NodeId peer_id, std::chrono::microseconds now);
 };
 
 #endif // BITCOIN_NODE_TXRECONCILIATION_H
@@ -8,9 +8,15 @@
 
 #include <primitives/transaction.h>
 #include <serialize.h>
+#include <streams.h>
 #include <uint256.h>
 #include <util/time.h>
 
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
 /** Nodes collect new transactions into a block, hash them into a hash tree,
  * and scan through nonce values to make the block's hash satisfy proof-of-work
  * requirements.  When they solve the proof-of-work, they broadcast the block
@@ -87,9 +93,41 @@ public:
         *(static_cast<CBlockHeader*>(this)) = header;
     }
 
-    SERIALIZE_METHODS(CBlock, obj)
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        s << AsBase<CBlockHeader>(*this) << vtx;
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
     {
-        READWRITE(AsBase<CBlockHeader>(obj), obj.vtx);
+        s >> AsBase<CBlockHeader>(*this);
+        // Read the transactions first, so that their hashes can be computed
+        // together.
+        std::vector<CMutableTransaction> txs;
+        if constexpr (requires { s.GetStream().data(); s.GetStream().size(); }) {
+            // The block is read from memory, so hash each transaction from the
+            // bytes it was read from. They are read through a SpanReader, and
+            // only consumed from the stream at the end, so that these bytes
+            // stay valid until then.
+            auto& stream{s.GetStream()};
+            SpanReader reader{std::span{stream.data(), stream.size()}};
+            ParamsStream tx_reader{reader, s.template GetParams<TransactionSerParams>()};
+            const uint64_t count{ReadCompactSize(tx_reader)};
+            std::vector<std::span<const std::byte>> serialized;
+            while (txs.size() < count) {
+                const std::byte* const begin{reader.data()};
+                const size_t size{reader.size()};
+                tx_reader >> txs.emplace_back();
+                serialized.emplace_back(begin, size - reader.size());
+            }
+            vtx = MakeTransactionRefs(std::move(txs), serialized);
+            stream.ignore(stream.size() - reader.size());
+        } else {
+            s >> txs;
+            vtx = MakeTransactionRefs(std::move(txs));
+        }
     }
 
     void SetNull()
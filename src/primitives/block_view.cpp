@@ -0,0 +1,162 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <primitives/block_view.h>
+
+#include <hash.h>
+#include <serialize.h>
+#include <span.h>
+#include <streams.h>
+
+#include <ios>
+
+namespace {
+/** Reads a serialization in place, returning variable-length fields as spans into it. */
+class ViewReader
+{
+    SpanReader m_reader;
+
+public:
+    explicit ViewReader(std::span<const std::byte> data) : m_reader{data} {}
+
+    const std::byte* Pos() const { return m_reader.data(); }
+
+    template <typename T>
+    T Read()
+    {
+        T obj;
+        m_reader >> obj;
+        return obj;
+    }
+
+    uint64_t ReadCount() { return ReadCompactSize(m_reader); }
+
+    //! Read a size-prefixed byte vector, like a script or a witness item.
+    std::span<const unsigned char> ReadBytes()
+    {
+        const uint64_t size{ReadCompactSize(m_reader)};
+        if (size > m_reader.size()) throw std::ios_base::failure("ViewReader::ReadBytes(): end of data");
+        const std::span<const unsigned char> bytes{UCharCast(m_reader.data()), size};
+        m_reader.ignore(size);
+        return bytes;
+    }
+};
+
+//! A range of the elements of one of the arrays of a BlockView.
+struct Range {
+    size_t begin;
+    size_t count;
+};
+} // namespace
+
+BlockView::BlockView(std::span<const std::byte> serialized)
+{
+    ViewReader reader{serialized};
+    header = reader.Read<CBlockHeader>();
+
+    // While parsing, the arrays may still grow, so the ranges of each
+    // transaction and input are only turned into spans at the end.
+    std::vector<Range> tx_inputs, tx_outputs, input_witnesses;
+    const uint64_t tx_count{reader.ReadCount()};
+    for (uint64_t i = 0; i < tx_count; ++i) {
+        BlockTxView& tx{m_txs.emplace_back()};
+        const std::byte* const tx_begin{reader.Pos()};
+        const size_t inputs_begin{m_inputs.size()}, outputs_begin{m_outputs.size()};
+        const auto read_inputs = [&] {
+            const uint64_t count{reader.ReadCount()};
+            for (uint64_t j = 0; j < count; ++j) {
+                TxInView& txin{m_inputs.emplace_back()};
+                txin.prevout = reader.Read<COutPoint>();
+                txin.scriptSig = reader.ReadBytes();
+                txin.nSequence = reader.Read<uint32_t>();
+            }
+            return count;
+        };
+        const auto read_outputs = [&] {
+            const uint64_t count{reader.ReadCount()};
+            for (uint64_t j = 0; j < count; ++j) {
+                TxOutView& txout{m_outputs.emplace_back()};
+                txout.nValue = reader.Read<CAmount>();
+                txout.scriptPubKey = reader.ReadBytes();
+            }
+        };
+
+        // See UnserializeTransaction.
+        tx.version = reader.Read<uint32_t>();
+        unsigned char flags = 0;
+        if (read_inputs() == 0) {
+            flags = reader.Read<unsigned char>();
+            if (flags != 0) {
+                read_inputs();
+                read_outputs();
+            }
+        } else {
+            read_outputs();
+        }
+        const size_t input_count{m_inputs.size() - inputs_begin};
+        if (flags & 1) {
+            flags ^= 1;
+            const std::byte* const witness_begin{reader.Pos()};
+            bool has_witness{false};
+            for (size_t j = 0; j < input_count; ++j) {
+                const uint64_t count{reader.ReadCount()};
+                input_witnesses.push_back({m_witness_items.size(), count});
+                for (uint64_t k = 0; k < count; ++k) m_witness_items.push_back(reader.ReadBytes());
+                has_witness |= count > 0;
+            }
+            if (!has_witness) throw std::ios_base::failure("Superfluous witness record");
+            tx.m_witness_offset = witness_begin - tx_begin;
+            tx.m_witness_size = reader.Pos() - witness_begin;
+        } else {
+            input_witnesses.resize(input_witnesses.size() + input_count, {m_witness_items.size(), 0});
+        }
+        if (flags) throw std::ios_base::failure("Unknown transaction optional data");
+        tx.nLockTime = reader.Read<uint32_t>();
+
+        tx.m_serialized = {tx_begin, reader.Pos()};
+        tx_inputs.push_back({inputs_begin, input_count});
+        tx_outputs.push_back({outputs_begin, m_outputs.size() - outputs_begin});
+    }
+    m_serialized = serialized.first(reader.Pos() - serialized.data());
+
+    for (size_t i = 0; i < m_inputs.size(); ++i) {
+        m_inputs[i].witness = std::span{m_witness_items}.subspan(input_witnesses[i].begin, input_witnesses[i].count);
+    }
+    for (size_t i = 0; i < m_txs.size(); ++i) {
+        m_txs[i].vin = std::span{m_inputs}.subspan(tx_inputs[i].begin, tx_inputs[i].count);
+        m_txs[i].vout = std::span{m_outputs}.subspan(tx_outputs[i].begin, tx_outputs[i].count);
+    }
+}
+
+size_t BlockView::GetStrippedSize() const
+{
+    size_t size{::GetSerializeSize(header) + GetSizeOfCompactSize(m_txs.size())};
+    for (const BlockTxView& tx : m_txs) size += tx.GetStrippedSize();
+    return size;
+}
+
+CBlock BlockView::ToBlock() const
+{
+    CBlock block;
+    SpanReader{m_serialized} >> TX_WITH_WITNESS(block);
+    return block;
+}
+
+Txid BlockTxView::GetHash() const
+{
+    if (!HasWitness()) return Txid::FromUint256(Hash(m_serialized));
+    // The serialization without the marker, flag and witness stacks.
+    uint256 hash;
+    CHash256()
+        .Write(MakeUCharSpan(m_serialized.first(4)))
+        .Write(MakeUCharSpan(m_serialized.subspan(6, m_witness_offset - 6)))
+        .Write(MakeUCharSpan(m_serialized.last(4)))
+        .Finalize(hash);
+    return Txid::FromUint256(hash);
+}
+
+Wtxid BlockTxView::GetWitnessHash() const
+{
+    return Wtxid::FromUint256(Hash(m_serialized));
+}
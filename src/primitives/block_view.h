@@ -0,0 +1,120 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_PRIMITIVES_BLOCK_VIEW_H
+#define BITCOIN_PRIMITIVES_BLOCK_VIEW_H
+
+#include <consensus/amount.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <util/transaction_identifier.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/** An input of a BlockTxView. */
+struct TxInView {
+    COutPoint prevout;
+    std::span<const unsigned char> scriptSig;
+    uint32_t nSequence;
+    //! The items of the witness stack, empty if the input has no witness.
+    std::span<const std::span<const unsigned char>> witness;
+};
+
+/** An output of a BlockTxView. */
+struct TxOutView {
+    CAmount nValue;
+    std::span<const unsigned char> scriptPubKey;
+};
+
+/**
+ * A read-only transaction of a BlockView.
+ *
+ * Scripts and witness items refer to the serialized block, and the inputs and
+ * outputs to arrays shared by all transactions of the block, so it remains
+ * valid only as long as both the BlockView and the buffer it was parsed from.
+ */
+class BlockTxView
+{
+public:
+    uint32_t version;
+    std::span<const TxInView> vin;
+    std::span<const TxOutView> vout;
+    uint32_t nLockTime;
+
+    bool IsCoinBase() const { return vin.size() == 1 && vin[0].prevout.IsNull(); }
+    bool HasWitness() const { return m_witness_size > 0; }
+
+    //! The serialized transaction, including witness data.
+    std::span<const std::byte> Serialized() const { return m_serialized; }
+    size_t GetTotalSize() const { return m_serialized.size(); }
+    //! The size of the serialization without witness data.
+    size_t GetStrippedSize() const { return HasWitness() ? m_serialized.size() - 2 - m_witness_size : m_serialized.size(); }
+
+    Txid GetHash() const;
+    Wtxid GetWitnessHash() const;
+
+private:
+    friend class BlockView;
+
+    std::span<const std::byte> m_serialized;
+    //! Position and size of the witness stacks in m_serialized, or 0 if there are none.
+    size_t m_witness_offset{0};
+    size_t m_witness_size{0};
+};
+
+/**
+ * A read-only block that references its serialization instead of copying it.
+ *
+ * Parsing a CBlock allocates every transaction, its inputs and outputs, each
+ * script that does not fit in a CScript's inline storage, and every witness
+ * stack and item. A BlockView instead stores the inputs, outputs and witness
+ * items of all its transactions in one array each, with scripts and witness
+ * items as spans into the serialized block.
+ *
+ * Useful for code that only reads blocks, such as context-free validation
+ * (see CheckBlock) and indexing. Use ToBlock() where a CBlock is needed.
+ */
+class BlockView
+{
+public:
+    CBlockHeader header;
+
+    /**
+     * Parse the witness serialization of a block at the start of serialized,
+     * which must outlive the view.
+     *
+     * @throws std::ios_base::failure if it is not a valid serialization,
+     *         whenever deserializing a CBlock would.
+     */
+    explicit BlockView(std::span<const std::byte> serialized);
+
+    // The transactions refer to the arrays owned by the view, which a copy
+    // would not own. A move does not reallocate them.
+    BlockView(const BlockView&) = delete;
+    BlockView& operator=(const BlockView&) = delete;
+    BlockView(BlockView&&) = default;
+    BlockView& operator=(BlockView&&) = default;
+
+    std::span<const BlockTxView> Transactions() const { return m_txs; }
+
+    //! The part of the buffer the block was parsed from.
+    std::span<const std::byte> Serialized() const { return m_serialized; }
+    //! The size of the serialization without witness data.
+    size_t GetStrippedSize() const;
+
+    //! Deserialize the block into a CBlock.
+    CBlock ToBlock() const;
+
+private:
+    std::span<const std::byte> m_serialized;
+    std::vector<BlockTxView> m_txs;
+    std::vector<TxInView> m_inputs;
+    std::vector<TxOutView> m_outputs;
+    std::vector<std::span<const unsigned char>> m_witness_items;
+};
+
+#endif // BITCOIN_PRIMITIVES_BLOCK_VIEW_H
@@ -7,16 +7,22 @@
 
 #include <consensus/amount.h>
 #include <crypto/hex_base.h>
+#include <crypto/sha256.h>
 #include <hash.h>
 #include <script/script.h>
 #include <serialize.h>
+#include <span.h>
+#include <streams.h>
 #include <tinyformat.h>
 #include <uint256.h>
 #include <util/transaction_identifier.h>
 
 #include <algorithm>
 #include <cassert>
+#include <span>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 std::string COutPoint::ToString() const
 {
@@ -94,6 +100,99 @@ Wtxid CTransaction::ComputeWitnessHash() const
 
 CTransaction::CTransaction(const CMutableTransaction& tx) : vin(tx.vin), vout(tx.vout), version{tx.version}, nLockTime{tx.nLockTime}, m_has_witness{ComputeHasWitness()}, hash{ComputeHash()}, m_witness_hash{ComputeWitnessHash()} {}
 CTransaction::CTransaction(CMutableTransaction&& tx) : vin(std::move(tx.vin)), vout(std::move(tx.vout)), version{tx.version}, nLockTime{tx.nLockTime}, m_has_witness{ComputeHasWitness()}, hash{ComputeHash()}, m_witness_hash{ComputeWitnessHash()} {}
+CTransaction::CTransaction(CMutableTransaction&& tx, const Txid& txid, const Wtxid& wtxid) : vin(std::move(tx.vin)), vout(std::move(tx.vout)), version{tx.version}, nLockTime{tx.nLockTime}, m_has_witness{ComputeHasWitness()}, hash{txid}, m_witness_hash{wtxid} {}
+
+namespace {
+/** The number of bytes the witness stacks of tx take up in its serialization. */
+size_t GetWitnessSize(const CMutableTransaction& tx)
+{
+    size_t size{0};
+    for (const auto& input : tx.vin) {
+        size += GetSizeOfCompactSize(input.scriptWitness.stack.size());
+        for (const auto& item : input.scriptWitness.stack) size += GetSizeOfCompactSize(item.size()) + item.size();
+    }
+    return size;
+}
+
+/**
+ * Construct CTransactions from txs, given their serializations without
+ * witness, followed by the serializations with witness of the transactions
+ * that have one.
+ */
+std::vector<CTransactionRef> HashTransactions(std::vector<CMutableTransaction>&& txs, std::span<const std::span<const unsigned char>> messages)
+{
+    std::vector<unsigned char> hashes(CSHA256::OUTPUT_SIZE * messages.size());
+    SHA256DMulti(hashes.data(), messages);
+    const auto hash_at{[&](size_t i) { return uint256{std::span{hashes}.subspan(CSHA256::OUTPUT_SIZE * i, CSHA256::OUTPUT_SIZE)}; }};
+
+    std::vector<CTransactionRef> ret;
+    ret.reserve(txs.size());
+    size_t next_witness{txs.size()};
+    for (size_t i{0}; i < txs.size(); ++i) {
+        const Txid txid{Txid::FromUint256(hash_at(i))};
+        const Wtxid wtxid{txs[i].HasWitness() ? Wtxid::FromUint256(hash_at(next_witness++)) : Wtxid::FromUint256(txid.ToUint256())};
+        ret.push_back(std::make_shared<const CTransaction>(std::move(txs[i]), txid, wtxid));
+    }
+    return ret;
+}
+} // namespace
+
+std::vector<CTransactionRef> MakeTransactionRefs(std::vector<CMutableTransaction>&& txs)
+{
+    std::vector<unsigned char> serialized;
+    std::vector<std::pair<size_t, size_t>> ranges;
+    const auto append{[&](const auto& tx_with_params) {
+        const size_t begin{serialized.size()};
+        VectorWriter{serialized, begin} << tx_with_params;
+        ranges.emplace_back(begin, serialized.size() - begin);
+    }};
+    for (const auto& tx : txs) append(TX_NO_WITNESS(tx));
+    for (const auto& tx : txs) {
+        if (tx.HasWitness()) append(TX_WITH_WITNESS(tx));
+    }
+
+    std::vector<std::span<const unsigned char>> messages;
+    messages.reserve(ranges.size());
+    for (const auto& [begin, size] : ranges) messages.emplace_back(serialized.data() + begin, size);
+    return HashTransactions(std::move(txs), messages);
+}
+
+std::vector<CTransactionRef> MakeTransactionRefs(std::vector<CMutableTransaction>&& txs, std::span<const std::span<const std::byte>> serialized)
+{
+    assert(txs.size() == serialized.size());
+    // A transaction without witness was read from its serialization without
+    // witness, which is hashed as is. For one with a witness, its txid covers
+    // all but the marker, flag and witness stacks, which are cut out of a
+    // copy.
+    std::vector<unsigned char> stripped;
+    std::vector<std::pair<size_t, size_t>> stripped_ranges;
+    for (size_t i{0}; i < txs.size(); ++i) {
+        if (!txs[i].HasWitness()) continue;
+        const auto bytes{UCharSpanCast(serialized[i])};
+        const size_t begin{stripped.size()};
+        const size_t witness_begin{bytes.size() - sizeof(uint32_t) - GetWitnessSize(txs[i])};
+        stripped.insert(stripped.end(), bytes.begin(), bytes.begin() + sizeof(uint32_t));
+        stripped.insert(stripped.end(), bytes.begin() + sizeof(uint32_t) + 2, bytes.begin() + witness_begin);
+        stripped.insert(stripped.end(), bytes.end() - sizeof(uint32_t), bytes.end());
+        stripped_ranges.emplace_back(begin, stripped.size() - begin);
+    }
+
+    std::vector<std::span<const unsigned char>> messages;
+    messages.reserve(txs.size() + stripped_ranges.size());
+    auto stripped_range{stripped_ranges.begin()};
+    for (size_t i{0}; i < txs.size(); ++i) {
+        if (txs[i].HasWitness()) {
+            messages.emplace_back(stripped.data() + stripped_range->first, stripped_range->second);
+            ++stripped_range;
+        } else {
+            messages.push_back(UCharSpanCast(serialized[i]));
+        }
+    }
+    for (size_t i{0}; i < txs.size(); ++i) {
+        if (txs[i].HasWitness()) messages.push_back(UCharSpanCast(serialized[i]));
+    }
+    return HashTransactions(std::move(txs), messages);
+}
 
 CAmount CTransaction::GetValueOut() const
 {
@@ -323,6 +323,9 @@ public:
     /** Convert a CMutableTransaction into a CTransaction. */
     explicit CTransaction(const CMutableTransaction& tx);
     explicit CTransaction(CMutableTransaction&& tx);
+    /** Convert a CMutableTransaction whose txid and wtxid were already computed
+     *  (see MakeTransactionRefs). They are not checked. */
+    CTransaction(CMutableTransaction&& tx, const Txid& txid, const Wtxid& wtxid);
 
     template <typename Stream>
     inline void Serialize(Stream& s) const {
@@ -423,4 +426,14 @@ struct CMutableTransaction
 typedef std::shared_ptr<const CTransaction> CTransactionRef;
 template <typename Tx> static inline CTransactionRef MakeTransactionRef(Tx&& txIn) { return std::make_shared<const CTransaction>(std::forward<Tx>(txIn)); }
 
+/** Convert a batch of CMutableTransactions, such as those of a block, into
+ *  CTransactions. Their txids and wtxids are computed together with
+ *  SHA256DMulti, which is faster than hashing them one at a time. */
+std::vector<CTransactionRef> MakeTransactionRefs(std::vector<CMutableTransaction>&& txs);
+
+/** Like MakeTransactionRefs, but hash the transactions straight from the bytes
+ *  they were deserialized from, instead of serializing them again.
+ *  serialized[i] must be exactly the bytes txs[i] was read from. */
+std::vector<CTransactionRef> MakeTransactionRefs(std::vector<CMutableTransaction>&& txs, std::span<const std::span<const std::byte>> serialized);
+
 #endif // BITCOIN_PRIMITIVES_TRANSACTION_H
@@ -264,6 +264,27 @@ inline constexpr const char* WTXIDRELAY{"wtxidrelay"};
  * txreconciliation, as described by BIP 330.
  */
 inline constexpr const char* SENDTXRCNCL{"sendtxrcncl"};
+/**
+ * Contains the size of the reconciliation set of the sender and the q
+ * coefficient used to estimate the set difference, and requests a sketch of
+ * the reconciliation set of the receiver, as described by BIP 330.
+ */
+inline constexpr const char* REQRECON{"reqrecon"};
+/**
+ * Contains a sketch of the reconciliation set of the sender, in response to
+ * a reqrecon or reqsketchext message, as described by BIP 330.
+ */
+inline constexpr const char* SKETCH{"sketch"};
+/**
+ * Requests an extension of the sketch which could not be decoded, as
+ * described by BIP 330.
+ */
+inline constexpr const char* REQSKETCHEXT{"reqsketchext"};
+/**
+ * Contains the outcome of a reconciliation and the short IDs of the
+ * transactions the sender is missing, as described by BIP 330.
+ */
+inline constexpr const char* RECONCILDIFF{"reconcildiff"};
 }; // namespace NetMsgType
 
 /** All known message types (see above). Keep this in the same order as the list of messages above. */
@@ -303,6 +324,10 @@ inline const std::array ALL_NET_MESSAGE_TYPES{std::to_array<std::string>({
     NetMsgType::CFCHECKPT,
     NetMsgType::WTXIDRELAY,
     NetMsgType::SENDTXRCNCL,
+    NetMsgType::REQRECON,
+    NetMsgType::SKETCH,
+    NetMsgType::REQSKETCHEXT,
+    NetMsgType::RECONCILDIFF,
 })};
 
 /** nServices flags */
@@ -16,6 +16,7 @@
 #include <consensus/params.h>
 #include <consensus/validation.h>
 #include <core_io.h>
+#include <dbwrapper.h>
 #include <deploymentinfo.h>
 #include <deploymentstatus.h>
 #include <flatfile.h>
@@ -3420,6 +3421,69 @@ return RPCHelpMan{
     };
 }
 
+static std::vector<RPCResult> RPCHelpForDBStats{
+    {RPCResult::Type::NUM, "compactions", "number of compactions (including memtable flushes) since the database was opened"},
+    {RPCResult::Type::NUM, "compaction_time", "time spent compacting, in microseconds"},
+    {RPCResult::Type::NUM, "compaction_bytes_read", "bytes read by compactions"},
+    {RPCResult::Type::NUM, "compaction_bytes_written", "bytes written by compactions"},
+    {RPCResult::Type::NUM, "write_slowdowns", "number of writes delayed to let compaction keep up"},
+    {RPCResult::Type::NUM, "write_slowdown_time", "time writes spent delayed, in microseconds"},
+    {RPCResult::Type::NUM, "write_stops", "number of writes that waited for a memtable flush or compaction to finish"},
+    {RPCResult::Type::NUM, "write_stop_time", "time writes spent waiting, in microseconds"},
+    {RPCResult::Type::ARR, "files_per_level", "number of table files at each level (empty for engines without levels)", {
+        {RPCResult::Type::NUM, "", "number of files"},
+    }},
+};
+
+static UniValue DBStatsToJSON(const DBStats& stats)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("compactions", stats.compactions);
+    obj.pushKV("compaction_time", stats.compaction_micros);
+    obj.pushKV("compaction_bytes_read", stats.compaction_bytes_read);
+    obj.pushKV("compaction_bytes_written", stats.compaction_bytes_written);
+    obj.pushKV("write_slowdowns", stats.write_slowdowns);
+    obj.pushKV("write_slowdown_time", stats.write_slowdown_micros);
+    obj.pushKV("write_stops", stats.write_stops);
+    obj.pushKV("write_stop_time", stats.write_stop_micros);
+    UniValue files(UniValue::VARR);
+    for (const uint64_t n : stats.files_per_level) {
+        files.push_back(n);
+    }
+    obj.pushKV("files_per_level", std::move(files));
+    return obj;
+}
+
+static RPCHelpMan getdbstats()
+{
+return RPCHelpMan{
+        "getdbstats",
+        "Return compaction and write stall statistics of the block index and active chainstate databases.\n"
+        "Counters are cumulative since the databases were opened, and can be sampled during initial block download\n"
+        "to see how much time is lost to database maintenance.\n",
+        {},
+        RPCResult{
+            RPCResult::Type::OBJ, "", "", {
+                {RPCResult::Type::OBJ, "blockindex", "statistics of the block index database", RPCHelpForDBStats},
+                {RPCResult::Type::OBJ, "chainstate", "statistics of the active chainstate's coins database", RPCHelpForDBStats},
+            }
+        },
+        RPCExamples{
+            HelpExampleCli("getdbstats", "")
+    + HelpExampleRpc("getdbstats", "")
+        },
+        [&](const RPCHelpMan& self, const JSONRPCRequest& request) -> UniValue
+{
+    ChainstateManager& chainman = EnsureAnyChainman(request.context);
+    LOCK(cs_main);
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("blockindex", DBStatsToJSON(chainman.m_blockman.m_block_tree_db->GetStats()));
+    obj.pushKV("chainstate", DBStatsToJSON(chainman.ActiveChainstate().CoinsDB().GetDBStats()));
+    return obj;
+}
+    };
+}
+
 
 void RegisterBlockchainRPCCommands(CRPCTable& t)
 {
@@ -3454,6 +3518,7 @@ void RegisterBlockchainRPCCommands(CRPCTable& t)
         {"hidden", &waitforblock},
         {"hidden", &waitforblockheight},
         {"hidden", &syncwithvalidationinterfacequeue},
+        {"hidden", &getdbstats},
     };
     for (const auto& c : commands) {
         t.appendCommand(c.name, &c);
@@ -166,6 +166,9 @@ static RPCHelpMan getpeerinfo()
                     {
                         {RPCResult::Type::NUM, "n", "The heights of blocks we're currently asking from this peer"},
                     }},
+                    {RPCResult::Type::NUM, "inflight_window", "The number of blocks we ask from this peer at a time during block download"},
+                    {RPCResult::Type::NUM, "block_download_rate", /*optional=*/true, "The measured block download throughput from this peer in bytes per second, if any"},
+                    {RPCResult::Type::NUM, "block_download_latency", /*optional=*/true, "The measured block request latency of this peer in seconds, if any"},
                     {RPCResult::Type::BOOL, "addr_relay_enabled", "Whether we participate in address relay with this peer"},
                     {RPCResult::Type::NUM, "addr_processed", "The total number of addresses processed, excluding those dropped due to rate limiting"},
                     {RPCResult::Type::NUM, "addr_rate_limited", "The total number of addresses dropped due to rate limiting"},
@@ -272,6 +275,13 @@ static RPCHelpMan getpeerinfo()
             heights.push_back(height);
         }
         obj.pushKV("inflight", std::move(heights));
+        obj.pushKV("inflight_window", statestats.m_inflight_window);
+        if (statestats.m_block_download_bytes_per_sec) {
+            obj.pushKV("block_download_rate", *statestats.m_block_download_bytes_per_sec);
+        }
+        if (statestats.m_block_download_latency) {
+            obj.pushKV("block_download_latency", Ticks<SecondsDouble>(*statestats.m_block_download_latency));
+        }
         obj.pushKV("addr_relay_enabled", statestats.m_addr_relay_enabled);
         obj.pushKV("addr_processed", statestats.m_addr_processed);
         obj.pushKV("addr_rate_limited", statestats.m_addr_rate_limited);
@@ -566,6 +576,8 @@ static RPCHelpMan getnettotals()
                    {
                        {RPCResult::Type::NUM, "totalbytesrecv", "Total bytes received"},
                        {RPCResult::Type::NUM, "totalbytessent", "Total bytes sent"},
+                       {RPCResult::Type::NUM, "totalsendcalls", "Total calls made to send data to peers, each of which can send several messages"},
+                       {RPCResult::Type::NUM, "totalrecvcalls", "Total calls made to receive data from peers"},
                        {RPCResult::Type::NUM_TIME, "timemillis", "Current system " + UNIX_EPOCH_TIME + " in milliseconds"},
                        {RPCResult::Type::OBJ, "uploadtarget", "",
                        {
@@ -576,6 +588,17 @@ static RPCHelpMan getnettotals()
                            {RPCResult::Type::NUM, "bytes_left_in_cycle", "Bytes left in current time cycle"},
                            {RPCResult::Type::NUM, "time_left_in_cycle", "Seconds left in current time cycle"},
                         }},
+                       {RPCResult::Type::OBJ_DYN, "bytessent_per_msg", "",
+                       {
+                           {RPCResult::Type::NUM, "msg", "The total bytes sent to all peers since startup aggregated by message type\n"
+                                                         "When a message type is not listed in this json object, the bytes sent are 0."}
+                       }},
+                       {RPCResult::Type::OBJ_DYN, "bytesrecv_per_msg", "",
+                       {
+                           {RPCResult::Type::NUM, "msg", "The total bytes received from all peers since startup aggregated by message type\n"
+                                                         "When a message type is not listed in this json object, the bytes received are 0.\n"
+                                                         "All bytes received of unknown message types are listed under '"+NET_MESSAGE_TYPE_OTHER+"'."}
+                       }},
                     }
                 },
                 RPCExamples{
@@ -590,6 +613,8 @@ static RPCHelpMan getnettotals()
     UniValue obj(UniValue::VOBJ);
     obj.pushKV("totalbytesrecv", connman.GetTotalBytesRecv());
     obj.pushKV("totalbytessent", connman.GetTotalBytesSent());
+    obj.pushKV("totalsendcalls", connman.GetTotalSendCalls());
+    obj.pushKV("totalrecvcalls", connman.GetTotalRecvCalls());
     obj.pushKV("timemillis", TicksSinceEpoch<std::chrono::milliseconds>(SystemClock::now()));
 
     UniValue outboundLimit(UniValue::VOBJ);
@@ -600,6 +625,19 @@ static RPCHelpMan getnettotals()
     outboundLimit.pushKV("bytes_left_in_cycle", connman.GetOutboundTargetBytesLeft());
     outboundLimit.pushKV("time_left_in_cycle", count_seconds(connman.GetMaxOutboundTimeLeftInCycle()));
     obj.pushKV("uploadtarget", std::move(outboundLimit));
+
+    mapMsgTypeSize sent_per_msg_type, recv_per_msg_type;
+    connman.GetTotalBytesPerMsgType(sent_per_msg_type, recv_per_msg_type);
+    UniValue sendPerMsgType(UniValue::VOBJ);
+    for (const auto& [msg_type, bytes] : sent_per_msg_type) {
+        if (bytes > 0) sendPerMsgType.pushKV(msg_type, bytes);
+    }
+    obj.pushKV("bytessent_per_msg", std::move(sendPerMsgType));
+    UniValue recvPerMsgType(UniValue::VOBJ);
+    for (const auto& [msg_type, bytes] : recv_per_msg_type) {
+        if (bytes > 0) recvPerMsgType.pushKV(msg_type, bytes);
+    }
+    obj.pushKV("bytesrecv_per_msg", std::move(recvPerMsgType));
     return obj;
 },
     };
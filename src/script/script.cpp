@@ -157,21 +157,27 @@ std::string GetOpName(opcodetype opcode)
 }
 
 unsigned int CScript::GetSigOpCount(bool fAccurate) const
+{
+    return ::GetSigOpCount(std::span{data(), size()}, fAccurate);
+}
+
+unsigned int GetSigOpCount(std::span<const unsigned char> script, bool fAccurate)
 {
     unsigned int n = 0;
-    const_iterator pc = begin();
+    CScriptBase::const_iterator pc{script.data()};
+    const CScriptBase::const_iterator end{script.data() + script.size()};
     opcodetype lastOpcode = OP_INVALIDOPCODE;
-    while (pc < end())
+    while (pc < end)
     {
         opcodetype opcode;
-        if (!GetOp(pc, opcode))
+        if (!GetScriptOp(pc, end, opcode, nullptr))
             break;
         if (opcode == OP_CHECKSIG || opcode == OP_CHECKSIGVERIFY)
             n++;
         else if (opcode == OP_CHECKMULTISIG || opcode == OP_CHECKMULTISIGVERIFY)
         {
             if (fAccurate && lastOpcode >= OP_1 && lastOpcode <= OP_16)
-                n += DecodeOP_N(lastOpcode);
+                n += CScript::DecodeOP_N(lastOpcode);
             else
                 n += MAX_PUBKEYS_PER_MULTISIG;
         }
@@ -242,7 +242,7 @@ public:
 
     static const size_t nDefaultMaxNumSize = 4;
 
-    explicit CScriptNum(const std::vector<unsigned char>& vch, bool fRequireMinimal,
+    explicit CScriptNum(std::span<const unsigned char> vch, bool fRequireMinimal,
                         const size_t nMaxNumSize = nDefaultMaxNumSize)
     {
         if (vch.size() > nMaxNumSize) {
@@ -347,11 +347,19 @@ public:
     }
 
     static std::vector<unsigned char> serialize(const int64_t& value)
+    {
+        std::vector<unsigned char> result;
+        serialize(value, result);
+        return result;
+    }
+
+    //! Serialize value into result, which must be empty.
+    template <typename Vector>
+    static void serialize(const int64_t& value, Vector& result)
     {
         if(value == 0)
-            return std::vector<unsigned char>();
+            return;
 
-        std::vector<unsigned char> result;
         const bool neg = value < 0;
         uint64_t absvalue = neg ? ~static_cast<uint64_t>(value) + 1 : static_cast<uint64_t>(value);
 
@@ -375,12 +383,10 @@ public:
             result.push_back(neg ? 0x80 : 0);
         else if (neg)
             result.back() |= 0x80;
-
-        return result;
     }
 
 private:
-    static int64_t set_vch(const std::vector<unsigned char>& vch)
+    static int64_t set_vch(std::span<const unsigned char> vch)
     {
       if (vch.empty())
           return 0;
@@ -410,6 +416,9 @@ typedef prevector<28, unsigned char> CScriptBase;
 
 bool GetScriptOp(CScriptBase::const_iterator& pc, CScriptBase::const_iterator end, opcodetype& opcodeRet, std::vector<unsigned char>* pvchRet);
 
+/** Count the sigops of a serialized script, like CScript::GetSigOpCount(bool). */
+unsigned int GetSigOpCount(std::span<const unsigned char> script, bool fAccurate);
+
 /** Serialized script, used inside transaction inputs and outputs */
 class CScript : public CScriptBase
 {
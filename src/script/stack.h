@@ -0,0 +1,226 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SCRIPT_STACK_H
+#define BITCOIN_SCRIPT_STACK_H
+
+#include <prevector.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+/**
+ * An element of the script interpreter's stack. Signatures, public keys,
+ * hashes and numbers are stored inline, only larger pushes (up to
+ * MAX_SCRIPT_ELEMENT_SIZE) allocate.
+ */
+using StackElement = prevector<76, unsigned char>;
+
+/**
+ * The stack of the script interpreter: a vector of StackElement which stores
+ * its first INLINE_CAPACITY elements inline, so that evaluating a typical
+ * script does not allocate at all.
+ *
+ * The interpreter limits the number of elements in the stacks to
+ * MAX_STACK_SIZE during execution, but an initial witness stack may be larger,
+ * in which case the elements are moved to the heap.
+ *
+ * Only the operations used by the interpreter are provided. Like for
+ * std::vector, operations that change the size invalidate iterators and
+ * references to the elements.
+ */
+class ScriptStack
+{
+public:
+    static constexpr size_t INLINE_CAPACITY{16};
+
+    using value_type = StackElement;
+    using iterator = StackElement*;
+    using const_iterator = const StackElement*;
+
+private:
+    alignas(StackElement) std::byte m_inline[INLINE_CAPACITY * sizeof(StackElement)];
+    StackElement* m_data;
+    size_t m_size{0};
+    size_t m_capacity{INLINE_CAPACITY};
+
+    StackElement* InlineData() { return std::launder(reinterpret_cast<StackElement*>(m_inline)); }
+    bool IsInline() const { return m_data == reinterpret_cast<const StackElement*>(m_inline); }
+
+    //! Move the elements to a heap allocation of at least min_capacity elements.
+    void Grow(size_t min_capacity)
+    {
+        const size_t capacity{std::max(min_capacity, 2 * m_capacity)};
+        auto* data{static_cast<StackElement*>(::operator new(capacity * sizeof(StackElement), std::align_val_t{alignof(StackElement)}))};
+        std::uninitialized_move(m_data, m_data + m_size, data);
+        std::destroy(m_data, m_data + m_size);
+        Free();
+        m_data = data;
+        m_capacity = capacity;
+    }
+
+    void Free() noexcept
+    {
+        if (!IsInline()) ::operator delete(m_data, std::align_val_t{alignof(StackElement)});
+    }
+
+    //! Take the elements of other, which is left empty.
+    void MoveFrom(ScriptStack& other) noexcept
+    {
+        if (other.IsInline()) {
+            m_data = InlineData();
+            m_capacity = INLINE_CAPACITY;
+            std::uninitialized_move(other.m_data, other.m_data + other.m_size, m_data);
+            std::destroy(other.m_data, other.m_data + other.m_size);
+        } else {
+            m_data = other.m_data;
+            m_capacity = other.m_capacity;
+            other.m_data = other.InlineData();
+            other.m_capacity = INLINE_CAPACITY;
+        }
+        m_size = other.m_size;
+        other.m_size = 0;
+    }
+
+public:
+    ScriptStack() : m_data{InlineData()} {}
+
+    template <typename InputIterator>
+    ScriptStack(InputIterator first, InputIterator last) : ScriptStack()
+    {
+        reserve(std::distance(first, last));
+        for (; first != last; ++first) emplace_back(first->begin(), first->end());
+    }
+
+    ScriptStack(const ScriptStack& other) : ScriptStack(other.begin(), other.end()) {}
+    ScriptStack(ScriptStack&& other) noexcept { MoveFrom(other); }
+
+    ScriptStack& operator=(const ScriptStack& other)
+    {
+        if (this != &other) {
+            clear();
+            reserve(other.size());
+            for (const StackElement& element : other) push_back(element);
+        }
+        return *this;
+    }
+
+    ScriptStack& operator=(ScriptStack&& other) noexcept
+    {
+        if (this != &other) {
+            clear();
+            Free();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    ~ScriptStack()
+    {
+        clear();
+        Free();
+    }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    size_t capacity() const { return m_capacity; }
+
+    iterator begin() { return m_data; }
+    iterator end() { return m_data + m_size; }
+    const_iterator begin() const { return m_data; }
+    const_iterator end() const { return m_data + m_size; }
+
+    StackElement& operator[](size_t pos) { return m_data[pos]; }
+    const StackElement& operator[](size_t pos) const { return m_data[pos]; }
+    StackElement& at(size_t pos)
+    {
+        if (pos >= m_size) throw std::out_of_range("ScriptStack::at(): out of range");
+        return m_data[pos];
+    }
+    const StackElement& at(size_t pos) const
+    {
+        if (pos >= m_size) throw std::out_of_range("ScriptStack::at(): out of range");
+        return m_data[pos];
+    }
+    StackElement& back() { assert(m_size > 0); return m_data[m_size - 1]; }
+    const StackElement& back() const { assert(m_size > 0); return m_data[m_size - 1]; }
+
+    void reserve(size_t capacity)
+    {
+        if (capacity > m_capacity) Grow(capacity);
+    }
+
+    template <typename... Args>
+    StackElement& emplace_back(Args&&... args)
+    {
+        if (m_size == m_capacity) {
+            // The arguments may refer to an element, so construct the new
+            // element before moving them.
+            StackElement element(std::forward<Args>(args)...);
+            Grow(m_size + 1);
+            return *new (m_data + m_size++) StackElement(std::move(element));
+        }
+        return *new (m_data + m_size++) StackElement(std::forward<Args>(args)...);
+    }
+
+    void push_back(const StackElement& element) { emplace_back(element); }
+    void push_back(StackElement&& element) { emplace_back(std::move(element)); }
+
+    void pop_back()
+    {
+        assert(m_size > 0);
+        std::destroy_at(m_data + --m_size);
+    }
+
+    void clear()
+    {
+        std::destroy(m_data, m_data + m_size);
+        m_size = 0;
+    }
+
+    //! Shrink to the first size elements.
+    void resize(size_t size)
+    {
+        assert(size <= m_size);
+        std::destroy(m_data + size, m_data + m_size);
+        m_size = size;
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        const iterator pos{m_data + (first - m_data)};
+        // Moving the elements onto themselves would free the heap storage of prevectors.
+        if (first == last) return pos;
+        const iterator new_end{std::move(pos + (last - first), end(), pos)};
+        std::destroy(new_end, end());
+        m_size = new_end - m_data;
+        return pos;
+    }
+
+    iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+    iterator insert(const_iterator pos, StackElement element)
+    {
+        const size_t index = pos - m_data;
+        assert(index <= m_size);
+        emplace_back(std::move(element));
+        std::rotate(m_data + index, end() - 1, end());
+        return m_data + index;
+    }
+
+    friend void swap(ScriptStack& a, ScriptStack& b) noexcept
+    {
+        ScriptStack tmp{std::move(a)};
+        a = std::move(b);
+        b = std::move(tmp);
+    }
+};
+
+#endif // BITCOIN_SCRIPT_STACK_H
@@ -100,6 +100,8 @@ public:
 
     size_t size() const { return m_data.size(); }
     bool empty() const { return m_data.empty(); }
+    //! The bytes that have not been read yet.
+    const std::byte* data() const { return m_data.data(); }
 
     void read(std::span<std::byte> dst)
     {
@@ -147,6 +149,7 @@ public:
     explicit DataStream() = default;
     explicit DataStream(std::span<const uint8_t> sp) : DataStream{std::as_bytes(sp)} {}
     explicit DataStream(std::span<const value_type> sp) : vch(sp.data(), sp.data() + sp.size()) {}
+    explicit DataStream(vector_type&& vch_in) noexcept : vch(std::move(vch_in)) {}
 
     std::string str() const
     {
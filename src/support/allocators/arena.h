@@ -0,0 +1,247 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SUPPORT_ALLOCATORS_ARENA_H
+#define BITCOIN_SUPPORT_ALLOCATORS_ARENA_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <vector>
+
+/**
+ * A monotonic memory resource for temporaries that are all freed at the same
+ * time, like the ones used while connecting a block. It has the following
+ * properties:
+ *
+ * * Allocations are carved out of large chunks in order. Deallocation does
+ *   nothing, the memory is only reused after Reset().
+ *
+ * * Reset() keeps the chunks. When more than one chunk was in use, they are
+ *   replaced by a single chunk of their total size, so that repeating a
+ *   workload of the same size after a Reset() does not allocate at all.
+ *
+ * * Allocations larger than the chunk size get a chunk of their own.
+ *
+ * ArenaResource is not thread-safe. It is intended to be used by ArenaAllocator.
+ *
+ * The memory held is that of the largest workload between two calls to
+ * Reset(), so it is not suited for containers that grow without bound.
+ */
+class ArenaResource
+{
+public:
+    struct Stats {
+        //! Number of allocations served since the last Reset().
+        size_t allocations{0};
+        //! Bytes handed out since the last Reset(), including alignment padding.
+        size_t bytes{0};
+        //! Number of chunks allocated from the heap since the last Reset().
+        size_t chunk_allocations{0};
+    };
+
+private:
+    //! Alignment of the chunks, larger alignments are handled by padding.
+    static constexpr size_t CHUNK_ALIGN_BYTES{alignof(std::max_align_t)};
+
+    struct Chunk {
+        std::byte* data;
+        size_t size;
+    };
+
+    //! Size of the chunks allocated when the current one is exhausted.
+    const size_t m_chunk_size_bytes;
+
+    //! All chunks, the ones after m_current are not in use yet.
+    std::vector<Chunk> m_chunks;
+    size_t m_current{0};
+
+    //! The memory still available in the current chunk.
+    std::byte* m_available_memory_it{nullptr};
+    std::byte* m_available_memory_end{nullptr};
+
+    Stats m_stats;
+
+    void AllocateChunk(size_t size)
+    {
+        std::byte* data{static_cast<std::byte*>(::operator new (size, std::align_val_t{CHUNK_ALIGN_BYTES}))};
+        m_chunks.push_back({data, size});
+        ++m_stats.chunk_allocations;
+    }
+
+    void FreeChunks() noexcept
+    {
+        for (const Chunk& chunk : m_chunks) {
+            ::operator delete (chunk.data, std::align_val_t{CHUNK_ALIGN_BYTES});
+        }
+        m_chunks.clear();
+    }
+
+    void UseChunk(size_t index)
+    {
+        m_current = index;
+        m_available_memory_it = m_chunks[index].data;
+        m_available_memory_end = m_chunks[index].data + m_chunks[index].size;
+    }
+
+    //! Bytes needed at m_available_memory_it to align it to alignment.
+    size_t Padding(size_t alignment) const
+    {
+        return -reinterpret_cast<uintptr_t>(m_available_memory_it) & (alignment - 1);
+    }
+
+    //! Make sure that the current chunk can serve the allocation.
+    void Reserve(size_t bytes, size_t alignment)
+    {
+        // Move on to the next chunk that is large enough, or append a new one.
+        // Chunks that are skipped stay unused until the next Reset().
+        const size_t needed{bytes + (alignment > CHUNK_ALIGN_BYTES ? alignment : 0)};
+        for (size_t i = m_current + 1; i < m_chunks.size(); ++i) {
+            if (m_chunks[i].size >= needed) {
+                std::swap(m_chunks[m_current + 1], m_chunks[i]);
+                UseChunk(m_current + 1);
+                return;
+            }
+        }
+        AllocateChunk(std::max(m_chunk_size_bytes, needed));
+        std::swap(m_chunks[m_current + 1], m_chunks.back());
+        UseChunk(m_current + 1);
+    }
+
+public:
+    /**
+     * Construct a new ArenaResource object which allocates the first chunk.
+     */
+    explicit ArenaResource(size_t chunk_size_bytes) : m_chunk_size_bytes{chunk_size_bytes}
+    {
+        assert(m_chunk_size_bytes > 0);
+        AllocateChunk(m_chunk_size_bytes);
+        UseChunk(0);
+        m_stats = {};
+    }
+
+    /**
+     * Construct a new ArenaResource object, defaults to 2^18=262144 chunk size.
+     */
+    ArenaResource() : ArenaResource(262144) {}
+
+    ArenaResource(const ArenaResource&) = delete;
+    ArenaResource& operator=(const ArenaResource&) = delete;
+    ArenaResource(ArenaResource&&) = delete;
+    ArenaResource& operator=(ArenaResource&&) = delete;
+
+    ~ArenaResource() { FreeChunks(); }
+
+    /**
+     * Allocates a block of bytes from the current chunk, moving to another
+     * chunk if it is exhausted.
+     */
+    void* Allocate(size_t bytes, size_t alignment)
+    {
+        assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+        if (bytes + Padding(alignment) > size_t(m_available_memory_end - m_available_memory_it)) {
+            Reserve(bytes, alignment);
+        }
+        const size_t used{bytes + Padding(alignment)};
+        void* p{m_available_memory_it + Padding(alignment)};
+        m_available_memory_it += used;
+        ++m_stats.allocations;
+        m_stats.bytes += used;
+        return p;
+    }
+
+    /**
+     * Does nothing, the memory is reused after Reset().
+     */
+    void Deallocate(void*, size_t, size_t) noexcept {}
+
+    /**
+     * Make all memory available again. Everything allocated before becomes
+     * invalid.
+     */
+    void Reset()
+    {
+        if (m_chunks.size() > 1) {
+            size_t total{0};
+            for (const Chunk& chunk : m_chunks) total += chunk.size;
+            FreeChunks();
+            AllocateChunk(total);
+        }
+        UseChunk(0);
+        m_stats = {};
+    }
+
+    /**
+     * Statistics of the allocations since the last Reset().
+     */
+    [[nodiscard]] const Stats& GetStats() const { return m_stats; }
+
+    /**
+     * Total size in bytes of the chunks held.
+     */
+    [[nodiscard]] size_t CapacityBytes() const
+    {
+        size_t total{0};
+        for (const Chunk& chunk : m_chunks) total += chunk.size;
+        return total;
+    }
+};
+
+/**
+ * Forwards all allocations to an ArenaResource. Deallocations are no-ops.
+ */
+template <class T>
+class ArenaAllocator
+{
+    ArenaResource* m_resource;
+
+public:
+    using value_type = T;
+
+    /**
+     * Not explicit so we can easily construct it with the correct resource
+     */
+    ArenaAllocator(ArenaResource* resource) noexcept : m_resource(resource) {}
+
+    ArenaAllocator(const ArenaAllocator& other) noexcept = default;
+    ArenaAllocator& operator=(const ArenaAllocator& other) noexcept = default;
+
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : m_resource(other.resource())
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T)) throw std::bad_array_new_length();
+        return static_cast<T*>(m_resource->Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, size_t n) noexcept
+    {
+        m_resource->Deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    ArenaResource* resource() const noexcept
+    {
+        return m_resource;
+    }
+};
+
+template <class T1, class T2>
+bool operator==(const ArenaAllocator<T1>& a, const ArenaAllocator<T2>& b) noexcept
+{
+    return a.resource() == b.resource();
+}
+
+template <class T1, class T2>
+bool operator!=(const ArenaAllocator<T1>& a, const ArenaAllocator<T2>& b) noexcept
+{
+    return !(a == b);
+}
+
+#endif // BITCOIN_SUPPORT_ALLOCATORS_ARENA_H
@@ -0,0 +1,106 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <support/allocators/arena.h>
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+BOOST_FIXTURE_TEST_SUITE(arena_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(arena_basic_allocating)
+{
+    ArenaResource resource{1024};
+    BOOST_CHECK_EQUAL(resource.CapacityBytes(), 1024U);
+    BOOST_CHECK_EQUAL(resource.GetStats().chunk_allocations, 0U);
+
+    // Allocations are consecutive, with padding for their alignment.
+    auto* a = static_cast<std::byte*>(resource.Allocate(3, 1));
+    auto* b = static_cast<std::byte*>(resource.Allocate(8, 8));
+    auto* c = static_cast<std::byte*>(resource.Allocate(1, 1));
+    BOOST_CHECK_EQUAL(reinterpret_cast<uintptr_t>(b) % 8, 0U);
+    BOOST_CHECK(b >= a + 3 && b < a + 3 + 8);
+    BOOST_CHECK(c == b + 8);
+    BOOST_CHECK_EQUAL(resource.GetStats().allocations, 3U);
+    BOOST_CHECK_EQUAL(resource.GetStats().bytes, size_t(c + 1 - a));
+
+    // Deallocation does not make the memory available again.
+    resource.Deallocate(c, 1, 1);
+    BOOST_CHECK(resource.Allocate(1, 1) == c + 1);
+
+    // Large alignments are supported.
+    void* aligned = resource.Allocate(10, 256);
+    BOOST_CHECK_EQUAL(reinterpret_cast<uintptr_t>(aligned) % 256, 0U);
+    BOOST_CHECK_EQUAL(resource.GetStats().chunk_allocations, 0U);
+
+    // Exhausting the chunk allocates another one.
+    resource.Allocate(1000, 8);
+    BOOST_CHECK_EQUAL(resource.GetStats().chunk_allocations, 1U);
+    BOOST_CHECK_EQUAL(resource.CapacityBytes(), 2048U);
+
+    // Allocations larger than a chunk get one of their own.
+    void* large = resource.Allocate(5000, 512);
+    BOOST_CHECK_EQUAL(reinterpret_cast<uintptr_t>(large) % 512, 0U);
+    std::memset(large, 0xff, 5000);
+    BOOST_CHECK_EQUAL(resource.GetStats().chunk_allocations, 2U);
+}
+
+BOOST_AUTO_TEST_CASE(arena_reset)
+{
+    ArenaResource resource{4096};
+    const auto workload = [&] {
+        for (int i = 0; i < 100; ++i) {
+            std::memset(resource.Allocate(200, 8), i, 200);
+        }
+        std::memset(resource.Allocate(10000, 16), 0, 10000);
+    };
+
+    workload();
+    BOOST_CHECK_EQUAL(resource.GetStats().allocations, 101U);
+    BOOST_CHECK(resource.GetStats().chunk_allocations > 1);
+    const size_t capacity{resource.CapacityBytes()};
+
+    // The chunks are merged into one, so the same workload does not need any
+    // new chunks anymore.
+    for (int i = 0; i < 3; ++i) {
+        resource.Reset();
+        BOOST_CHECK_EQUAL(resource.GetStats().allocations, 0U);
+        BOOST_CHECK_EQUAL(resource.CapacityBytes(), capacity);
+        workload();
+        BOOST_CHECK_EQUAL(resource.GetStats().chunk_allocations, 0U);
+        BOOST_CHECK_EQUAL(resource.CapacityBytes(), capacity);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(arena_allocator_containers)
+{
+    ArenaResource resource{256};
+    for (int round = 0; round < 10; ++round) {
+        std::vector<std::vector<uint64_t, ArenaAllocator<uint64_t>>, ArenaAllocator<std::vector<uint64_t, ArenaAllocator<uint64_t>>>> vectors{&resource};
+        std::vector<std::vector<uint64_t>> expected;
+        for (int i = 0; i < 50; ++i) {
+            auto& v = vectors.emplace_back(&resource);
+            auto& e = expected.emplace_back();
+            const int size = m_rng.randrange(100);
+            for (int j = 0; j < size; ++j) {
+                const uint64_t value{m_rng.rand64()};
+                v.push_back(value);
+                e.push_back(value);
+            }
+        }
+        for (size_t i = 0; i < expected.size(); ++i) {
+            BOOST_CHECK(std::vector<uint64_t>(vectors[i].begin(), vectors[i].end()) == expected[i]);
+        }
+        vectors.clear();
+        resource.Reset();
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
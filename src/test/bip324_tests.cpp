@@ -300,4 +300,42 @@ BOOST_AUTO_TEST_CASE(packet_test_vectors) {
         "7c4b9e1e6c1ce69da7b01513cdc4588fd93b04dafefaf87f31561763d906c672bac3dfceb751ebd126728ac017d4d580e931b8e5c7d5dfe0123be4dc9b2d2238b655c8a7fadaf8082c31e310909b5b731efc12f0a56e849eae6bfeedcc86dd27ef9b91d159256aa8e8d2b71a311f73350863d70f18d0d7302cf551e4303c7733");
 }
 
+BOOST_AUTO_TEST_CASE(decrypt_in_place)
+{
+    const CKey initiator_key{GenerateRandomKey()}, responder_key{GenerateRandomKey()};
+    const auto initiator_ent{m_rng.randbytes<std::byte>(32)}, responder_ent{m_rng.randbytes<std::byte>(32)};
+    BIP324Cipher initiator(initiator_key, initiator_ent);
+    // Two identical responders, one decrypting into a separate buffer, the other in place.
+    BIP324Cipher responder(responder_key, responder_ent);
+    BIP324Cipher responder_in_place(responder_key, responder_ent);
+    initiator.Initialize(responder.GetOurPubKey(), /*initiator=*/true);
+    responder.Initialize(initiator.GetOurPubKey(), /*initiator=*/false);
+    responder_in_place.Initialize(initiator.GetOurPubKey(), /*initiator=*/false);
+
+    // Sizes around the ChaCha20 block size, and large enough for the multi-block code paths.
+    for (const size_t size : {0, 1, 63, 64, 65, 1000, 100000}) {
+        const auto contents{m_rng.randbytes<std::byte>(size)};
+        const auto aad{m_rng.randbytes<std::byte>(m_rng.randrange(2) * 16)};
+        const bool ignore{m_rng.randbool()};
+        std::vector<std::byte> packet(size + BIP324Cipher::EXPANSION);
+        initiator.Encrypt(contents, aad, ignore, packet);
+
+        BOOST_CHECK_EQUAL(responder.DecryptLength(std::span{packet}.first(BIP324Cipher::LENGTH_LEN)), size);
+        BOOST_CHECK_EQUAL(responder_in_place.DecryptLength(std::span{packet}.first(BIP324Cipher::LENGTH_LEN)), size);
+        const std::span<std::byte> input{std::span{packet}.subspan(BIP324Cipher::LENGTH_LEN)};
+
+        std::vector<std::byte> decrypted(size);
+        bool dec_ignore{!ignore};
+        BOOST_CHECK(responder.Decrypt(input, aad, dec_ignore, decrypted));
+        BOOST_CHECK_EQUAL(dec_ignore, ignore);
+        BOOST_CHECK(decrypted == contents);
+
+        dec_ignore = !ignore;
+        const std::span<std::byte> in_place{input.subspan(BIP324Cipher::HEADER_LEN, size)};
+        BOOST_CHECK(responder_in_place.Decrypt(input, aad, dec_ignore, in_place));
+        BOOST_CHECK_EQUAL(dec_ignore, ignore);
+        BOOST_CHECK(std::ranges::equal(in_place, contents));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
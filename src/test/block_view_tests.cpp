@@ -0,0 +1,248 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <consensus/merkle.h>
+#include <consensus/tx_check.h>
+#include <consensus/tx_verify.h>
+#include <consensus/validation.h>
+#include <primitives/block.h>
+#include <primitives/block_view.h>
+#include <primitives/transaction.h>
+#include <script/script.h>
+#include <serialize.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <ios>
+#include <span>
+#include <vector>
+
+namespace {
+struct BlockViewTest : public BasicTestingSetup {
+    //! Scripts around the size of CScript's inline storage, with some sigops.
+    CScript RandomScript()
+    {
+        std::vector<unsigned char> bytes{m_rng.randbytes(m_rng.randrange(60))};
+        for (unsigned char& byte : bytes) {
+            if (m_rng.randrange(8) == 0) byte = OP_CHECKSIG;
+        }
+        return CScript(bytes.begin(), bytes.end());
+    }
+
+    CMutableTransaction RandomTransaction(bool coinbase, bool witness)
+    {
+        CMutableTransaction tx;
+        tx.version = m_rng.rand32();
+        tx.nLockTime = m_rng.rand32();
+        const int inputs = coinbase ? 1 : 1 + m_rng.randrange(4);
+        for (int i = 0; i < inputs; ++i) {
+            CTxIn& txin{tx.vin.emplace_back()};
+            if (!coinbase) txin.prevout = COutPoint{Txid::FromUint256(m_rng.rand256()), m_rng.randrange<uint32_t>(8)};
+            txin.scriptSig = coinbase ? CScript() << m_rng.randbytes(8) : RandomScript();
+            txin.nSequence = m_rng.rand32();
+            if (witness && m_rng.randbool()) {
+                txin.scriptWitness.stack.resize(m_rng.randrange(4));
+                for (auto& item : txin.scriptWitness.stack) item = m_rng.randbytes(m_rng.randrange(80));
+            }
+        }
+        if (witness && !CTransaction{tx}.HasWitness()) tx.vin[0].scriptWitness.stack.push_back(m_rng.randbytes(32));
+        const int outputs = m_rng.randrange(4);
+        for (int i = 0; i < outputs; ++i) {
+            tx.vout.emplace_back(m_rng.randrange(COIN), RandomScript());
+        }
+        return tx;
+    }
+
+    CBlock RandomBlock()
+    {
+        CBlock block;
+        block.nVersion = m_rng.rand32();
+        block.hashPrevBlock = m_rng.rand256();
+        block.nTime = m_rng.rand32();
+        block.nBits = m_rng.rand32();
+        block.nNonce = m_rng.rand32();
+        const int txs = 1 + m_rng.randrange(20);
+        for (int i = 0; i < txs; ++i) {
+            block.vtx.push_back(MakeTransactionRef(RandomTransaction(/*coinbase=*/i == 0, /*witness=*/m_rng.randbool())));
+        }
+        block.hashMerkleRoot = BlockMerkleRoot(block);
+        return block;
+    }
+};
+
+std::vector<std::byte> Serialize(const CBlock& block)
+{
+    DataStream stream;
+    stream << TX_WITH_WITNESS(block);
+    return {stream.begin(), stream.end()};
+}
+
+bool Equal(std::span<const unsigned char> a, std::span<const unsigned char> b)
+{
+    return std::ranges::equal(a, b);
+}
+
+//! Check that the consensus checks which accept a view agree with their
+//! CBlock versions, and that CheckBlock fails the block with reject_reason.
+void CheckViewAndBlock(const CBlock& block, const std::string& reject_reason)
+{
+    const std::vector<std::byte> data{Serialize(block)};
+    const BlockView view{data};
+
+    bool mutated, view_mutated;
+    BOOST_CHECK_EQUAL(BlockMerkleRoot(view, &view_mutated), BlockMerkleRoot(block, &mutated));
+    BOOST_CHECK_EQUAL(view_mutated, mutated);
+    BOOST_REQUIRE_EQUAL(view.Transactions().size(), block.vtx.size());
+    for (size_t i = 0; i < block.vtx.size(); ++i) {
+        TxValidationState state, view_state;
+        BOOST_CHECK_EQUAL(CheckTransaction(view.Transactions()[i], view_state), CheckTransaction(*block.vtx[i], state));
+        BOOST_CHECK_EQUAL(view_state.GetRejectReason(), state.GetRejectReason());
+        BOOST_CHECK_EQUAL(GetLegacySigOpCount(view.Transactions()[i]), GetLegacySigOpCount(*block.vtx[i]));
+    }
+
+    BlockValidationState state;
+    // CheckBlock remembers that the merkle root of a block is valid, and copies of the block inherit that.
+    block.m_checked_merkle_root = false;
+    BOOST_CHECK_EQUAL(CheckBlock(block, state, Params().GetConsensus(), /*fCheckPOW=*/false), reject_reason.empty());
+    BOOST_CHECK_EQUAL(state.GetRejectReason(), reject_reason);
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(block_view_tests, BlockViewTest)
+
+BOOST_AUTO_TEST_CASE(block_view_matches_block)
+{
+    for (int i = 0; i < 50; ++i) {
+        const CBlock block{RandomBlock()};
+        std::vector<std::byte> data{Serialize(block)};
+        const size_t size{data.size()};
+        // Data after the block is not part of it.
+        data.resize(size + m_rng.randrange(3));
+        const BlockView view{data};
+
+        BOOST_CHECK_EQUAL(view.header.GetHash(), block.GetHash());
+        BOOST_CHECK_EQUAL(view.Serialized().size(), size);
+        BOOST_CHECK_EQUAL(view.GetStrippedSize(), ::GetSerializeSize(TX_NO_WITNESS(block)));
+        BOOST_CHECK_EQUAL(BlockMerkleRoot(view), block.hashMerkleRoot);
+        BOOST_CHECK(Serialize(view.ToBlock()) == Serialize(block));
+
+        BOOST_REQUIRE_EQUAL(view.Transactions().size(), block.vtx.size());
+        for (size_t j = 0; j < block.vtx.size(); ++j) {
+            const CTransaction& tx{*block.vtx[j]};
+            const BlockTxView& tx_view{view.Transactions()[j]};
+            BOOST_CHECK_EQUAL(tx_view.GetHash(), tx.GetHash());
+            BOOST_CHECK_EQUAL(tx_view.GetWitnessHash(), tx.GetWitnessHash());
+            BOOST_CHECK_EQUAL(tx_view.HasWitness(), tx.HasWitness());
+            BOOST_CHECK_EQUAL(tx_view.IsCoinBase(), tx.IsCoinBase());
+            BOOST_CHECK_EQUAL(tx_view.GetTotalSize(), tx.GetTotalSize());
+            BOOST_CHECK_EQUAL(tx_view.GetStrippedSize(), ::GetSerializeSize(TX_NO_WITNESS(tx)));
+            BOOST_CHECK_EQUAL(tx_view.version, tx.version);
+            BOOST_CHECK_EQUAL(tx_view.nLockTime, tx.nLockTime);
+            BOOST_CHECK_EQUAL(GetLegacySigOpCount(tx_view), GetLegacySigOpCount(tx));
+
+            BOOST_REQUIRE_EQUAL(tx_view.vin.size(), tx.vin.size());
+            for (size_t k = 0; k < tx.vin.size(); ++k) {
+                BOOST_CHECK(tx_view.vin[k].prevout == tx.vin[k].prevout);
+                BOOST_CHECK(Equal(tx_view.vin[k].scriptSig, tx.vin[k].scriptSig));
+                BOOST_CHECK_EQUAL(tx_view.vin[k].nSequence, tx.vin[k].nSequence);
+                const auto& stack{tx.vin[k].scriptWitness.stack};
+                BOOST_REQUIRE_EQUAL(tx_view.vin[k].witness.size(), stack.size());
+                for (size_t l = 0; l < stack.size(); ++l) {
+                    BOOST_CHECK(Equal(tx_view.vin[k].witness[l], stack[l]));
+                }
+            }
+            BOOST_REQUIRE_EQUAL(tx_view.vout.size(), tx.vout.size());
+            for (size_t k = 0; k < tx.vout.size(); ++k) {
+                BOOST_CHECK_EQUAL(tx_view.vout[k].nValue, tx.vout[k].nValue);
+                BOOST_CHECK(Equal(tx_view.vout[k].scriptPubKey, tx.vout[k].scriptPubKey));
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(block_view_consensus_checks)
+{
+    CBlock block{RandomBlock()};
+    // An odd number of transactions, so that one can be duplicated below.
+    if (block.vtx.size() % 2 == 0) block.vtx.push_back(MakeTransactionRef(RandomTransaction(/*coinbase=*/false, /*witness=*/false)));
+    // Transactions without outputs fail CheckTransaction.
+    for (auto& tx : block.vtx) {
+        if (tx->vout.empty()) {
+            CMutableTransaction mtx{*tx};
+            mtx.vout.emplace_back(COIN, RandomScript());
+            tx = MakeTransactionRef(mtx);
+        }
+    }
+    block.hashMerkleRoot = BlockMerkleRoot(block);
+    CheckViewAndBlock(block, "");
+
+    CBlock bad_merkle_root{block};
+    bad_merkle_root.hashMerkleRoot = m_rng.rand256();
+    CheckViewAndBlock(bad_merkle_root, "bad-txnmrklroot");
+
+    // Duplicating the last transaction does not change the merkle root.
+    CBlock duplicate{block};
+    duplicate.vtx.push_back(duplicate.vtx.back());
+    CheckViewAndBlock(duplicate, "bad-txns-duplicate");
+
+    CBlock no_coinbase{block};
+    no_coinbase.vtx.erase(no_coinbase.vtx.begin());
+    no_coinbase.vtx.push_back(MakeTransactionRef(RandomTransaction(/*coinbase=*/false, /*witness=*/false)));
+    no_coinbase.hashMerkleRoot = BlockMerkleRoot(no_coinbase);
+    CheckViewAndBlock(no_coinbase, "bad-cb-missing");
+
+    CBlock duplicate_inputs{block};
+    CMutableTransaction mtx{RandomTransaction(/*coinbase=*/false, /*witness=*/false)};
+    mtx.vout.emplace_back(COIN, RandomScript());
+    mtx.vin.push_back(mtx.vin[0]);
+    duplicate_inputs.vtx.push_back(MakeTransactionRef(mtx));
+    duplicate_inputs.hashMerkleRoot = BlockMerkleRoot(duplicate_inputs);
+    CheckViewAndBlock(duplicate_inputs, "bad-txns-inputs-duplicate");
+
+    CBlock too_many_sigops{block};
+    mtx = RandomTransaction(/*coinbase=*/false, /*witness=*/false);
+    const std::vector<unsigned char> checksigs(MAX_BLOCK_SIGOPS_COST / WITNESS_SCALE_FACTOR + 1, OP_CHECKSIG);
+    mtx.vout.emplace_back(COIN, CScript(checksigs.begin(), checksigs.end()));
+    too_many_sigops.vtx.push_back(MakeTransactionRef(mtx));
+    too_many_sigops.hashMerkleRoot = BlockMerkleRoot(too_many_sigops);
+    CheckViewAndBlock(too_many_sigops, "bad-blk-sigops");
+}
+
+BOOST_AUTO_TEST_CASE(block_view_invalid)
+{
+    CBlock block{RandomBlock()};
+    CMutableTransaction mtx{RandomTransaction(/*coinbase=*/false, /*witness=*/true)};
+    block.vtx.push_back(MakeTransactionRef(mtx));
+    const std::vector<std::byte> data{Serialize(block)};
+
+    // Every truncation fails to parse, as it does for a CBlock.
+    for (size_t size = 0; size < data.size(); size += 1 + m_rng.randrange(8)) {
+        BOOST_CHECK_THROW(BlockView{std::span{data}.first(size)}, std::ios_base::failure);
+    }
+
+    // Change the flag byte of the last transaction, which has a witness. A
+    // witness flag on transactions without witnesses is a failure as well.
+    const size_t flag_pos{data.size() - GetSerializeSize(TX_WITH_WITNESS(mtx)) + 5};
+    BOOST_REQUIRE_EQUAL(data[flag_pos], std::byte{1});
+    std::vector<std::byte> unknown_flag{data};
+    unknown_flag[flag_pos] = std::byte{3};
+    BOOST_CHECK_EXCEPTION(BlockView{unknown_flag}, std::ios_base::failure, HasReason{"Unknown transaction optional data"});
+
+    for (auto& txin : mtx.vin) txin.scriptWitness.SetNull();
+    DataStream stream;
+    stream << TX_NO_WITNESS(mtx);
+    std::vector<std::byte> superfluous{data.begin(), data.begin() + flag_pos + 1};
+    superfluous.insert(superfluous.end(), stream.begin() + 4, stream.end() - 4);
+    for (size_t i = 0; i < mtx.vin.size(); ++i) superfluous.push_back(std::byte{0});
+    superfluous.insert(superfluous.end(), stream.end() - 4, stream.end());
+    BOOST_CHECK_EXCEPTION(BlockView{superfluous}, std::ios_base::failure, HasReason{"Superfluous witness record"});
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,230 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blockdownload.h>
+#include <test/util/setup_common.h>
+#include <util/time.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+using namespace std::chrono_literals;
+using node::BlockDownloadModel;
+
+namespace {
+//! A fake peer, which serves the blocks requested from it in order.
+struct SimulatedPeer {
+    double bytes_per_second;
+    std::chrono::microseconds latency;
+};
+
+/**
+ * Simulate the download of blocks of the given sizes from fake peers. Blocks
+ * are picked for each peer by the BlockDownloadWalk of PeerManagerImpl, over
+ * a download window above the tip, with either a fixed number of blocks in
+ * flight per peer, or the adaptive window with redundant requests of the
+ * block holding back the window. Returns the time until all blocks are
+ * received.
+ */
+std::chrono::microseconds SimulateBlockDownload(const std::vector<SimulatedPeer>& sim_peers, const std::vector<size_t>& block_sizes, bool adaptive)
+{
+    static constexpr int DOWNLOAD_WINDOW{1024};
+    const int num_blocks = block_sizes.size();
+
+    struct Peer {
+        SimulatedPeer sim;
+        BlockDownloadModel model;
+        //! When the peer finishes sending the blocks requested so far.
+        std::chrono::microseconds busy_until{0};
+        //! Heights in flight from this peer, with the time they were requested.
+        std::vector<std::pair<int, std::chrono::microseconds>> in_flight;
+    };
+    std::vector<Peer> peers;
+    for (const auto& sim : sim_peers) peers.push_back({sim, {}, {}, {}});
+
+    // Arrivals of blocks, as (time, peer, height).
+    using Arrival = std::tuple<std::chrono::microseconds, size_t, int>;
+    std::priority_queue<Arrival, std::vector<Arrival>, std::greater<>> arrivals;
+    std::vector<bool> received(num_blocks);
+    //! Peers each block is in flight from, in the order it was requested from them.
+    std::vector<std::vector<NodeId>> requested_from(num_blocks);
+    int tip{-1};
+
+    const auto request = [&](size_t p, int height, std::chrono::microseconds now) {
+        Peer& peer{peers[p]};
+        const auto start{std::max(now + peer.sim.latency, peer.busy_until)};
+        peer.busy_until = start + std::chrono::microseconds{static_cast<int64_t>(block_sizes[height] / peer.sim.bytes_per_second * 1e6)};
+        peer.in_flight.emplace_back(height, now);
+        requested_from[height].push_back(p);
+        arrivals.emplace(peer.busy_until, p, height);
+    };
+
+    // Like the getdata (blocks) step of PeerManagerImpl::SendMessages.
+    const auto schedule = [&](std::chrono::microseconds now) {
+        const int window_end{tip + DOWNLOAD_WINDOW};
+        const int max_height{std::min(window_end + 1, num_blocks - 1)};
+        for (size_t p = 0; p < peers.size(); ++p) {
+            const size_t window{adaptive ? peers[p].model.GetWindow() : node::DEFAULT_BLOCKS_IN_FLIGHT_PER_PEER};
+            const auto budget = [&] { return window - std::min(window, peers[p].in_flight.size()); };
+            if (budget() == 0) continue;
+            const size_t count{budget()};
+            node::BlockDownloadWalk walk{NodeId(p), window_end};
+            std::vector<int> to_request;
+            for (int height = tip + 1; height <= max_height && to_request.size() < count; ++height) {
+                if (received[height]) continue;
+                const auto in_flight_from{requested_from[height].empty() ? std::nullopt : std::optional{requested_from[height].front()}};
+                const auto step{walk.Next(height, in_flight_from, /*too_deep=*/false)};
+                if (step == node::BlockDownloadWalk::Step::STOP) break;
+                if (step == node::BlockDownloadWalk::Step::REQUEST) to_request.push_back(height);
+            }
+            for (const int height : to_request) request(p, height, now);
+            const auto stalling{walk.GetStallingHeight()};
+            if (adaptive && stalling && node::ShouldRequestStallingBlock(budget(), requested_from[*stalling].size())) {
+                request(p, *stalling, now);
+            }
+        }
+    };
+
+    std::chrono::microseconds now{0};
+    schedule(now);
+    while (tip < num_blocks - 1) {
+        BOOST_REQUIRE(!arrivals.empty());
+        const auto [time, p, height]{arrivals.top()};
+        arrivals.pop();
+        now = time;
+        Peer& peer{peers[p]};
+        const auto it{std::ranges::find(peer.in_flight, height, [](const auto& entry) { return entry.first; })};
+        // Requests are removed from all peers once the block is received.
+        if (it == peer.in_flight.end()) continue;
+        peer.model.BlockReceived(it->second, now, block_sizes[height]);
+        received[height] = true;
+        for (Peer& other : peers) {
+            std::erase_if(other.in_flight, [&](const auto& entry) { return entry.first == height; });
+        }
+        requested_from[height].clear();
+        while (tip + 1 < num_blocks && received[tip + 1]) ++tip;
+        schedule(now);
+    }
+    return now;
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(blockdownload_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(blockdownload_model)
+{
+    BlockDownloadModel model;
+    BOOST_CHECK_EQUAL(model.GetWindow(), node::DEFAULT_BLOCKS_IN_FLIGHT_PER_PEER);
+    BOOST_CHECK(!model.GetBytesPerSecond());
+    BOOST_CHECK(!model.GetLatency());
+
+    // Four blocks requested at once: the first one measures the latency, the
+    // others the throughput of 8 MB/s.
+    model.BlockReceived(0s, 1000ms, 1'000'000);
+    BOOST_CHECK(model.GetLatency() == 1s);
+    BOOST_CHECK(!model.GetBytesPerSecond());
+    model.BlockReceived(0s, 1125ms, 1'000'000);
+    model.BlockReceived(0s, 1250ms, 1'000'000);
+    BOOST_CHECK_EQUAL(*model.GetBytesPerSecond(), 8'000'000);
+    BOOST_CHECK_EQUAL(model.GetWindow(), node::DEFAULT_BLOCKS_IN_FLIGHT_PER_PEER);
+    model.BlockReceived(0s, 1375ms, 1'000'000);
+    BOOST_CHECK_EQUAL(model.GetSamples(), 4U);
+    // The peer delivers 8 blocks per second, for its latency plus TARGET_QUEUE_TIME.
+    BOOST_CHECK_EQUAL(model.GetWindow(), 24U);
+
+    // A block requested while the peer was idle: the response time beyond the
+    // transfer time is averaged into the latency.
+    model.BlockReceived(2000ms, 2500ms, 1'000'000);
+    BOOST_CHECK(model.GetLatency() == 921875us);
+    BOOST_CHECK_EQUAL(*model.GetBytesPerSecond(), 8'000'000);
+    BOOST_CHECK_EQUAL(model.GetWindow(), 24U);
+
+    // Slow peers get few blocks in flight, fast ones many.
+    BlockDownloadModel slow;
+    for (int i = 0; i < 10; ++i) slow.BlockReceived(0s, std::chrono::seconds{4 * (i + 1)}, 1'000'000);
+    BOOST_CHECK_EQUAL(*slow.GetBytesPerSecond(), 250'000);
+    BOOST_CHECK_EQUAL(slow.GetWindow(), node::MIN_BLOCKS_IN_FLIGHT_PER_PEER);
+    BlockDownloadModel fast;
+    for (int i = 0; i < 10; ++i) fast.BlockReceived(0s, 1ms * (i + 1), 1'000'000);
+    BOOST_CHECK_EQUAL(fast.GetWindow(), node::MAX_BLOCKS_IN_FLIGHT_PER_PEER);
+
+    // Blocks processed in the same instant do not break the measurement.
+    BlockDownloadModel burst;
+    for (int i = 0; i < 10; ++i) burst.BlockReceived(0s, 1s, 1'000'000);
+    BOOST_CHECK_EQUAL(burst.GetWindow(), node::MAX_BLOCKS_IN_FLIGHT_PER_PEER);
+}
+
+BOOST_AUTO_TEST_CASE(blockdownload_walk)
+{
+    using Step = node::BlockDownloadWalk::Step;
+
+    // Blocks in flight are skipped, and blocks beyond the window end the walk.
+    node::BlockDownloadWalk walk{/*peer=*/0, /*window_end=*/12};
+    BOOST_CHECK(walk.Next(10, /*in_flight_from=*/1, /*too_deep=*/false) == Step::SKIP);
+    BOOST_CHECK(walk.Next(11, std::nullopt, /*too_deep=*/true) == Step::SKIP);
+    BOOST_CHECK(walk.Next(12, std::nullopt, /*too_deep=*/false) == Step::REQUEST);
+    BOOST_CHECK(walk.Next(13, std::nullopt, /*too_deep=*/false) == Step::STOP);
+    // Something was requested, so the window is not stalled.
+    BOOST_CHECK(!walk.GetStaller());
+    BOOST_CHECK(!walk.GetStallingHeight());
+
+    // The whole window is in flight: the peer of the first block holds it back.
+    node::BlockDownloadWalk stalled{/*peer=*/0, /*window_end=*/11};
+    BOOST_CHECK(stalled.Next(10, /*in_flight_from=*/1, /*too_deep=*/false) == Step::SKIP);
+    BOOST_CHECK(stalled.Next(11, /*in_flight_from=*/2, /*too_deep=*/false) == Step::SKIP);
+    BOOST_CHECK(stalled.Next(12, std::nullopt, /*too_deep=*/false) == Step::STOP);
+    BOOST_CHECK_EQUAL(stalled.GetStaller().value_or(-1), 1);
+    BOOST_CHECK_EQUAL(stalled.GetStallingHeight().value_or(-1), 10);
+
+    // A peer does not stall itself, and blocks it can't serve are not requested again.
+    node::BlockDownloadWalk own{/*peer=*/1, /*window_end=*/10};
+    BOOST_CHECK(own.Next(10, /*in_flight_from=*/1, /*too_deep=*/false) == Step::SKIP);
+    BOOST_CHECK(own.Next(11, std::nullopt, /*too_deep=*/false) == Step::STOP);
+    BOOST_CHECK(!own.GetStaller());
+    node::BlockDownloadWalk deep{/*peer=*/0, /*window_end=*/10};
+    BOOST_CHECK(deep.Next(10, /*in_flight_from=*/1, /*too_deep=*/true) == Step::SKIP);
+    BOOST_CHECK(deep.Next(11, std::nullopt, /*too_deep=*/false) == Step::STOP);
+    BOOST_CHECK_EQUAL(deep.GetStaller().value_or(-1), 1);
+    BOOST_CHECK(!deep.GetStallingHeight());
+
+    BOOST_CHECK(node::ShouldRequestStallingBlock(/*budget=*/1, /*requests=*/1));
+    BOOST_CHECK(!node::ShouldRequestStallingBlock(/*budget=*/0, /*requests=*/1));
+    BOOST_CHECK(!node::ShouldRequestStallingBlock(/*budget=*/1, node::MAX_STALLING_BLOCK_REQUESTS));
+}
+
+BOOST_AUTO_TEST_CASE(blockdownload_simulation)
+{
+    std::vector<size_t> block_sizes(3000);
+    for (auto& size : block_sizes) size = 500'000 + m_rng.randrange(1'000'000);
+
+    // Peers on heterogeneous links, one of them much slower than the others.
+    const std::vector<SimulatedPeer> peers{
+        {20'000'000, 50ms},
+        {10'000'000, 100ms},
+        {5'000'000, 200ms},
+        {2'000'000, 100ms},
+        {200'000, 500ms},
+    };
+    const auto fixed{SimulateBlockDownload(peers, block_sizes, /*adaptive=*/false)};
+    const auto adaptive{SimulateBlockDownload(peers, block_sizes, /*adaptive=*/true)};
+    BOOST_TEST_MESSAGE("Simulated block download: " << Ticks<SecondsDouble>(fixed) << "s with a fixed window, " << Ticks<SecondsDouble>(adaptive) << "s with the adaptive window");
+    BOOST_CHECK(adaptive < fixed);
+
+    // Without a straggler, the adaptive window is about as fast.
+    const std::vector<SimulatedPeer> uniform_peers(4, {10'000'000, 100ms});
+    const auto uniform_fixed{SimulateBlockDownload(uniform_peers, block_sizes, /*adaptive=*/false)};
+    const auto uniform_adaptive{SimulateBlockDownload(uniform_peers, block_sizes, /*adaptive=*/true)};
+    BOOST_CHECK(uniform_adaptive < uniform_fixed * 101 / 100);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
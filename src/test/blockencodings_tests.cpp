@@ -354,6 +354,40 @@ BOOST_AUTO_TEST_CASE(ReceiveWithExtraTransactions) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(ReceiveFromLargeMempool)
+{
+    CTxMemPool& pool = *Assert(m_node.mempool);
+    TestMemPoolEntryHelper entry;
+    auto rand_ctx(FastRandomContext(uint256{42}));
+
+    CBlock block(BuildBlockTestCase(rand_ctx));
+    block.vtx.resize(1);
+    std::vector<CTransactionRef> removed;
+
+    LOCK2(cs_main, pool.cs);
+    for (int i = 0; i < 1000; i++) {
+        CMutableTransaction mtx = BuildTransactionTestCase();
+        mtx.vin[0].prevout.hash = Txid::FromUint256(rand_ctx.rand256());
+        const CTransactionRef tx = MakeTransactionRef(std::move(mtx));
+        AddToMempool(pool, entry.FromTx(tx));
+        if (i % 10 == 0) block.vtx.push_back(tx);
+        if (i % 7 == 0) removed.push_back(tx);
+    }
+    // Removing transactions reorders the remaining ones.
+    for (const auto& tx : removed) pool.removeRecursive(*tx, MemPoolRemovalReason::REPLACED);
+    BOOST_CHECK_EQUAL(pool.wtxids_randomized.size(), pool.txns_randomized.size());
+    for (size_t i = 0; i < pool.txns_randomized.size(); i++) {
+        BOOST_CHECK(pool.wtxids_randomized[i] == pool.txns_randomized[i]->GetWitnessHash());
+    }
+
+    const CBlockHeaderAndShortTxIDs cmpctblock{block, rand_ctx.rand64()};
+    PartiallyDownloadedBlock partial_block(&pool);
+    BOOST_CHECK(partial_block.InitData(cmpctblock, empty_extra_txn) == READ_STATUS_OK);
+    for (size_t i = 1; i < block.vtx.size(); i++) {
+        BOOST_CHECK_EQUAL(partial_block.IsTxAvailable(i), pool.exists(block.vtx[i]->GetWitnessHash()));
+    }
+}
+
 BOOST_AUTO_TEST_CASE(TransactionsRequestSerializationTest) {
     BlockTransactionsRequest req1;
     req1.blockhash = m_rng.rand256();
@@ -8,6 +8,7 @@
 #include <blockfilter.h>
 #include <core_io.h>
 #include <primitives/block.h>
+#include <primitives/block_view.h>
 #include <serialize.h>
 #include <streams.h>
 #include <undo.h>
@@ -171,6 +172,13 @@ BOOST_AUTO_TEST_CASE(blockfilters_json_test)
         BlockFilter computed_filter_basic(BlockFilterType::BASIC, block, block_undo);
         BOOST_CHECK(computed_filter_basic.GetFilter().GetEncoded() == filter_basic);
 
+        // A filter built from a view of the serialized block must be identical.
+        const std::vector<unsigned char> block_data = ParseHex(test[2].get_str());
+        const BlockView block_view{std::as_bytes(std::span{block_data})};
+        const BlockFilter view_filter_basic(BlockFilterType::BASIC, block_view, block_undo);
+        BOOST_CHECK(view_filter_basic.GetEncodedFilter() == filter_basic);
+        BOOST_CHECK_EQUAL(view_filter_basic.GetBlockHash(), computed_filter_basic.GetBlockHash());
+
         uint256 computed_header_basic = computed_filter_basic.ComputeHeader(prev_filter_header_basic);
         BOOST_CHECK(computed_header_basic == filter_header_basic);
     }
@@ -5,11 +5,17 @@
 #include <chain.h>
 #include <chainparams.h>
 #include <clientversion.h>
+#include <consensus/amount.h>
+#include <consensus/validation.h>
+#include <node/blockfile_reader.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
 #include <node/kernel_notifications.h>
 #include <script/solver.h>
 #include <primitives/block.h>
+#include <streams.h>
+#include <undo.h>
+#include <util/strencodings.h>
 #include <util/chaintype.h>
 #include <validation.h>
 
@@ -17,7 +23,12 @@
 #include <test/util/logging.h>
 #include <test/util/setup_common.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
 using node::STORAGE_HEADER_BYTES;
+using node::BLOCK_COMPRESSED_FLAG;
 using node::BlockManager;
 using node::KernelNotifications;
 using node::MAX_BLOCKFILE_SIZE;
@@ -216,4 +227,258 @@ BOOST_AUTO_TEST_CASE(blockmanager_flush_block_file)
     BOOST_CHECK_EQUAL(read_block.nVersion, 2);
 }
 
+BOOST_AUTO_TEST_CASE(blockmanager_compressed_blocks)
+{
+    KernelNotifications notifications{Assert(m_node.shutdown_request), m_node.exit_status, *Assert(m_node.warnings)};
+    node::BlockManager::Options blockman_opts{
+        .chainparams = Params(),
+        .compress_blocks = true,
+        .blocks_dir = m_args.GetBlocksDirPath(),
+        .notifications = notifications,
+        .block_tree_db_params = DBParams{
+            .path = m_args.GetDataDirNet() / "blocks" / "index",
+            .cache_bytes = 0,
+        },
+    };
+    BlockManager blockman{*Assert(m_node.shutdown_signal), blockman_opts};
+
+    // A block with many similar outputs compresses well
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vout.assign(100, CTxOut{COIN, CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, 0x42) << OP_EQUALVERIFY << OP_CHECKSIG});
+    CBlock block;
+    block.nVersion = 1;
+    block.vtx.push_back(MakeTransactionRef(tx));
+    DataStream expected;
+    expected << TX_WITH_WITNESS(block);
+
+    const FlatFilePos pos{blockman.WriteBlock(block, /*nHeight=*/1)};
+    BOOST_CHECK_EQUAL(pos.nPos, STORAGE_HEADER_BYTES);
+    BOOST_CHECK_LT(blockman.CalculateCurrentUsage(), expected.size() / 2);
+
+    std::vector<std::byte> raw_block;
+    BOOST_REQUIRE(blockman.ReadRawBlock(raw_block, pos));
+    BOOST_CHECK(std::ranges::equal(raw_block, expected));
+
+    // A block that does not compress is stored as is
+    CMutableTransaction random_tx;
+    random_tx.vin.emplace_back(Txid::FromUint256(m_rng.rand256()), m_rng.rand32(), CScript() << m_rng.randbytes(1000));
+    random_tx.vout.emplace_back(m_rng.randrange(MAX_MONEY), CScript() << m_rng.randbytes(32));
+    CBlock random_block;
+    random_block.nVersion = 2;
+    random_block.hashPrevBlock = m_rng.rand256();
+    random_block.hashMerkleRoot = m_rng.rand256();
+    random_block.vtx.push_back(MakeTransactionRef(random_tx));
+    DataStream random_expected;
+    random_expected << TX_WITH_WITNESS(random_block);
+    const FlatFilePos random_pos{blockman.WriteBlock(random_block, /*nHeight=*/2)};
+    {
+        AutoFile file{blockman.OpenBlockFile({random_pos.nFile, random_pos.nPos - STORAGE_HEADER_BYTES}, /*fReadOnly=*/true)};
+        MessageStartChars blk_start;
+        uint32_t blk_size;
+        file >> blk_start >> blk_size;
+        BOOST_CHECK_EQUAL(blk_size & BLOCK_COMPRESSED_FLAG, 0U);
+        BOOST_CHECK_EQUAL(blk_size, random_expected.size());
+    }
+    BOOST_REQUIRE(blockman.ReadRawBlock(raw_block, random_pos));
+    BOOST_CHECK(std::ranges::equal(raw_block, random_expected));
+
+    // The reader used by -reindex decompresses blocks as well
+    AutoFile file{blockman.OpenBlockFile({0, 0}, /*fReadOnly=*/true)};
+    node::BlockFileReader reader{file, Params().MessageStart()};
+    auto entry{reader.Next()};
+    BOOST_REQUIRE(entry);
+    BOOST_CHECK_EQUAL(entry->pos, pos.nPos);
+    BOOST_CHECK_EQUAL(entry->hash, block.GetHash());
+    BOOST_REQUIRE(entry->block);
+    BOOST_CHECK_EQUAL(entry->block->vtx.at(0)->GetHash(), tx.GetHash());
+    entry = reader.Next();
+    BOOST_REQUIRE(entry);
+    BOOST_CHECK_EQUAL(entry->hash, random_block.GetHash());
+}
+
+BOOST_AUTO_TEST_CASE(compressed_block_data_malformed)
+{
+    // Too short to hold the size
+    BOOST_CHECK(!node::DecompressBlockData(std::vector<std::byte>(3)));
+    // Size beyond what can be deserialized
+    BOOST_CHECK(!node::DecompressBlockData(ParseHex<std::byte>("ffffffff00")));
+    // Size that does not match the data
+    BOOST_CHECK(!node::DecompressBlockData(ParseHex<std::byte>("020000001061")));
+    const auto data{node::DecompressBlockData(ParseHex<std::byte>("010000001061"))};
+    BOOST_REQUIRE(data);
+    BOOST_CHECK(*data == std::vector<std::byte>{std::byte{'a'}});
+}
+
+BOOST_FIXTURE_TEST_CASE(blockmanager_compress_block_files, TestChain100Setup)
+{
+    auto& chainman{*Assert(m_node.chainman)};
+    auto& blockman{chainman.m_blockman};
+
+    std::vector<std::pair<const CBlockIndex*, std::vector<std::byte>>> blocks;
+    {
+        LOCK(::cs_main);
+        for (const CBlockIndex* index{chainman.ActiveTip()}; index; index = index->pprev) {
+            BOOST_REQUIRE(blockman.ReadRawBlock(blocks.emplace_back(index, std::vector<std::byte>{}).second, index->GetBlockPos()));
+        }
+    }
+    const uint64_t usage_before{blockman.CalculateCurrentUsage()};
+
+    BOOST_CHECK(!WITH_LOCK(::cs_main, return blockman.m_block_tree_db->ReadTxIndexStale()));
+    BOOST_CHECK(blockman.CompressBlockFiles());
+    // The rewrite is recorded for the transaction index to be discarded.
+    BOOST_CHECK(WITH_LOCK(::cs_main, return blockman.m_block_tree_db->ReadTxIndexStale()));
+    BOOST_CHECK(WITH_LOCK(::cs_main, return blockman.m_block_tree_db->EraseTxIndexStale()));
+    // The coinbase transactions of the test chain contain enough zeros to compress.
+    BOOST_CHECK_LT(blockman.CalculateCurrentUsage(), usage_before);
+    BOOST_CHECK(!fs::exists(blockman.GetBlockPosFilename({0, 0}) + ".tmp"));
+    int pending_file;
+    BOOST_CHECK(!WITH_LOCK(::cs_main, return blockman.m_block_tree_db->ReadPendingBlockFile(pending_file)));
+
+    for (const auto& [index, expected] : blocks) {
+        std::vector<std::byte> raw_block;
+        BOOST_CHECK(blockman.ReadRawBlock(raw_block, WITH_LOCK(::cs_main, return index->GetBlockPos())));
+        BOOST_CHECK(raw_block == expected);
+        CBlock block;
+        BOOST_CHECK(blockman.ReadBlock(block, *index));
+    }
+
+    // Compressing again leaves the files as they are
+    const uint64_t usage_compressed{blockman.CalculateCurrentUsage()};
+    BOOST_CHECK(blockman.CompressBlockFiles());
+    BOOST_CHECK(!WITH_LOCK(::cs_main, return blockman.m_block_tree_db->ReadTxIndexStale()));
+    BOOST_CHECK_EQUAL(blockman.CalculateCurrentUsage(), usage_compressed);
+
+    // New blocks are appended after the rewritten ones
+    const CBlock new_block{CreateAndProcessBlock({}, GetScriptForRawPubKey(coinbaseKey.GetPubKey()))};
+    CBlock read_block;
+    BOOST_CHECK(blockman.ReadBlock(read_block, *WITH_LOCK(::cs_main, return chainman.ActiveTip())));
+    BOOST_CHECK_EQUAL(read_block.GetHash(), new_block.GetHash());
+}
+
+BOOST_FIXTURE_TEST_CASE(blockmanager_compact_undo, TestChain100Setup)
+{
+    // Spend coins created at different heights, some paying to the same script.
+    const CScript script{GetScriptForRawPubKey(coinbaseKey.GetPubKey())};
+    CBlockUndo blockundo;
+    for (int i{0}; i < 10; ++i) {
+        CTxUndo& txundo{blockundo.vtxundo.emplace_back()};
+        for (int j{0}; j <= i; ++j) {
+            CScript coin_script{script};
+            if (j % 3 == 0) coin_script << i << j;
+            txundo.vprevout.emplace_back(CTxOut{i * COIN + j, coin_script}, /*nHeightIn=*/100 - i * 10 + j, /*fCoinBaseIn=*/j == 0);
+        }
+    }
+    DataStream expected;
+    expected << blockundo;
+
+    DataStream compact;
+    compact << Using<BlockUndoCompactFormatter>(blockundo);
+    BOOST_CHECK_LT(compact.size(), expected.size());
+    CBlockUndo decoded;
+    compact >> Using<BlockUndoCompactFormatter>(decoded);
+    BOOST_CHECK(compact.empty());
+    DataStream reserialized;
+    reserialized << decoded;
+    BOOST_CHECK(std::ranges::equal(reserialized, expected));
+
+    // Undo data written in the compact format is read back transparently.
+    KernelNotifications notifications{Assert(m_node.shutdown_request), m_node.exit_status, *Assert(m_node.warnings)};
+    const fs::path blocks_dir{m_args.GetDataDirNet() / "blocks_compact_undo"};
+    fs::create_directories(blocks_dir);
+    BlockManager blockman{*Assert(m_node.shutdown_signal), BlockManager::Options{
+        .chainparams = Params(),
+        .compact_undo = true,
+        .blocks_dir = blocks_dir,
+        .notifications = notifications,
+        .block_tree_db_params = DBParams{
+            .path = blocks_dir / "index",
+            .cache_bytes = 0,
+        },
+    }};
+    CBlockIndex* prev{WITH_LOCK(::cs_main, return m_node.chainman->ActiveTip())};
+    CBlock block;
+    const FlatFilePos pos{blockman.WriteBlock(block, prev->nHeight + 1)};
+    CBlockIndex index;
+    index.pprev = prev;
+    index.nHeight = prev->nHeight + 1;
+    index.nFile = pos.nFile;
+    BlockValidationState state;
+    BOOST_REQUIRE(WITH_LOCK(::cs_main, return blockman.WriteBlockUndo(blockundo, state, index)));
+    BOOST_CHECK_EQUAL(blockman.GetBlockFileInfo(pos.nFile)->nUndoSize, GetSerializeSize(Using<BlockUndoCompactFormatter>(blockundo)) + node::UNDO_DATA_DISK_OVERHEAD);
+    decoded = {};
+    BOOST_REQUIRE(blockman.ReadBlockUndo(decoded, index));
+    reserialized.clear();
+    reserialized << decoded;
+    BOOST_CHECK(std::ranges::equal(reserialized, expected));
+
+    // Undo data of the test chain is in the original format.
+    const CBlockIndex* tip{WITH_LOCK(::cs_main, return m_node.chainman->ActiveTip())};
+    BOOST_REQUIRE(m_node.chainman->m_blockman.ReadBlockUndo(decoded, *tip));
+}
+
+BOOST_AUTO_TEST_CASE(compact_undo_malformed)
+{
+    CBlockUndo blockundo;
+    // Per transaction counts that do not add up
+    BOOST_CHECK_THROW(DataStream(ParseHex("0100000002000000000000000100000000")) >> Using<BlockUndoCompactFormatter>(blockundo), std::ios_base::failure);
+    // More coins than a block can spend
+    BOOST_CHECK_THROW(DataStream(ParseHex("01000000ffffffff00000000ffffffff")) >> Using<BlockUndoCompactFormatter>(blockundo), std::ios_base::failure);
+    // Coin older than the genesis block
+    BOOST_CHECK_THROW(DataStream(ParseHex("01000000010000000000000001000000020000")) >> Using<BlockUndoCompactFormatter>(blockundo), std::ios_base::failure);
+    // Reference to a script not seen yet
+    BOOST_CHECK_THROW(DataStream(ParseHex("010000000100000000000000010000000000010000")) >> Using<BlockUndoCompactFormatter>(blockundo), std::ios_base::failure);
+}
+
+BOOST_AUTO_TEST_CASE(blockfile_reader)
+{
+    const MessageStartChars& message_start{Params().MessageStart()};
+    const fs::path path{m_args.GetDataDirBase() / "blk_reader.dat"};
+
+    CBlock block1;
+    block1.nVersion = 1;
+    CBlock block2;
+    block2.nVersion = 2;
+    CBlock block3;
+    block3.nVersion = 3;
+    {
+        AutoFile file{fsbridge::fopen(path, "wb")};
+        // Junk before the first block is skipped
+        file << uint8_t{0x42} << message_start[0] << uint8_t{0x42};
+        file << message_start << uint32_t{81} << TX_WITH_WITNESS(block1);
+        // A message start with an implausible size is skipped
+        file << message_start << uint32_t{10};
+        // A block whose header reads fine but whose transactions don't
+        file << message_start << uint32_t{89} << block2.GetBlockHeader() << uint8_t{1} << uint64_t{std::numeric_limits<uint64_t>::max()};
+        file << message_start << uint32_t{81} << TX_WITH_WITNESS(block3);
+        BOOST_REQUIRE_EQUAL(file.fclose(), 0);
+    }
+
+    // Reading ahead is limited to a single block at a time.
+    AutoFile file{fsbridge::fopen(path, "rb")};
+    node::BlockFileReader reader{file, message_start, /*max_buffered=*/1};
+
+    auto entry{reader.Next()};
+    BOOST_REQUIRE(entry);
+    BOOST_CHECK_EQUAL(entry->pos, 3U + 8U);
+    BOOST_CHECK_EQUAL(entry->hash, block1.GetHash());
+    BOOST_REQUIRE(entry->block);
+    BOOST_CHECK_EQUAL(entry->block->nVersion, 1);
+
+    entry = reader.Next();
+    BOOST_REQUIRE(entry);
+    BOOST_CHECK_EQUAL(entry->hash, block2.GetHash());
+    BOOST_CHECK(!entry->block);
+    BOOST_CHECK(!entry->error.empty());
+
+    entry = reader.Next();
+    BOOST_REQUIRE(entry);
+    BOOST_CHECK_EQUAL(entry->hash, block3.GetHash());
+    BOOST_REQUIRE(entry->block);
+    BOOST_CHECK_EQUAL(entry->block->nVersion, 3);
+
+    BOOST_CHECK(!reader.Next());
+    BOOST_CHECK(!reader.Next());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
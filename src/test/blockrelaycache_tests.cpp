@@ -0,0 +1,126 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <memusage.h>
+#include <net.h>
+#include <node/blockrelaycache.h>
+#include <protocol.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+using node::BlockRelayCache;
+
+namespace {
+CSerializedNetMsg MakeMessage(const std::string& msg_type, std::vector<unsigned char> data)
+{
+    CSerializedNetMsg msg;
+    msg.m_type = msg_type;
+    msg.data = std::move(data);
+    return msg;
+}
+
+std::vector<unsigned char> Bytes(std::span<const unsigned char> payload) { return {payload.begin(), payload.end()}; }
+
+//! All bytes the transport produces for msg.
+std::vector<unsigned char> Serialize(CSerializedNetMsg&& msg)
+{
+    V1Transport transport{/*node_id=*/0};
+    BOOST_REQUIRE(transport.SetMessageToSend(msg));
+    std::vector<unsigned char> ret;
+    while (true) {
+        const auto& [bytes, more, msg_type] = transport.GetBytesToSend(/*have_next_message=*/false);
+        if (bytes.empty()) break;
+        ret.insert(ret.end(), bytes.begin(), bytes.end());
+        transport.MarkBytesSent(bytes.size());
+    }
+    return ret;
+}
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(blockrelaycache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(blockrelaycache_hits)
+{
+    BlockRelayCache cache;
+    const uint256 hash{m_rng.rand256()};
+    const std::vector<unsigned char> payload{m_rng.randbytes(1000)};
+    const BlockRelayCache::Key key{NetMsgType::CMPCTBLOCK, hash, {}};
+
+    BOOST_CHECK(!cache.Find(key));
+    int serialized{0};
+    const auto make{[&] {
+        ++serialized;
+        return MakeMessage(NetMsgType::CMPCTBLOCK, payload);
+    }};
+    const CSerializedNetMsg first{cache.Get(key, make)};
+    const CSerializedNetMsg second{cache.Get(key, make)};
+    BOOST_CHECK_EQUAL(serialized, 1);
+    BOOST_CHECK_EQUAL(first.m_type, NetMsgType::CMPCTBLOCK);
+    BOOST_CHECK(Bytes(first.Payload()) == payload);
+    BOOST_CHECK(first.data.empty());
+    // Both messages share the cached payload.
+    BOOST_CHECK_EQUAL(first.Payload().data(), second.Payload().data());
+    BOOST_CHECK_EQUAL(first.Copy().Payload().data(), first.Payload().data());
+
+    // Other variants and message types of the same block are separate entries.
+    BOOST_CHECK(!cache.Find({NetMsgType::CMPCTBLOCK, hash, uint256::ONE}));
+    BOOST_CHECK(!cache.Find({NetMsgType::BLOCK, hash, {}}));
+
+    const auto stats{cache.GetStats()};
+    BOOST_CHECK_EQUAL(stats.hits, 1U);
+    BOOST_CHECK_EQUAL(stats.misses, 4U);
+    BOOST_CHECK_EQUAL(stats.entries, 1U);
+    BOOST_CHECK_EQUAL(stats.bytes, memusage::DynamicUsage(payload));
+
+    // A shared payload goes over the wire like an owned one.
+    BOOST_CHECK(Serialize(first.Copy()) == Serialize(MakeMessage(NetMsgType::CMPCTBLOCK, payload)));
+}
+
+BOOST_AUTO_TEST_CASE(blockrelaycache_eviction)
+{
+    const std::vector<unsigned char> payload(10'000, 0x42);
+    const size_t entry_bytes{memusage::DynamicUsage(payload)};
+    BlockRelayCache cache{3 * entry_bytes};
+
+    std::vector<BlockRelayCache::Key> keys;
+    for (int i = 0; i < 4; ++i) keys.push_back({NetMsgType::BLOCK, m_rng.rand256(), {}});
+
+    const CSerializedNetMsg evicted{cache.Insert(keys[0], MakeMessage(NetMsgType::BLOCK, payload))};
+    cache.Insert(keys[1], MakeMessage(NetMsgType::BLOCK, payload));
+    cache.Insert(keys[2], MakeMessage(NetMsgType::BLOCK, payload));
+    // Using the second entry makes the first one the least recently used.
+    BOOST_CHECK(cache.Find(keys[1]));
+    cache.Insert(keys[3], MakeMessage(NetMsgType::BLOCK, payload));
+    BOOST_CHECK(!cache.Find(keys[0]));
+    BOOST_CHECK(cache.Find(keys[1]));
+    BOOST_CHECK(cache.Find(keys[2]));
+    BOOST_CHECK(cache.Find(keys[3]));
+    BOOST_CHECK_EQUAL(cache.GetStats().entries, 3U);
+    BOOST_CHECK_EQUAL(cache.GetStats().bytes, 3 * entry_bytes);
+    // Messages handed out before the eviction keep their payload.
+    BOOST_CHECK(Bytes(evicted.Payload()) == payload);
+
+    // Inserting a key which is already cached returns the cached payload.
+    const auto cached{cache.Find(keys[3])};
+    const CSerializedNetMsg raced{cache.Insert(keys[3], MakeMessage(NetMsgType::BLOCK, payload))};
+    BOOST_CHECK_EQUAL(raced.Payload().data(), cached->Payload().data());
+    BOOST_CHECK_EQUAL(cache.GetStats().entries, 3U);
+
+    // Payloads beyond the budget are passed through without evicting anything.
+    const std::vector<unsigned char> large(4 * payload.size(), 0x43);
+    const CSerializedNetMsg msg{cache.Insert({NetMsgType::BLOCK, m_rng.rand256(), {}}, MakeMessage(NetMsgType::BLOCK, large))};
+    BOOST_CHECK(Bytes(msg.Payload()) == large);
+    BOOST_CHECK_EQUAL(cache.GetStats().entries, 3U);
+    BOOST_CHECK(cache.Find(keys[1]));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
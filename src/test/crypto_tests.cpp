@@ -22,6 +22,7 @@
 #include <util/strencodings.h>
 
 #include <algorithm>
+#include <limits>
 #include <vector>
 
 #include <boost/test/unit_test.hpp>
@@ -1086,6 +1087,74 @@ BOOST_AUTO_TEST_CASE(sha256d64)
     }
 }
 
+BOOST_AUTO_TEST_CASE(sha256_multi)
+{
+    using namespace sha256_implementation;
+    for (UseImplementation implementation : {STANDARD, USE_SSE4, USE_SSE4_AND_AVX2, USE_ALL}) {
+        SHA256AutoDetect(implementation);
+        for (int i = 0; i <= 40; ++i) {
+            // Lengths around the one and two padding block boundaries, so that
+            // lanes finish at different times.
+            std::vector<std::vector<unsigned char>> data;
+            std::vector<std::span<const unsigned char>> messages;
+            for (int j = 0; j < i; ++j) data.push_back(m_rng.randbytes(m_rng.randrange(300)));
+            for (const auto& message : data) messages.emplace_back(message);
+            std::vector<unsigned char> out1(32 * i), out2(32 * i), out3(32 * i), out4(32 * i);
+            for (int j = 0; j < i; ++j) {
+                CSHA256().Write(data[j].data(), data[j].size()).Finalize(out1.data() + 32 * j);
+                CHash256().Write(data[j]).Finalize({out3.data() + 32 * j, 32});
+            }
+            SHA256Multi(out2.data(), messages);
+            SHA256DMulti(out4.data(), messages);
+            BOOST_CHECK(out1 == out2);
+            BOOST_CHECK(out3 == out4);
+        }
+    }
+    SHA256AutoDetect();
+}
+
+BOOST_AUTO_TEST_CASE(chacha20_poly1305_implementations)
+{
+    // Compare the optimized implementations against the standard ones over
+    // lengths around their block multiples, and a block counter that carries
+    // into the nonce partway through.
+    const auto key = m_rng.randbytes<std::byte>(32);
+    const ChaCha20::Nonce96 nonce{m_rng.rand32(), m_rng.rand64()};
+    const uint32_t counter = std::numeric_limits<uint32_t>::max() - m_rng.randrange(64);
+    for (size_t len : {0, 1, 63, 64, 65, 511, 512, 513, 1023, 1024, 1025, 1600, 4097}) {
+        const auto plain = m_rng.randbytes<std::byte>(len);
+        std::vector<std::byte> expected_cipher(len), expected_keystream(len), cipher(len), keystream(len);
+        std::vector<std::byte> expected_tag(Poly1305::TAGLEN), tag(Poly1305::TAGLEN);
+
+        ChaCha20AutoDetect(chacha20_implementation::STANDARD);
+        Poly1305AutoDetect(/*use_optimized=*/false);
+        ChaCha20 chacha20{key};
+        chacha20.Seek(nonce, counter);
+        chacha20.Crypt(plain, expected_cipher);
+        chacha20.Seek(nonce, counter);
+        chacha20.Keystream(expected_keystream);
+        Poly1305{key}.Update(plain).Finalize(expected_tag);
+
+        using namespace chacha20_implementation;
+        for (UseImplementation implementation : {USE_AVX2, USE_AVX512, USE_ALL}) {
+            ChaCha20AutoDetect(implementation);
+            chacha20.Seek(nonce, counter);
+            chacha20.Crypt(plain, cipher);
+            BOOST_CHECK(cipher == expected_cipher);
+            // Fragmented, to exercise the buffering of partial blocks.
+            const size_t split = m_rng.randrange(len + 1);
+            chacha20.Seek(nonce, counter);
+            chacha20.Keystream(std::span{keystream}.first(split));
+            chacha20.Keystream(std::span{keystream}.subspan(split));
+            BOOST_CHECK(keystream == expected_keystream);
+        }
+        Poly1305AutoDetect();
+        Poly1305{key}.Update(plain).Finalize(tag);
+        BOOST_CHECK(tag == expected_tag);
+    }
+    ChaCha20AutoDetect();
+}
+
 void CryptoTest::TestSHA3_256(const std::string& input, const std::string& output)
 {
     const auto in_bytes = ParseHex(input);
@@ -3,344 +3,410 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <dbwrapper.h>
+#include <logging.h>
+#include <test/util/logging.h>
 #include <test/util/random.h>
 #include <test/util/setup_common.h>
 #include <uint256.h>
 #include <util/string.h>
 
+#include <array>
 #include <memory>
+#include <optional>
 #include <ranges>
+#include <utility>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
 using util::ToString;
 
+//! Every test runs against each storage engine.
+static constexpr std::array ALL_ENGINES{DBEngine::LEVELDB, DBEngine::LOGSTORE};
+
 BOOST_FIXTURE_TEST_SUITE(dbwrapper_tests, BasicTestingSetup)
 
 BOOST_AUTO_TEST_CASE(dbwrapper)
 {
-    // Perform tests both obfuscated and non-obfuscated.
-    for (const bool obfuscate : {false, true}) {
-        constexpr size_t CACHE_SIZE{1_MiB};
-        const fs::path path{m_args.GetDataDirBase() / "dbwrapper"};
+    for (const DBEngine engine : ALL_ENGINES) {
+        // Perform tests both obfuscated and non-obfuscated.
+        for (const bool obfuscate : {false, true}) {
+            constexpr size_t CACHE_SIZE{1_MiB};
+            const fs::path path{m_args.GetDataDirBase() / fs::u8path(DBEngineName(engine)) / "dbwrapper"};
+
+            Obfuscation obfuscation;
+            std::vector<std::pair<uint8_t, uint256>> key_values{};
+
+            // Write values
+            {
+                CDBWrapper dbw{{.path = path, .cache_bytes = CACHE_SIZE, .wipe_data = true, .obfuscate = obfuscate, .options = {.engine = engine}}};
+                BOOST_CHECK_EQUAL(obfuscate, !dbw.IsEmpty());
+
+                // Ensure that we're doing real obfuscation when obfuscate=true
+                obfuscation = dbwrapper_private::GetObfuscation(dbw);
+                BOOST_CHECK_EQUAL(obfuscate, dbwrapper_private::GetObfuscation(dbw));
+
+                for (uint8_t k{0}; k < 10; ++k) {
+                    uint8_t key{k};
+                    uint256 value{m_rng.rand256()};
+                    BOOST_CHECK(dbw.Write(key, value));
+                    key_values.emplace_back(key, value);
+                }
+            }
 
-        Obfuscation obfuscation;
-        std::vector<std::pair<uint8_t, uint256>> key_values{};
+            // Verify that the obfuscation key is never obfuscated
+            {
+                CDBWrapper dbw{{.path = path, .cache_bytes = CACHE_SIZE, .obfuscate = false, .options = {.engine = engine}}};
+                BOOST_CHECK_EQUAL(obfuscation, dbwrapper_private::GetObfuscation(dbw));
+            }
 
-        // Write values
-        {
-            CDBWrapper dbw{{.path = path, .cache_bytes = CACHE_SIZE, .wipe_data = true, .obfuscate = obfuscate}};
-            BOOST_CHECK_EQUAL(obfuscate, !dbw.IsEmpty());
+            // Read back the values
+            {
+                CDBWrapper dbw{{.path = path, .cache_bytes = CACHE_SIZE, .obfuscate = obfuscate, .options = {.engine = engine}}};
 
-            // Ensure that we're doing real obfuscation when obfuscate=true
-            obfuscation = dbwrapper_private::GetObfuscation(dbw);
-            BOOST_CHECK_EQUAL(obfuscate, dbwrapper_private::GetObfuscation(dbw));
+                // Ensure obfuscation is read back correctly
+                BOOST_CHECK_EQUAL(obfuscation, dbwrapper_private::GetObfuscation(dbw));
+                BOOST_CHECK_EQUAL(obfuscate, dbwrapper_private::GetObfuscation(dbw));
 
-            for (uint8_t k{0}; k < 10; ++k) {
-                uint8_t key{k};
-                uint256 value{m_rng.rand256()};
-                BOOST_CHECK(dbw.Write(key, value));
-                key_values.emplace_back(key, value);
+                // Verify all written values
+                for (const auto& [key, expected_value] : key_values) {
+                    uint256 read_value{};
+                    BOOST_CHECK(dbw.Read(key, read_value));
+                    BOOST_CHECK_EQUAL(read_value, expected_value);
+                }
             }
         }
+    }
+}
 
-        // Verify that the obfuscation key is never obfuscated
-        {
-            CDBWrapper dbw{{.path = path, .cache_bytes = CACHE_SIZE, .obfuscate = false}};
-            BOOST_CHECK_EQUAL(obfuscation, dbwrapper_private::GetObfuscation(dbw));
-        }
+BOOST_AUTO_TEST_CASE(dbwrapper_basic_data)
+{
+    for (const DBEngine engine : ALL_ENGINES) {
+        // Perform tests both obfuscated and non-obfuscated.
+        for (bool obfuscate : {false, true}) {
+            fs::path ph = m_args.GetDataDirBase() / fs::u8path(DBEngineName(engine)) / (obfuscate ? "dbwrapper_1_obfuscate_true" : "dbwrapper_1_obfuscate_false");
+            CDBWrapper dbw({.path = ph, .cache_bytes = 1 << 20, .memory_only = false, .wipe_data = true, .obfuscate = obfuscate, .options = {.engine = engine}});
 
-        // Read back the values
-        {
-            CDBWrapper dbw{{.path = path, .cache_bytes = CACHE_SIZE, .obfuscate = obfuscate}};
+            uint256 res;
+            uint32_t res_uint_32;
+            bool res_bool;
 
-            // Ensure obfuscation is read back correctly
-            BOOST_CHECK_EQUAL(obfuscation, dbwrapper_private::GetObfuscation(dbw));
+            // Ensure that we're doing real obfuscation when obfuscate=true
             BOOST_CHECK_EQUAL(obfuscate, dbwrapper_private::GetObfuscation(dbw));
 
-            // Verify all written values
-            for (const auto& [key, expected_value] : key_values) {
-                uint256 read_value{};
-                BOOST_CHECK(dbw.Read(key, read_value));
-                BOOST_CHECK_EQUAL(read_value, expected_value);
-            }
+            //Simulate block raw data - "b + block hash"
+            std::string key_block = "b" + m_rng.rand256().ToString();
+
+            uint256 in_block = m_rng.rand256();
+            BOOST_CHECK(dbw.Write(key_block, in_block));
+            BOOST_CHECK(dbw.Read(key_block, res));
+            BOOST_CHECK_EQUAL(res.ToString(), in_block.ToString());
+
+            //Simulate file raw data - "f + file_number"
+            std::string key_file = strprintf("f%04x", m_rng.rand32());
+
+            uint256 in_file_info = m_rng.rand256();
+            BOOST_CHECK(dbw.Write(key_file, in_file_info));
+            BOOST_CHECK(dbw.Read(key_file, res));
+            BOOST_CHECK_EQUAL(res.ToString(), in_file_info.ToString());
+
+            //Simulate transaction raw data - "t + transaction hash"
+            std::string key_transaction = "t" + m_rng.rand256().ToString();
+
+            uint256 in_transaction = m_rng.rand256();
+            BOOST_CHECK(dbw.Write(key_transaction, in_transaction));
+            BOOST_CHECK(dbw.Read(key_transaction, res));
+            BOOST_CHECK_EQUAL(res.ToString(), in_transaction.ToString());
+
+            //Simulate UTXO raw data - "c + transaction hash"
+            std::string key_utxo = "c" + m_rng.rand256().ToString();
+
+            uint256 in_utxo = m_rng.rand256();
+            BOOST_CHECK(dbw.Write(key_utxo, in_utxo));
+            BOOST_CHECK(dbw.Read(key_utxo, res));
+            BOOST_CHECK_EQUAL(res.ToString(), in_utxo.ToString());
+
+            //Simulate last block file number - "l"
+            uint8_t key_last_blockfile_number{'l'};
+            uint32_t lastblockfilenumber = m_rng.rand32();
+            BOOST_CHECK(dbw.Write(key_last_blockfile_number, lastblockfilenumber));
+            BOOST_CHECK(dbw.Read(key_last_blockfile_number, res_uint_32));
+            BOOST_CHECK_EQUAL(lastblockfilenumber, res_uint_32);
+
+            //Simulate Is Reindexing - "R"
+            uint8_t key_IsReindexing{'R'};
+            bool isInReindexing = m_rng.randbool();
+            BOOST_CHECK(dbw.Write(key_IsReindexing, isInReindexing));
+            BOOST_CHECK(dbw.Read(key_IsReindexing, res_bool));
+            BOOST_CHECK_EQUAL(isInReindexing, res_bool);
+
+            //Simulate last block hash up to which UXTO covers - 'B'
+            uint8_t key_lastblockhash_uxto{'B'};
+            uint256 lastblock_hash = m_rng.rand256();
+            BOOST_CHECK(dbw.Write(key_lastblockhash_uxto, lastblock_hash));
+            BOOST_CHECK(dbw.Read(key_lastblockhash_uxto, res));
+            BOOST_CHECK_EQUAL(lastblock_hash, res);
+
+            //Simulate file raw data - "F + filename_number + filename"
+            std::string file_option_tag = "F";
+            uint8_t filename_length = m_rng.randbits(8);
+            std::string filename = "randomfilename";
+            std::string key_file_option = strprintf("%s%01x%s", file_option_tag, filename_length, filename);
+
+            bool in_file_bool = m_rng.randbool();
+            BOOST_CHECK(dbw.Write(key_file_option, in_file_bool));
+            BOOST_CHECK(dbw.Read(key_file_option, res_bool));
+            BOOST_CHECK_EQUAL(res_bool, in_file_bool);
         }
     }
 }
 
-BOOST_AUTO_TEST_CASE(dbwrapper_basic_data)
+// Test batch operations
+BOOST_AUTO_TEST_CASE(dbwrapper_batch)
 {
-    // Perform tests both obfuscated and non-obfuscated.
-    for (bool obfuscate : {false, true}) {
-        fs::path ph = m_args.GetDataDirBase() / (obfuscate ? "dbwrapper_1_obfuscate_true" : "dbwrapper_1_obfuscate_false");
-        CDBWrapper dbw({.path = ph, .cache_bytes = 1 << 20, .memory_only = false, .wipe_data = true, .obfuscate = obfuscate});
-
-        uint256 res;
-        uint32_t res_uint_32;
-        bool res_bool;
-
-        // Ensure that we're doing real obfuscation when obfuscate=true
-        BOOST_CHECK_EQUAL(obfuscate, dbwrapper_private::GetObfuscation(dbw));
-
-        //Simulate block raw data - "b + block hash"
-        std::string key_block = "b" + m_rng.rand256().ToString();
-
-        uint256 in_block = m_rng.rand256();
-        BOOST_CHECK(dbw.Write(key_block, in_block));
-        BOOST_CHECK(dbw.Read(key_block, res));
-        BOOST_CHECK_EQUAL(res.ToString(), in_block.ToString());
-
-        //Simulate file raw data - "f + file_number"
-        std::string key_file = strprintf("f%04x", m_rng.rand32());
-
-        uint256 in_file_info = m_rng.rand256();
-        BOOST_CHECK(dbw.Write(key_file, in_file_info));
-        BOOST_CHECK(dbw.Read(key_file, res));
-        BOOST_CHECK_EQUAL(res.ToString(), in_file_info.ToString());
-
-        //Simulate transaction raw data - "t + transaction hash"
-        std::string key_transaction = "t" + m_rng.rand256().ToString();
-
-        uint256 in_transaction = m_rng.rand256();
-        BOOST_CHECK(dbw.Write(key_transaction, in_transaction));
-        BOOST_CHECK(dbw.Read(key_transaction, res));
-        BOOST_CHECK_EQUAL(res.ToString(), in_transaction.ToString());
-
-        //Simulate UTXO raw data - "c + transaction hash"
-        std::string key_utxo = "c" + m_rng.rand256().ToString();
-
-        uint256 in_utxo = m_rng.rand256();
-        BOOST_CHECK(dbw.Write(key_utxo, in_utxo));
-        BOOST_CHECK(dbw.Read(key_utxo, res));
-        BOOST_CHECK_EQUAL(res.ToString(), in_utxo.ToString());
-
-        //Simulate last block file number - "l"
-        uint8_t key_last_blockfile_number{'l'};
-        uint32_t lastblockfilenumber = m_rng.rand32();
-        BOOST_CHECK(dbw.Write(key_last_blockfile_number, lastblockfilenumber));
-        BOOST_CHECK(dbw.Read(key_last_blockfile_number, res_uint_32));
-        BOOST_CHECK_EQUAL(lastblockfilenumber, res_uint_32);
-
-        //Simulate Is Reindexing - "R"
-        uint8_t key_IsReindexing{'R'};
-        bool isInReindexing = m_rng.randbool();
-        BOOST_CHECK(dbw.Write(key_IsReindexing, isInReindexing));
-        BOOST_CHECK(dbw.Read(key_IsReindexing, res_bool));
-        BOOST_CHECK_EQUAL(isInReindexing, res_bool);
-
-        //Simulate last block hash up to which UXTO covers - 'B'
-        uint8_t key_lastblockhash_uxto{'B'};
-        uint256 lastblock_hash = m_rng.rand256();
-        BOOST_CHECK(dbw.Write(key_lastblockhash_uxto, lastblock_hash));
-        BOOST_CHECK(dbw.Read(key_lastblockhash_uxto, res));
-        BOOST_CHECK_EQUAL(lastblock_hash, res);
-
-        //Simulate file raw data - "F + filename_number + filename"
-        std::string file_option_tag = "F";
-        uint8_t filename_length = m_rng.randbits(8);
-        std::string filename = "randomfilename";
-        std::string key_file_option = strprintf("%s%01x%s", file_option_tag, filename_length, filename);
-
-        bool in_file_bool = m_rng.randbool();
-        BOOST_CHECK(dbw.Write(key_file_option, in_file_bool));
-        BOOST_CHECK(dbw.Read(key_file_option, res_bool));
-        BOOST_CHECK_EQUAL(res_bool, in_file_bool);
+    for (const DBEngine engine : ALL_ENGINES) {
+        // Perform tests both obfuscated and non-obfuscated.
+        for (const bool obfuscate : {false, true}) {
+            fs::path ph = m_args.GetDataDirBase() / fs::u8path(DBEngineName(engine)) / (obfuscate ? "dbwrapper_batch_obfuscate_true" : "dbwrapper_batch_obfuscate_false");
+            CDBWrapper dbw({.path = ph, .cache_bytes = 1 << 20, .memory_only = true, .wipe_data = false, .obfuscate = obfuscate, .options = {.engine = engine}});
+
+            uint8_t key{'i'};
+            uint256 in = m_rng.rand256();
+            uint8_t key2{'j'};
+            uint256 in2 = m_rng.rand256();
+            uint8_t key3{'k'};
+            uint256 in3 = m_rng.rand256();
+
+            uint256 res;
+            CDBBatch batch(dbw);
+
+            batch.Write(key, in);
+            batch.Write(key2, in2);
+            batch.Write(key3, in3);
+
+            // Remove key3 before it's even been written
+            batch.Erase(key3);
+
+            BOOST_CHECK(dbw.WriteBatch(batch));
+
+            BOOST_CHECK(dbw.Read(key, res));
+            BOOST_CHECK_EQUAL(res.ToString(), in.ToString());
+            BOOST_CHECK(dbw.Read(key2, res));
+            BOOST_CHECK_EQUAL(res.ToString(), in2.ToString());
+
+            // key3 should've never been written
+            BOOST_CHECK(dbw.Read(key3, res) == false);
+        }
     }
 }
 
-// Test batch operations
-BOOST_AUTO_TEST_CASE(dbwrapper_batch)
+BOOST_AUTO_TEST_CASE(dbwrapper_iterator)
 {
-    // Perform tests both obfuscated and non-obfuscated.
-    for (const bool obfuscate : {false, true}) {
-        fs::path ph = m_args.GetDataDirBase() / (obfuscate ? "dbwrapper_batch_obfuscate_true" : "dbwrapper_batch_obfuscate_false");
-        CDBWrapper dbw({.path = ph, .cache_bytes = 1 << 20, .memory_only = true, .wipe_data = false, .obfuscate = obfuscate});
+    for (const DBEngine engine : ALL_ENGINES) {
+        // Perform tests both obfuscated and non-obfuscated.
+        for (const bool obfuscate : {false, true}) {
+            fs::path ph = m_args.GetDataDirBase() / fs::u8path(DBEngineName(engine)) / (obfuscate ? "dbwrapper_iterator_obfuscate_true" : "dbwrapper_iterator_obfuscate_false");
+            CDBWrapper dbw({.path = ph, .cache_bytes = 1 << 20, .memory_only = true, .wipe_data = false, .obfuscate = obfuscate, .options = {.engine = engine}});
 
-        uint8_t key{'i'};
-        uint256 in = m_rng.rand256();
-        uint8_t key2{'j'};
-        uint256 in2 = m_rng.rand256();
-        uint8_t key3{'k'};
-        uint256 in3 = m_rng.rand256();
+            // The two keys are intentionally chosen for ordering
+            uint8_t key{'j'};
+            uint256 in = m_rng.rand256();
+            BOOST_CHECK(dbw.Write(key, in));
+            uint8_t key2{'k'};
+            uint256 in2 = m_rng.rand256();
+            BOOST_CHECK(dbw.Write(key2, in2));
 
-        uint256 res;
-        CDBBatch batch(dbw);
+            std::unique_ptr<CDBIterator> it(const_cast<CDBWrapper&>(dbw).NewIterator());
 
-        batch.Write(key, in);
-        batch.Write(key2, in2);
-        batch.Write(key3, in3);
+            // Be sure to seek past the obfuscation key (if it exists)
+            it->Seek(key);
 
-        // Remove key3 before it's even been written
-        batch.Erase(key3);
+            uint8_t key_res;
+            uint256 val_res;
 
-        BOOST_CHECK(dbw.WriteBatch(batch));
+            BOOST_REQUIRE(it->GetKey(key_res));
+            BOOST_REQUIRE(it->GetValue(val_res));
+            BOOST_CHECK_EQUAL(key_res, key);
+            BOOST_CHECK_EQUAL(val_res.ToString(), in.ToString());
 
-        BOOST_CHECK(dbw.Read(key, res));
-        BOOST_CHECK_EQUAL(res.ToString(), in.ToString());
-        BOOST_CHECK(dbw.Read(key2, res));
-        BOOST_CHECK_EQUAL(res.ToString(), in2.ToString());
+            it->Next();
+
+            BOOST_REQUIRE(it->GetKey(key_res));
+            BOOST_REQUIRE(it->GetValue(val_res));
+            BOOST_CHECK_EQUAL(key_res, key2);
+            BOOST_CHECK_EQUAL(val_res.ToString(), in2.ToString());
 
-        // key3 should've never been written
-        BOOST_CHECK(dbw.Read(key3, res) == false);
+            it->Next();
+            BOOST_CHECK_EQUAL(it->Valid(), false);
+        }
     }
 }
 
-BOOST_AUTO_TEST_CASE(dbwrapper_iterator)
+// Test that we do not obfuscation if there is existing data.
+BOOST_AUTO_TEST_CASE(existing_data_no_obfuscate)
 {
-    // Perform tests both obfuscated and non-obfuscated.
-    for (const bool obfuscate : {false, true}) {
-        fs::path ph = m_args.GetDataDirBase() / (obfuscate ? "dbwrapper_iterator_obfuscate_true" : "dbwrapper_iterator_obfuscate_false");
-        CDBWrapper dbw({.path = ph, .cache_bytes = 1 << 20, .memory_only = true, .wipe_data = false, .obfuscate = obfuscate});
-
-        // The two keys are intentionally chosen for ordering
-        uint8_t key{'j'};
+    for (const DBEngine engine : ALL_ENGINES) {
+        // We're going to share this fs::path between two wrappers
+        fs::path ph = m_args.GetDataDirBase() / fs::u8path(DBEngineName(engine)) / "existing_data_no_obfuscate";
+        fs::create_directories(ph);
+
+        // Set up a non-obfuscated wrapper to write some initial data.
+        std::unique_ptr<CDBWrapper> dbw = std::make_unique<CDBWrapper>(DBParams{.path = ph, .cache_bytes = 1 << 10, .memory_only = false, .wipe_data = false, .obfuscate = false, .options = {.engine = engine}});
+        uint8_t key{'k'};
         uint256 in = m_rng.rand256();
-        BOOST_CHECK(dbw.Write(key, in));
-        uint8_t key2{'k'};
-        uint256 in2 = m_rng.rand256();
-        BOOST_CHECK(dbw.Write(key2, in2));
+        uint256 res;
 
-        std::unique_ptr<CDBIterator> it(const_cast<CDBWrapper&>(dbw).NewIterator());
+        BOOST_CHECK(dbw->Write(key, in));
+        BOOST_CHECK(dbw->Read(key, res));
+        BOOST_CHECK_EQUAL(res.ToString(), in.ToString());
 
-        // Be sure to seek past the obfuscation key (if it exists)
-        it->Seek(key);
+        // Call the destructor to free leveldb LOCK
+        dbw.reset();
 
-        uint8_t key_res;
-        uint256 val_res;
+        // Now, set up another wrapper that wants to obfuscate the same directory
+        CDBWrapper odbw({.path = ph, .cache_bytes = 1 << 10, .memory_only = false, .wipe_data = false, .obfuscate = true, .options = {.engine = engine}});
 
-        BOOST_REQUIRE(it->GetKey(key_res));
-        BOOST_REQUIRE(it->GetValue(val_res));
-        BOOST_CHECK_EQUAL(key_res, key);
-        BOOST_CHECK_EQUAL(val_res.ToString(), in.ToString());
+        // Check that the key/val we wrote with unobfuscated wrapper exists and
+        // is readable.
+        uint256 res2;
+        BOOST_CHECK(odbw.Read(key, res2));
+        BOOST_CHECK_EQUAL(res2.ToString(), in.ToString());
 
-        it->Next();
+        BOOST_CHECK(!odbw.IsEmpty());
+        BOOST_CHECK(!dbwrapper_private::GetObfuscation(odbw)); // The key should be an empty string
 
-        BOOST_REQUIRE(it->GetKey(key_res));
-        BOOST_REQUIRE(it->GetValue(val_res));
-        BOOST_CHECK_EQUAL(key_res, key2);
-        BOOST_CHECK_EQUAL(val_res.ToString(), in2.ToString());
+        uint256 in2 = m_rng.rand256();
+        uint256 res3;
 
-        it->Next();
-        BOOST_CHECK_EQUAL(it->Valid(), false);
+        // Check that we can write successfully
+        BOOST_CHECK(odbw.Write(key, in2));
+        BOOST_CHECK(odbw.Read(key, res3));
+        BOOST_CHECK_EQUAL(res3.ToString(), in2.ToString());
     }
 }
 
-// Test that we do not obfuscation if there is existing data.
-BOOST_AUTO_TEST_CASE(existing_data_no_obfuscate)
-{
-    // We're going to share this fs::path between two wrappers
-    fs::path ph = m_args.GetDataDirBase() / "existing_data_no_obfuscate";
-    fs::create_directories(ph);
-
-    // Set up a non-obfuscated wrapper to write some initial data.
-    std::unique_ptr<CDBWrapper> dbw = std::make_unique<CDBWrapper>(DBParams{.path = ph, .cache_bytes = 1 << 10, .memory_only = false, .wipe_data = false, .obfuscate = false});
-    uint8_t key{'k'};
-    uint256 in = m_rng.rand256();
-    uint256 res;
-
-    BOOST_CHECK(dbw->Write(key, in));
-    BOOST_CHECK(dbw->Read(key, res));
-    BOOST_CHECK_EQUAL(res.ToString(), in.ToString());
-
-    // Call the destructor to free leveldb LOCK
-    dbw.reset();
-
-    // Now, set up another wrapper that wants to obfuscate the same directory
-    CDBWrapper odbw({.path = ph, .cache_bytes = 1 << 10, .memory_only = false, .wipe_data = false, .obfuscate = true});
-
-    // Check that the key/val we wrote with unobfuscated wrapper exists and
-    // is readable.
-    uint256 res2;
-    BOOST_CHECK(odbw.Read(key, res2));
-    BOOST_CHECK_EQUAL(res2.ToString(), in.ToString());
-
-    BOOST_CHECK(!odbw.IsEmpty());
-    BOOST_CHECK(!dbwrapper_private::GetObfuscation(odbw)); // The key should be an empty string
-
-    uint256 in2 = m_rng.rand256();
-    uint256 res3;
-
-    // Check that we can write successfully
-    BOOST_CHECK(odbw.Write(key, in2));
-    BOOST_CHECK(odbw.Read(key, res3));
-    BOOST_CHECK_EQUAL(res3.ToString(), in2.ToString());
-}
-
 // Ensure that we start obfuscating during a reindex.
 BOOST_AUTO_TEST_CASE(existing_data_reindex)
 {
-    // We're going to share this fs::path between two wrappers
-    fs::path ph = m_args.GetDataDirBase() / "existing_data_reindex";
-    fs::create_directories(ph);
-
-    // Set up a non-obfuscated wrapper to write some initial data.
-    std::unique_ptr<CDBWrapper> dbw = std::make_unique<CDBWrapper>(DBParams{.path = ph, .cache_bytes = 1 << 10, .memory_only = false, .wipe_data = false, .obfuscate = false});
-    uint8_t key{'k'};
-    uint256 in = m_rng.rand256();
-    uint256 res;
-
-    BOOST_CHECK(dbw->Write(key, in));
-    BOOST_CHECK(dbw->Read(key, res));
-    BOOST_CHECK_EQUAL(res.ToString(), in.ToString());
-
-    // Call the destructor to free leveldb LOCK
-    dbw.reset();
-
-    // Simulate a -reindex by wiping the existing data store
-    CDBWrapper odbw({.path = ph, .cache_bytes = 1 << 10, .memory_only = false, .wipe_data = true, .obfuscate = true});
-
-    // Check that the key/val we wrote with unobfuscated wrapper doesn't exist
-    uint256 res2;
-    BOOST_CHECK(!odbw.Read(key, res2));
-    BOOST_CHECK(dbwrapper_private::GetObfuscation(odbw));
-
-    uint256 in2 = m_rng.rand256();
-    uint256 res3;
-
-    // Check that we can write successfully
-    BOOST_CHECK(odbw.Write(key, in2));
-    BOOST_CHECK(odbw.Read(key, res3));
-    BOOST_CHECK_EQUAL(res3.ToString(), in2.ToString());
+    for (const DBEngine engine : ALL_ENGINES) {
+        // We're going to share this fs::path between two wrappers
+        fs::path ph = m_args.GetDataDirBase() / fs::u8path(DBEngineName(engine)) / "existing_data_reindex";
+        fs::create_directories(ph);
+
+        // Set up a non-obfuscated wrapper to write some initial data.
+        std::unique_ptr<CDBWrapper> dbw = std::make_unique<CDBWrapper>(DBParams{.path = ph, .cache_bytes = 1 << 10, .memory_only = false, .wipe_data = false, .obfuscate = false, .options = {.engine = engine}});
+        uint8_t key{'k'};
+        uint256 in = m_rng.rand256();
+        uint256 res;
+
+        BOOST_CHECK(dbw->Write(key, in));
+        BOOST_CHECK(dbw->Read(key, res));
+        BOOST_CHECK_EQUAL(res.ToString(), in.ToString());
+
+        // Call the destructor to free leveldb LOCK
+        dbw.reset();
+
+        // Simulate a -reindex by wiping the existing data store
+        CDBWrapper odbw({.path = ph, .cache_bytes = 1 << 10, .memory_only = false, .wipe_data = true, .obfuscate = true, .options = {.engine = engine}});
+
+        // Check that the key/val we wrote with unobfuscated wrapper doesn't exist
+        uint256 res2;
+        BOOST_CHECK(!odbw.Read(key, res2));
+        BOOST_CHECK(dbwrapper_private::GetObfuscation(odbw));
+
+        uint256 in2 = m_rng.rand256();
+        uint256 res3;
+
+        // Check that we can write successfully
+        BOOST_CHECK(odbw.Write(key, in2));
+        BOOST_CHECK(odbw.Read(key, res3));
+        BOOST_CHECK_EQUAL(res3.ToString(), in2.ToString());
+    }
 }
 
 BOOST_AUTO_TEST_CASE(iterator_ordering)
 {
-    fs::path ph = m_args.GetDataDirBase() / "iterator_ordering";
-    CDBWrapper dbw({.path = ph, .cache_bytes = 1 << 20, .memory_only = true, .wipe_data = false, .obfuscate = false});
-    for (int x=0x00; x<256; ++x) {
-        uint8_t key = x;
-        uint32_t value = x*x;
-        if (!(x & 1)) BOOST_CHECK(dbw.Write(key, value));
-    }
+    for (const DBEngine engine : ALL_ENGINES) {
+        fs::path ph = m_args.GetDataDirBase() / fs::u8path(DBEngineName(engine)) / "iterator_ordering";
+        CDBWrapper dbw({.path = ph, .cache_bytes = 1 << 20, .memory_only = true, .wipe_data = false, .obfuscate = false, .options = {.engine = engine}});
+        for (int x=0x00; x<256; ++x) {
+            uint8_t key = x;
+            uint32_t value = x*x;
+            if (!(x & 1)) BOOST_CHECK(dbw.Write(key, value));
+        }
 
-    // Check that creating an iterator creates a snapshot
-    std::unique_ptr<CDBIterator> it(const_cast<CDBWrapper&>(dbw).NewIterator());
+        // Check that creating an iterator creates a snapshot
+        std::unique_ptr<CDBIterator> it(const_cast<CDBWrapper&>(dbw).NewIterator());
 
-    for (unsigned int x=0x00; x<256; ++x) {
-        uint8_t key = x;
-        uint32_t value = x*x;
-        if (x & 1) BOOST_CHECK(dbw.Write(key, value));
-    }
+        for (unsigned int x=0x00; x<256; ++x) {
+            uint8_t key = x;
+            uint32_t value = x*x;
+            if (x & 1) BOOST_CHECK(dbw.Write(key, value));
+        }
 
-    for (const int seek_start : {0x00, 0x80}) {
-        it->Seek((uint8_t)seek_start);
-        for (unsigned int x=seek_start; x<255; ++x) {
-            uint8_t key;
-            uint32_t value;
-            BOOST_CHECK(it->Valid());
-            if (!it->Valid()) // Avoid spurious errors about invalid iterator's key and value in case of failure
-                break;
-            BOOST_CHECK(it->GetKey(key));
-            if (x & 1) {
-                BOOST_CHECK_EQUAL(key, x + 1);
-                continue;
+        for (const int seek_start : {0x00, 0x80}) {
+            it->Seek((uint8_t)seek_start);
+            for (unsigned int x=seek_start; x<255; ++x) {
+                uint8_t key;
+                uint32_t value;
+                BOOST_CHECK(it->Valid());
+                if (!it->Valid()) // Avoid spurious errors about invalid iterator's key and value in case of failure
+                    break;
+                BOOST_CHECK(it->GetKey(key));
+                if (x & 1) {
+                    BOOST_CHECK_EQUAL(key, x + 1);
+                    continue;
+                }
+                BOOST_CHECK(it->GetValue(value));
+                BOOST_CHECK_EQUAL(key, x);
+                BOOST_CHECK_EQUAL(value, x*x);
+                it->Next();
             }
-            BOOST_CHECK(it->GetValue(value));
-            BOOST_CHECK_EQUAL(key, x);
-            BOOST_CHECK_EQUAL(value, x*x);
-            it->Next();
+            BOOST_CHECK(!it->Valid());
         }
-        BOOST_CHECK(!it->Valid());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(iterator_snapshots)
+{
+    for (const DBEngine engine : ALL_ENGINES) {
+        fs::path ph = m_args.GetDataDirBase() / fs::u8path(DBEngineName(engine)) / "iterator_snapshots";
+        CDBWrapper dbw({.path = ph, .cache_bytes = 1 << 20, .memory_only = true, .options = {.engine = engine}});
+        const auto contents{[](CDBIterator& it) {
+            std::vector<std::pair<uint8_t, uint32_t>> res;
+            for (it.SeekToFirst(); it.Valid(); it.Next()) {
+                uint8_t key{0};
+                uint32_t value{0};
+                BOOST_REQUIRE(it.GetKey(key));
+                BOOST_REQUIRE(it.GetValue(value));
+                res.emplace_back(key, value);
+            }
+            return res;
+        }};
+        for (uint8_t key{0}; key < 4; ++key) BOOST_CHECK(dbw.Write(key, uint32_t{key}));
+
+        // Each iterator keeps seeing the keys as they were when it was created,
+        // however often they are overwritten, erased or added afterwards.
+        std::unique_ptr<CDBIterator> it1{dbw.NewIterator()};
+        BOOST_CHECK(dbw.Write(uint8_t{1}, uint32_t{10}));
+        BOOST_CHECK(dbw.Erase(uint8_t{2}));
+        BOOST_CHECK(dbw.Write(uint8_t{4}, uint32_t{40}));
+        std::unique_ptr<CDBIterator> it2{dbw.NewIterator()};
+        BOOST_CHECK(dbw.Write(uint8_t{1}, uint32_t{11}));
+        BOOST_CHECK(dbw.Write(uint8_t{2}, uint32_t{21}));
+        BOOST_CHECK(dbw.Erase(uint8_t{3}));
+        BOOST_CHECK(dbw.Erase(uint8_t{4}));
+        BOOST_CHECK(dbw.Write(uint8_t{5}, uint32_t{51}));
+
+        using Contents = std::vector<std::pair<uint8_t, uint32_t>>;
+        BOOST_CHECK(contents(*it1) == (Contents{{0, 0}, {1, 1}, {2, 2}, {3, 3}}));
+        BOOST_CHECK(contents(*it2) == (Contents{{0, 0}, {1, 10}, {3, 3}, {4, 40}}));
+        it1.reset();
+        it2.reset();
+        std::unique_ptr<CDBIterator> it3{dbw.NewIterator()};
+        BOOST_CHECK(contents(*it3) == (Contents{{0, 0}, {1, 11}, {2, 21}, {5, 51}}));
+        BOOST_CHECK(!dbw.Exists(uint8_t{3}));
+        BOOST_CHECK(!dbw.Exists(uint8_t{4}));
     }
 }
 
@@ -373,54 +439,271 @@ struct StringContentsSerializer {
 
 BOOST_AUTO_TEST_CASE(iterator_string_ordering)
 {
-    fs::path ph = m_args.GetDataDirBase() / "iterator_string_ordering";
-    CDBWrapper dbw({.path = ph, .cache_bytes = 1 << 20, .memory_only = true, .wipe_data = false, .obfuscate = false});
-    for (int x = 0; x < 10; ++x) {
-        for (int y = 0; y < 10; ++y) {
-            std::string key{ToString(x)};
-            for (int z = 0; z < y; ++z)
-                key += key;
-            uint32_t value = x*x;
-            BOOST_CHECK(dbw.Write(StringContentsSerializer{key}, value));
-        }
-    }
-
-    std::unique_ptr<CDBIterator> it(const_cast<CDBWrapper&>(dbw).NewIterator());
-    for (const int seek_start : {0, 5}) {
-        it->Seek(StringContentsSerializer{ToString(seek_start)});
-        for (unsigned int x = seek_start; x < 10; ++x) {
+    for (const DBEngine engine : ALL_ENGINES) {
+        fs::path ph = m_args.GetDataDirBase() / fs::u8path(DBEngineName(engine)) / "iterator_string_ordering";
+        CDBWrapper dbw({.path = ph, .cache_bytes = 1 << 20, .memory_only = true, .wipe_data = false, .obfuscate = false, .options = {.engine = engine}});
+        for (int x = 0; x < 10; ++x) {
             for (int y = 0; y < 10; ++y) {
-                std::string exp_key{ToString(x)};
+                std::string key{ToString(x)};
                 for (int z = 0; z < y; ++z)
-                    exp_key += exp_key;
-                StringContentsSerializer key;
-                uint32_t value;
-                BOOST_CHECK(it->Valid());
-                if (!it->Valid()) // Avoid spurious errors about invalid iterator's key and value in case of failure
-                    break;
-                BOOST_CHECK(it->GetKey(key));
-                BOOST_CHECK(it->GetValue(value));
-                BOOST_CHECK_EQUAL(key.str, exp_key);
-                BOOST_CHECK_EQUAL(value, x*x);
-                it->Next();
+                    key += key;
+                uint32_t value = x*x;
+                BOOST_CHECK(dbw.Write(StringContentsSerializer{key}, value));
             }
         }
-        BOOST_CHECK(!it->Valid());
+
+        std::unique_ptr<CDBIterator> it(const_cast<CDBWrapper&>(dbw).NewIterator());
+        for (const int seek_start : {0, 5}) {
+            it->Seek(StringContentsSerializer{ToString(seek_start)});
+            for (unsigned int x = seek_start; x < 10; ++x) {
+                for (int y = 0; y < 10; ++y) {
+                    std::string exp_key{ToString(x)};
+                    for (int z = 0; z < y; ++z)
+                        exp_key += exp_key;
+                    StringContentsSerializer key;
+                    uint32_t value;
+                    BOOST_CHECK(it->Valid());
+                    if (!it->Valid()) // Avoid spurious errors about invalid iterator's key and value in case of failure
+                        break;
+                    BOOST_CHECK(it->GetKey(key));
+                    BOOST_CHECK(it->GetValue(value));
+                    BOOST_CHECK_EQUAL(key.str, exp_key);
+                    BOOST_CHECK_EQUAL(value, x*x);
+                    it->Next();
+                }
+            }
+            BOOST_CHECK(!it->Valid());
+        }
     }
 }
 
 BOOST_AUTO_TEST_CASE(unicodepath)
 {
-    // Attempt to create a database with a UTF8 character in the path.
-    // On Windows this test will fail if the directory is created using
-    // the ANSI CreateDirectoryA call and the code page isn't UTF8.
-    // It will succeed if created with CreateDirectoryW.
-    fs::path ph = m_args.GetDataDirBase() / "test_runner_₿_🏃_20191128_104644";
-    CDBWrapper dbw({.path = ph, .cache_bytes = 1 << 20});
-
-    fs::path lockPath = ph / "LOCK";
-    BOOST_CHECK(fs::exists(lockPath));
+    for (const DBEngine engine : ALL_ENGINES) {
+        // Attempt to create a database with a UTF8 character in the path.
+        // On Windows this test will fail if the directory is created using
+        // the ANSI CreateDirectoryA call and the code page isn't UTF8.
+        // It will succeed if created with CreateDirectoryW.
+        fs::path ph = m_args.GetDataDirBase() / fs::u8path(DBEngineName(engine)) / "test_runner_₿_🏃_20191128_104644";
+        CDBWrapper dbw({.path = ph, .cache_bytes = 1 << 20, .options = {.engine = engine}});
+
+        fs::path lockPath = ph / "LOCK";
+        BOOST_CHECK(fs::exists(lockPath));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(dbwrapper_stats)
+{
+    for (const DBEngine engine : ALL_ENGINES) {
+        const fs::path ph{m_args.GetDataDirBase() / fs::u8path(DBEngineName(engine)) / "dbwrapper_stats"};
+        for (const bool defer_compaction : {false, true}) {
+            // A small cache makes LevelDB flush its memtable several times.
+            CDBWrapper dbw{{.path = ph, .cache_bytes = 1 << 20, .wipe_data = true, .options = {.engine = engine, .compaction_threads = 4, .defer_compaction = defer_compaction}}};
+            std::vector<uint256> values(20000);
+            for (uint32_t key{0}; key < values.size(); key += 1000) {
+                CDBBatch batch{dbw};
+                for (uint32_t i{key}; i < key + 1000; ++i) {
+                    values[i] = m_rng.rand256();
+                    batch.Write(i, std::make_pair(values[i], values[i]));
+                }
+                BOOST_CHECK(dbw.WriteBatch(batch));
+            }
+
+            const DBStats stats{dbw.GetStats()};
+            if (engine == DBEngine::LEVELDB) {
+                BOOST_CHECK_GT(stats.compactions, 0U);
+                BOOST_CHECK_GT(stats.compaction_bytes_written, 0U);
+                BOOST_CHECK_EQUAL(stats.files_per_level.size(), 7U);
+            } else {
+                BOOST_CHECK(stats.files_per_level.empty());
+            }
+            for (uint32_t key{0}; key < values.size(); ++key) {
+                std::pair<uint256, uint256> res;
+                BOOST_REQUIRE(dbw.Read(key, res));
+                BOOST_CHECK_EQUAL(res.first, values[key]);
+            }
+        }
+    }
 }
 
+BOOST_AUTO_TEST_CASE(dbwrapper_subcompactions)
+{
+    const auto key{[](uint32_t i) { return StringContentsSerializer{strprintf("%08u", i)}; }};
+    constexpr uint32_t NUM_KEYS{40000};
+    // The contents of the database after compacting it with a single and with several ranges.
+    std::vector<std::vector<std::pair<std::string, uint256>>> contents;
+    for (const int compaction_threads : {1, 4}) {
+        const fs::path ph{m_args.GetDataDirBase() / fs::u8path(strprintf("dbwrapper_subcompactions_%d", compaction_threads))};
+        const DBOptions options{.engine = DBEngine::LEVELDB, .compaction_threads = compaction_threads};
+        FastRandomContext rng{/*fDeterministic=*/true};
+        {
+            // Keys in ascending order, with a small write buffer: every memtable flush becomes a
+            // level-2 file, as it overlaps no other file.
+            CDBWrapper dbw{{.path = ph, .cache_bytes = 1 << 20, .wipe_data = true, .options = options}};
+            for (uint32_t i{0}; i < NUM_KEYS; i += 1000) {
+                CDBBatch batch{dbw};
+                for (uint32_t j{i}; j < i + 1000; ++j) batch.Write(key(j), rng.rand256());
+                BOOST_CHECK(dbw.WriteBatch(batch));
+            }
+        }
+        {
+            // Overwrite and erase keys across the whole range, which end up in a level-1 file
+            // overlapping all the level-2 ones.
+            CDBWrapper dbw{{.path = ph, .cache_bytes = 1 << 20, .options = options}};
+            CDBBatch batch{dbw};
+            for (uint32_t j{0}; j < NUM_KEYS; j += 97) batch.Write(key(j), rng.rand256());
+            for (uint32_t j{50}; j < NUM_KEYS; j += 101) batch.Erase(key(j));
+            BOOST_CHECK(dbw.WriteBatch(batch));
+        }
+        {
+            LogInstance().EnableCategory(BCLog::LEVELDB);
+            // The compaction of the level-1 file is split at the level-2 files it overlaps.
+            std::optional<DebugLogHelper> multi_range;
+            if (compaction_threads > 1) {
+                multi_range.emplace("range(s)", [](const std::string* line) { return !line || line->find(" in 1 range(s)") == std::string::npos; });
+            }
+            CDBWrapper dbw{{.path = ph, .cache_bytes = 1 << 20, .options = {.force_compact = true, .engine = DBEngine::LEVELDB, .compaction_threads = compaction_threads}}};
+            multi_range.reset();
+            LogInstance().DisableCategory(BCLog::LEVELDB);
+
+            auto& entries{contents.emplace_back()};
+            std::unique_ptr<CDBIterator> it{dbw.NewIterator()};
+            for (it->SeekToFirst(); it->Valid(); it->Next()) {
+                StringContentsSerializer k;
+                uint256 v;
+                BOOST_REQUIRE(it->GetKey(k));
+                BOOST_REQUIRE(it->GetValue(v));
+                entries.emplace_back(k.str, v);
+            }
+        }
+    }
+    BOOST_CHECK_EQUAL(contents[0].size(), NUM_KEYS - (NUM_KEYS - 50 + 100) / 101);
+    BOOST_CHECK(contents[0] == contents[1]);
+}
+
+BOOST_AUTO_TEST_CASE(engine_mismatch)
+{
+    const fs::path ph{m_args.GetDataDirBase() / "engine_mismatch"};
+    {
+        CDBWrapper dbw({.path = ph, .cache_bytes = 1 << 20, .options = {.engine = DBEngine::LEVELDB}});
+        BOOST_CHECK(dbw.Write(uint8_t{'k'}, uint32_t{1}));
+    }
+    // Opening existing data with another engine must not look like an empty database
+    BOOST_CHECK_THROW(CDBWrapper({.path = ph, .cache_bytes = 1 << 20, .options = {.engine = DBEngine::LOGSTORE}}), dbwrapper_error);
+
+    // Wiping (as done by -reindex) allows switching engines
+    CDBWrapper dbw({.path = ph, .cache_bytes = 1 << 20, .wipe_data = true, .options = {.engine = DBEngine::LOGSTORE}});
+    BOOST_CHECK(dbw.IsEmpty());
+    BOOST_CHECK(!fs::exists(ph / "CURRENT"));
+}
+
+BOOST_AUTO_TEST_CASE(logstore_torn_write)
+{
+    const fs::path ph{m_args.GetDataDirBase() / "logstore_torn_write"};
+    const DBParams params{.path = ph, .cache_bytes = 1 << 20, .options = {.engine = DBEngine::LOGSTORE}};
+    uint32_t value;
+    {
+        CDBWrapper dbw{params};
+        BOOST_CHECK(dbw.Write(uint8_t{'a'}, uint32_t{1}));
+        BOOST_CHECK(dbw.Write(uint8_t{'b'}, uint32_t{2}));
+    }
+
+    // Simulate a crash in the middle of appending the last batch
+    const fs::path log_path{ph / "data.log"};
+    fs::resize_file(log_path, fs::file_size(log_path) - 1);
+    {
+        CDBWrapper dbw{params};
+        BOOST_CHECK(dbw.Read(uint8_t{'a'}, value));
+        BOOST_CHECK_EQUAL(value, 1U);
+        BOOST_CHECK(!dbw.Exists(uint8_t{'b'}));
+        // New writes go after the last intact batch
+        BOOST_CHECK(dbw.Write(uint8_t{'c'}, uint32_t{3}));
+    }
+    CDBWrapper dbw{params};
+    BOOST_CHECK(dbw.Read(uint8_t{'a'}, value));
+    BOOST_CHECK_EQUAL(value, 1U);
+    BOOST_CHECK(dbw.Read(uint8_t{'c'}, value));
+    BOOST_CHECK_EQUAL(value, 3U);
+}
+
+BOOST_AUTO_TEST_CASE(logstore_corruption)
+{
+    const fs::path ph{m_args.GetDataDirBase() / "logstore_corruption"};
+    const DBParams params{.path = ph, .cache_bytes = 1 << 20, .options = {.engine = DBEngine::LOGSTORE}};
+    const fs::path log_path{ph / "data.log"};
+    uint64_t second_batch_end;
+    {
+        CDBWrapper dbw{params};
+        BOOST_CHECK(dbw.Write(uint8_t{'a'}, uint32_t{1}));
+        BOOST_CHECK(dbw.Write(uint8_t{'b'}, uint32_t{2}));
+        second_batch_end = fs::file_size(log_path);
+        BOOST_CHECK(dbw.Write(uint8_t{'c'}, uint32_t{3}));
+    }
+    const uint64_t log_size{fs::file_size(log_path)};
+    const auto flip_bit{[&](uint64_t pos) {
+        AutoFile file{fsbridge::fopen(log_path, "r+b")};
+        std::array<std::byte, 1> byte;
+        file.seek(pos, SEEK_SET);
+        file.read(byte);
+        byte[0] ^= std::byte{1};
+        file.seek(pos, SEEK_SET);
+        file.write(byte);
+        BOOST_REQUIRE_EQUAL(file.fclose(), 0);
+    }};
+
+    // A bad batch followed by more batches is not a torn write, and dropping
+    // it would lose the batches after it.
+    flip_bit(second_batch_end - 1);
+    BOOST_CHECK_THROW(CDBWrapper{params}, dbwrapper_error);
+    BOOST_CHECK_EQUAL(fs::file_size(log_path), log_size);
+    flip_bit(second_batch_end - 1);
+
+    // A bad final batch is.
+    flip_bit(log_size - 1);
+    CDBWrapper dbw{params};
+    uint32_t value;
+    BOOST_CHECK(dbw.Read(uint8_t{'b'}, value));
+    BOOST_CHECK_EQUAL(value, 2U);
+    BOOST_CHECK(!dbw.Exists(uint8_t{'c'}));
+    BOOST_CHECK_EQUAL(fs::file_size(log_path), second_batch_end);
+}
+
+BOOST_AUTO_TEST_CASE(logstore_compaction)
+{
+    const fs::path ph{m_args.GetDataDirBase() / "logstore_compaction"};
+    DBParams params{.path = ph, .cache_bytes = 1 << 20, .obfuscate = true, .options = {.engine = DBEngine::LOGSTORE}};
+    const fs::path log_path{ph / "data.log"};
+    std::vector<uint256> values(100);
+    {
+        CDBWrapper dbw{params};
+        // Overwrite every key a few times and erase the odd ones
+        for (int round{0}; round < 5; ++round) {
+            CDBBatch batch{dbw};
+            for (uint32_t key{0}; key < values.size(); ++key) {
+                values[key] = m_rng.rand256();
+                batch.Write(key, values[key]);
+            }
+            BOOST_CHECK(dbw.WriteBatch(batch));
+        }
+        CDBBatch batch{dbw};
+        for (uint32_t key{1}; key < values.size(); key += 2) batch.Erase(key);
+        BOOST_CHECK(dbw.WriteBatch(batch));
+    }
+
+    const auto size_before{fs::file_size(log_path)};
+    params.options.force_compact = true;
+    for (int reopen{0}; reopen < 2; ++reopen) {
+        CDBWrapper dbw{params};
+        BOOST_CHECK_LT(fs::file_size(log_path), size_before / 5);
+        for (uint32_t key{0}; key < values.size(); ++key) {
+            uint256 res;
+            BOOST_CHECK_EQUAL(dbw.Read(key, res), key % 2 == 0);
+            if (key % 2 == 0) BOOST_CHECK_EQUAL(res, values[key]);
+        }
+        // Writes after a rewrite must survive reopening
+        if (reopen == 0) BOOST_CHECK(dbw.Write(uint32_t{0}, values[0]));
+        params.options.force_compact = false;
+    }
+}
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -230,6 +230,10 @@ FUZZ_TARGET_DESERIALIZE(blockundo_deserialize, {
     CBlockUndo bu;
     DeserializeFromFuzzingInput(buffer, bu);
 })
+FUZZ_TARGET_DESERIALIZE(blockundo_compact_deserialize, {
+    CBlockUndo bu;
+    DeserializeFromFuzzingInput(buffer, Using<BlockUndoCompactFormatter>(bu));
+})
 FUZZ_TARGET_DESERIALIZE(coins_deserialize, {
     Coin coin;
     DeserializeFromFuzzingInput(buffer, coin);
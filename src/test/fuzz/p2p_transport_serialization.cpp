@@ -189,6 +189,12 @@ void SimulationTest(Transport& initiator, Transport& responder, R& rng, FuzzedDa
         assert(std::ranges::equal(bytes, bytes_next));
         assert(msg_type == msg_type_next);
         if (more_nonext) assert(more_next);
+        // The buffers for a vectored send start with the same bytes, and end with the same 'more'.
+        const auto [buffers, buffers_more] = transports[side]->GetBuffersToSend(false);
+        assert(buffers.empty() == bytes.empty());
+        if (!buffers.empty()) assert(std::ranges::equal(buffers.front(), bytes));
+        for (const auto& buffer : buffers) assert(!buffer.empty());
+        if (buffers.size() <= 1) assert(buffers_more == more_nonext);
         // Compare with previously reported output.
         assert(to_send[side].size() <= bytes.size());
         assert(std::ranges::equal(to_send[side], std::span{bytes}.first(to_send[side].size())));
@@ -0,0 +1,152 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <addresstype.h>
+#include <hash.h>
+#include <pubkey.h>
+#include <script/interpreter.h>
+#include <script/script.h>
+#include <script/script_error.h>
+#include <test/fuzz/FuzzedDataProvider.h>
+#include <test/fuzz/fuzz.h>
+#include <test/fuzz/util.h>
+#include <test/util/script.h>
+#include <uint256.h>
+
+#include <cassert>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace {
+/**
+ * Decides signature checks by the last byte of the signature, and records
+ * them, so that the checks of two evaluations can be compared.
+ */
+class RecordingSignatureChecker : public BaseSignatureChecker
+{
+public:
+    struct Check {
+        std::vector<unsigned char> sig;
+        std::vector<unsigned char> pubkey;
+        CScript script_code;
+        SigVersion sigversion;
+
+        bool operator==(const Check&) const = default;
+    };
+
+    mutable std::vector<Check> m_checks;
+
+    bool CheckECDSASignature(const std::vector<unsigned char>& sig, const std::vector<unsigned char>& pubkey, const CScript& script_code, SigVersion sigversion) const override
+    {
+        m_checks.push_back({sig, pubkey, script_code, sigversion});
+        return !sig.empty() && (sig.back() & 1);
+    }
+
+    bool CheckSchnorrSignature(std::span<const unsigned char> sig, std::span<const unsigned char> pubkey, SigVersion sigversion, ScriptExecutionData& execdata, ScriptError* serror = nullptr) const override
+    {
+        m_checks.push_back({{sig.begin(), sig.end()}, {pubkey.begin(), pubkey.end()}, {}, sigversion});
+        if (!sig.empty() && (sig.back() & 1)) return true;
+        if (serror) *serror = SCRIPT_ERR_SCHNORR_SIG;
+        return false;
+    }
+};
+
+//! Append a push of data with the given push opcode, which need not be minimal.
+void AppendPush(CScript& script, std::span<const unsigned char> data, opcodetype opcode)
+{
+    script.insert(script.end(), static_cast<unsigned char>(opcode));
+    const uint32_t size = data.size();
+    const unsigned char size_bytes[]{uint8_t(size), uint8_t(size >> 8), uint8_t(size >> 16), uint8_t(size >> 24)};
+    if (opcode == OP_PUSHDATA1) script.insert(script.end(), size_bytes, size_bytes + 1);
+    if (opcode == OP_PUSHDATA2) script.insert(script.end(), size_bytes, size_bytes + 2);
+    if (opcode == OP_PUSHDATA4) script.insert(script.end(), size_bytes, size_bytes + 4);
+    script.insert(script.end(), data.begin(), data.end());
+}
+} // namespace
+
+//! Compare the fast paths of VerifyScript with the general interpreter.
+FUZZ_TARGET(script_fast_paths)
+{
+    FuzzedDataProvider fuzzed_data_provider(buffer.data(), buffer.size());
+    const unsigned int flags{fuzzed_data_provider.ConsumeIntegral<unsigned int>()};
+    if (!IsValidFlagCombination(flags)) return;
+
+    const std::vector<unsigned char> sig{ConsumeRandomLengthByteVector(fuzzed_data_provider, 600)};
+    std::vector<unsigned char> pubkey{ConsumeRandomLengthByteVector(fuzzed_data_provider, 600)};
+    if (fuzzed_data_provider.ConsumeBool()) {
+        // Give the pubkey a valid encoding.
+        pubkey.resize(CPubKey::COMPRESSED_SIZE);
+        pubkey[0] = fuzzed_data_provider.PickValueInArray({0x02, 0x03});
+    }
+    const uint160 keyid{fuzzed_data_provider.ConsumeBool() ? Hash160(pubkey) : uint160{ConsumeFixedLengthByteVector(fuzzed_data_provider, uint160::size())}};
+
+    // Start from one of the spends with a fast path, or arbitrary scripts.
+    CScript script_sig, script_pubkey;
+    CScriptWitness witness;
+    switch (fuzzed_data_provider.ConsumeIntegralInRange(0, 4)) {
+    case 0:
+        script_pubkey = GetScriptForDestination(PKHash{keyid});
+        script_sig << sig << pubkey;
+        break;
+    case 1:
+        script_pubkey = GetScriptForDestination(WitnessV0KeyHash{keyid});
+        witness.stack = {sig, pubkey};
+        break;
+    case 2: {
+        const CScript redeem_script{GetScriptForDestination(WitnessV0KeyHash{keyid})};
+        script_pubkey = GetScriptForDestination(ScriptHash{redeem_script});
+        script_sig << ToByteVector(redeem_script);
+        witness.stack = {sig, pubkey};
+        break;
+    }
+    case 3:
+        script_pubkey = CScript() << OP_1 << ConsumeFixedLengthByteVector(fuzzed_data_provider, WITNESS_V1_TAPROOT_SIZE);
+        witness.stack = {sig};
+        break;
+    case 4:
+        script_sig = ConsumeScript(fuzzed_data_provider);
+        script_pubkey = ConsumeScript(fuzzed_data_provider);
+        break;
+    }
+
+    // Variations at the edges of the fast paths.
+    LIMITED_WHILE(fuzzed_data_provider.ConsumeBool(), 4)
+    {
+        CallOneOf(
+            fuzzed_data_provider,
+            [&] {
+                script_sig.clear();
+                for (const auto& push : {sig, pubkey}) {
+                    AppendPush(script_sig, push, fuzzed_data_provider.PickValueInArray({OP_PUSHDATA1, OP_PUSHDATA2, OP_PUSHDATA4}));
+                }
+            },
+            [&] {
+                const CScript suffix{ConsumeScript(fuzzed_data_provider)};
+                script_sig.insert(script_sig.end(), suffix.begin(), suffix.end());
+            },
+            [&] {
+                if (script_pubkey.empty()) return;
+                const size_t pos{fuzzed_data_provider.ConsumeIntegralInRange<size_t>(0, script_pubkey.size() - 1)};
+                script_pubkey[pos] = fuzzed_data_provider.ConsumeIntegral<uint8_t>();
+            },
+            [&] {
+                witness.stack.push_back(ConsumeRandomLengthByteVector(fuzzed_data_provider, 600));
+            },
+            [&] {
+                if (!witness.stack.empty()) witness.stack.pop_back();
+            },
+            [&] {
+                witness.stack = {std::vector<unsigned char>(MAX_SCRIPT_ELEMENT_SIZE + 1), pubkey};
+            });
+    }
+
+    RecordingSignatureChecker checker, generic_checker;
+    ScriptError error, generic_error;
+    const bool result{VerifyScript(script_sig, script_pubkey, &witness, flags, checker, &error)};
+    const bool generic_result{VerifyScriptGeneric(script_sig, script_pubkey, &witness, flags, generic_checker, &generic_error)};
+    assert(result == generic_result);
+    assert(error == generic_error);
+    assert(checker.m_checks == generic_checker.m_checks);
+}
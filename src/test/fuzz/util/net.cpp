@@ -172,6 +172,14 @@ ssize_t FuzzedSock::Send(const void* data, size_t len, int flags) const
     return r;
 }
 
+ssize_t FuzzedSock::SendVectored(std::span<const std::span<const unsigned char>> bufs, int flags) const
+{
+    size_t len{0};
+    for (const auto& buf : bufs) len += buf.size();
+    // Send() only looks at the length.
+    return Send(bufs.empty() ? nullptr : bufs.front().data(), len, flags);
+}
+
 ssize_t FuzzedSock::Recv(void* buf, size_t len, int flags) const
 {
     // Have a permanent error at recv_errnos[0] because when the fuzzed data is exhausted
@@ -49,7 +49,7 @@ public:
     /**
      * Compare with another AddrMan.
      * This compares:
-     * - the values in `mapInfo` (the keys aka ids are ignored)
+     * - the values in `m_infos` (the ids are ignored)
      * - vvNew entries refer to the same addresses
      * - vvTried entries refer to the same addresses
      */
@@ -57,13 +57,13 @@ public:
     {
         LOCK2(m_impl->cs, other.m_impl->cs);
 
-        if (m_impl->mapInfo.size() != other.m_impl->mapInfo.size() || m_impl->nNew != other.m_impl->nNew ||
+        if (m_impl->vRandom.size() != other.m_impl->vRandom.size() || m_impl->nNew != other.m_impl->nNew ||
             m_impl->nTried != other.m_impl->nTried) {
             return false;
         }
 
-        // Check that all values in `mapInfo` are equal to all values in `other.mapInfo`.
-        // Keys may be different.
+        // Check that all values in `m_infos` are equal to all values in `other.m_infos`.
+        // Ids may be different.
 
         auto addrinfo_hasher = [](const AddrInfo& a) {
             CSipHasher hasher(0, 0);
@@ -89,16 +89,16 @@ public:
 
         using Addresses = std::unordered_set<AddrInfo, decltype(addrinfo_hasher), decltype(addrinfo_eq)>;
 
-        const size_t num_addresses{m_impl->mapInfo.size()};
+        const size_t num_addresses{m_impl->vRandom.size()};
 
         Addresses addresses{num_addresses, addrinfo_hasher, addrinfo_eq};
-        for (const auto& [id, addr] : m_impl->mapInfo) {
-            addresses.insert(addr);
+        for (const nid_type id : m_impl->vRandom) {
+            addresses.insert(m_impl->m_infos[id]);
         }
 
         Addresses other_addresses{num_addresses, addrinfo_hasher, addrinfo_eq};
-        for (const auto& [id, addr] : other.m_impl->mapInfo) {
-            other_addresses.insert(addr);
+        for (const nid_type id : other.m_impl->vRandom) {
+            other_addresses.insert(other.m_impl->m_infos[id]);
         }
 
         if (addresses != other_addresses) {
@@ -112,11 +112,11 @@ public:
             if ((id == -1 && other_id != -1) || (id != -1 && other_id == -1)) {
                 return false;
             }
-            return m_impl->mapInfo.at(id) == other.m_impl->mapInfo.at(other_id);
+            return m_impl->m_infos.at(id) == other.m_impl->m_infos.at(other_id);
         };
 
         // Check that `vvNew` contains the same addresses as `other.vvNew`. Notice - `vvNew[i][j]`
-        // contains just an id and the address is to be found in `mapInfo.at(id)`. The ids
+        // contains just an id and the address is to be found in `m_infos.at(id)`. The ids
         // themselves may differ between `vvNew` and `other.vvNew`.
         for (size_t i = 0; i < ADDRMAN_NEW_BUCKET_COUNT; ++i) {
             for (size_t j = 0; j < ADDRMAN_BUCKET_SIZE; ++j) {
@@ -176,6 +176,8 @@ public:
 
     ssize_t Send(const void* data, size_t len, int flags) const override;
 
+    ssize_t SendVectored(std::span<const std::span<const unsigned char>> bufs, int flags) const override;
+
     ssize_t Recv(void* buf, size_t len, int flags) const override;
 
     int Connect(const sockaddr*, socklen_t) const override;
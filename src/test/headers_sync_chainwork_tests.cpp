@@ -8,7 +8,10 @@
 #include <headerssync.h>
 #include <pow.h>
 #include <test/util/setup_common.h>
+#include <util/threadpool.h>
 #include <validation.h>
+
+#include <span>
 #include <vector>
 
 #include <boost/test/unit_test.hpp>
@@ -118,6 +121,7 @@ BOOST_AUTO_TEST_CASE(headers_sync_state)
     BOOST_CHECK(!result.request_more);
     // All headers should be ready for acceptance:
     BOOST_CHECK(result.pow_validated_headers.size() == first_chain.size());
+    BOOST_CHECK(result.pow_validated_hashes == GetBlockHeaderHashes(first_chain));
     // Nothing left for the sync logic to do:
     BOOST_CHECK(hss->GetState() == HeadersSyncState::State::FINAL);
 
@@ -143,4 +147,28 @@ BOOST_AUTO_TEST_CASE(headers_sync_state)
     BOOST_CHECK(result.success);
 }
 
+BOOST_AUTO_TEST_CASE(headers_hashes)
+{
+    std::vector<CBlockHeader> headers;
+    GenerateHeaders(headers, 1000, Params().GenesisBlock().GetHash(),
+            Params().GenesisBlock().nVersion, Params().GenesisBlock().nTime,
+            ArithToUint256(0), Params().GenesisBlock().nBits);
+
+    ThreadPool pool{"headerstest", 3};
+    for (const size_t count : {size_t{0}, size_t{1}, MIN_PARALLEL_HEADERS - 1, MIN_PARALLEL_HEADERS, size_t{999}, size_t{1000}}) {
+        const std::span batch{std::span{headers}.first(count)};
+        const std::vector<uint256> hashes{GetBlockHeaderHashes(batch, &pool)};
+        BOOST_REQUIRE_EQUAL(hashes.size(), count);
+        for (size_t i = 0; i < count; ++i) BOOST_CHECK_EQUAL(hashes[i], batch[i].GetHash());
+        BOOST_CHECK(hashes == GetBlockHeaderHashes(batch));
+        BOOST_CHECK(HasValidProofOfWork(batch, hashes, Params().GetConsensus()));
+    }
+
+    // A header whose nonce no longer meets its target is caught given the hashes too.
+    CBlockHeader& header{headers[500]};
+    while (CheckProofOfWork(header.GetHash(), header.nBits, Params().GetConsensus())) ++header.nNonce;
+    BOOST_CHECK(!HasValidProofOfWork(headers, Params().GetConsensus()));
+    BOOST_CHECK(!HasValidProofOfWork(headers, GetBlockHeaderHashes(headers, &pool), Params().GetConsensus()));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,81 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+#include <util/lz4.h>
+#include <util/strencodings.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <vector>
+
+BOOST_FIXTURE_TEST_SUITE(lz4_tests, BasicTestingSetup)
+
+static void CheckRoundTrip(const std::vector<std::byte>& data)
+{
+    const auto compressed{util::LZ4Compress(data)};
+    const auto decompressed{util::LZ4Decompress(compressed, data.size())};
+    BOOST_REQUIRE(decompressed);
+    BOOST_CHECK(*decompressed == data);
+    // The size of the decompressed data must match exactly.
+    BOOST_CHECK(!util::LZ4Decompress(compressed, data.size() + 1));
+    if (!data.empty()) BOOST_CHECK(!util::LZ4Decompress(compressed, data.size() - 1));
+}
+
+BOOST_AUTO_TEST_CASE(lz4_roundtrip)
+{
+    CheckRoundTrip({});
+    CheckRoundTrip(std::vector<std::byte>(1, std::byte{0x42}));
+    CheckRoundTrip(std::vector<std::byte>(12, std::byte{0}));
+    CheckRoundTrip(std::vector<std::byte>(13, std::byte{0}));
+    // Long runs need more than one extra length byte.
+    CheckRoundTrip(std::vector<std::byte>(100000, std::byte{0}));
+    // Incompressible data is stored as literals.
+    CheckRoundTrip(m_rng.randbytes<std::byte>(100000));
+
+    // Random data interleaved with repeats of earlier data, near and far.
+    std::vector<std::byte> mixed;
+    for (int i{0}; i < 1000; ++i) {
+        const auto chunk{m_rng.randbytes<std::byte>(m_rng.randrange(300))};
+        mixed.insert(mixed.end(), chunk.begin(), chunk.end());
+        const size_t length{m_rng.randrange<size_t>(300)};
+        if (mixed.size() > length) {
+            const size_t start{m_rng.randrange(mixed.size() - length)};
+            for (size_t j{0}; j < length; ++j) mixed.push_back(mixed[start + j]);
+        }
+    }
+    CheckRoundTrip(mixed);
+}
+
+BOOST_AUTO_TEST_CASE(lz4_compresses)
+{
+    const std::vector<std::byte> zeros(1000, std::byte{0});
+    BOOST_CHECK_LT(util::LZ4Compress(zeros).size(), 20U);
+    const auto random{m_rng.randbytes<std::byte>(1000)};
+    BOOST_CHECK_LE(util::LZ4Compress(random).size(), random.size() + random.size() / 255 + 16);
+}
+
+BOOST_AUTO_TEST_CASE(lz4_decompress_malformed)
+{
+    // Empty input
+    BOOST_CHECK(!util::LZ4Decompress({}, 0));
+    // Literal length exceeds the input
+    BOOST_CHECK(!util::LZ4Decompress(ParseHex<std::byte>("50616263"), 5));
+    // Match offset of zero
+    BOOST_CHECK(!util::LZ4Decompress(ParseHex<std::byte>("1061000000"), 5));
+    // Match offset before the start of the output
+    BOOST_CHECK(!util::LZ4Decompress(ParseHex<std::byte>("1061020000"), 5));
+    // Truncated match offset
+    BOOST_CHECK(!util::LZ4Decompress(ParseHex<std::byte>("106101"), 5));
+    // Output would exceed the expected size
+    BOOST_CHECK(!util::LZ4Decompress(ParseHex<std::byte>("1f6101000000"), 5));
+    // Well formed: one literal, a match of 4 repeating it, then an empty last sequence
+    const auto decompressed{util::LZ4Decompress(ParseHex<std::byte>("1061010000"), 5)};
+    BOOST_REQUIRE(decompressed);
+    BOOST_CHECK(*decompressed == std::vector<std::byte>(5, std::byte{'a'}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -5,6 +5,7 @@
 #include <consensus/merkle.h>
 #include <test/util/random.h>
 #include <test/util/setup_common.h>
+#include <util/threadpool.h>
 
 #include <boost/test/unit_test.hpp>
 
@@ -245,4 +246,53 @@ BOOST_AUTO_TEST_CASE(merkle_test_BlockWitness)
 
     BOOST_CHECK_EQUAL(merkleRootofHashes, blockWitness);
 }
+
+BOOST_AUTO_TEST_CASE(merkle_test_parallel)
+{
+    ThreadPool pool{"merkletest", 3};
+    for (size_t size : {size_t{0}, size_t{1}, MIN_PARALLEL_MERKLE_LEAVES - 1, MIN_PARALLEL_MERKLE_LEAVES, MIN_PARALLEL_MERKLE_LEAVES + 1,
+                        size_t{3001}, size_t{4096}, size_t{4097}, size_t{6143}, size_t{9000}}) {
+        std::vector<uint256> leaves(size);
+        for (auto& leaf : leaves) leaf = m_rng.rand256();
+        for (int duplicate = 0; duplicate < 2; ++duplicate) {
+            // Duplicate the last two leaves of a power of two, in the last
+            // part, as in CVE-2012-2459.
+            if (duplicate && size >= 6) {
+                leaves[size - 2] = leaves[size - 4];
+                leaves[size - 1] = leaves[size - 3];
+            }
+            bool mutated_serial{false}, mutated_parallel{false};
+            const uint256 root{ComputeMerkleRoot(leaves, &mutated_serial)};
+            BOOST_CHECK_EQUAL(ComputeMerkleRoot(leaves, &mutated_parallel, &pool), root);
+            BOOST_CHECK_EQUAL(ComputeMerkleRoot(leaves, nullptr, &pool), root);
+            BOOST_CHECK_EQUAL(mutated_parallel, mutated_serial);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(merkle_test_builder)
+{
+    MerkleBuilder builder;
+    BOOST_CHECK_EQUAL(builder.Root(), uint256());
+    CBlock block;
+    for (int i = 0; i < 70; ++i) {
+        CMutableTransaction mtx;
+        mtx.nLockTime = i;
+        block.vtx.push_back(MakeTransactionRef(std::move(mtx)));
+        builder.Append(block.vtx.back()->GetHash().ToUint256());
+        BOOST_CHECK_EQUAL(builder.Size(), block.vtx.size());
+        BOOST_CHECK_EQUAL(builder.Root(), BlockMerkleRoot(block));
+
+        // Replace the first transaction, like a new coinbase.
+        CMutableTransaction coinbase;
+        coinbase.version = i;
+        block.vtx[0] = MakeTransactionRef(std::move(coinbase));
+        builder.Set(0, block.vtx[0]->GetHash().ToUint256());
+        BOOST_CHECK_EQUAL(builder.Root(), BlockMerkleRoot(block));
+        for (uint32_t pos = 0; pos < block.vtx.size(); pos += 7) {
+            BOOST_CHECK(builder.Path(pos) == TransactionMerklePath(block, pos));
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
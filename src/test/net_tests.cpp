@@ -26,10 +26,13 @@
 #include <boost/test/unit_test.hpp>
 
 #include <algorithm>
+#include <future>
 #include <ios>
+#include <map>
 #include <memory>
 #include <optional>
 #include <string>
+#include <thread>
 
 using namespace std::literals;
 using namespace util::hex_literals;
@@ -1026,10 +1029,11 @@ class V2TransportTester
     bool m_sent_aad{false};
 
 public:
-    /** Construct a tester object. test_initiator: whether the tested transport is initiator. */
-    explicit V2TransportTester(FastRandomContext& rng, bool test_initiator)
+    /** Construct a tester object. test_initiator: whether the tested transport is initiator.
+     *  key_exchange_pool: pool for the tested transport to compute the shared secret on. */
+    explicit V2TransportTester(FastRandomContext& rng, bool test_initiator, ThreadPool* key_exchange_pool = nullptr)
         : m_rng{rng},
-          m_transport{0, test_initiator},
+          m_transport{0, test_initiator, key_exchange_pool},
           m_cipher{GenerateRandomTestKey(m_rng), MakeByteSpan(m_rng.rand256())},
           m_test_initiator(test_initiator) {}
 
@@ -1052,9 +1056,28 @@ public:
         std::vector<std::optional<CNetMessage>> ret;
         while (true) {
             bool progress{false};
+            // Let the transport continue after a key exchange on the pool, or wait for it without
+            // sending it more bytes, like the socket handler.
+            const bool waiting{m_transport.ReceiveWaiting()};
+            if (m_transport.ReceivePending()) {
+                std::span<const uint8_t> no_bytes;
+                if (!m_transport.ReceivedBytes(no_bytes)) {
+                    return std::nullopt; // transport error occurred
+                }
+                progress = true;
+            } else if (waiting) {
+                progress = true;
+            }
             // Send bytes from m_to_send to the transport.
-            if (!m_to_send.empty()) {
+            if (!m_to_send.empty() && !waiting) {
                 std::span<const uint8_t> to_send = std::span{m_to_send}.first(1 + m_rng.randrange(m_to_send.size()));
+                // Sometimes put the bytes into the transport's receive buffer first, like the socket
+                // handler does.
+                if (const auto recv_buffer{m_transport.GetReceiveBuffer()}; !recv_buffer.empty() && m_rng.randbool()) {
+                    to_send = to_send.first(std::min(to_send.size(), recv_buffer.size()));
+                    std::ranges::copy(to_send, recv_buffer.begin());
+                    to_send = recv_buffer.first(to_send.size());
+                }
                 size_t old_len = to_send.size();
                 if (!m_transport.ReceivedBytes(to_send)) {
                     return std::nullopt; // transport error occurred
@@ -1546,4 +1569,212 @@ BOOST_AUTO_TEST_CASE(v2transport_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(v2transport_key_exchange_pool_test)
+{
+    ThreadPool pool{"keyexchtest", 2};
+    for (int i = 0; i < 20; ++i) {
+        // Both sides, with everything after the key sent at once, so that it arrives while the
+        // key exchange is in progress, in the same read as the key or after it.
+        const bool initiator{i % 2 == 0};
+        V2TransportTester tester(m_rng, initiator, &pool);
+        if (!initiator) tester.SendKey();
+        auto ret = tester.Interact();
+        BOOST_REQUIRE(ret && ret->empty());
+        tester.ReceiveKey();
+        if (initiator) tester.SendKey();
+        tester.SendGarbage(i % 4 < 2 ? V2Transport::MAX_GARBAGE_LEN : m_rng.randrange(V2Transport::MAX_GARBAGE_LEN + 1));
+        tester.SendGarbageTerm();
+        tester.SendVersion();
+        auto msg_data_1 = m_rng.randbytes<uint8_t>(m_rng.randrange(10000));
+        auto msg_data_2 = m_rng.randbytes<uint8_t>(m_rng.randrange(100));
+        tester.SendMessage("tx", msg_data_1);
+        tester.SendMessage(uint8_t(4), msg_data_2); // cmpctblock short id
+        tester.AddMessage("block", msg_data_1);
+        ret = tester.Interact();
+        BOOST_REQUIRE(ret && ret->size() == 2);
+        BOOST_CHECK((*ret)[0] && (*ret)[0]->m_type == "tx" && std::ranges::equal((*ret)[0]->m_recv, MakeByteSpan(msg_data_1)));
+        BOOST_CHECK((*ret)[1] && (*ret)[1]->m_type == "cmpctblock" && std::ranges::equal((*ret)[1]->m_recv, MakeByteSpan(msg_data_2)));
+        tester.ReceiveGarbage();
+        tester.ReceiveVersion();
+        tester.CompareSessionIDs();
+        tester.ReceiveMessage(uint8_t(2), msg_data_1); // "block" short id
+    }
+}
+
+BOOST_AUTO_TEST_CASE(v2transport_key_exchange_no_wait_test)
+{
+    // Keep the only thread of the pool busy, so that the key exchange stays queued.
+    ThreadPool pool{"keyexchtest", 1};
+    std::promise<void> release;
+    auto busy{pool.Submit([released = release.get_future().share()] { released.wait(); })};
+
+    V2Transport initiator{0, true, GenerateRandomTestKey(m_rng), MakeByteSpan(m_rng.rand256()), m_rng.randbytes<uint8_t>(1000)};
+    V2Transport responder{1, false, &pool};
+    const auto& [to_send, more, msg_type] = initiator.GetBytesToSend(/*have_next_message=*/false);
+    const std::vector<uint8_t> sent{to_send.begin(), to_send.end()};
+    BOOST_REQUIRE_EQUAL(sent.size(), EllSwiftPubKey::size() + 1000);
+
+    std::span<const uint8_t> key{std::span{sent}.first(EllSwiftPubKey::size())};
+    BOOST_REQUIRE(responder.ReceivedBytes(key));
+    BOOST_CHECK(key.empty());
+    BOOST_CHECK(responder.ReceiveWaiting());
+    // Bytes which arrive while the key exchange is queued are kept, without waiting for it.
+    std::span<const uint8_t> garbage{std::span{sent}.subspan(EllSwiftPubKey::size())};
+    BOOST_REQUIRE(responder.ReceivedBytes(garbage));
+    BOOST_CHECK(garbage.empty());
+    BOOST_CHECK(responder.ReceiveWaiting());
+    BOOST_CHECK(!responder.ReceivePending());
+
+    release.set_value();
+    busy.wait();
+    while (!responder.ReceivePending()) std::this_thread::yield();
+    BOOST_CHECK(!responder.ReceiveWaiting());
+    std::span<const uint8_t> no_bytes;
+    BOOST_REQUIRE(responder.ReceivedBytes(no_bytes));
+    BOOST_CHECK(!responder.ReceivePending());
+    BOOST_CHECK(!responder.ReceiveWaiting());
+}
+
+namespace {
+/** Send messages from sender to receiver, receiving half of the bytes through its receive buffer. */
+void CheckReceiveBuffer(FastRandomContext& rng, Transport& sender, Transport& receiver)
+{
+    // Payloads both smaller and (much) larger than what the receiver allocates ahead.
+    std::vector<std::vector<uint8_t>> payloads;
+    for (const size_t size : {0, 1, 1000, 300000, 1000000}) payloads.push_back(rng.randbytes(size));
+
+    std::vector<uint8_t> wire;
+    for (const auto& payload : payloads) {
+        CSerializedNetMsg msg;
+        msg.m_type = "block";
+        msg.data = payload;
+        BOOST_REQUIRE(sender.SetMessageToSend(msg));
+        while (true) {
+            const auto& [bytes, more, msg_type] = sender.GetBytesToSend(/*have_next_message=*/false);
+            if (bytes.empty()) break;
+            wire.insert(wire.end(), bytes.begin(), bytes.end());
+            sender.MarkBytesSent(bytes.size());
+        }
+    }
+
+    // Feed the wire bytes in random chunks, half of the time through the receive buffer.
+    std::span<const uint8_t> to_receive{wire};
+    size_t received{0}, in_place{0};
+    while (!to_receive.empty()) {
+        std::span<const uint8_t> chunk{to_receive.first(1 + rng.randrange(std::min<size_t>(to_receive.size(), 100000)))};
+        if (const auto recv_buffer{receiver.GetReceiveBuffer()}; !recv_buffer.empty() && rng.randbool()) {
+            chunk = chunk.first(std::min(chunk.size(), recv_buffer.size()));
+            std::ranges::copy(chunk, recv_buffer.begin());
+            chunk = recv_buffer.first(chunk.size());
+            in_place += chunk.size();
+        }
+        const size_t chunk_size{chunk.size()};
+        BOOST_REQUIRE(receiver.ReceivedBytes(chunk));
+        to_receive = to_receive.subspan(chunk_size - chunk.size());
+        if (receiver.ReceivedMessageComplete()) {
+            bool reject{false};
+            const CNetMessage msg{receiver.GetReceivedMessage(/*time=*/{}, reject)};
+            BOOST_CHECK(!reject);
+            BOOST_REQUIRE(received < payloads.size());
+            BOOST_CHECK_EQUAL(msg.m_type, "block");
+            BOOST_CHECK(std::ranges::equal(msg.m_recv, MakeByteSpan(payloads[received])));
+            ++received;
+        }
+    }
+    BOOST_CHECK_EQUAL(received, payloads.size());
+    BOOST_CHECK(in_place > 0);
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(v1transport_receive_buffer_test)
+{
+    V1Transport sender{/*node_id=*/0}, receiver{/*node_id=*/1};
+    CheckReceiveBuffer(m_rng, sender, receiver);
+}
+
+BOOST_AUTO_TEST_CASE(v2transport_receive_buffer_test)
+{
+    V2Transport sender{/*nodeid=*/0, /*initiating=*/true}, receiver{/*nodeid=*/1, /*initiating=*/false};
+    // Run the handshake, by handing everything one side sends to the other.
+    const auto transfer{[](Transport& from, Transport& to) {
+        while (true) {
+            const auto& [bytes, more, msg_type] = from.GetBytesToSend(/*have_next_message=*/false);
+            if (bytes.empty()) break;
+            std::span<const uint8_t> to_receive{bytes};
+            BOOST_REQUIRE(to.ReceivedBytes(to_receive));
+            BOOST_REQUIRE(to_receive.empty());
+            from.MarkBytesSent(bytes.size());
+        }
+    }};
+    for (int i = 0; i < 3; ++i) {
+        transfer(sender, receiver);
+        transfer(receiver, sender);
+    }
+    BOOST_REQUIRE(sender.GetInfo().transport_type == TransportProtocolType::V2);
+    BOOST_REQUIRE(receiver.GetInfo().session_id && receiver.GetInfo().session_id == sender.GetInfo().session_id);
+    CheckReceiveBuffer(m_rng, sender, receiver);
+}
+
+BOOST_AUTO_TEST_CASE(v1transport_send_queue_test)
+{
+    V1Transport sender{/*node_id=*/0}, receiver{/*node_id=*/1};
+    // One message being sent, and a full queue behind it.
+    std::vector<CSerializedNetMsg> msgs;
+    for (size_t i = 0; i <= Transport::MAX_SEND_QUEUE; ++i) {
+        CSerializedNetMsg& msg{msgs.emplace_back()};
+        msg.m_type = i % 2 ? "tx" : "block";
+        msg.data = m_rng.randbytes(i % 3 ? m_rng.randrange(2000) : 0);
+        CSerializedNetMsg copy{msg.Copy()};
+        BOOST_REQUIRE(sender.SetMessageToSend(copy));
+    }
+    CSerializedNetMsg rejected{msgs.back().Copy()};
+    BOOST_CHECK(!sender.SetMessageToSend(rejected));
+
+    // Send the buffers in random parts, reporting the sent bytes one message at a time, like
+    // SocketSendData does.
+    std::vector<uint8_t> wire;
+    std::map<std::string, size_t> bytes_per_type;
+    while (true) {
+        const auto [buffers, more] = sender.GetBuffersToSend(/*have_next_message=*/false);
+        BOOST_CHECK(!more);
+        if (buffers.empty()) break;
+        std::vector<uint8_t> to_send;
+        for (const auto& buf : buffers) {
+            BOOST_CHECK(!buf.empty());
+            to_send.insert(to_send.end(), buf.begin(), buf.end());
+        }
+        size_t left{1 + m_rng.randrange(to_send.size())};
+        wire.insert(wire.end(), to_send.begin(), to_send.begin() + left);
+        while (left > 0) {
+            const auto& [bytes, _more, msg_type] = sender.GetBytesToSend(/*have_next_message=*/false);
+            BOOST_REQUIRE(!bytes.empty());
+            const size_t sent{std::min(left, bytes.size())};
+            bytes_per_type[msg_type] += sent;
+            sender.MarkBytesSent(sent);
+            left -= sent;
+        }
+    }
+    CSerializedNetMsg next{msgs.back().Copy()};
+    BOOST_CHECK(sender.SetMessageToSend(next));
+
+    size_t received{0};
+    std::span<const uint8_t> to_receive{wire};
+    while (!to_receive.empty()) {
+        BOOST_REQUIRE(receiver.ReceivedBytes(to_receive));
+        if (receiver.ReceivedMessageComplete()) {
+            bool reject{false};
+            const CNetMessage msg{receiver.GetReceivedMessage(/*time=*/{}, reject)};
+            BOOST_CHECK(!reject);
+            BOOST_REQUIRE(received < msgs.size());
+            BOOST_CHECK_EQUAL(msg.m_type, msgs[received].m_type);
+            BOOST_CHECK(std::ranges::equal(msg.m_recv, MakeByteSpan(msgs[received].data)));
+            bytes_per_type[msg.m_type] -= CMessageHeader::HEADER_SIZE + msg.m_message_size;
+            ++received;
+        }
+    }
+    BOOST_CHECK_EQUAL(received, msgs.size());
+    // All bytes were accounted for the type of the message they belong to.
+    for (const auto& [msg_type, bytes] : bytes_per_type) BOOST_CHECK_EQUAL(bytes, 0U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -889,5 +889,43 @@ BOOST_AUTO_TEST_CASE(peer_worksets)
             BOOST_CHECK(!orphanage->HaveTxFromPeer(orphan_wtxid, node));
         }
     }
+
+    // Worksets are processed in the order the orphans were received, regardless of the order the parents arrive in,
+    // and orphans that are processed return to their original place in the eviction order.
+    {
+        auto parent_a = MakeTransactionSpending({}, det_rand);
+        auto parent_b = MakeTransactionSpending({}, det_rand);
+        std::vector<CTransactionRef> orphans;
+        for (unsigned int i{0}; i < 12; ++i) {
+            const auto& parent{i % 3 == 0 ? parent_a : i % 3 == 1 ? parent_b : MakeTransactionSpending({}, det_rand)};
+            orphans.emplace_back(MakeTransactionSpending({COutPoint{parent->GetHash(), i % 2}}, det_rand));
+            BOOST_CHECK(orphanage->AddTx(orphans.back(), node0));
+        }
+
+        // parent_b arrives before parent_a, but the orphans come out of the workset oldest first.
+        BOOST_CHECK_EQUAL(orphanage->AddChildrenToWorkSet(*parent_b, det_rand).size(), 4);
+        BOOST_CHECK_EQUAL(orphanage->AddChildrenToWorkSet(*parent_a, det_rand).size(), 4);
+        orphanage->SanityCheck();
+        for (unsigned int i{0}; i < orphans.size(); ++i) {
+            if (i % 3 == 2) continue;
+            BOOST_CHECK_EQUAL(orphanage->GetTxToReconsider(node0), orphans.at(i));
+        }
+        BOOST_CHECK(!orphanage->HaveTxToReconsider(node0));
+        orphanage->SanityCheck();
+
+        // An orphan that leaves the workset returns to its place in the eviction order: with orphan 0 processed and
+        // orphans 3, 6 and 9 still in the workset, orphans 0 and 1 are the oldest ones to evict.
+        auto limited_orphanage{node::MakeTxOrphanage(/*max_global_ann=*/orphans.size() - 2, /*reserved_peer_usage=*/node::DEFAULT_RESERVED_ORPHAN_WEIGHT_PER_PEER)};
+        for (const auto& orphan : orphans) limited_orphanage->AddTx(orphan, node0);
+        BOOST_CHECK_EQUAL(limited_orphanage->AddChildrenToWorkSet(*parent_a, det_rand).size(), 4);
+        BOOST_CHECK_EQUAL(limited_orphanage->GetTxToReconsider(node0), orphans.at(0));
+        limited_orphanage->LimitOrphans();
+        limited_orphanage->SanityCheck();
+        BOOST_CHECK(!limited_orphanage->HaveTx(orphans.at(0)->GetWitnessHash()));
+        BOOST_CHECK(!limited_orphanage->HaveTx(orphans.at(1)->GetWitnessHash()));
+        BOOST_CHECK(limited_orphanage->HaveTx(orphans.at(2)->GetWitnessHash()));
+        BOOST_CHECK(limited_orphanage->HaveTx(orphans.at(3)->GetWitnessHash()));
+        BOOST_CHECK_EQUAL(limited_orphanage->GetTxToReconsider(node0), orphans.at(3));
+    }
 }
 BOOST_AUTO_TEST_SUITE_END()
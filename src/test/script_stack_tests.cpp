@@ -0,0 +1,126 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <script/stack.h>
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+struct ScriptStackTest : public BasicTestingSetup {
+    ScriptStack m_stack;
+    std::vector<std::vector<unsigned char>> m_expected;
+
+    //! Elements both stored inline and on the heap.
+    StackElement RandomElement()
+    {
+        const std::vector<unsigned char> bytes{m_rng.randbytes(m_rng.randbool() ? m_rng.randrange(80) : m_rng.randrange(600))};
+        return StackElement(bytes.begin(), bytes.end());
+    }
+
+    void Check() const
+    {
+        BOOST_REQUIRE_EQUAL(m_stack.size(), m_expected.size());
+        BOOST_CHECK_EQUAL(m_stack.empty(), m_expected.empty());
+        BOOST_CHECK(m_stack.capacity() >= m_stack.size());
+        for (size_t i = 0; i < m_expected.size(); ++i) {
+            BOOST_CHECK(std::vector<unsigned char>(m_stack[i].begin(), m_stack[i].end()) == m_expected[i]);
+        }
+    }
+};
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(script_stack_tests, ScriptStackTest)
+
+BOOST_AUTO_TEST_CASE(script_stack_operations)
+{
+    for (int i = 0; i < 5000; ++i) {
+        // Stay around the inline capacity most of the time.
+        const bool grow{m_expected.size() < ScriptStack::INLINE_CAPACITY * (m_rng.randbool() ? 1 : 4)};
+        switch (m_rng.randrange(8)) {
+        case 0:
+        case 1: {
+            if (!grow) break;
+            const StackElement element{RandomElement()};
+            m_stack.push_back(element);
+            m_expected.emplace_back(element.begin(), element.end());
+            break;
+        }
+        case 2:
+            // Push a copy of an element of the stack itself.
+            if (!grow || m_expected.empty()) break;
+            m_stack.push_back(m_stack[0]);
+            m_expected.push_back(m_expected[0]);
+            break;
+        case 3:
+            if (m_expected.empty()) break;
+            m_stack.pop_back();
+            m_expected.pop_back();
+            break;
+        case 4: {
+            if (!grow) break;
+            const size_t pos{m_rng.randrange(m_expected.size() + 1)};
+            const StackElement element{RandomElement()};
+            m_stack.insert(m_stack.begin() + pos, element);
+            m_expected.emplace(m_expected.begin() + pos, element.begin(), element.end());
+            break;
+        }
+        case 5: {
+            const size_t first{m_rng.randrange(m_expected.size() + 1)};
+            const size_t last{first + m_rng.randrange(m_expected.size() - first + 1)};
+            m_stack.erase(m_stack.begin() + first, m_stack.begin() + last);
+            m_expected.erase(m_expected.begin() + first, m_expected.begin() + last);
+            break;
+        }
+        case 6: {
+            const size_t size{m_rng.randrange(m_expected.size() + 1)};
+            m_stack.resize(size);
+            m_expected.resize(size);
+            break;
+        }
+        case 7: {
+            // Copies and moves, from and to both inline and heap storage.
+            ScriptStack copy{m_stack};
+            ScriptStack moved;
+            if (m_rng.randbool()) moved.push_back(RandomElement());
+            moved = std::move(copy);
+            ScriptStack other{m_rng.randbool() ? ScriptStack{} : ScriptStack{m_expected.begin(), m_expected.end()}};
+            swap(moved, other);
+            m_stack = m_rng.randbool() ? other : std::move(other);
+            break;
+        }
+        }
+        Check();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(script_stack_inline)
+{
+    ScriptStack stack;
+    for (size_t i = 0; i < ScriptStack::INLINE_CAPACITY; ++i) stack.push_back(StackElement(1, static_cast<unsigned char>(i)));
+    BOOST_CHECK_EQUAL(stack.capacity(), ScriptStack::INLINE_CAPACITY);
+    stack.push_back(StackElement(1, static_cast<unsigned char>(0xff)));
+    BOOST_CHECK(stack.capacity() > ScriptStack::INLINE_CAPACITY);
+    for (size_t i = 0; i < ScriptStack::INLINE_CAPACITY; ++i) {
+        BOOST_CHECK(stack[i] == StackElement(1, static_cast<unsigned char>(i)));
+    }
+    BOOST_CHECK(stack.back() == StackElement(1, static_cast<unsigned char>(0xff)));
+
+    // Moving a stack on the heap takes its allocation.
+    const StackElement* data{&stack[0]};
+    ScriptStack moved{std::move(stack)};
+    BOOST_CHECK_EQUAL(&moved[0], data);
+    BOOST_CHECK(stack.empty()); // NOLINT(bugprone-use-after-move)
+    BOOST_CHECK_EQUAL(stack.capacity(), ScriptStack::INLINE_CAPACITY);
+
+    BOOST_CHECK_THROW(moved.at(moved.size()), std::out_of_range);
+    BOOST_CHECK(moved.at(0) == StackElement(1, static_cast<unsigned char>(0)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,47 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <test/util/setup_common.h>
+#include <util/threadpool.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+BOOST_FIXTURE_TEST_SUITE(threadpool_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(threadpool_submit)
+{
+    ThreadPool pool{"pooltest", 4};
+    BOOST_CHECK_EQUAL(pool.WorkersCount(), 4U);
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 100; ++i) {
+        futures.push_back(pool.Submit([i] { return i * i; }));
+    }
+    for (int i = 0; i < 100; ++i) {
+        BOOST_CHECK_EQUAL(futures[i].get(), i * i);
+    }
+
+    // Exceptions are passed on to the submitter.
+    auto failing{pool.Submit([]() -> int { throw std::runtime_error("failed"); })};
+    BOOST_CHECK_THROW(failing.get(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(threadpool_stop)
+{
+    // Tasks still queued when the pool is destroyed are run first.
+    std::atomic<int> count{0};
+    {
+        ThreadPool pool{"pooltest", 2};
+        for (int i = 0; i < 50; ++i) {
+            pool.Submit([&count] { ++count; });
+        }
+    }
+    BOOST_CHECK_EQUAL(count, 50);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -16,6 +16,7 @@
 #include <key.h>
 #include <policy/policy.h>
 #include <policy/settings.h>
+#include <primitives/block.h>
 #include <script/script.h>
 #include <script/script_error.h>
 #include <script/sigcache.h>
@@ -1149,4 +1150,57 @@ BOOST_AUTO_TEST_CASE(max_standard_legacy_sigops)
     BOOST_CHECK(!::AreInputsStandard(CTransaction(tx_max_sigops), coins));
 }
 
+BOOST_AUTO_TEST_CASE(block_transaction_hashes)
+{
+    // A block mixing transactions with and without witness, each of which
+    // is hashed from the bytes it was read from when reading from memory.
+    CBlock block;
+    for (int i = 0; i < 50; ++i) {
+        CMutableTransaction mtx;
+        mtx.version = m_rng.rand32();
+        mtx.nLockTime = m_rng.rand32();
+        mtx.vin.resize(1 + m_rng.randrange(3));
+        for (auto& input : mtx.vin) {
+            input.prevout = COutPoint{Txid::FromUint256(m_rng.rand256()), m_rng.rand32()};
+            const auto script_sig{m_rng.randbytes(m_rng.randrange(120))};
+            input.scriptSig = CScript(script_sig.begin(), script_sig.end());
+            if (i % 3 == 0) continue;
+            for (int j = m_rng.randrange(4); j > 0; --j) input.scriptWitness.stack.push_back(m_rng.randbytes(m_rng.randrange(300)));
+        }
+        mtx.vout.resize(m_rng.randrange(4));
+        for (auto& output : mtx.vout) {
+            const auto script{m_rng.randbytes(m_rng.randrange(40))};
+            output = CTxOut{CAmount(m_rng.randrange(MAX_MONEY)), CScript(script.begin(), script.end())};
+        }
+        block.vtx.push_back(MakeTransactionRef(std::move(mtx)));
+    }
+    BOOST_CHECK(std::ranges::any_of(block.vtx, [](const auto& tx) { return tx->HasWitness(); }));
+    BOOST_CHECK(!std::ranges::all_of(block.vtx, [](const auto& tx) { return tx->HasWitness(); }));
+
+    const auto check_hashes{[&](const CBlock& read, bool with_witness) {
+        BOOST_REQUIRE_EQUAL(read.vtx.size(), block.vtx.size());
+        for (size_t i = 0; i < block.vtx.size(); ++i) {
+            BOOST_CHECK_EQUAL(read.vtx[i]->GetHash(), block.vtx[i]->GetHash());
+            if (with_witness) BOOST_CHECK_EQUAL(read.vtx[i]->GetWitnessHash(), block.vtx[i]->GetWitnessHash());
+        }
+    }};
+    for (const auto& params : {TX_WITH_WITNESS, TX_NO_WITNESS}) {
+        DataStream stream;
+        stream << params(block) << uint8_t{42};
+        CBlock read;
+        SpanReader{stream} >> params(read);
+        check_hashes(read, params.allow_witness);
+        stream >> params(read);
+        check_hashes(read, params.allow_witness);
+        // Only the block was consumed.
+        BOOST_CHECK_EQUAL(stream.size(), 1U);
+    }
+
+    std::vector<CMutableTransaction> txs;
+    for (const auto& tx : block.vtx) txs.emplace_back(*tx);
+    CBlock reserialized;
+    reserialized.vtx = MakeTransactionRefs(std::move(txs));
+    check_hashes(reserialized, /*with_witness=*/true);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
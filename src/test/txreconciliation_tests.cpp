@@ -4,10 +4,106 @@
 
 #include <node/txreconciliation.h>
 
+#include <serialize.h>
 #include <test/util/setup_common.h>
+#include <util/transaction_identifier.h>
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+/** Size of a p2p message header. */
+constexpr size_t HEADER_BYTES{24};
+/** Size of an entry of an INV message. */
+constexpr size_t INV_ENTRY_BYTES{36};
+
+size_t InvBytes(size_t count) { return count == 0 ? 0 : HEADER_BYTES + GetSizeOfCompactSize(count) + count * INV_ENTRY_BYTES; }
+
+/** Two trackers reconciling with each other: tracker a (peer 0) initiates reconciliations with tracker b (peer 1). */
+struct ReconciliationPair {
+    TxReconciliationTracker a{TXRECONCILIATION_VERSION};
+    TxReconciliationTracker b{TXRECONCILIATION_VERSION};
+
+    ReconciliationPair()
+    {
+        const uint64_t salt_a{a.PreRegisterPeer(1)};
+        const uint64_t salt_b{b.PreRegisterPeer(0)};
+        BOOST_REQUIRE(a.RegisterPeer(1, /*is_peer_inbound=*/false, TXRECONCILIATION_VERSION, salt_b) == ReconciliationRegisterResult::SUCCESS);
+        BOOST_REQUIRE(b.RegisterPeer(0, /*is_peer_inbound=*/true, TXRECONCILIATION_VERSION, salt_a) == ReconciliationRegisterResult::SUCCESS);
+    }
+
+    /** Outcome of a reconciliation: what a and b announce to each other, and the bytes of the reconciliation messages. */
+    struct Round {
+        bool extended{false};
+        bool success{false};
+        std::set<Wtxid> announced_by_a;
+        std::set<Wtxid> announced_by_b;
+        size_t bytes{0};
+    };
+
+    /** Run a reconciliation, or return std::nullopt if a does not initiate one at time now. */
+    std::optional<Round> Reconcile(std::chrono::microseconds now)
+    {
+        const auto request{a.InitiateReconciliationRequest(1, now)};
+        if (!request) return std::nullopt;
+        Round round;
+        round.bytes += HEADER_BYTES + 4;
+        auto skdata{b.HandleReconciliationRequest(0, request->first, request->second)};
+        BOOST_REQUIRE(skdata);
+        round.bytes += HEADER_BYTES + GetSizeOfCompactSize(skdata->size()) + skdata->size();
+        auto result{a.HandleSketch(1, *skdata)};
+        BOOST_REQUIRE(result);
+        if (result->request_extension) {
+            round.extended = true;
+            round.bytes += HEADER_BYTES;
+            skdata = b.HandleSketchExtensionRequest(0);
+            BOOST_REQUIRE(skdata);
+            round.bytes += HEADER_BYTES + GetSizeOfCompactSize(skdata->size()) + skdata->size();
+            result = a.HandleSketch(1, *skdata);
+            BOOST_REQUIRE(result);
+            BOOST_REQUIRE(!result->request_extension);
+        }
+        round.success = result->success;
+        round.bytes += HEADER_BYTES + 1 + GetSizeOfCompactSize(result->ask_shortids.size()) + 4 * result->ask_shortids.size();
+        const auto announce_b{b.HandleReconciliationDifference(0, result->success, result->ask_shortids)};
+        BOOST_REQUIRE(announce_b);
+        round.announced_by_a.insert(result->announce.begin(), result->announce.end());
+        round.announced_by_b.insert(announce_b->begin(), announce_b->end());
+        return round;
+    }
+};
+
+/**
+ * Add n transactions to the reconciliation sets of both trackers, and n_a and n_b to only one
+ * of them. Both trackers pick the same transactions for fanout, which are not in the sets.
+ */
+void FillSets(ReconciliationPair& pair, FastRandomContext& rng, int n, int n_a, int n_b, std::set<Wtxid>& only_a, std::set<Wtxid>& only_b)
+{
+    for (int i = 0; i < n; ++i) {
+        const Wtxid wtxid{Wtxid::FromUint256(rng.rand256())};
+        BOOST_CHECK_EQUAL(pair.a.AddToSet(1, wtxid), pair.b.AddToSet(0, wtxid));
+    }
+    while (only_a.size() < size_t(n_a)) {
+        const Wtxid wtxid{Wtxid::FromUint256(rng.rand256())};
+        if (pair.a.AddToSet(1, wtxid)) only_a.insert(wtxid);
+    }
+    while (only_b.size() < size_t(n_b)) {
+        const Wtxid wtxid{Wtxid::FromUint256(rng.rand256())};
+        if (pair.b.AddToSet(0, wtxid)) only_b.insert(wtxid);
+    }
+}
+} // namespace
+
 BOOST_FIXTURE_TEST_SUITE(txreconciliation_tests, BasicTestingSetup)
 
 BOOST_AUTO_TEST_CASE(RegisterPeerTest)
@@ -81,4 +177,232 @@ BOOST_AUTO_TEST_CASE(IsPeerRegisteredTest)
     BOOST_CHECK(!tracker.IsPeerRegistered(peer_id0));
 }
 
+BOOST_AUTO_TEST_CASE(ReconciliationRoundTest)
+{
+    ReconciliationPair pair;
+    const Wtxid wtxid{Wtxid::FromUint256(m_rng.rand256())};
+
+    // Only registered peers reconcile, and only the initiator requests.
+    BOOST_CHECK(!pair.a.AddToSet(2, wtxid));
+    BOOST_CHECK(!pair.b.InitiateReconciliationRequest(0, 0s));
+    BOOST_CHECK(!pair.a.HandleReconciliationRequest(1, 0, 0));
+    BOOST_CHECK(!pair.b.HandleSketch(0, {}));
+    BOOST_CHECK(!pair.b.HandleSketchExtensionRequest(0));
+    BOOST_CHECK(!pair.b.HandleReconciliationDifference(0, true, {}));
+
+    // Small differences are found with the initial sketch.
+    std::set<Wtxid> only_a, only_b;
+    FillSets(pair, m_rng, 100, 3, 2, only_a, only_b);
+    auto round{pair.Reconcile(0s)};
+    BOOST_REQUIRE(round);
+    BOOST_CHECK(round->success);
+    BOOST_CHECK(!round->extended);
+    BOOST_CHECK(round->announced_by_a == only_a);
+    BOOST_CHECK(round->announced_by_b == only_b);
+
+    // The next reconciliation waits for RECON_REQUEST_INTERVAL.
+    BOOST_CHECK(!pair.Reconcile(RECON_REQUEST_INTERVAL - 1s));
+    round = pair.Reconcile(RECON_REQUEST_INTERVAL);
+    BOOST_REQUIRE(round);
+    BOOST_CHECK(round->success);
+    BOOST_CHECK(round->announced_by_a.empty());
+    BOOST_CHECK(round->announced_by_b.empty());
+
+    // Differences beyond the estimate based on q need the sketch extension.
+    only_a.clear();
+    only_b.clear();
+    FillSets(pair, m_rng, 15, 2, 2, only_a, only_b);
+    round = pair.Reconcile(2 * RECON_REQUEST_INTERVAL);
+    BOOST_REQUIRE(round);
+    BOOST_CHECK(round->success);
+    BOOST_CHECK(round->extended);
+    BOOST_CHECK(round->announced_by_a == only_a);
+    BOOST_CHECK(round->announced_by_b == only_b);
+
+    // If even the extension is too small, both sides announce their whole set.
+    only_a.clear();
+    only_b.clear();
+    FillSets(pair, m_rng, 0, 50, 50, only_a, only_b);
+    round = pair.Reconcile(3 * RECON_REQUEST_INTERVAL);
+    BOOST_REQUIRE(round);
+    BOOST_CHECK(!round->success);
+    BOOST_CHECK(round->extended);
+    BOOST_CHECK(round->announced_by_a == only_a);
+    BOOST_CHECK(round->announced_by_b == only_b);
+
+    // Messages out of order are protocol violations.
+    BOOST_CHECK(!pair.a.HandleSketch(1, {}));
+    BOOST_CHECK(!pair.b.HandleSketchExtensionRequest(0));
+    BOOST_CHECK(!pair.b.HandleReconciliationDifference(0, true, {}));
+    BOOST_REQUIRE(pair.a.InitiateReconciliationRequest(1, 4 * RECON_REQUEST_INTERVAL));
+    BOOST_CHECK(!pair.a.InitiateReconciliationRequest(1, 5 * RECON_REQUEST_INTERVAL));
+    BOOST_REQUIRE(pair.b.HandleReconciliationRequest(0, 0, 0));
+    BOOST_CHECK(!pair.b.HandleReconciliationRequest(0, 0, 0));
+    BOOST_CHECK(!pair.a.HandleSketch(1, std::vector<uint8_t>(3)));
+}
+
+BOOST_AUTO_TEST_CASE(ReconciliationTimeoutTest)
+{
+    ReconciliationPair pair;
+    std::set<Wtxid> only_a, only_b;
+    FillSets(pair, m_rng, 0, 20, 20, only_a, only_b);
+
+    // Nothing expires while no reconciliation is in progress.
+    BOOST_CHECK(pair.a.ExpireReconciliation(1, 1h).empty());
+    BOOST_CHECK(pair.b.ExpireReconciliation(0, 1h).empty());
+
+    // The initiator gives up if the peer does not answer its reqrecon in time, announcing the
+    // transactions of the reconciliation and those added meanwhile.
+    BOOST_REQUIRE(pair.a.InitiateReconciliationRequest(1, 0s));
+    std::set<Wtxid> added_a;
+    FillSets(pair, m_rng, 0, 5, 0, added_a, only_b);
+    BOOST_CHECK(pair.a.ExpireReconciliation(1, RECON_RESPONSE_TIMEOUT - 1us).empty());
+    const auto expired_a{pair.a.ExpireReconciliation(1, RECON_RESPONSE_TIMEOUT)};
+    only_a.insert(added_a.begin(), added_a.end());
+    BOOST_CHECK(std::set<Wtxid>(expired_a.begin(), expired_a.end()) == only_a);
+    BOOST_CHECK(pair.a.ExpireReconciliation(1, 1h).empty());
+    // A late sketch is a protocol violation.
+    BOOST_CHECK(!pair.a.HandleSketch(1, {}));
+
+    // The responder's deadline starts with its first check after it sent its sketch.
+    BOOST_REQUIRE(pair.b.HandleReconciliationRequest(0, 0, 0));
+    BOOST_CHECK(pair.b.ExpireReconciliation(0, 1h).empty());
+    BOOST_CHECK(pair.b.ExpireReconciliation(0, 1h + RECON_RESPONSE_TIMEOUT - 1us).empty());
+    const auto expired_b{pair.b.ExpireReconciliation(0, 1h + RECON_RESPONSE_TIMEOUT)};
+    BOOST_CHECK(std::set<Wtxid>(expired_b.begin(), expired_b.end()) == only_b);
+    BOOST_CHECK(!pair.b.HandleReconciliationDifference(0, true, {}));
+
+    // Each phase gets its own deadline: an extension round restarts the clock.
+    only_a.clear();
+    only_b.clear();
+    FillSets(pair, m_rng, 15, 2, 2, only_a, only_b);
+    const auto now{2h};
+    const auto request{pair.a.InitiateReconciliationRequest(1, now)};
+    BOOST_REQUIRE(request);
+    // Claim a q of 0 so that the initial sketch is too small for the difference.
+    const auto skdata{pair.b.HandleReconciliationRequest(0, request->first, /*remote_q=*/0)};
+    BOOST_REQUIRE(skdata);
+    const auto result{pair.a.HandleSketch(1, *skdata)};
+    BOOST_REQUIRE(result);
+    BOOST_REQUIRE(result->request_extension);
+    BOOST_CHECK(pair.a.ExpireReconciliation(1, now + RECON_RESPONSE_TIMEOUT).empty());
+    BOOST_CHECK(pair.a.ExpireReconciliation(1, now + 2 * RECON_RESPONSE_TIMEOUT - 1us).empty());
+    BOOST_CHECK(!pair.a.ExpireReconciliation(1, now + 2 * RECON_RESPONSE_TIMEOUT).empty());
+}
+
+BOOST_AUTO_TEST_CASE(ReconciliationSimulationTest)
+{
+    // Relay transactions through a network of nodes with 8 outbound connections each, and
+    // compare the bytes of announcements when flooding INVs to all peers and when
+    // reconciling. Transactions are announced once per second, and received a second later.
+    constexpr int NUM_NODES{30};
+    constexpr int OUTBOUND{8};
+    constexpr int NUM_TXS{300};
+    constexpr int TX_SECONDS{60};
+
+    std::vector<std::set<int>> links(NUM_NODES);
+    std::vector<std::pair<int, int>> outbound;
+    for (int node = 0; node < NUM_NODES; ++node) {
+        while (std::ranges::count(outbound, node, &std::pair<int, int>::first) < OUTBOUND) {
+            const int peer = m_rng.randrange(NUM_NODES);
+            if (peer == node || links[node].contains(peer)) continue;
+            links[node].insert(peer);
+            links[peer].insert(node);
+            outbound.emplace_back(node, peer);
+        }
+    }
+    std::vector<Wtxid> txs;
+    for (int i = 0; i < NUM_TXS; ++i) txs.push_back(Wtxid::FromUint256(m_rng.rand256()));
+
+    const auto simulate{[&](bool reconcile) {
+        std::vector<std::unique_ptr<TxReconciliationTracker>> trackers;
+        for (int node = 0; node < NUM_NODES; ++node) trackers.push_back(std::make_unique<TxReconciliationTracker>(TXRECONCILIATION_VERSION));
+        if (reconcile) {
+            for (const auto& [node, peer] : outbound) {
+                const uint64_t salt_node{trackers[node]->PreRegisterPeer(peer)};
+                const uint64_t salt_peer{trackers[peer]->PreRegisterPeer(node)};
+                BOOST_REQUIRE(trackers[node]->RegisterPeer(peer, false, TXRECONCILIATION_VERSION, salt_peer) == ReconciliationRegisterResult::SUCCESS);
+                BOOST_REQUIRE(trackers[peer]->RegisterPeer(node, true, TXRECONCILIATION_VERSION, salt_node) == ReconciliationRegisterResult::SUCCESS);
+            }
+        }
+        // Transactions each node knows, and which peers it knows know them.
+        std::vector<std::set<Wtxid>> known(NUM_NODES);
+        std::map<std::pair<int, int>, std::set<Wtxid>> peer_knows;
+        // Announcements per (from, to), delivered in the next second.
+        std::map<std::pair<int, int>, std::vector<Wtxid>> invs, next_invs;
+        std::vector<std::vector<Wtxid>> to_relay(NUM_NODES);
+        size_t bytes{0};
+
+        const auto announce{[&](int from, int to, const Wtxid& wtxid) {
+            peer_knows[{from, to}].insert(wtxid);
+            next_invs[{from, to}].push_back(wtxid);
+        }};
+        for (int second = 0; known != std::vector<std::set<Wtxid>>(NUM_NODES, std::set<Wtxid>(txs.begin(), txs.end())); ++second) {
+            BOOST_REQUIRE(second < 10 * TX_SECONDS);
+            // Receive the announcements of the previous second.
+            for (auto& [link, wtxids] : invs) {
+                const auto [from, to] = link;
+                bytes += InvBytes(wtxids.size());
+                for (const Wtxid& wtxid : wtxids) {
+                    peer_knows[{to, from}].insert(wtxid);
+                    if (known[to].insert(wtxid).second) to_relay[to].push_back(wtxid);
+                }
+            }
+            invs.clear();
+            if (second < TX_SECONDS) {
+                for (int i = second * NUM_TXS / TX_SECONDS; i < (second + 1) * NUM_TXS / TX_SECONDS; ++i) {
+                    const int node = m_rng.randrange(NUM_NODES);
+                    known[node].insert(txs[i]);
+                    to_relay[node].push_back(txs[i]);
+                }
+            }
+            for (int node = 0; node < NUM_NODES; ++node) {
+                for (const Wtxid& wtxid : to_relay[node]) {
+                    for (const int peer : links[node]) {
+                        if (peer_knows[{node, peer}].contains(wtxid)) continue;
+                        if (trackers[node]->AddToSet(peer, wtxid)) {
+                            peer_knows[{node, peer}].insert(wtxid);
+                        } else {
+                            announce(node, peer, wtxid);
+                        }
+                    }
+                }
+                to_relay[node].clear();
+            }
+            if (reconcile) {
+                for (const auto& [node, peer] : outbound) {
+                    const auto request{trackers[node]->InitiateReconciliationRequest(peer, std::chrono::seconds{second})};
+                    if (!request) continue;
+                    bytes += HEADER_BYTES + 4;
+                    auto skdata{trackers[peer]->HandleReconciliationRequest(node, request->first, request->second)};
+                    BOOST_REQUIRE(skdata);
+                    bytes += HEADER_BYTES + GetSizeOfCompactSize(skdata->size()) + skdata->size();
+                    auto result{trackers[node]->HandleSketch(peer, *skdata)};
+                    BOOST_REQUIRE(result);
+                    if (result->request_extension) {
+                        bytes += HEADER_BYTES;
+                        skdata = trackers[peer]->HandleSketchExtensionRequest(node);
+                        BOOST_REQUIRE(skdata);
+                        bytes += HEADER_BYTES + GetSizeOfCompactSize(skdata->size()) + skdata->size();
+                        result = trackers[node]->HandleSketch(peer, *skdata);
+                        BOOST_REQUIRE(result);
+                    }
+                    bytes += HEADER_BYTES + 1 + GetSizeOfCompactSize(result->ask_shortids.size()) + 4 * result->ask_shortids.size();
+                    for (const Wtxid& wtxid : result->announce) announce(node, peer, wtxid);
+                    const auto wtxids{trackers[peer]->HandleReconciliationDifference(node, result->success, result->ask_shortids)};
+                    BOOST_REQUIRE(wtxids);
+                    for (const Wtxid& wtxid : *wtxids) announce(peer, node, wtxid);
+                }
+            }
+            std::swap(invs, next_invs);
+        }
+        return bytes;
+    }};
+
+    const size_t flooding_bytes{simulate(/*reconcile=*/false)};
+    const size_t reconciliation_bytes{simulate(/*reconcile=*/true)};
+    BOOST_TEST_MESSAGE("Simulated transaction announcements: " << flooding_bytes << " bytes flooding, " << reconciliation_bytes << " bytes reconciling");
+    BOOST_CHECK(reconciliation_bytes < flooding_bytes);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
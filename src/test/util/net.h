@@ -147,6 +147,8 @@ public:
 
     ssize_t Send(const void*, size_t len, int) const override;
 
+    ssize_t SendVectored(std::span<const std::span<const unsigned char>> bufs, int) const override;
+
     ssize_t Recv(void* buf, size_t len, int flags) const override;
 
     int Connect(const sockaddr*, socklen_t) const override;
@@ -318,6 +320,8 @@ public:
 
     ssize_t Send(const void* buf, size_t len, int) const override;
 
+    ssize_t SendVectored(std::span<const std::span<const unsigned char>> bufs, int) const override;
+
     std::unique_ptr<Sock> Accept(sockaddr* addr, socklen_t* addr_len) const override;
 
     bool Wait(std::chrono::milliseconds timeout,
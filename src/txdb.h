@@ -59,6 +59,9 @@ public:
 
     //! @returns filesystem path to on-disk storage or std::nullopt if in memory.
     std::optional<fs::path> StoragePath() { return m_db->StoragePath(); }
+
+    //! Storage engine statistics of the underlying database.
+    DBStats GetDBStats() const { return m_db->GetStats(); }
 };
 
 #endif // BITCOIN_TXDB_H
@@ -369,6 +369,7 @@ public:
 
     using txiter = indexed_transaction_set::nth_index<0>::type::const_iterator;
     std::vector<CTransactionRef> txns_randomized GUARDED_BY(cs); //!< All transactions in mapTx, in random order
+    std::vector<Wtxid> wtxids_randomized GUARDED_BY(cs); //!< Witness hashes of txns_randomized, in the same order, to scan them without touching the transactions
 
     typedef std::set<txiter, CompareIteratorByHash> setEntries;
 
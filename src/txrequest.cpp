@@ -17,9 +17,16 @@
 #include <boost/multi_index_container.hpp>
 #include <boost/tuple/tuple.hpp>
 
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <chrono>
+#include <iterator>
+#include <set>
+#include <tuple>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include <cassert>
 
@@ -124,7 +131,7 @@ public:
     }
 };
 
-// Definitions for the 3 indexes used in the main data structure.
+// Definitions for the 2 indexes used in the main data structure.
 //
 // Each index has a By* type to identify it, a By*View data type to represent the view of announcement it is sorted
 // by, and an By*ViewExtractor type to convert an announcement into the By*View type.
@@ -172,50 +179,147 @@ public:
     }
 };
 
-enum class WaitState {
-    //! Used for announcements that need efficient testing of "is their timestamp in the future?".
-    FUTURE_EVENT,
-    //! Used for announcements whose timestamp is not relevant.
-    NO_EVENT,
-    //! Used for announcements that need efficient testing of "is their timestamp in the past?".
-    PAST_EVENT,
+/** The time at which a CANDIDATE_DELAYED or REQUESTED announcement stops waiting. */
+struct TimeEvent {
+    std::chrono::microseconds m_time;
+    NodeId m_peer;
+    uint256 m_txhash;
 };
 
-WaitState GetWaitState(const Announcement& ann)
-{
-    if (ann.IsWaiting()) return WaitState::FUTURE_EVENT;
-    if (ann.IsSelectable()) return WaitState::PAST_EVENT;
-    return WaitState::NO_EVENT;
-}
+/** Hierarchical timing wheel of TimeEvents.
+ *
+ * Time is divided into ticks of 2^TICK_BITS microseconds, and tick numbers into digits of SLOT_BITS bits. Level l
+ * of the wheel has one slot per value of digit l. An event is stored at the level of the most significant digit in
+ * which its tick differs from the current tick of the wheel, in the slot of its own digit there. Thus all events at
+ * a level are later than the events at the levels below it, and advancing the wheel only visits the slots whose
+ * time has come, redistributing their events over the lower levels. Events too far in the future for the highest
+ * level are kept in an overflow list, which is only redistributed when the highest digits of the current tick
+ * change.
+ *
+ * Adding an event is O(1), and every event is moved at most once per level. Events cannot be removed: users of the
+ * wheel must check whether an event still applies when it is due.
+ */
+class TimingWheel {
+    static constexpr int TICK_BITS{10};
+    static constexpr int SLOT_BITS{6};
+    static constexpr int SLOTS{1 << SLOT_BITS};
+    static constexpr int LEVELS{5};
+
+    //! The current tick. All events at or before it are in m_due.
+    uint64_t m_tick{0};
+    //! Events per level and slot, with a bitmap of the non-empty slots of every level.
+    std::array<std::array<std::vector<TimeEvent>, SLOTS>, LEVELS> m_slots;
+    std::array<uint64_t, LEVELS> m_occupied{};
+    //! Events whose tick differs from m_tick beyond the highest level.
+    std::vector<TimeEvent> m_overflow;
+    //! Events whose tick has been reached, but which may still be in the future within that tick.
+    std::vector<TimeEvent> m_due;
+
+    static uint64_t ToTick(std::chrono::microseconds time)
+    {
+        return time.count() > 0 ? uint64_t(time.count()) >> TICK_BITS : 0;
+    }
 
-// The ByTime index is sorted by (wait_state, time).
-//
-// All announcements with a timestamp in the future can be found by iterating the index forward from the beginning.
-// All announcements with a timestamp in the past can be found by iterating the index backwards from the end.
-//
-// Uses:
-// * Finding CANDIDATE_DELAYED announcements whose reqtime has passed, and REQUESTED announcements whose expiry has
-//   passed.
-// * Finding CANDIDATE_READY/BEST announcements whose reqtime is in the future (when the clock time went backwards).
-struct ByTime {};
-using ByTimeView = std::pair<WaitState, std::chrono::microseconds>;
-struct ByTimeViewExtractor
-{
-    using result_type = ByTimeView;
-    result_type operator()(const Announcement& ann) const
+    //! Store an event relative to m_tick.
+    void Place(TimeEvent&& event)
+    {
+        const uint64_t tick{ToTick(event.m_time)};
+        if (tick <= m_tick) {
+            m_due.push_back(std::move(event));
+            return;
+        }
+        const int level{(int(std::bit_width(tick ^ m_tick)) - 1) / SLOT_BITS};
+        if (level >= LEVELS) {
+            m_overflow.push_back(std::move(event));
+            return;
+        }
+        const int slot = (tick >> (level * SLOT_BITS)) & (SLOTS - 1);
+        m_slots[level][slot].push_back(std::move(event));
+        m_occupied[level] |= uint64_t{1} << slot;
+    }
+
+    //! Move the events in a slot to the levels below it (or to m_due).
+    void Cascade(int level, int slot)
     {
-        return ByTimeView{GetWaitState(ann), ann.m_time};
+        std::vector<TimeEvent> events{std::move(m_slots[level][slot])};
+        m_slots[level][slot].clear();
+        m_occupied[level] &= ~(uint64_t{1} << slot);
+        for (TimeEvent& event : events) Place(std::move(event));
+    }
+
+    //! Set the current tick, moving all events at or before it to m_due.
+    void Advance(uint64_t target)
+    {
+        if (target < m_tick) {
+            // Time went backwards. This does not happen in production, so just rebuild the wheel.
+            std::vector<TimeEvent> events{std::move(m_due)};
+            m_due.clear();
+            ForEach([&](const TimeEvent& event) { events.push_back(event); });
+            for (auto& level : m_slots) {
+                for (auto& slot : level) slot.clear();
+            }
+            m_occupied.fill(0);
+            m_overflow.clear();
+            m_tick = target;
+            for (TimeEvent& event : events) Place(std::move(event));
+            return;
+        }
+        while (true) {
+            // The earliest events are in the first non-empty slot of the lowest non-empty level.
+            int level{0};
+            while (level < LEVELS && m_occupied[level] == 0) ++level;
+            if (level == LEVELS) break;
+            const int slot{std::countr_zero(m_occupied[level])};
+            const int shift{level * SLOT_BITS};
+            const uint64_t start{(m_tick >> (shift + SLOT_BITS) << (shift + SLOT_BITS)) | (uint64_t(slot) << shift)};
+            if (start > target) break;
+            m_tick = start;
+            Cascade(level, slot);
+        }
+        const bool overflow_due{target >> (LEVELS * SLOT_BITS) != m_tick >> (LEVELS * SLOT_BITS)};
+        m_tick = target;
+        if (overflow_due) {
+            // The wheel is empty now, as all its events were before target.
+            std::vector<TimeEvent> events{std::move(m_overflow)};
+            m_overflow.clear();
+            for (TimeEvent& event : events) Place(std::move(event));
+        }
+    }
+
+public:
+    void Add(TimeEvent event) { Place(std::move(event)); }
+
+    //! Replace the contents of due with all events with a time at or before now, sorted by time.
+    void PopDue(std::chrono::microseconds now, std::vector<TimeEvent>& due)
+    {
+        due.clear();
+        Advance(ToTick(now));
+        const auto it{std::partition(m_due.begin(), m_due.end(), [&](const TimeEvent& event) { return event.m_time > now; })};
+        std::move(it, m_due.end(), std::back_inserter(due));
+        m_due.erase(it, m_due.end());
+        std::stable_sort(due.begin(), due.end(), [](const TimeEvent& a, const TimeEvent& b) { return a.m_time < b.m_time; });
+    }
+
+    template <typename F>
+    void ForEach(F f) const
+    {
+        for (const TimeEvent& event : m_due) f(event);
+        for (const auto& level : m_slots) {
+            for (const auto& slot : level) {
+                for (const TimeEvent& event : slot) f(event);
+            }
+        }
+        for (const TimeEvent& event : m_overflow) f(event);
     }
 };
 
 struct Announcement_Indices final : boost::multi_index::indexed_by<
     boost::multi_index::ordered_unique<boost::multi_index::tag<ByPeer>, ByPeerViewExtractor>,
-    boost::multi_index::ordered_non_unique<boost::multi_index::tag<ByTxHash>, ByTxHashViewExtractor>,
-    boost::multi_index::ordered_non_unique<boost::multi_index::tag<ByTime>, ByTimeViewExtractor>
+    boost::multi_index::ordered_non_unique<boost::multi_index::tag<ByTxHash>, ByTxHashViewExtractor>
 >
 {};
 
-/** Data type for the main data structure (Announcement objects with ByPeer/ByTxHash/ByTime indexes). */
+/** Data type for the main data structure (Announcement objects with ByPeer/ByTxHash indexes). */
 using Index = boost::multi_index_container<
     Announcement,
     Announcement_Indices
@@ -312,6 +416,17 @@ class TxRequestTracker::Impl {
     //! Map with this tracker's per-peer statistics.
     std::unordered_map<NodeId, PeerInfo> m_peerinfo;
 
+    //! The times at which CANDIDATE_DELAYED and REQUESTED announcements stop waiting. Every such announcement has an
+    //! event for its current time; events of announcements which changed since are stale and skipped.
+    TimingWheel m_wheel;
+
+    //! Buffer for the due events in SetTimePoint.
+    std::vector<TimeEvent> m_due_events;
+
+    //! The time passed to the last SetTimePoint call. No CANDIDATE_READY or CANDIDATE_BEST announcement has a later
+    //! time.
+    std::chrono::microseconds m_last_now{std::chrono::microseconds::min()};
+
 public:
     void SanityCheck() const
     {
@@ -345,6 +460,13 @@ public:
             std::sort(info.m_peers.begin(), info.m_peers.end());
             assert(std::adjacent_find(info.m_peers.begin(), info.m_peers.end()) == info.m_peers.end());
         }
+
+        // Every CANDIDATE_DELAYED and REQUESTED announcement must have an event in the timing wheel.
+        std::set<std::tuple<NodeId, uint256, std::chrono::microseconds>> events;
+        m_wheel.ForEach([&](const TimeEvent& event) { events.emplace(event.m_peer, event.m_txhash, event.m_time); });
+        for (const Announcement& ann : m_index) {
+            if (ann.IsWaiting()) assert(events.count({ann.m_peer, ann.m_gtxid.ToUint256(), ann.m_time}));
+        }
     }
 
     void PostGetRequestableSanityCheck(std::chrono::microseconds now) const
@@ -486,30 +608,42 @@ private:
         if (expired) expired->clear();
 
         // Iterate over all CANDIDATE_DELAYED and REQUESTED from old to new, as long as they're in the past,
-        // and convert them to CANDIDATE_READY and COMPLETED respectively.
-        while (!m_index.empty()) {
-            auto it = m_index.get<ByTime>().begin();
-            if (it->GetState() == State::CANDIDATE_DELAYED && it->m_time <= now) {
+        // and convert them to CANDIDATE_READY and COMPLETED respectively. Skip the events of announcements which
+        // are no longer waiting for that time.
+        m_wheel.PopDue(now, m_due_events);
+        for (const TimeEvent& event : m_due_events) {
+            auto it = m_index.get<ByPeer>().find(ByPeerView{event.m_peer, false, event.m_txhash});
+            if (it == m_index.get<ByPeer>().end() || it->m_time != event.m_time) continue;
+            if (it->GetState() == State::CANDIDATE_DELAYED) {
                 PromoteCandidateReady(m_index.project<ByTxHash>(it));
-            } else if (it->GetState() == State::REQUESTED && it->m_time <= now) {
+            } else if (it->GetState() == State::REQUESTED) {
                 if (expired) expired->emplace_back(it->m_peer, it->m_gtxid);
                 MakeCompleted(m_index.project<ByTxHash>(it));
-            } else {
-                break;
             }
         }
 
-        while (!m_index.empty()) {
+        if (now < m_last_now) {
             // If time went backwards, we may need to demote CANDIDATE_BEST and CANDIDATE_READY announcements back
             // to CANDIDATE_DELAYED. This is an unusual edge case, and unlikely to matter in production. However,
             // it makes it much easier to specify and test TxRequestTracker::Impl's behaviour.
-            auto it = std::prev(m_index.get<ByTime>().end());
-            if (it->IsSelectable() && it->m_time > now) {
+            std::vector<std::pair<NodeId, uint256>> demote;
+            for (const Announcement& ann : m_index) {
+                if (ann.IsSelectable() && ann.m_time > now) demote.emplace_back(ann.m_peer, ann.m_gtxid.ToUint256());
+            }
+            for (const auto& [peer, txhash] : demote) {
+                auto it = m_index.get<ByPeer>().find(ByPeerView{peer, true, txhash});
+                if (it == m_index.get<ByPeer>().end()) it = m_index.get<ByPeer>().find(ByPeerView{peer, false, txhash});
                 ChangeAndReselect(m_index.project<ByTxHash>(it), State::CANDIDATE_DELAYED);
-            } else {
-                break;
+                Schedule(*it);
             }
         }
+        m_last_now = now;
+    }
+
+    //! Add the event for the time of a CANDIDATE_DELAYED or REQUESTED announcement.
+    void Schedule(const Announcement& ann)
+    {
+        m_wheel.Add({ann.m_time, ann.m_peer, ann.m_gtxid.ToUint256()});
     }
 
 public:
@@ -518,8 +652,7 @@ public:
         // Explicitly initialize m_index as we need to pass a reference to m_computer to ByTxHashViewExtractor.
         m_index(boost::make_tuple(
             boost::make_tuple(ByPeerViewExtractor(), std::less<ByPeerView>()),
-            boost::make_tuple(ByTxHashViewExtractor(m_computer), std::less<ByTxHashView>()),
-            boost::make_tuple(ByTimeViewExtractor(), std::less<ByTimeView>())
+            boost::make_tuple(ByTxHashViewExtractor(m_computer), std::less<ByTxHashView>())
         )) {}
 
     // Disable copying and assigning (a default copy won't work due the stateful ByTxHashViewExtractor).
@@ -587,6 +720,7 @@ public:
         // Bail out in that case.
         auto ret = m_index.get<ByPeer>().emplace(gtxid, peer, preferred, reqtime, m_current_sequence);
         if (!ret.second) return;
+        Schedule(*ret.first);
 
         // Update accounting metadata.
         ++m_peerinfo[peer].m_total;
@@ -666,6 +800,7 @@ public:
             ann.SetState(State::REQUESTED);
             ann.m_time = expiry;
         });
+        Schedule(*it);
     }
 
     void ReceivedResponse(NodeId peer, const uint256& txhash)
@@ -9,9 +9,16 @@
 #include <coins.h>
 #include <compressor.h>
 #include <consensus/consensus.h>
+#include <indirectmap.h>
 #include <primitives/transaction.h>
 #include <serialize.h>
 
+#include <algorithm>
+#include <cstdint>
+#include <ios>
+#include <map>
+#include <vector>
+
 /** Formatter for undo information for a CTxIn
  *
  *  Contains the prevout's CTxOut being spent, and its metadata as well
@@ -67,4 +74,128 @@ public:
     SERIALIZE_METHODS(CBlockUndo, obj) { READWRITE(obj.vtxundo); }
 };
 
+/** Compact formatter for undo information for a CBlock
+ *
+ *  Used for undo data records flagged with node::UNDO_COMPACT_FLAG. All
+ *  counts are stored up front with a fixed width, so that the decoder can
+ *  size everything before reading any coin, followed by one column per
+ *  field of the spent coins:
+ *
+ *  - uint32 number of transactions, uint32 number of coins, uint32 height of
+ *    the most recent coin, and a uint32 number of coins per transaction
+ *  - for each coin, VARINT of its distance to the most recent height times
+ *    two plus the coinbase flag, which is small for recently created coins
+ *  - for each coin, VARINT of its compressed amount
+ *  - for each coin, VARINT of zero if its script is used for the first time,
+ *    or of one plus the index of the earlier script it reuses
+ *  - every distinct script, compressed, in the order of first use
+ */
+struct BlockUndoCompactFormatter
+{
+    //! No block can spend more coins than this, as each input takes at least
+    //! 41 bytes.
+    static constexpr uint32_t MAX_COINS{MAX_BLOCK_WEIGHT / (WITNESS_SCALE_FACTOR * 41)};
+
+    template<typename Stream>
+    void Ser(Stream& s, const CBlockUndo& blockundo)
+    {
+        uint32_t num_coins{0};
+        uint32_t max_height{0};
+        for (const CTxUndo& txundo : blockundo.vtxundo) {
+            num_coins += txundo.vprevout.size();
+            for (const Coin& coin : txundo.vprevout) max_height = std::max<uint32_t>(max_height, coin.nHeight);
+        }
+        ser_writedata32(s, blockundo.vtxundo.size());
+        ser_writedata32(s, num_coins);
+        ser_writedata32(s, max_height);
+        for (const CTxUndo& txundo : blockundo.vtxundo) {
+            ser_writedata32(s, txundo.vprevout.size());
+        }
+        for (const CTxUndo& txundo : blockundo.vtxundo) {
+            for (const Coin& coin : txundo.vprevout) {
+                ::Serialize(s, VARINT((max_height - coin.nHeight) * uint32_t{2} + coin.fCoinBase));
+            }
+        }
+        for (const CTxUndo& txundo : blockundo.vtxundo) {
+            for (const Coin& coin : txundo.vprevout) {
+                ::Serialize(s, Using<AmountCompression>(coin.out.nValue));
+            }
+        }
+        std::map<const CScript*, uint32_t, DereferencingComparator<const CScript*>> script_index;
+        std::vector<const CScript*> scripts;
+        for (const CTxUndo& txundo : blockundo.vtxundo) {
+            for (const Coin& coin : txundo.vprevout) {
+                const auto [it, inserted]{script_index.try_emplace(&coin.out.scriptPubKey, scripts.size())};
+                if (inserted) scripts.push_back(&coin.out.scriptPubKey);
+                ::Serialize(s, VARINT(inserted ? 0 : it->second + 1));
+            }
+        }
+        for (const CScript* script : scripts) {
+            ::Serialize(s, Using<ScriptCompression>(*script));
+        }
+    }
+
+    template<typename Stream>
+    void Unser(Stream& s, CBlockUndo& blockundo)
+    {
+        const uint32_t num_txs{ser_readdata32(s)};
+        const uint32_t num_coins{ser_readdata32(s)};
+        const uint32_t max_height{ser_readdata32(s)};
+        if (num_txs > MAX_COINS || num_coins > MAX_COINS) {
+            throw std::ios_base::failure("BlockUndoCompactFormatter: too many coins");
+        }
+        blockundo.vtxundo.clear();
+        blockundo.vtxundo.resize(num_txs);
+        uint64_t total_coins{0};
+        for (CTxUndo& txundo : blockundo.vtxundo) {
+            const uint32_t tx_coins{ser_readdata32(s)};
+            total_coins += tx_coins;
+            if (total_coins > num_coins) {
+                throw std::ios_base::failure("BlockUndoCompactFormatter: coin count mismatch");
+            }
+            txundo.vprevout.resize(tx_coins);
+        }
+        if (total_coins != num_coins) {
+            throw std::ios_base::failure("BlockUndoCompactFormatter: coin count mismatch");
+        }
+        for (CTxUndo& txundo : blockundo.vtxundo) {
+            for (Coin& coin : txundo.vprevout) {
+                uint32_t code{0};
+                ::Unserialize(s, VARINT(code));
+                if ((code >> 1) > max_height) {
+                    throw std::ios_base::failure("BlockUndoCompactFormatter: invalid height");
+                }
+                coin.nHeight = max_height - (code >> 1);
+                coin.fCoinBase = code & 1;
+            }
+        }
+        for (CTxUndo& txundo : blockundo.vtxundo) {
+            for (Coin& coin : txundo.vprevout) {
+                ::Unserialize(s, Using<AmountCompression>(coin.out.nValue));
+            }
+        }
+        std::vector<uint32_t> refs(num_coins);
+        for (uint32_t& ref : refs) {
+            ::Unserialize(s, VARINT(ref));
+        }
+        // Scripts are read straight into the coin that first uses them, and
+        // copied from there for later uses.
+        std::vector<const CScript*> scripts;
+        auto ref{refs.begin()};
+        for (CTxUndo& txundo : blockundo.vtxundo) {
+            for (Coin& coin : txundo.vprevout) {
+                if (*ref == 0) {
+                    ::Unserialize(s, Using<ScriptCompression>(coin.out.scriptPubKey));
+                    scripts.push_back(&coin.out.scriptPubKey);
+                } else if (*ref <= scripts.size()) {
+                    coin.out.scriptPubKey = *scripts[*ref - 1];
+                } else {
+                    throw std::ios_base::failure("BlockUndoCompactFormatter: invalid script reference");
+                }
+                ++ref;
+            }
+        }
+    }
+};
+
 #endif // BITCOIN_UNDO_H
@@ -0,0 +1,139 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <util/lz4.h>
+
+#include <crypto/common.h>
+#include <span.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace util {
+namespace {
+//! Matches are at least this long.
+constexpr size_t MIN_MATCH{4};
+//! The last bytes of the input are always stored as literals.
+constexpr size_t LAST_LITERALS{5};
+//! A match must start at least this many bytes before the end of the input.
+constexpr size_t MF_LIMIT{12};
+//! Matches are encoded as a 16 bit offset back into the output.
+constexpr size_t MAX_DISTANCE{0xffff};
+constexpr int HASH_BITS{16};
+
+uint32_t HashSequence(uint32_t sequence)
+{
+    return (sequence * 2654435761U) >> (32 - HASH_BITS);
+}
+
+//! Write the remainder of a length that did not fit in its 4 bit token field.
+void WriteLength(std::vector<std::byte>& out, size_t length)
+{
+    length -= 15;
+    for (; length >= 255; length -= 255) out.push_back(std::byte{255});
+    out.push_back(std::byte(length));
+}
+
+//! Write a sequence of literals followed by a match. The last sequence of the
+//! input has no match (match_length == 0).
+void WriteSequence(std::vector<std::byte>& out, std::span<const std::byte> literals, size_t match_length, size_t offset)
+{
+    const size_t match_code{match_length == 0 ? 0 : match_length - MIN_MATCH};
+    out.push_back(std::byte(std::min<size_t>(literals.size(), 15) << 4 | std::min<size_t>(match_code, 15)));
+    if (literals.size() >= 15) WriteLength(out, literals.size());
+    out.insert(out.end(), literals.begin(), literals.end());
+    if (match_length == 0) return;
+    out.push_back(std::byte(offset & 0xff));
+    out.push_back(std::byte(offset >> 8));
+    if (match_code >= 15) WriteLength(out, match_code);
+}
+
+//! Read the remainder of a length whose 4 bit token field was 15.
+bool ReadLength(std::span<const std::byte> input, size_t& pos, size_t& length)
+{
+    uint8_t byte;
+    do {
+        if (pos >= input.size()) return false;
+        byte = uint8_t(input[pos++]);
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+} // namespace
+
+std::vector<std::byte> LZ4Compress(std::span<const std::byte> input)
+{
+    std::vector<std::byte> out;
+    out.reserve(input.size() + input.size() / 255 + 16);
+    const size_t size{input.size()};
+    size_t anchor{0};
+    if (size > MF_LIMIT) {
+        // Most recent position of each hashed 4 byte sequence.
+        std::vector<uint32_t> table(size_t{1} << HASH_BITS);
+        const size_t match_limit{size - LAST_LITERALS};
+        size_t pos{0};
+        // Step further after many misses in a row, so that incompressible
+        // data (such as signatures and hashes) is skipped over quickly.
+        size_t misses{0};
+        while (pos + MF_LIMIT <= size) {
+            const uint32_t sequence{ReadLE32(UCharCast(input.data() + pos))};
+            uint32_t& slot{table[HashSequence(sequence)]};
+            const size_t candidate{slot};
+            slot = pos;
+            if (candidate >= pos || pos - candidate > MAX_DISTANCE || ReadLE32(UCharCast(input.data() + candidate)) != sequence) {
+                pos += 1 + (misses++ >> 6);
+                continue;
+            }
+            size_t length{MIN_MATCH};
+            while (pos + length < match_limit && input[candidate + length] == input[pos + length]) ++length;
+            WriteSequence(out, input.subspan(anchor, pos - anchor), length, pos - candidate);
+            pos += length;
+            anchor = pos;
+            misses = 0;
+        }
+    }
+    WriteSequence(out, input.subspan(anchor), /*match_length=*/0, /*offset=*/0);
+    return out;
+}
+
+std::optional<std::vector<std::byte>> LZ4Decompress(std::span<const std::byte> input, size_t decompressed_size)
+{
+    std::vector<std::byte> out;
+    out.reserve(decompressed_size);
+    size_t pos{0};
+    while (true) {
+        if (pos >= input.size()) return std::nullopt;
+        const uint8_t token{uint8_t(input[pos++])};
+
+        size_t literals{size_t{token} >> 4};
+        if (literals == 15 && !ReadLength(input, pos, literals)) return std::nullopt;
+        if (input.size() - pos < literals || decompressed_size - out.size() < literals) return std::nullopt;
+        out.insert(out.end(), input.begin() + pos, input.begin() + pos + literals);
+        pos += literals;
+        // The last sequence ends after its literals.
+        if (pos == input.size()) break;
+
+        if (input.size() - pos < 2) return std::nullopt;
+        const size_t offset{size_t(uint8_t(input[pos])) | size_t(uint8_t(input[pos + 1])) << 8};
+        pos += 2;
+        size_t length{size_t{token} & 15};
+        if (length == 15 && !ReadLength(input, pos, length)) return std::nullopt;
+        length += MIN_MATCH;
+        if (offset == 0 || offset > out.size() || decompressed_size - out.size() < length) return std::nullopt;
+
+        const size_t start{out.size() - offset};
+        out.resize(out.size() + length);
+        std::byte* const dest{out.data() + out.size() - length};
+        if (offset >= length) {
+            std::memcpy(dest, out.data() + start, length);
+        } else {
+            // The match overlaps the bytes it produces, e.g. a run of a repeated byte.
+            for (size_t i{0}; i < length; ++i) dest[i] = out[start + i];
+        }
+    }
+    if (out.size() != decompressed_size) return std::nullopt;
+    return out;
+}
+} // namespace util
@@ -0,0 +1,34 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTIL_LZ4_H
+#define BITCOIN_UTIL_LZ4_H
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace util {
+/**
+ * Compress data into the LZ4 block format.
+ *
+ * This is a small, greedy implementation that favors simplicity and
+ * decompression speed over compression ratio. The output does not record the
+ * size of the input, which must be stored separately to decompress it.
+ */
+std::vector<std::byte> LZ4Compress(std::span<const std::byte> input);
+
+/**
+ * Decompress data in the LZ4 block format.
+ *
+ * @param[in] input             The compressed data
+ * @param[in] decompressed_size The exact size of the decompressed data
+ * @returns the decompressed data, or std::nullopt if input is malformed or
+ *          does not decompress to exactly decompressed_size bytes.
+ */
+std::optional<std::vector<std::byte>> LZ4Decompress(std::span<const std::byte> input, size_t decompressed_size);
+} // namespace util
+
+#endif // BITCOIN_UTIL_LZ4_H
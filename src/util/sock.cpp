@@ -11,14 +11,21 @@
 #include <util/threadinterrupt.h>
 #include <util/time.h>
 
+#include <algorithm>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 #ifdef USE_POLL
 #include <poll.h>
 #endif
 
+#ifndef WIN32
+#include <climits>
+#include <sys/uio.h>
+#endif
+
 static inline bool IOErrorIsPermanent(int err)
 {
     return err != WSAEAGAIN && err != WSAEINTR && err != WSAEWOULDBLOCK && err != WSAEINPROGRESS;
@@ -47,6 +54,28 @@ ssize_t Sock::Send(const void* data, size_t len, int flags) const
     return send(m_socket, static_cast<const char*>(data), len, flags);
 }
 
+ssize_t Sock::SendVectored(std::span<const std::span<const unsigned char>> bufs, int flags) const
+{
+#ifdef WIN32
+    if (bufs.empty()) return 0;
+    return Send(bufs.front().data(), bufs.front().size(), flags);
+#else
+#ifdef IOV_MAX
+    // Sending fewer buffers than passed is just a partial send.
+    bufs = bufs.first(std::min<size_t>(bufs.size(), IOV_MAX));
+#endif
+    std::vector<iovec> iov(bufs.size());
+    for (size_t i = 0; i < bufs.size(); ++i) {
+        iov[i].iov_base = const_cast<unsigned char*>(bufs[i].data());
+        iov[i].iov_len = bufs[i].size();
+    }
+    msghdr msg{};
+    msg.msg_iov = iov.data();
+    msg.msg_iovlen = iov.size();
+    return sendmsg(m_socket, &msg, flags);
+#endif
+}
+
 ssize_t Sock::Recv(void* buf, size_t len, int flags) const
 {
     return recv(m_socket, static_cast<char*>(buf), len, flags);
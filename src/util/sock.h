@@ -11,6 +11,7 @@
 
 #include <chrono>
 #include <memory>
+#include <span>
 #include <string>
 #include <unordered_map>
 
@@ -64,6 +65,14 @@ public:
      */
     [[nodiscard]] virtual ssize_t Send(const void* data, size_t len, int flags) const;
 
+    /**
+     * sendmsg(2) wrapper, sending the concatenation of bufs with one call. Equivalent to
+     * `sendmsg(m_socket, msg, flags);` with an iovec per buffer in msg. Where sendmsg(2) is not
+     * available, only the first buffer is sent. Code that uses this wrapper can be unit tested
+     * if this method is overridden by a mock Sock implementation.
+     */
+    [[nodiscard]] virtual ssize_t SendVectored(std::span<const std::span<const unsigned char>> bufs, int flags) const;
+
     /**
      * recv(2) wrapper. Equivalent to `recv(m_socket, buf, len, flags);`. Code that uses this
      * wrapper can be unit tested if this method is overridden by a mock Sock implementation.
@@ -0,0 +1,108 @@
+// Copyright (c) The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTIL_THREADPOOL_H
+#define BITCOIN_UTIL_THREADPOOL_H
+
+#include <sync.h>
+#include <tinyformat.h>
+#include <util/threadnames.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * A fixed set of worker threads running tasks submitted from other threads.
+ *
+ * Tasks are run in the order they were submitted. A task must not wait for
+ * another task of the same pool, as that one may be queued behind it.
+ */
+class ThreadPool
+{
+private:
+    Mutex m_mutex;
+    //! Worker threads block on this when out of work
+    std::condition_variable m_worker_cv;
+    std::deque<std::packaged_task<void()>> m_queue GUARDED_BY(m_mutex);
+    bool m_request_stop GUARDED_BY(m_mutex){false};
+    std::vector<std::thread> m_worker_threads;
+
+    void Loop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        while (true) {
+            std::packaged_task<void()> task;
+            {
+                WAIT_LOCK(m_mutex, lock);
+                m_worker_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) { return m_request_stop || !m_queue.empty(); });
+                if (m_queue.empty()) return;
+                task = std::move(m_queue.front());
+                m_queue.pop_front();
+            }
+            task();
+        }
+    }
+
+public:
+    /**
+     * @param[in] name               Prefix of the names of the worker threads
+     * @param[in] worker_threads_num Number of worker threads to start
+     */
+    ThreadPool(const std::string& name, int worker_threads_num)
+    {
+        m_worker_threads.reserve(worker_threads_num);
+        for (int n = 0; n < worker_threads_num; ++n) {
+            m_worker_threads.emplace_back([this, name, n]() {
+                util::ThreadRename(strprintf("%s.%i", name, n));
+                Loop();
+            });
+        }
+    }
+
+    // Since this class manages its own resources, which is a thread
+    // pool `m_worker_threads`, copy and move operations are not appropriate.
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    //! Stop the worker threads once all submitted tasks have run.
+    ~ThreadPool()
+    {
+        WITH_LOCK(m_mutex, m_request_stop = true);
+        m_worker_cv.notify_all();
+        for (std::thread& t : m_worker_threads) {
+            t.join();
+        }
+    }
+
+    /**
+     * Queue fn to be run on a worker thread.
+     *
+     * @returns a future for the result of fn, or for the exception it threw.
+     * @pre The pool has worker threads.
+     */
+    template <typename F>
+    std::future<std::invoke_result_t<F>> Submit(F&& fn) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex)
+    {
+        std::packaged_task<std::invoke_result_t<F>()> task{std::forward<F>(fn)};
+        auto future{task.get_future()};
+        {
+            LOCK(m_mutex);
+            m_queue.emplace_back(std::move(task));
+        }
+        m_worker_cv.notify_one();
+        return future;
+    }
+
+    size_t WorkersCount() const { return m_worker_threads.size(); }
+};
+
+#endif // BITCOIN_UTIL_THREADPOOL_H
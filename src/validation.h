@@ -23,6 +23,7 @@
 #include <policy/policy.h>
 #include <script/script_error.h>
 #include <script/sigcache.h>
+#include <support/allocators/arena.h>
 #include <sync.h>
 #include <txdb.h>
 #include <txmempool.h>
@@ -31,6 +32,7 @@
 #include <util/fs.h>
 #include <util/hasher.h>
 #include <util/result.h>
+#include <util/threadpool.h>
 #include <util/time.h>
 #include <util/translation.h>
 #include <versionbits.h>
@@ -81,6 +83,8 @@ static const uint64_t MIN_DISK_SPACE_FOR_BLOCK_FILES = 550 * 1024 * 1024;
 
 /** Maximum number of dedicated script-checking threads allowed */
 static constexpr int MAX_SCRIPTCHECK_THREADS{15};
+/** Batches of fewer headers than this are not worth hashing across threads. */
+static constexpr size_t MIN_PARALLEL_HEADERS{256};
 
 /** Current sync state passed to tip changed callbacks. */
 enum class SynchronizationState {
@@ -331,7 +335,7 @@ bool CheckSequenceLocksAtTip(CBlockIndex* tip,
 class CScriptCheck
 {
 private:
-    CTxOut m_tx_out;
+    const CTxOut* m_tx_out;
     const CTransaction *ptxTo;
     unsigned int nIn;
     unsigned int nFlags;
@@ -340,8 +344,9 @@ private:
     SignatureCache* m_signature_cache;
 
 public:
+    //! The output, transaction and precomputed data must outlive the check.
     CScriptCheck(const CTxOut& outIn, const CTransaction& txToIn, SignatureCache& signature_cache, unsigned int nInIn, unsigned int nFlagsIn, bool cacheIn, PrecomputedTransactionData* txdataIn) :
-        m_tx_out(outIn), ptxTo(&txToIn), nIn(nInIn), nFlags(nFlagsIn), cacheStore(cacheIn), txdata(txdataIn), m_signature_cache(&signature_cache) { }
+        m_tx_out(&outIn), ptxTo(&txToIn), nIn(nInIn), nFlags(nFlagsIn), cacheStore(cacheIn), txdata(txdataIn), m_signature_cache(&signature_cache) { }
 
     CScriptCheck(const CScriptCheck&) = delete;
     CScriptCheck& operator=(const CScriptCheck&) = delete;
@@ -351,6 +356,9 @@ public:
     std::optional<std::pair<ScriptError, std::string>> operator()();
 };
 
+//! The script checks of a transaction while connecting a block.
+using ScriptCheckVector = std::vector<CScriptCheck, ArenaAllocator<CScriptCheck>>;
+
 // CScriptCheck is used a lot in std::vector, make sure that's efficient
 static_assert(std::is_nothrow_move_assignable_v<CScriptCheck>);
 static_assert(std::is_nothrow_move_constructible_v<CScriptCheck>);
@@ -382,7 +390,7 @@ public:
 /** Functions for validating blocks and updating the block tree */
 
 /** Context-independent validity checks */
-bool CheckBlock(const CBlock& block, BlockValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true, bool fCheckMerkleRoot = true);
+bool CheckBlock(const CBlock& block, BlockValidationState& state, const Consensus::Params& consensusParams, bool fCheckPOW = true, bool fCheckMerkleRoot = true, ThreadPool* merkle_pool = nullptr);
 
 /**
  * Verify a block, including transactions.
@@ -407,8 +415,17 @@ BlockValidationState TestBlockValidity(
     bool check_pow,
     bool check_merkle_root) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 
+/**
+ * Compute the hashes of headers. If pool is given and there are at least
+ * MIN_PARALLEL_HEADERS of them, they are split across its threads and the
+ * calling thread.
+ */
+std::vector<uint256> GetBlockHeaderHashes(std::span<const CBlockHeader> headers, ThreadPool* pool = nullptr);
+
 /** Check with the proof of work on each blockheader matches the value in nBits */
 bool HasValidProofOfWork(const std::vector<CBlockHeader>& headers, const Consensus::Params& consensusParams);
+/** Same, given the hashes of the headers. */
+bool HasValidProofOfWork(std::span<const CBlockHeader> headers, std::span<const uint256> hashes, const Consensus::Params& consensusParams);
 
 /** Check if a block has been mutated (with respect to its merkle root and witness commitments). */
 bool IsBlockMutated(const CBlock& block, bool check_witness_root);
@@ -550,6 +567,11 @@ protected:
     //! Cached result of LookupBlockIndex(*m_from_snapshot_blockhash)
     mutable const CBlockIndex* m_cached_snapshot_base GUARDED_BY(::cs_main){nullptr};
 
+    //! Memory for the temporaries of ConnectBlock, which is reset for every
+    //! block, so that connecting a block does not need to allocate them on
+    //! the heap.
+    ArenaResource m_connect_block_arena GUARDED_BY(::cs_main);
+
 public:
     //! Reference to a BlockManager instance which itself is shared across all
     //! Chainstate instances.
@@ -961,6 +983,10 @@ private:
 
     //! A queue for script verifications that have to be performed by worker threads.
     CCheckQueue<CScriptCheck> m_script_check_queue;
+    //! Worker threads for computing the merkle roots of large blocks and the
+    //! hashes of batches of headers. Mutable as the const block checks use it
+    //! too.
+    mutable ThreadPool m_hash_pool;
 
     //! Timers and counters used for benchmarking validation in both background
     //! and active chainstates.
@@ -1259,8 +1285,9 @@ public:
     /** Update uncommitted block structures (currently: only the witness reserved value). This is safe for submitted blocks. */
     void UpdateUncommittedBlockStructures(CBlock& block, const CBlockIndex* pindexPrev) const;
 
-    /** Produce the necessary coinbase commitment for a block (modifies the hash, don't call for mined blocks). */
-    std::vector<unsigned char> GenerateCoinbaseCommitment(CBlock& block, const CBlockIndex* pindexPrev) const;
+    /** Produce the necessary coinbase commitment for a block (modifies the hash, don't call for mined blocks).
+     *  witness_root is the witness merkle root of the block, if it is already known. */
+    std::vector<unsigned char> GenerateCoinbaseCommitment(CBlock& block, const CBlockIndex* pindexPrev, const std::optional<uint256>& witness_root = std::nullopt) const;
 
     /** This is used by net_processing to report pre-synchronization progress of headers, as
      *  headers are not yet fed to validation during that time, but validation is (for now)
@@ -1319,6 +1346,7 @@ public:
     void RecalculateBestHeader() EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
 
     CCheckQueue<CScriptCheck>& GetCheckQueue() { return m_script_check_queue; }
+    ThreadPool& GetHashPool() const { return m_hash_pool; }
 
     ~ChainstateManager();
 };
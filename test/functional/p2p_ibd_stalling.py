@@ -99,6 +99,9 @@ class P2PIBDStallingTest(BitcoinTestFramework):
                 p.send_without_ping(headers_message)
             self.all_sync_send_with_ping(peers)
 
+        self.log.info("Check that the stalling block is requested from a second peer as well")
+        self.wait_until(lambda: sum(stall_block in p.getdata_requests for p in peers) == 2)
+
         self.log.info("Check that the stalling peer is disconnected after 2 seconds")
         self.mocktime += 3
         node.setmocktime(self.mocktime)
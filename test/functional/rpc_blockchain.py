@@ -95,6 +95,7 @@ class BlockchainTest(BitcoinTestFramework):
         self._test_gettxout()
         self._test_getblockheader()
         self._test_getdifficulty()
+        self._test_getdbstats()
         self._test_getnetworkhashps()
         self._test_stopatheight()
         self._test_waitforblock() # also tests waitfornewblock
@@ -492,6 +493,15 @@ class BlockchainTest(BitcoinTestFramework):
         # binary => decimal => binary math is why we do this check
         assert abs(difficulty * 2**31 - 1) < 0.0001
 
+    def _test_getdbstats(self):
+        self.log.info("Test getdbstats")
+        stats = self.nodes[0].getdbstats()
+        for db in ("blockindex", "chainstate"):
+            assert_equal(len(stats[db]["files_per_level"]), 7)
+            for key in ("compactions", "compaction_time", "compaction_bytes_read", "compaction_bytes_written",
+                        "write_slowdowns", "write_slowdown_time", "write_stops", "write_stop_time"):
+                assert_greater_than_or_equal(stats[db][key], 0)
+
     def _test_getnetworkhashps(self):
         self.log.info("Test getnetworkhashps")
         assert_raises_rpc_error(
@@ -157,6 +157,7 @@ class NetTest(BitcoinTestFramework):
                 "id": no_version_peer_id,
                 "inbound": True,
                 "inflight": [],
+                "inflight_window": 16,
                 "last_block": 0,
                 "last_transaction": 0,
                 "lastrecv": 0 if not self.options.v2transport else no_version_peer_conntime,
@@ -196,6 +197,11 @@ class NetTest(BitcoinTestFramework):
         self.nodes[0].ping()
         self.wait_until(lambda: (self.nodes[0].getnettotals()['totalbytessent'] >= net_totals_before['totalbytessent'] + ping_size * 2), timeout=1)
         self.wait_until(lambda: (self.nodes[0].getnettotals()['totalbytesrecv'] >= net_totals_before['totalbytesrecv'] + ping_size * 2), timeout=1)
+        self.wait_until(lambda: (self.nodes[0].getnettotals()['bytessent_per_msg'].get('ping', 0) >= net_totals_before['bytessent_per_msg'].get('ping', 0) + ping_size * 2), timeout=1)
+        self.wait_until(lambda: (self.nodes[0].getnettotals()['bytesrecv_per_msg'].get('pong', 0) >= net_totals_before['bytesrecv_per_msg'].get('pong', 0) + ping_size * 2), timeout=1)
+        # Each ping and pong took at least one call to send and one to receive.
+        self.wait_until(lambda: (self.nodes[0].getnettotals()['totalsendcalls'] >= net_totals_before['totalsendcalls'] + 2), timeout=1)
+        self.wait_until(lambda: (self.nodes[0].getnettotals()['totalrecvcalls'] >= net_totals_before['totalrecvcalls'] + 2), timeout=1)
 
         for peer_before in peer_info_before:
             peer_after = lambda: next(p for p in self.nodes[0].getpeerinfo() if p['id'] == peer_before['id'])